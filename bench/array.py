@@ -0,0 +1,42 @@
+# Arithmetic on a million doubles, as a list of boxed floats or as a typed array.
+# Python's arrays have no arithmetic methods, so the array versions use builtins over the array.
+from array import array
+import operator
+
+xs = [i * 0.5 for i in range(1000000)]
+ys = [i * 0.25 for i in range(1000000)]
+xa = array('d', xs)
+ya = array('d', ys)
+
+def list_add():
+    [x + y for x, y in zip(xs, ys)]
+
+def array_add():
+    array('d', map(operator.add, xa, ya))
+
+def list_sum():
+    sum(xs)
+
+def array_sum():
+    sum(xa)
+
+def list_dot():
+    total = 0.0
+    for x, y in zip(xs, ys):
+        total += x * y
+
+def array_dot():
+    sum(map(operator.mul, xa, ya))
+
+def array_tobytes():
+    array('d', xa.tobytes())
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(list_add, number=1) for x in range(5)), 'array list add')
+    print(min(timeit(array_add, number=1) for x in range(5)), 'array add')
+    print(min(timeit(list_sum, number=1) for x in range(5)), 'array list sum')
+    print(min(timeit(array_sum, number=1) for x in range(5)), 'array sum')
+    print(min(timeit(list_dot, number=1) for x in range(5)), 'array list dot')
+    print(min(timeit(array_dot, number=1) for x in range(5)), 'array dot')
+    print(min(timeit(array_tobytes, number=1) for x in range(5)), 'array bytes round trip')
@@ -0,0 +1,129 @@
+# Arbitrary-precision integer arithmetic at a range of operand sizes.
+def make(bits):
+    x = 1
+    for i in range(bits // 30):
+        x = (x << 30) | ((i * 7919 + 104729) & 0x3FFFFFFF)
+    return x
+
+def multiply(bits, count):
+    a = make(bits)
+    b = make(bits) + 12345
+    def run():
+        for i in range(count):
+            a * b
+    return run
+
+def square(bits, count):
+    a = make(bits)
+    def run():
+        for i in range(count):
+            a * a
+    return run
+
+def divide(bits, count):
+    a = make(bits * 2) + 99
+    b = make(bits) + 12345
+    def run():
+        for i in range(count):
+            a // b
+            a % b
+    return run
+
+def modulo(bits, count):
+    a = make(200000)
+    b = make(bits) + 1
+    def run():
+        for i in range(count):
+            a % b
+    return run
+
+def convert(digits):
+    s = '7' * digits
+    x = int(s)
+    def run():
+        int(s)
+        str(x)
+    return run
+
+def bitwise(bits, count):
+    a = make(bits)
+    b = make(bits) + 12345
+    def run():
+        for i in range(count):
+            a & b
+            a | b
+            a ^ b
+    return run
+
+def shift(bits, count):
+    a = make(bits)
+    def run():
+        for i in range(count):
+            a << 77
+            a >> 77
+    return run
+
+def powmod(bits, count):
+    a = make(bits)
+    e = make(bits) + 3
+    m = make(bits) + 1
+    def run():
+        for i in range(count):
+            pow(a, e, m)
+    return run
+
+def gcd(bits, count):
+    import math
+    a = make(bits) * 3
+    b = make(bits // 2) * 7 + 3
+    def run():
+        for i in range(count):
+            math.gcd(a, b)
+    return run
+
+def isqrt(bits, count):
+    import math
+    a = make(bits)
+    def run():
+        for i in range(count):
+            math.isqrt(a)
+    return run
+
+def unbalanced():
+    a = make(200000)
+    b = make(5000)
+    for i in range(10):
+        a * b
+
+def factorial():
+    x = 1
+    for i in range(1, 5001):
+        x *= i
+
+def power():
+    3 ** 200000
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    for bits, count in [(1000, 20000), (2000, 5000), (5000, 1000), (10000, 300), (50000, 20), (200000, 2)]:
+        print(min(timeit(multiply(bits, count), number=1) for x in range(5)), 'multiply', bits, 'bits x', count)
+        print(min(timeit(square(bits, count), number=1) for x in range(5)), 'square', bits, 'bits x', count)
+    for bits, count in [(1000, 100000), (100000, 2000)]:
+        print(min(timeit(bitwise(bits, count), number=1) for x in range(5)), 'and/or/xor', bits, 'bits x', count)
+        print(min(timeit(shift(bits, count), number=1) for x in range(5)), 'shift', bits, 'bits x', count)
+    for bits, count in [(100, 20000), (1000, 2000), (10000, 20), (50000, 2)]:
+        print(min(timeit(divide(bits, count), number=1) for x in range(5)), 'divide', bits * 2, 'by', bits, 'bits x', count)
+    for bits, count in [(1000, 50), (20000, 20)]:
+        print(min(timeit(modulo(bits, count), number=1) for x in range(5)), 'modulo 200000 by', bits, 'bits x', count)
+    for bits, count in [(256, 2000), (1024, 100), (4096, 3)]:
+        print(min(timeit(powmod(bits, count), number=1) for x in range(5)), 'pow mod', bits, 'bits x', count)
+    for bits, count in [(1000, 2000), (20000, 10)]:
+        print(min(timeit(gcd(bits, count), number=1) for x in range(5)), 'gcd', bits, 'bits x', count)
+        print(min(timeit(isqrt(bits, count), number=1) for x in range(5)), 'isqrt', bits, 'bits x', count)
+    import sys
+    sys.set_int_max_str_digits(0)
+    for digits in [1000, 10000, 100000]:
+        print(min(timeit(convert(digits), number=1) for x in range(5)), 'int/str round trip', digits, 'digits')
+    print(min(timeit(unbalanced, number=1) for x in range(5)), '200000 x 5000 bits')
+    print(min(timeit(factorial, number=1) for x in range(5)), 'factorial(5000)')
+    print(min(timeit(power, number=1) for x in range(5)), '3 ** 200000')
@@ -0,0 +1,31 @@
+# Reading a file in fixed-size chunks, into fresh bytes objects or into one reused buffer.
+import io as fileio
+import os
+
+path = '/tmp/krk_bench_buffers.bin'
+with fileio.open(path, 'wb') as f:
+    f.write(('0123456789abcdef' * 65536).encode())
+
+def read_chunks():
+    with fileio.open(path, 'rb') as f:
+        while True:
+            chunk = f.read(4096)
+            if not chunk: break
+
+def readinto_chunks():
+    buffer = bytearray(4096)
+    with fileio.open(path, 'rb') as f:
+        while f.readinto(buffer):
+            pass
+
+def view_slices():
+    view = memoryview(bytearray(1048576))
+    for i in range(0, 1048576 - 4096, 64):
+        view[i:i+4096]
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(read_chunks, number=1) for x in range(5)), 'buffers read')
+    print(min(timeit(readinto_chunks, number=1) for x in range(5)), 'buffers readinto')
+    print(min(timeit(view_slices, number=1) for x in range(5)), 'buffers view slices')
+    os.remove(path)
@@ -0,0 +1,53 @@
+# Queue traffic through collections.deque: FIFO churn, a BFS over a grid,
+# a bounded window, rotation and indexing.
+from fasttimer import timeit
+from collections import deque
+
+def fifo():
+    q = deque()
+    for i in range(100000):
+        q.append(i)
+        q.append(i)
+        q.popleft()
+    while q:
+        q.popleft()
+
+def bfs():
+    n = 200
+    seen = set()
+    q = deque([(0, 0)])
+    seen.add((0, 0))
+    while q:
+        p = q.popleft()
+        x = p[0]
+        y = p[1]
+        for step in ((1, 0), (0, 1), (-1, 0), (0, -1)):
+            nx = x + step[0]
+            ny = y + step[1]
+            if 0 <= nx < n and 0 <= ny < n and (nx, ny) not in seen:
+                seen.add((nx, ny))
+                q.append((nx, ny))
+
+def window():
+    w = deque(maxlen=100)
+    for i in range(200000):
+        w.append(i)
+
+big = deque(range(100000))
+
+def rotate():
+    for i in range(100):
+        big.rotate(1000)
+        big.rotate(-999)
+
+def index():
+    total = 0
+    for i in range(0, 100000, 97):
+        total += big[i]
+
+if True:
+    print(min(timeit(fifo, number=1) for x in range(5)), "deque fifo")
+    print(min(timeit(bfs, number=1) for x in range(5)), "deque bfs")
+    print(min(timeit(window, number=1) for x in range(5)), "deque bounded window")
+    print(min(timeit(rotate, number=1) for x in range(5)), "deque rotate")
+    print(min(timeit(index, number=1) for x in range(5)), "deque index")
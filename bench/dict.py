@@ -0,0 +1,39 @@
+# Dictionary-heavy workloads: counting, joining, memoizing, and lookups that miss.
+words = [str(i % 5003) + 'w' for i in range(100000)]
+left = {i * 7: str(i) for i in range(20000)}
+right = [(i * 3, i) for i in range(20000)]
+collide = {i * 65536: i for i in range(2048)}
+probes = [i * 65536 + 1 for i in range(2048)]
+
+def word_count():
+    counts = {}
+    for w in words:
+        counts[w] = counts.get(w, 0) + 1
+
+def join():
+    out = []
+    for k, v in right:
+        if k in left:
+            out.append((left[k], v))
+
+def memo():
+    cache = {}
+    def fib(n):
+        if n in cache: return cache[n]
+        r = n if n < 2 else fib(n-1) + fib(n-2)
+        cache[n] = r
+        return r
+    for i in range(300):
+        cache.clear()
+        fib(200)
+
+def misses():
+    for p in probes:
+        p in collide
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(word_count, number=1) for x in range(5)), 'dict word count')
+    print(min(timeit(join, number=1) for x in range(5)), 'dict join')
+    print(min(timeit(memo, number=1) for x in range(5)), 'dict memo')
+    print(min(timeit(misses, number=1) for x in range(5)), 'dict collision misses')
@@ -0,0 +1,42 @@
+# Printing and parsing doubles spread over the whole exponent range.
+import math
+
+def make(count):
+    values = []
+    state = 12345
+    for i in range(count):
+        state = (state * 1103515245 + 12345) & 0x7FFFFFFF
+        high = state
+        state = (state * 1103515245 + 12345) & 0x7FFFFFFF
+        low = state
+        state = (state * 1103515245 + 12345) & 0x7FFFFFFF
+        mantissa = high / 2147483648.0 + low / 4611686018427387904.0
+        values.append((mantissa - 0.5) * math.pow(2.0, (state % 2040) - 1020))
+    return values
+
+values = make(100000)
+strings = [repr(x) for x in values]
+
+def to_repr():
+    for x in values:
+        repr(x)
+
+def to_fixed():
+    for x in values:
+        format(x, '.3f')
+
+def to_general():
+    for x in values:
+        format(x, '.6g')
+
+def parse():
+    for s in strings:
+        float(s)
+
+if __name__ == '__main__':
+    from timeit import timeit
+    print(min(timeit(to_repr, number=1) for x in range(5)), 'repr')
+    print(min(timeit(to_fixed, number=1) for x in range(5)), 'format .3f')
+    print(min(timeit(to_general, number=1) for x in range(5)), 'format .6g')
+    print(min(timeit(parse, number=1) for x in range(5)), 'float()')
+    print(len([x for x in values if float(repr(x)) != x]), 'of', len(values), 'did not round-trip')
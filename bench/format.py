@@ -0,0 +1,21 @@
+# Log-line style formatting of ints, strs and bools.
+def fstrings():
+    level = 'INFO'
+    ok = True
+    for i in range(200000):
+        f"{level} request {i} took {i % 977} ms ok={ok}"
+
+def str_format():
+    template = "{} request {} took {} ms ok={}"
+    for i in range(200000):
+        template.format('INFO', i, i % 977, True)
+
+def str_format_named():
+    for i in range(200000):
+        "{level} request {n} done".format(level='INFO', n=i)
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(fstrings, number=1) for x in range(5)), 'f-strings')
+    print(min(timeit(str_format, number=1) for x in range(5)), 'str.format positional')
+    print(min(timeit(str_format_named, number=1) for x in range(5)), 'str.format keywords')
@@ -0,0 +1,41 @@
+# Hashing throughput for str and bytes, and dict behavior for keys
+# that used to collide: multiples of a large power of two and small floats.
+data = ('the quick brown fox jumps over the lazy dog ' * 2000).encode()
+short = [data[i:i+12] for i in range(0, 8000, 8)]
+long = [data[i:i+4096] for i in range(0, 8000, 8)]
+strided = [i << 20 for i in range(4000)]
+fractions = [i / 1000 for i in range(4000)]
+
+def hash_short():
+    for b in short:
+        hash(b)
+
+def hash_long():
+    for b in long:
+        hash(b)
+
+def make_strings():
+    for b in short:
+        b.decode() + '!'
+
+def dict_strided():
+    d = {}
+    for k in strided:
+        d[k] = k
+    for k in strided:
+        d[k]
+
+def dict_fractions():
+    d = {}
+    for k in fractions:
+        d[k] = k
+    for k in fractions:
+        d[k]
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(hash_short, number=10) for x in range(5)), 'hash 12-byte bytes')
+    print(min(timeit(hash_long, number=10) for x in range(5)), 'hash 4096-byte bytes')
+    print(min(timeit(make_strings, number=10) for x in range(5)), 'create short strings')
+    print(min(timeit(dict_strided, number=1) for x in range(5)), 'dict with strided int keys')
+    print(min(timeit(dict_fractions, number=1) for x in range(5)), 'dict with float keys')
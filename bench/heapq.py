@@ -0,0 +1,33 @@
+# Priority queue traffic through heapq: ints, (priority, counter, task)
+# tuples, heapify, selection and merging.
+from fasttimer import timeit
+import heapq
+
+ints = [(i * 2654435761) % 1000003 for i in range(100000)]
+tasks = [(x % 100, i, 'task') for i, x in enumerate(ints)]
+runs = [sorted(ints[i::10]) for i in range(10)]
+
+def push_pop(items):
+    h = []
+    for x in items:
+        heapq.heappush(h, x)
+    while h:
+        heapq.heappop(h)
+
+def heapify():
+    heapq.heapify(ints[:])
+
+def select():
+    heapq.nsmallest(100, ints)
+    heapq.nlargest(100, ints)
+
+def merge():
+    for x in heapq.merge(*runs):
+        pass
+
+if True:
+    print(min(timeit(lambda: push_pop(ints), number=1) for x in range(5)), "heapq push pop ints")
+    print(min(timeit(lambda: push_pop(tasks), number=1) for x in range(5)), "heapq push pop tuples")
+    print(min(timeit(heapify, number=1) for x in range(5)), "heapq heapify")
+    print(min(timeit(select, number=1) for x in range(5)), "heapq nsmallest nlargest")
+    print(min(timeit(merge, number=1) for x in range(5)), "heapq merge")
@@ -0,0 +1,55 @@
+# Iterator pipelines built from itertools: chaining, slicing, grouping,
+# running totals, zipping and combinatorics.
+from fasttimer import timeit
+from itertools import chain, islice, count, accumulate, groupby, zip_longest, product, combinations, starmap, tee
+
+rows = [(i % 7, i) for i in range(100000)]
+parts = [list(range(i, i + 1000)) for i in range(0, 100000, 1000)]
+
+def chained():
+    for x in chain.from_iterable(parts):
+        pass
+
+def sliced():
+    for x in islice(count(), 10, 200000, 2):
+        pass
+
+def totals():
+    for x in accumulate(range(200000)):
+        pass
+
+def grouped():
+    for k, g in groupby(sorted(rows)):
+        for x in g:
+            pass
+
+def zipped():
+    for x in zip_longest(range(100000), range(50000), fillvalue=0):
+        pass
+
+def combinatorics():
+    for x in product(range(20), repeat=4):
+        pass
+    for x in combinations(range(30), 4):
+        pass
+
+def starmapped():
+    for x in starmap(max, rows):
+        pass
+
+def teed():
+    a, b = tee(range(200000))
+    for x in a:
+        pass
+    for x in b:
+        pass
+
+if True:
+    print(min(timeit(chained, number=1) for x in range(5)), "itertools chain.from_iterable")
+    print(min(timeit(sliced, number=1) for x in range(5)), "itertools islice count")
+    print(min(timeit(totals, number=1) for x in range(5)), "itertools accumulate")
+    print(min(timeit(grouped, number=1) for x in range(5)), "itertools groupby")
+    print(min(timeit(zipped, number=1) for x in range(5)), "itertools zip_longest")
+    print(min(timeit(combinatorics, number=1) for x in range(5)), "itertools product combinations")
+    print(min(timeit(starmapped, number=1) for x in range(5)), "itertools starmap")
+    print(min(timeit(teed, number=1) for x in range(5)), "itertools tee")
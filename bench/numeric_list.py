@@ -0,0 +1,13 @@
+# Summing, searching and sorting lists that hold only ints or only floats.
+from fasttimer import timeit
+
+ints = [(i * 2654435761) % 1000003 for i in range(1000000)]
+floats = [x / 7 for x in ints]
+
+if True:
+    print(min(timeit(lambda: sum(ints), number=1) for x in range(5)), "numeric list sum ints")
+    print(min(timeit(lambda: sum(floats), number=1) for x in range(5)), "numeric list sum floats")
+    print(min(timeit(lambda: (min(floats), max(floats)), number=1) for x in range(5)), "numeric list min max")
+    print(min(timeit(lambda: -1.0 in floats, number=1) for x in range(5)), "numeric list contains")
+    print(min(timeit(lambda: sorted(ints), number=1) for x in range(5)), "numeric list sort ints")
+    print(min(timeit(lambda: sorted(floats), number=1) for x in range(5)), "numeric list sort floats")
@@ -0,0 +1,25 @@
+# Consuming a large buffer by repeatedly slicing off its head, and taking large slices of bytes.
+text = ''.join(str(i) + ' ' for i in range(10000))
+data = text.encode()
+
+def consume():
+    rest = text
+    while rest:
+        space = rest.find(' ')
+        rest = rest[space+1:]
+
+def consume_bytes():
+    rest = data
+    while rest:
+        space = rest.find(b' ')
+        rest = rest[space+1:]
+
+def chunks():
+    for i in range(0, len(data) - 16384, 64):
+        data[i:i+16384]
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(consume, number=1) for x in range(5)), 'slice consume str')
+    print(min(timeit(consume_bytes, number=1) for x in range(5)), 'slice consume bytes')
+    print(min(timeit(chunks, number=1) for x in range(5)), 'slice bytes chunks')
@@ -0,0 +1,29 @@
+# Lots of tiny tables: keyword arguments, small literals, and short-lived records.
+d = {'a': 1, 'b': 2, 'c': 3, 'd': 4}
+
+def kw(**kwargs):
+    return kwargs['b']
+
+def kwargs_calls():
+    for i in range(100000):
+        kw(a=i, b=i, c=i)
+
+def literals():
+    for i in range(100000):
+        r = {'x': i, 'y': i, 'z': i}
+
+def lookups():
+    for i in range(100000):
+        d['a'] + d['b'] + d['c'] + d['d']
+
+def int_keys():
+    for i in range(100000):
+        r = {1: i, 2: i, 3: i}
+        r[2]
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(kwargs_calls, number=1) for x in range(5)), 'small dict kwargs')
+    print(min(timeit(literals, number=1) for x in range(5)), 'small dict literals')
+    print(min(timeit(lookups, number=1) for x in range(5)), 'small dict lookups')
+    print(min(timeit(int_keys, number=1) for x in range(5)), 'small dict int keys')
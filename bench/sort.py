@@ -0,0 +1,12 @@
+# Sorting strings, tuples and keyed records.
+from fasttimer import timeit
+
+ints = [(i * 2654435761) % 1000003 for i in range(300000)]
+strs = [str(x) for x in ints]
+pairs = [(x, i) for i, x in enumerate(ints)]
+records = [{'id': x} for x in ints]
+
+if True:
+    print(min(timeit(lambda: sorted(strs), number=1) for x in range(5)), "sort strings")
+    print(min(timeit(lambda: sorted(pairs), number=1) for x in range(5)), "sort tuples")
+    print(min(timeit(lambda: sorted(records, key=lambda r: r['id']), number=1) for x in range(5)), "sort with key")
@@ -0,0 +1,47 @@
+# Indexing and slicing long non-ASCII strings.
+cjk = '日本語のテキストと漢字、ひらがな、カタカナ。' * 20000
+mixed = 'Ünïcödé téxt wïth sömé äccénts, mostly plain ASCII otherwise. ' * 8000
+
+def fresh(text):
+    # A new copy of the text, without any codepoint representation yet.
+    return (text.encode() + b'!').decode()
+
+def first_index(text):
+    def run():
+        for i in range(50):
+            s = fresh(text)
+            s[len(s) // 2]
+    return run
+
+def random_access(text):
+    s = fresh(text)
+    n = len(s)
+    def run():
+        j = 0
+        for i in range(200000):
+            j = (j * 7919 + 13) % n
+            s[j]
+    return run
+
+def sequential(text):
+    s = fresh(text)
+    def run():
+        for i in range(len(s)):
+            s[i]
+    return run
+
+def slices(text):
+    s = fresh(text)
+    n = len(s)
+    def run():
+        for i in range(0, n - 100, 97):
+            s[i:i+100]
+    return run
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(first_index(cjk), number=1) for x in range(5)), 'str index first cjk')
+    print(min(timeit(first_index(mixed), number=1) for x in range(5)), 'str index first mixed')
+    print(min(timeit(random_access(cjk), number=1) for x in range(5)), 'str index random cjk')
+    print(min(timeit(sequential(mixed), number=1) for x in range(5)), 'str index sequential mixed')
+    print(min(timeit(slices(cjk), number=1) for x in range(5)), 'str slice cjk')
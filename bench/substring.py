@@ -0,0 +1,30 @@
+# Substring search across needle lengths, on log-like text.
+line = 'INFO 2024-01-01 12:00:00 worker-3 request handled in 12ms path=/api/v1/items status=200\n'
+text = line * 2000 + 'ERROR 2024-01-01 12:00:01 worker-7 connection reset by peer path=/api/v1/upload\n'
+needles = ['E', 'ER', 'ERROR', 'connection reset', 'worker-7 connection reset by peer path=/api/v1/upload']
+
+def contains(needle):
+    def run():
+        for i in range(20):
+            needle in text
+    return run
+
+def split_lines():
+    for i in range(20):
+        text.split('\n')
+
+def replace_paths():
+    for i in range(20):
+        text.replace('/api/v1/', '/api/v2/')
+
+def count_status():
+    for i in range(20):
+        text.count('status=200')
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    for needle in needles:
+        print(min(timeit(contains(needle), number=1) for x in range(5)), 'substring contains, needle length', len(needle))
+    print(min(timeit(split_lines, number=1) for x in range(5)), 'substring split lines')
+    print(min(timeit(replace_paths, number=1) for x in range(5)), 'substring replace')
+    print(min(timeit(count_status, number=1) for x in range(5)), 'substring count')
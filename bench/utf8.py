@@ -0,0 +1,29 @@
+# Creating strings from bytes: validation, codepoint counting, and expansion for indexing.
+ascii = ('The quick brown fox jumps over the lazy dog. ' * 20000).encode()
+mixed = ('Ünïcödé téxt wïth sömé äccénts, mostly plain ASCII otherwise. ' * 15000).encode()
+cjk = ('日本語のテキストと漢字、ひらがな、カタカナ。' * 10000).encode()
+
+# Each string is made unique so it is not found already interned.
+suffixes = [str(i).encode() for i in range(100)]
+
+def decode(data):
+    def run():
+        for suffix in suffixes:
+            s = (data + suffix).decode()
+    return run
+
+def index(data):
+    def run():
+        for suffix in suffixes:
+            # Indexing a new string builds its codepoint array.
+            s = (data + suffix).decode()
+            s[len(s) // 2]
+    return run
+
+if __name__ == '__main__':
+    from fasttimer import timeit
+    print(min(timeit(decode(ascii), number=1) for x in range(5)), 'utf8 decode ascii')
+    print(min(timeit(decode(mixed), number=1) for x in range(5)), 'utf8 decode mixed')
+    print(min(timeit(decode(cjk), number=1) for x in range(5)), 'utf8 decode cjk')
+    print(min(timeit(index(mixed), number=1) for x in range(5)), 'utf8 index mixed')
+    print(min(timeit(index(cjk), number=1) for x in range(5)), 'utf8 index cjk')
@@ -22,6 +22,12 @@ KrkValue krk_dirObject(int argc, const KrkValue argv[], int hasKw) {
 	if (IS_INSTANCE(argv[0])) {
 		/* Obtain self-reference */
 		KrkInstance * self = AS_INSTANCE(argv[0]);
+		if (self->fields.split) {
+			for (size_t i = 0; i < self->fields.count; ++i) {
+				krk_writeValueArray(AS_LIST(myList),
+					self->fields.split->keys->entries[i].key);
+			}
+		}
 		for (size_t i = 0; i < self->fields.capacity; ++i) {
 			if (!IS_KWARGS(self->fields.entries[i].key)) {
 				krk_writeValueArray(AS_LIST(myList),
@@ -93,6 +99,8 @@ KRK_Method(object,__class__) {
 		if (!IS_CLASS(argv[1])) return krk_runtimeError(vm.exceptions->typeError, "'%T' object is not a class", argv[1]);
 		if (!IS_INSTANCE(argv[0]) || current->allocSize != sizeof(KrkInstance)) return krk_runtimeError(vm.exceptions->typeError, "'%T' object does not have modifiable type", argv[0]); /* TODO class? */
 		if (AS_CLASS(argv[1])->allocSize != sizeof(KrkInstance)) return krk_runtimeError(vm.exceptions->typeError, "'%S' type is not assignable", AS_CLASS(argv[1])->name);
+		/* The old class owns the key layout, so stop sharing it. */
+		krk_tableUnshare(&AS_INSTANCE(argv[0])->fields);
 		AS_INSTANCE(argv[0])->_class = AS_CLASS(argv[1]);
 		current = AS_CLASS(argv[1]);
 	}
@@ -380,11 +388,6 @@ KRK_Function(bin) {
 	return TYPE_ERROR(int,argv[0]);
 }
 
-#define KRK_STRING_FAST(string,offset)  (uint32_t)\
-	((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) <= (KRK_OBJ_FLAGS_STRING_UCS1) ? ((uint8_t*)string->codes)[offset] : \
-	((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == (KRK_OBJ_FLAGS_STRING_UCS2) ? ((uint16_t*)string->codes)[offset] : \
-	((uint32_t*)string->codes)[offset]))
-
 int krk_unpackIterable(KrkValue iterable, void * context, int callback(void *, const KrkValue *, size_t)) {
 	if (IS_TUPLE(iterable)) {
 		if (callback(context, AS_TUPLE(iterable)->values.values, AS_TUPLE(iterable)->values.count)) return 1;
@@ -397,7 +400,7 @@ int krk_unpackIterable(KrkValue iterable, void * context, int callback(void *, c
 			}
 		}
 	} else if (IS_STRING(iterable)) {
-		krk_unicodeString(AS_STRING(iterable));
+		krk_unicodeIndex(AS_STRING(iterable));
 		for (size_t i = 0; i < AS_STRING(iterable)->codesLength; ++i) {
 			KrkValue s = krk_string_get(2, (KrkValue[]){iterable,INTEGER_VAL(i)}, i);
 			if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return 1;
@@ -748,11 +751,36 @@ KRK_Method(enumerate,__call__) {
 	return out;
 }
 
+/**
+ * Runs of numbers are added without dispatch: ints in a machine word until
+ * it would overflow, and anything involving a float in a double, in the same
+ * order as the generic loop so that the result does not change.
+ */
 static int _sum_callback(void * context, const KrkValue * values, size_t count) {
 	struct SimpleContext * _context = context;
-	for (size_t i = 0; i < count; ++i) {
+	size_t i = 0;
+	while (i < count) {
+		if (IS_INTEGER(_context->base) && IS_INTEGER(values[i])) {
+			int64_t total = AS_INTEGER(_context->base);
+			for (; i < count && IS_INTEGER(values[i]); ++i) {
+				int64_t next;
+				if (__builtin_add_overflow(total, AS_INTEGER(values[i]), &next)) break;
+				total = next;
+			}
+			_context->base = krk_int_from_ll(total);
+			if (i == count || !IS_INTEGER(values[i])) continue;
+		}
+#ifndef KRK_NO_FLOAT
+		else if (krk_isNumber(_context->base) && krk_isNumber(values[i]) && (IS_FLOATING(_context->base) || IS_FLOATING(values[i]))) {
+			double total = krk_numberAsDouble(_context->base);
+			for (; i < count && krk_isNumber(values[i]); ++i) total += krk_numberAsDouble(values[i]);
+			_context->base = FLOATING_VAL(total);
+			continue;
+		}
+#endif
 		_context->base = krk_operator_add(_context->base, values[i]);
 		if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return 1;
+		i++;
 	}
 	return 0;
 }
@@ -770,7 +798,9 @@ static int _min_callback(void * context, const KrkValue * values, size_t count)
 	struct SimpleContext * _context = context;
 	for (size_t i = 0; i < count; ++i) {
 		if (IS_KWARGS(_context->base)) _context->base = values[i];
-		else {
+		else if (krk_isNumber(values[i]) && krk_isNumber(_context->base)) {
+			if (krk_numbersLess(values[i], _context->base)) _context->base = values[i];
+		} else {
 			KrkValue check = krk_operator_lt(values[i], _context->base);
 			if (!IS_BOOLEAN(check)) return 1;
 			else if (AS_BOOLEAN(check) == 1) _context->base = values[i];
@@ -795,7 +825,9 @@ static int _max_callback(void * context, const KrkValue * values, size_t count)
 	struct SimpleContext * _context = context;
 	for (size_t i = 0; i < count; ++i) {
 		if (IS_KWARGS(_context->base)) _context->base = values[i];
-		else {
+		else if (krk_isNumber(values[i]) && krk_isNumber(_context->base)) {
+			if (krk_numbersLess(_context->base, values[i])) _context->base = values[i];
+		} else {
 			KrkValue check = krk_operator_gt(values[i], _context->base);
 			if (!IS_BOOLEAN(check)) return 1;
 			else if (AS_BOOLEAN(check) == 1) _context->base = values[i];
@@ -1273,6 +1305,32 @@ KRK_Function(abs) {
 	}
 }
 
+extern KrkValue krk_operator_pow (KrkValue a, KrkValue b);
+extern KrkValue krk_long_pow_mod (KrkValue base, KrkValue exp, KrkValue mod);
+KRK_Function(pow) {
+	KrkValue base, exp, mod = NONE_VAL();
+	if (!krk_parseArgs("VV|V", (const char*[]){"base","exp","mod"}, &base, &exp, &mod)) return NONE_VAL();
+	if (IS_NONE(mod)) return krk_operator_pow(base, exp);
+
+	KrkValue result = krk_long_pow_mod(base, exp, mod);
+	if (!IS_NOTIMPL(result)) return result;
+
+	/* Let other types provide a three-argument __pow__ */
+	KrkClass * type = krk_getType(base);
+	KrkValue method;
+	while (type) {
+		if (krk_tableGet(&type->methods, OBJECT_VAL(S("__pow__")), &method)) {
+			krk_push(method);
+			krk_push(base);
+			krk_push(exp);
+			krk_push(mod);
+			return krk_callStack(3);
+		}
+		type = type->base;
+	}
+	return krk_runtimeError(vm.exceptions->typeError, "unsupported operand types for pow(): '%T', '%T', '%T'", base, exp, mod);
+}
+
 KRK_Function(format) {
 	FUNCTION_TAKES_AT_LEAST(1);
 	FUNCTION_TAKES_AT_MOST(2);
@@ -1714,6 +1772,11 @@ void _createAndBind_builtins(void) {
 	BUILTIN_FUNCTION("abs", FUNC_NAME(krk,abs),
 		"@brief Obtain the absolute value of a numeric.\n"
 		"@arguments iterable");
+	BUILTIN_FUNCTION("pow", FUNC_NAME(krk,pow),
+		"@brief Raise a number to a power, optionally modulo a third.\n"
+		"@arguments base,exp,mod=None\n\n"
+		"With two arguments, this is the same as @c base**exp. With three integers, computes "
+		"@c base**exp%mod efficiently, and a negative @p exp takes the inverse of @p base modulo @p mod.");
 	BUILTIN_FUNCTION("format", FUNC_NAME(krk,format),
 		"@brief Format a value for string printing.\n"
 		"@arguments value[,format_spec]");
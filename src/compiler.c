@@ -814,6 +814,12 @@ static void number(struct GlobalState * state, int exprType, RewindState *rewind
 	/* If we got here, it's an integer of some sort. */
 	KrkValue result = krk_parse_int(start, state->parser.previous.literalWidth, 0);
 	if (IS_NONE(result)) {
+		if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) {
+			/* Over the digit limit; report it against the literal instead */
+			krk_currentThread.flags &= ~KRK_THREAD_HAS_EXCEPTION;
+			error("integer literal exceeds the limit of %zu digits; use a hexadecimal literal", vm.maxIntStrDigits);
+			return;
+		}
 		error("invalid numeric literal");
 		return;
 	}
@@ -2900,6 +2906,7 @@ static void string(struct GlobalState * state, int exprType, RewindState *rewind
 	}
 
 	int formatElements = 0;
+	int formatValues = 0;
 
 	/* This should capture everything but the quotes. */
 	do {
@@ -3048,6 +3055,7 @@ static void string(struct GlobalState * state, int exprType, RewindState *rewind
 				}
 
 				EMIT_OPERAND_OP(OP_FORMAT_VALUE, formatType);
+				formatValues++;
 
 				if (*c != '}') {
 					error("Expected closing '}' after expression in f-string");
@@ -3090,7 +3098,8 @@ _nextStr:
 		emitConstant(krk_finishStringBuilder(&sb));
 		formatElements++;
 	}
-	if (formatElements != 1) {
+	/* OP_FORMAT_VALUE leaves simple values for OP_MAKE_STRING to convert, so always finish with it. */
+	if (formatElements != 1 || formatValues) {
 		EMIT_OPERAND_OP(OP_MAKE_STRING, formatElements);
 	}
 _cleanupError:
@@ -50,6 +50,10 @@ typedef struct KrkObj {
 #define KRK_OBJ_FLAGS_STRING_UCS1   0x0001
 #define KRK_OBJ_FLAGS_STRING_UCS2   0x0002
 #define KRK_OBJ_FLAGS_STRING_UCS4   0x0003
+#define KRK_OBJ_FLAGS_STRING_INDEXED 0x0004
+#define KRK_OBJ_FLAGS_STRING_SLICE  0x0008
+
+#define KRK_OBJ_FLAGS_BYTES_SLICE   0x0001
 
 #define KRK_OBJ_FLAGS_CODEOBJECT_COLLECTS_ARGS 0x0001
 #define KRK_OBJ_FLAGS_CODEOBJECT_COLLECTS_KWS  0x0002
@@ -205,6 +209,28 @@ typedef struct {
 
 typedef void (*KrkCleanupCallback)(struct KrkInstance *);
 
+/**
+ * @brief Memory exported by an object through the buffer protocol.
+ *
+ * The pointer is only valid until the exporting object is next modified
+ * or may have been collected, so it should be requested again rather
+ * than stored across calls into the VM.
+ */
+typedef struct {
+	void * buf;           /**< @brief Start of the exported memory */
+	size_t len;           /**< @brief Length of the exported memory in bytes */
+	size_t itemsize;      /**< @brief Size of one item in bytes */
+	const char * format;  /**< @brief Item type, as a format character of the @c struct module */
+	int readonly;         /**< @brief Set if the memory must not be modified */
+} KrkBuffer;
+
+/**
+ * @brief Fill in a buffer description for an object.
+ *
+ * Returns 1 on success. On failure, returns 0 with an exception set.
+ */
+typedef int (*KrkBufferCallback)(KrkValue, KrkBuffer *);
+
 /**
  * @brief Type object.
  * @extends KrkObj
@@ -268,6 +294,8 @@ typedef struct KrkClass {
 	KrkObj * _bool;
 
 	size_t cacheIndex;
+	KrkTable * sharedKeys;    /**< @brief Attribute names shared by instances' fields tables, or NULL if they are private */
+	KrkBufferCallback _getbuffer; /**< @brief C function to export the memory of an instance of this class, see krk_getBuffer */
 } KrkClass;
 
 /**
@@ -336,7 +364,9 @@ typedef struct {
 	KrkInstance inst;     /**< @protected @brief Base */
 	KrkValueArray values; /**< @brief Stores the length, capacity, and actual values of the list */
 #ifndef KRK_DISABLE_THREADS
-	pthread_rwlock_t rwlock;
+	unsigned int rwlock;  /**< @private @brief Reader count and writer flag, see @ref _krk_rwlock_rdlock */
+	unsigned int rwdepth; /**< @private @brief Nested acquisitions by the thread holding the write lock */
+	void * rwowner;       /**< @private @brief Thread state of the writer, or NULL */
 #endif
 } KrkList;
 
@@ -460,7 +490,8 @@ extern KrkString * krk_copyString(const char * chars, size_t length);
  * Obtain an untyped pointer to the codepoint representation of a string.
  * If the string does not have a codepoint representation allocated, it will
  * be generated by this function and remain with the string for the duration
- * of its lifetime.
+ * of its lifetime. Long strings that were prepared for indexing keep their
+ * offset table, so the array returned may not be @c string->codes.
  *
  * @param string String to obtain the codepoint representation of.
  * @return A pointer to the bytes of the codepoint representation.
@@ -618,6 +649,21 @@ extern KrkTuple *       krk_newTuple(size_t length);
  */
 extern KrkBytes *       krk_newBytes(size_t length, uint8_t * source);
 
+/**
+ * @brief Obtain the memory backing a bytes-like object.
+ *
+ * Supports @c bytes and any class which provides a @c _getbuffer callback,
+ * such as @c bytearray and @c memoryview. If @p writable is set, read-only
+ * buffers are rejected.
+ *
+ * @param value    Object to export memory from.
+ * @param buffer   Description of the memory, filled in on success.
+ * @param writable Whether the caller intends to modify the memory.
+ * @return 1 on success, 0 with a @c TypeError set if the object does not
+ *         support the buffer protocol or is not writable.
+ */
+extern int krk_getBuffer(KrkValue value, KrkBuffer * buffer, int writable);
+
 #define krk_isObjType(v,t) (IS_OBJECT(v) && (AS_OBJECT(v)->type == (t)))
 #define OBJECT_TYPE(value) (AS_OBJECT(value)->type)
 #define IS_STRING(value)   krk_isObjType(value, KRK_OBJ_STRING)
@@ -22,15 +22,35 @@ typedef struct {
 	KrkValue value;
 } KrkTableEntry;
 
+/**
+ * @brief Values of a table whose keys are shared with other tables.
+ *
+ * Instances of the same class tend to have the same attributes, assigned
+ * in the same order. Rather than each keeping its own copy of the keys,
+ * their attribute tables point to an append-only layout owned by the class
+ * which maps each key to a position, and store only the values for the
+ * first @c count keys of that layout.
+ */
+typedef struct KrkSplitValues {
+	struct KrkTable * keys; /**< Shared layout; each key maps to its position as an integer */
+	size_t capacity;        /**< Allocated size of @c values */
+	KrkValue values[];      /**< Values, in layout order */
+} KrkSplitValues;
+
 /**
  * @brief Simple hash table of arbitrary keys to values.
+ *
+ * When @c split is set, the table is empty as far as @c capacity, @c used,
+ * @c entries and @c indexes are concerned and its @c count items live in
+ * the split values instead; the table API handles both representations.
  */
-typedef struct {
+typedef struct KrkTable {
 	size_t count;            /**< Number of actual items in the dict. */
 	size_t capacity;         /**< Size (in items) of each of the entries/indexes arrays */
 	size_t used;             /**< Next insertion index in the entries array */
 	KrkTableEntry * entries; /**< Key-value pairs, in insertion order (with KWARGS_VAL(0) gaps) */
-	ssize_t * indexes;       /**< Actual hash map: indexes into the key-value pairs. */
+	ssize_t * indexes;       /**< Actual hash map: indexes into the key-value pairs, or NULL for small tables searched linearly. */
+	KrkSplitValues * split;  /**< Values for a table with shared keys, or NULL */
 } KrkTable;
 
 /**
@@ -45,6 +65,31 @@ typedef struct {
  */
 extern void krk_initTable(KrkTable * table);
 
+/**
+ * @brief Initialize a hash table that shares its key layout.
+ * @memberof KrkTable
+ *
+ * Sets up @p table to store only values, with keys taken from @p keys,
+ * which must outlive it. Assignments that follow the order of the layout
+ * append to it; anything else, such as deleting a key, using a non-string
+ * key, or assigning keys in a different order, converts the table to a
+ * private one transparently.
+ *
+ * @param table Hash table to initialize.
+ * @param keys  Shared key layout, itself a table.
+ */
+extern void krk_initTableShared(KrkTable * table, KrkTable * keys);
+
+/**
+ * @brief Give a table with shared keys its own private copy of them.
+ * @memberof KrkTable
+ *
+ * Does nothing for tables that are already private.
+ *
+ * @param table Hash table to convert.
+ */
+extern void krk_tableUnshare(KrkTable * table);
+
 /**
  * @brief Release resources associated with a hash table.
  * @memberof KrkTable
@@ -167,6 +212,19 @@ extern int krk_tableDeleteExact(KrkTable * table, KrkValue key);
  */
 extern int krk_hashValue(KrkValue value, uint32_t *hashOut);
 
+/**
+ * @brief Calculate the hash of a sequence of bytes.
+ *
+ * This is the hash used for the contents of strings and bytes objects.
+ * It is keyed with a random per-process seed, so results will differ
+ * between runs unless @c KUROKO_HASH_SEED is set in the environment.
+ *
+ * @param data   Bytes to hash.
+ * @param length Number of bytes.
+ * @return An unsigned 32-bit hash value.
+ */
+extern uint32_t krk_hashBytes(const void * data, size_t length);
+
 /**
  * @brief Preset the size of a table.
  * @memberof KrkTable
@@ -178,6 +236,21 @@ extern int krk_hashValue(KrkValue value, uint32_t *hashOut);
  */
 extern void krk_tableAdjustCapacity(KrkTable * table, size_t capacity);
 
+/**
+ * @brief Remove tombstones from a table and release unused space.
+ * @memberof KrkTable
+ *
+ * Rebuilds the table without the entries left behind by deletions,
+ * shrinking it if it holds far fewer entries than its capacity.
+ * Tables are also compacted automatically when an insertion would
+ * otherwise need to grow them, but deletions never move entries, so
+ * this must not be called while something iterates over the table
+ * by index and deletes from it.
+ *
+ * @param table Table to compact.
+ */
+extern void krk_tableCompact(KrkTable * table);
+
 /**
  * @brief Update the value of a table entry only if it is found.
  * @memberof KrkTable
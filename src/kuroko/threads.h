@@ -27,6 +27,42 @@ static inline void _krk_internal_spin_unlock(int volatile * lock) {
 #define _obtain_lock(v)  _krk_internal_spin_lock(&v);
 #define _release_lock(v) _krk_internal_spin_unlock(&v);
 
+/**
+ * @brief Compact reader-writer lock.
+ *
+ * A single word holding the number of readers in its low bits and a writer
+ * flag in its top bit; zero is unlocked. Uncontended acquisitions are one
+ * atomic operation, and waiters yield like the spin lock above.
+ *
+ * The word does not record an owner, so a thread that already holds the
+ * lock and tries to take it again will spin forever. Callers that can
+ * re-enter must track the writing thread themselves, as lists do.
+ */
+#define KRK_RWLOCK_WRITER 0x80000000U
+
+static inline void _krk_rwlock_rdlock(unsigned int * lock) {
+	while (__atomic_fetch_add(lock, 1, __ATOMIC_ACQUIRE) & KRK_RWLOCK_WRITER) {
+		__atomic_fetch_sub(lock, 1, __ATOMIC_RELAXED);
+		while (__atomic_load_n(lock, __ATOMIC_RELAXED) & KRK_RWLOCK_WRITER) sched_yield();
+	}
+}
+
+static inline void _krk_rwlock_wrlock(unsigned int * lock) {
+	unsigned int expected = 0;
+	while (!__atomic_compare_exchange_n(lock, &expected, KRK_RWLOCK_WRITER, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		expected = 0;
+		sched_yield();
+	}
+}
+
+static inline void _krk_rwlock_rdunlock(unsigned int * lock) {
+	__atomic_fetch_sub(lock, 1, __ATOMIC_RELEASE);
+}
+
+static inline void _krk_rwlock_wrunlock(unsigned int * lock) {
+	__atomic_fetch_sub(lock, KRK_RWLOCK_WRITER, __ATOMIC_RELEASE);
+}
+
 #else
 
 #define _obtain_lock(v)
@@ -29,6 +29,14 @@
  */
 #define KRK_THREAD_SCRATCH_SIZE 3
 
+/**
+ * @def KRK_THREAD_FORMAT_CACHE_SIZE
+ * @brief Number of parsed str.format templates each thread keeps.
+ *
+ * Must be a power of two; templates are cached by the hash of their format string.
+ */
+#define KRK_THREAD_FORMAT_CACHE_SIZE 16
+
 /**
  * @brief Represents a managed call state in a VM thread.
  *
@@ -138,6 +146,7 @@ struct BaseClasses {
 	KrkClass * ThreadClass;          /**< Threading.Thread */
 	KrkClass * LockClass;            /**< Threading.Lock */
 	KrkClass * ellipsisClass;        /**< Type of the Ellipsis (...) singleton */
+	KrkClass * memoryviewClass;      /**< View of the memory of a bytes-like object */
 };
 
 /**
@@ -167,6 +176,7 @@ typedef struct KrkThreadState {
 	KrkValue * stackMax;       /**< End of allocated stack space. */
 
 	KrkValue scratchSpace[KRK_THREAD_SCRATCH_SIZE]; /**< A place to store a few values to keep them from being prematurely GC'd. */
+	KrkValue formatCache[KRK_THREAD_FORMAT_CACHE_SIZE]; /**< Recently parsed str.format templates. */
 } KrkThreadState;
 
 /**
@@ -198,6 +208,9 @@ typedef struct KrkVM {
 
 	KrkThreadState * threads;         /**< Invasive linked list of all VM threads. */
 	struct DebuggerState * dbgState;  /**< Opaque debugger state pointer. */
+	uint64_t hashSeed;                /**< Key for hashing strings, bytes, and numbers; random unless KUROKO_HASH_SEED is set */
+	size_t maxIntStrDigits;           /**< Most decimal digits allowed when converting between int and str; 0 for no limit */
+	size_t sortThreads;               /**< Most threads list.sort may use for very large lists; 1 to always sort on the calling thread */
 } KrkVM;
 
 /* Thread-specific flags */
@@ -205,8 +205,12 @@ static void freeObject(KrkObj * object) {
 	switch (object->type) {
 		case KRK_OBJ_STRING: {
 			KrkString * string = (KrkString*)object;
+			krk_unicodeFree(string);
+			if (string->obj.flags & KRK_OBJ_FLAGS_STRING_SLICE) {
+				FREE_OBJECT(KrkStringSlice, object);
+				break;
+			}
 			KRK_FREE_ARRAY(char, string->chars, string->length + 1);
-			if (string->codes && string->codes != string->chars) free(string->codes);
 			FREE_OBJECT(KrkString, object);
 			break;
 		}
@@ -241,6 +245,10 @@ static void freeObject(KrkObj * object) {
 			KrkClass * _class = (KrkClass*)object;
 			krk_freeTable(&_class->methods);
 			krk_freeTable(&_class->subclasses);
+			if (_class->sharedKeys) {
+				krk_freeTable(_class->sharedKeys);
+				KRK_FREE_ARRAY(KrkTable, _class->sharedKeys, 1);
+			}
 			if (_class->base) {
 				krk_tableDeleteExact(&_class->base->subclasses, OBJECT_VAL(object));
 			}
@@ -267,6 +275,10 @@ static void freeObject(KrkObj * object) {
 		}
 		case KRK_OBJ_BYTES: {
 			KrkBytes * bytes = (KrkBytes*)object;
+			if (bytes->obj.flags & KRK_OBJ_FLAGS_BYTES_SLICE) {
+				FREE_OBJECT(KrkBytesSlice, bytes);
+				break;
+			}
 			KRK_FREE_ARRAY(uint8_t, bytes->bytes, bytes->length);
 			FREE_OBJECT(KrkBytes, bytes);
 			break;
@@ -380,6 +392,7 @@ static void blackenObject(KrkObj * object) {
 			krk_markObject((KrkObj*)_class->base);
 			krk_markObject((KrkObj*)_class->_class);
 			krk_markTable(&_class->methods);
+			if (_class->sharedKeys) krk_markTable(_class->sharedKeys);
 			break;
 		}
 		case KRK_OBJ_INSTANCE: {
@@ -399,9 +412,13 @@ static void blackenObject(KrkObj * object) {
 			markArray(&tuple->values);
 			break;
 		}
-		case KRK_OBJ_NATIVE:
 		case KRK_OBJ_STRING:
+			if (object->flags & KRK_OBJ_FLAGS_STRING_SLICE) krk_markObject(((KrkStringSlice*)object)->parent);
+			break;
 		case KRK_OBJ_BYTES:
+			if (object->flags & KRK_OBJ_FLAGS_BYTES_SLICE) krk_markObject(((KrkBytesSlice*)object)->parent);
+			break;
+		case KRK_OBJ_NATIVE:
 			break;
 	}
 }
@@ -442,6 +459,12 @@ static size_t sweep(void) {
 }
 
 void krk_markTable(KrkTable * table) {
+	if (table->split) {
+		for (size_t i = 0; i < table->count; ++i) {
+			krk_markValue(table->split->values[i]);
+		}
+		return;
+	}
 	for (size_t i = 0; i < table->used; ++i) {
 		KrkTableEntry * entry = &table->entries[i];
 		krk_markValue(entry->key);
@@ -472,6 +495,10 @@ static void markThreadRoots(KrkThreadState * thread) {
 	for (int i = 0; i < KRK_THREAD_SCRATCH_SIZE; ++i) {
 		krk_markValue(thread->scratchSpace[i]);
 	}
+
+	for (int i = 0; i < KRK_THREAD_FORMAT_CACHE_SIZE; ++i) {
+		krk_markValue(thread->formatCache[i]);
+	}
 }
 
 static void markRoots(void) {
@@ -0,0 +1,716 @@
+/**
+ * @file    module__collections.c
+ * @brief   Native implementation of collections.deque.
+ *
+ * A deque is a doubly-linked list of fixed-size blocks of values, as in
+ * CPython: appends and pops at either end touch only the end blocks, and a
+ * new block is allocated (or an empty one released) once every
+ * @c DEQUE_BLOCK operations. Indexing walks blocks from the nearer end.
+ *
+ * Operations that call back into the VM (comparisons and reprs) check the
+ * deque's mutation counter afterwards, as the callee may have changed it
+ * and released the block being walked.
+ */
+#include <limits.h>
+#include <kuroko/vm.h>
+#include <kuroko/util.h>
+#include <kuroko/memory.h>
+
+static KrkClass * deque;
+static KrkClass * dequeiterator;
+
+/** Values per block; an empty deque starts in the middle of its block. */
+#define DEQUE_BLOCK  64
+#define DEQUE_CENTER ((DEQUE_BLOCK - 1) / 2)
+
+struct DequeBlock {
+	struct DequeBlock * prev;
+	struct DequeBlock * next;
+	KrkValue values[DEQUE_BLOCK];
+};
+
+/**
+ * @brief Deque object.
+ *
+ * The items are @c left->values[leftIndex] through @c right->values[rightIndex].
+ * An empty deque has no blocks, or a single block with @c leftIndex one past
+ * @c rightIndex. A zeroed object is a valid, empty, unbounded deque.
+ */
+struct Deque {
+	KrkInstance inst;
+	struct DequeBlock * left;
+	struct DequeBlock * right;
+	size_t leftIndex;
+	size_t rightIndex;
+	size_t count;
+	size_t maxlen;
+	int bounded;
+	size_t state; /**< Incremented on every change, to detect mutation during iteration */
+};
+
+struct DequeIterator {
+	KrkInstance inst;
+	KrkValue deque;
+	struct DequeBlock * block;
+	size_t index;
+	size_t remaining;
+	size_t state;
+};
+
+#define IS_deque(o) (krk_isInstanceOf(o,deque))
+#define AS_deque(o) ((struct Deque*)AS_OBJECT(o))
+#define CURRENT_CTYPE struct Deque *
+#define CURRENT_NAME  self
+
+/** @brief Position of an item, for walking through a deque in order. */
+struct DequeCursor {
+	struct DequeBlock * block;
+	size_t index;
+};
+
+/** @brief Find item @p i, walking from the nearer end. */
+static struct DequeCursor _seek(struct Deque * self, size_t i) {
+	if (i < self->count / 2) {
+		struct DequeBlock * block = self->left;
+		size_t index = self->leftIndex + i;
+		while (index >= DEQUE_BLOCK) {
+			block = block->next;
+			index -= DEQUE_BLOCK;
+		}
+		return (struct DequeCursor){block, index};
+	}
+	struct DequeBlock * block = self->right;
+	ssize_t index = (ssize_t)self->rightIndex - (ssize_t)(self->count - 1 - i);
+	while (index < 0) {
+		block = block->prev;
+		index += DEQUE_BLOCK;
+	}
+	return (struct DequeCursor){block, index};
+}
+
+static KrkValue * _slot(struct Deque * self, size_t i) {
+	struct DequeCursor cursor = _seek(self, i);
+	return &cursor.block->values[cursor.index];
+}
+
+/** @brief Return the item under the cursor and advance it; the block is only valid while the deque is unchanged. */
+static inline KrkValue _next(struct DequeCursor * cursor) {
+	KrkValue value = cursor->block->values[cursor->index];
+	if (++cursor->index == DEQUE_BLOCK) {
+		cursor->block = cursor->block->next;
+		cursor->index = 0;
+	}
+	return value;
+}
+
+static struct DequeBlock * _newBlock(void) {
+	struct DequeBlock * block = krk_reallocate(NULL, 0, sizeof(struct DequeBlock));
+	block->prev = NULL;
+	block->next = NULL;
+	return block;
+}
+
+static void _freeBlock(struct DequeBlock * block) {
+	krk_reallocate(block, sizeof(struct DequeBlock), 0);
+}
+
+static void _deque_gcscan(KrkInstance * _self) {
+	struct Deque * self = (struct Deque*)_self;
+	struct DequeCursor cursor = {self->left, self->leftIndex};
+	for (size_t i = 0; i < self->count; ++i) {
+		krk_markValue(_next(&cursor));
+	}
+}
+
+static void _freeBlocks(struct Deque * self) {
+	struct DequeBlock * block = self->left;
+	while (block) {
+		struct DequeBlock * next = block->next;
+		_freeBlock(block);
+		block = next;
+	}
+	self->left = self->right = NULL;
+	self->count = 0;
+	self->state++;
+}
+
+static void _deque_gcsweep(KrkInstance * _self) {
+	_freeBlocks((struct Deque*)_self);
+}
+
+/**
+ * @brief Make sure there is a block to put the first item in.
+ *
+ * Allocating may run the collector, so every change to the deque's links
+ * happens after the allocation, while the deque is still consistent.
+ */
+static void _start(struct Deque * self) {
+	if (!self->left) {
+		struct DequeBlock * block = _newBlock();
+		self->left = self->right = block;
+	}
+	self->leftIndex = DEQUE_CENTER + 1;
+	self->rightIndex = DEQUE_CENTER;
+}
+
+/* The raw operations below ignore maxlen; pops require a non-empty deque. */
+
+static void _append(struct Deque * self, KrkValue value) {
+	if (!self->count) _start(self);
+	if (self->rightIndex == DEQUE_BLOCK - 1) {
+		struct DequeBlock * block = _newBlock();
+		block->prev = self->right;
+		self->right->next = block;
+		self->right = block;
+		self->rightIndex = 0;
+	} else {
+		self->rightIndex++;
+	}
+	self->right->values[self->rightIndex] = value;
+	self->count++;
+	self->state++;
+}
+
+static void _appendleft(struct Deque * self, KrkValue value) {
+	if (!self->count) _start(self);
+	if (self->leftIndex == 0) {
+		struct DequeBlock * block = _newBlock();
+		block->next = self->left;
+		self->left->prev = block;
+		self->left = block;
+		self->leftIndex = DEQUE_BLOCK - 1;
+	} else {
+		self->leftIndex--;
+	}
+	self->left->values[self->leftIndex] = value;
+	self->count++;
+	self->state++;
+}
+
+static KrkValue _pop(struct Deque * self) {
+	KrkValue value = self->right->values[self->rightIndex];
+	self->count--;
+	self->state++;
+	if (!self->count) {
+		_start(self);
+	} else if (self->rightIndex == 0) {
+		struct DequeBlock * block = self->right;
+		self->right = block->prev;
+		self->right->next = NULL;
+		self->rightIndex = DEQUE_BLOCK - 1;
+		_freeBlock(block);
+	} else {
+		self->rightIndex--;
+	}
+	return value;
+}
+
+static KrkValue _popleft(struct Deque * self) {
+	KrkValue value = self->left->values[self->leftIndex];
+	self->count--;
+	self->state++;
+	if (!self->count) {
+		_start(self);
+	} else if (self->leftIndex == DEQUE_BLOCK - 1) {
+		struct DequeBlock * block = self->left;
+		self->left = block->next;
+		self->left->prev = NULL;
+		self->leftIndex = 0;
+		_freeBlock(block);
+	} else {
+		self->leftIndex++;
+	}
+	return value;
+}
+
+/** @brief Append, dropping an item from the other end if the deque is full. */
+static void _appendBounded(struct Deque * self, KrkValue value) {
+	if (self->bounded && !self->maxlen) return;
+	_append(self, value);
+	if (self->bounded && self->count > self->maxlen) _popleft(self);
+}
+
+static void _appendleftBounded(struct Deque * self, KrkValue value) {
+	if (self->bounded && !self->maxlen) return;
+	_appendleft(self, value);
+	if (self->bounded && self->count > self->maxlen) _pop(self);
+}
+
+/**
+ * @brief Rotate @p n steps to the right; negative values rotate left.
+ *
+ * Each step moves one item between the ends; the item is written to its
+ * new end before it is removed from the old one, so it stays reachable
+ * if adding the item allocates a block.
+ */
+static void _rotate(struct Deque * self, ssize_t n) {
+	if (self->count < 2) return;
+	ssize_t count = self->count;
+	n %= count;
+	if (n > count / 2) n -= count;
+	else if (n < -(count / 2)) n += count;
+	for (; n > 0; --n) {
+		_appendleft(self, self->right->values[self->rightIndex]);
+		_pop(self);
+	}
+	for (; n < 0; ++n) {
+		_append(self, self->left->values[self->leftIndex]);
+		_popleft(self);
+	}
+}
+
+static int _wrapIndex(struct Deque * self, KrkValue value, size_t * out) {
+	if (!IS_INTEGER(value)) {
+		krk_runtimeError(vm.exceptions->typeError, "sequence index must be integer, not '%T'", value);
+		return 0;
+	}
+	krk_integer_type index = AS_INTEGER(value);
+	if (index < 0) index += self->count;
+	if (index < 0 || index >= (krk_integer_type)self->count) {
+		krk_runtimeError(vm.exceptions->indexError, "deque index out of range");
+		return 0;
+	}
+	*out = index;
+	return 1;
+}
+
+/** @brief Remove item @p i by rotating it to the left end. */
+static void _delete(struct Deque * self, size_t i) {
+	_rotate(self, -(ssize_t)i);
+	_popleft(self);
+	_rotate(self, i);
+}
+
+/**
+ * @brief Position of the first item in [start, stop) equal to @p value.
+ *
+ * Returns -1 if there is none, or -2 with an exception set if a comparison
+ * raised or changed the deque.
+ */
+static ssize_t _search(struct Deque * self, KrkValue value, size_t start, size_t stop) {
+	if (start >= self->count) return -1;
+	size_t state = self->state;
+	struct DequeCursor cursor = _seek(self, start);
+	for (size_t i = start; i < stop && i < self->count; ++i) {
+		int same = krk_valuesSameOrEqual(_next(&cursor), value);
+		if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return -2;
+		if (state != self->state) {
+			krk_runtimeError(vm.exceptions->Exception, "deque mutated during iteration");
+			return -2;
+		}
+		if (same) return i;
+	}
+	return -1;
+}
+
+static int _extend_callback(void * context, const KrkValue * values, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		_appendBounded(context, values[i]);
+	}
+	return 0;
+}
+
+static int _extendleft_callback(void * context, const KrkValue * values, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		_appendleftBounded(context, values[i]);
+	}
+	return 0;
+}
+
+/** @brief Copy the items into a new list, for iterating over a deque while changing it. */
+static KrkValue _toList(struct Deque * self) {
+	KrkValue list = krk_list_of(0, NULL, 0);
+	krk_push(list);
+	KrkValueArray * values = AS_LIST(list);
+	values->values = KRK_GROW_ARRAY(KrkValue, values->values, 0, self->count);
+	values->capacity = self->count;
+	struct DequeCursor cursor = {self->left, self->leftIndex};
+	for (size_t i = 0; i < self->count; ++i) {
+		values->values[i] = _next(&cursor);
+	}
+	values->count = self->count;
+	return krk_pop();
+}
+
+static int _extend(struct Deque * self, KrkValue iterable, int left) {
+	if (krk_valuesSame(OBJECT_VAL(self), iterable)) iterable = _toList(self);
+	krk_push(iterable);
+	krk_unpackIterable(iterable, self, left ? _extendleft_callback : _extend_callback);
+	krk_pop();
+	return !(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION);
+}
+
+static struct Deque * _newDeque(KrkClass * type, struct Deque * like) {
+	struct Deque * out = (struct Deque*)krk_newInstance(type);
+	out->bounded = like->bounded;
+	out->maxlen = like->maxlen;
+	return out;
+}
+
+KRK_Method(deque,__init__) {
+	KrkValue iterable = NONE_VAL();
+	KrkValue maxlen = NONE_VAL();
+	if (!krk_parseArgs(".|VV:deque", (const char*[]){"iterable","maxlen"}, &iterable, &maxlen)) return NONE_VAL();
+	if (!IS_NONE(maxlen)) {
+		if (!IS_INTEGER(maxlen)) return TYPE_ERROR(int,maxlen);
+		if (AS_INTEGER(maxlen) < 0) return krk_runtimeError(vm.exceptions->valueError, "maxlen must be non-negative");
+	}
+	if (self->count) _freeBlocks(self);
+	self->bounded = !IS_NONE(maxlen);
+	self->maxlen = self->bounded ? (size_t)AS_INTEGER(maxlen) : 0;
+	if (!IS_NONE(iterable)) _extend(self, iterable, 0);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,maxlen) {
+	if (!self->bounded) return NONE_VAL();
+	return INTEGER_VAL(self->maxlen);
+}
+
+KRK_Method(deque,__len__) {
+	METHOD_TAKES_NONE();
+	return INTEGER_VAL(self->count);
+}
+
+KRK_Method(deque,append) {
+	METHOD_TAKES_EXACTLY(1);
+	_appendBounded(self, argv[1]);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,appendleft) {
+	METHOD_TAKES_EXACTLY(1);
+	_appendleftBounded(self, argv[1]);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,pop) {
+	METHOD_TAKES_NONE();
+	if (!self->count) return krk_runtimeError(vm.exceptions->indexError, "pop from an empty deque");
+	return _pop(self);
+}
+
+KRK_Method(deque,popleft) {
+	METHOD_TAKES_NONE();
+	if (!self->count) return krk_runtimeError(vm.exceptions->indexError, "pop from an empty deque");
+	return _popleft(self);
+}
+
+KRK_Method(deque,extend) {
+	METHOD_TAKES_EXACTLY(1);
+	_extend(self, argv[1], 0);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,extendleft) {
+	METHOD_TAKES_EXACTLY(1);
+	_extend(self, argv[1], 1);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,clear) {
+	METHOD_TAKES_NONE();
+	_freeBlocks(self);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,copy) {
+	METHOD_TAKES_NONE();
+	struct Deque * out = _newDeque(self->inst._class, self);
+	krk_push(OBJECT_VAL(out));
+	struct DequeCursor cursor = {self->left, self->leftIndex};
+	for (size_t i = 0; i < self->count; ++i) _append(out, _next(&cursor));
+	return krk_pop();
+}
+
+KRK_Method(deque,rotate) {
+	ssize_t n = 1;
+	if (!krk_parseArgs(".|n", (const char*[]){"n"}, &n)) return NONE_VAL();
+	_rotate(self, n);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,reverse) {
+	METHOD_TAKES_NONE();
+	if (self->count < 2) return NONE_VAL();
+	struct DequeBlock * lblock = self->left, * rblock = self->right;
+	size_t lindex = self->leftIndex, rindex = self->rightIndex;
+	for (size_t i = 0; i < self->count / 2; ++i) {
+		KrkValue tmp = lblock->values[lindex];
+		lblock->values[lindex] = rblock->values[rindex];
+		rblock->values[rindex] = tmp;
+		if (++lindex == DEQUE_BLOCK) {
+			lblock = lblock->next;
+			lindex = 0;
+		}
+		if (rindex-- == 0) {
+			rblock = rblock->prev;
+			rindex = DEQUE_BLOCK - 1;
+		}
+	}
+	self->state++;
+	return NONE_VAL();
+}
+
+KRK_Method(deque,__getitem__) {
+	METHOD_TAKES_EXACTLY(1);
+	size_t index;
+	if (!_wrapIndex(self, argv[1], &index)) return NONE_VAL();
+	return *_slot(self, index);
+}
+
+KRK_Method(deque,__setitem__) {
+	METHOD_TAKES_EXACTLY(2);
+	size_t index;
+	if (!_wrapIndex(self, argv[1], &index)) return NONE_VAL();
+	*_slot(self, index) = argv[2];
+	return argv[2];
+}
+
+KRK_Method(deque,__delitem__) {
+	METHOD_TAKES_EXACTLY(1);
+	size_t index;
+	if (!_wrapIndex(self, argv[1], &index)) return NONE_VAL();
+	_delete(self, index);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,insert) {
+	ssize_t index;
+	KrkValue value;
+	if (!krk_parseArgs(".nV", (const char*[]){"i","x"}, &index, &value)) return NONE_VAL();
+	if (self->bounded && self->count >= self->maxlen) return krk_runtimeError(vm.exceptions->indexError, "deque already at its maximum size");
+	ssize_t count = self->count;
+	if (index < 0) index = (index + count < 0) ? 0 : index + count;
+	if (index >= count) {
+		_append(self, value);
+	} else if (index == 0) {
+		_appendleft(self, value);
+	} else {
+		_rotate(self, -index);
+		_appendleft(self, value);
+		_rotate(self, index);
+	}
+	return NONE_VAL();
+}
+
+KRK_Method(deque,index) {
+	KrkValue value;
+	ssize_t start = 0, stop = SSIZE_MAX;
+	if (!krk_parseArgs(".V|nn", (const char*[]){"x","start","stop"}, &value, &start, &stop)) return NONE_VAL();
+	ssize_t count = self->count;
+	if (start < 0) start = (start + count < 0) ? 0 : start + count;
+	if (stop < 0) stop = (stop + count < 0) ? 0 : stop + count;
+	ssize_t found = _search(self, value, start, stop);
+	if (found == -2) return NONE_VAL();
+	if (found == -1) return krk_runtimeError(vm.exceptions->valueError, "%R is not in deque", value);
+	return INTEGER_VAL(found);
+}
+
+KRK_Method(deque,count) {
+	METHOD_TAKES_EXACTLY(1);
+	size_t state = self->state;
+	krk_integer_type count = 0;
+	struct DequeCursor cursor = {self->left, self->leftIndex};
+	for (size_t i = 0; i < self->count; ++i) {
+		if (krk_valuesSameOrEqual(_next(&cursor), argv[1])) count++;
+		if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+		if (state != self->state) return krk_runtimeError(vm.exceptions->Exception, "deque mutated during iteration");
+	}
+	return INTEGER_VAL(count);
+}
+
+KRK_Method(deque,remove) {
+	METHOD_TAKES_EXACTLY(1);
+	ssize_t found = _search(self, argv[1], 0, self->count);
+	if (found == -2) return NONE_VAL();
+	if (found == -1) return krk_runtimeError(vm.exceptions->valueError, "%R is not in deque", argv[1]);
+	_delete(self, found);
+	return NONE_VAL();
+}
+
+KRK_Method(deque,__contains__) {
+	METHOD_TAKES_EXACTLY(1);
+	ssize_t found = _search(self, argv[1], 0, self->count);
+	if (found == -2) return NONE_VAL();
+	return BOOLEAN_VAL(found >= 0);
+}
+
+KRK_Method(deque,__eq__) {
+	METHOD_TAKES_EXACTLY(1);
+	if (!IS_deque(argv[1])) return NOTIMPL_VAL();
+	struct Deque * other = AS_deque(argv[1]);
+	if (self->count != other->count) return BOOLEAN_VAL(0);
+	size_t state = self->state, otherState = other->state;
+	struct DequeCursor a = {self->left, self->leftIndex}, b = {other->left, other->leftIndex};
+	for (size_t i = 0; i < self->count; ++i) {
+		KrkValue left = _next(&a);
+		int same = krk_valuesSameOrEqual(left, _next(&b));
+		if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+		if (state != self->state || otherState != other->state) return krk_runtimeError(vm.exceptions->Exception, "deque mutated during iteration");
+		if (!same) return BOOLEAN_VAL(0);
+	}
+	return BOOLEAN_VAL(1);
+}
+
+KRK_Method(deque,__add__) {
+	METHOD_TAKES_EXACTLY(1);
+	if (!IS_deque(argv[1])) return NOTIMPL_VAL();
+	KrkValue out = FUNC_NAME(deque,copy)(1, argv, 0);
+	krk_push(out);
+	_extend(AS_deque(out), argv[1], 0);
+	return krk_pop();
+}
+
+KRK_Method(deque,__iadd__) {
+	METHOD_TAKES_EXACTLY(1);
+	if (!_extend(self, argv[1], 0)) return NONE_VAL();
+	return argv[0];
+}
+
+KRK_Method(deque,__repr__) {
+	METHOD_TAKES_NONE();
+	if (((KrkObj*)self)->flags & KRK_OBJ_FLAGS_IN_REPR) return OBJECT_VAL(S("[...]"));
+	((KrkObj*)self)->flags |= KRK_OBJ_FLAGS_IN_REPR;
+	struct StringBuilder sb = {0};
+	pushStringBuilderStr(&sb, "deque([", 7);
+	size_t state = self->state;
+	struct DequeCursor cursor = {self->left, self->leftIndex};
+	for (size_t i = 0; i < self->count; ++i) {
+		if (i) pushStringBuilderStr(&sb, ", ", 2);
+		if (!krk_pushStringBuilderFormat(&sb, "%R", _next(&cursor))) goto _error;
+		if (state != self->state) {
+			krk_runtimeError(vm.exceptions->Exception, "deque mutated during iteration");
+			goto _error;
+		}
+	}
+	pushStringBuilder(&sb, ']');
+	if (self->bounded && !krk_pushStringBuilderFormat(&sb, ", maxlen=%zu", self->maxlen)) goto _error;
+	pushStringBuilder(&sb, ')');
+	((KrkObj*)self)->flags &= ~(KRK_OBJ_FLAGS_IN_REPR);
+	return finishStringBuilder(&sb);
+
+_error:
+	krk_discardStringBuilder(&sb);
+	((KrkObj*)self)->flags &= ~(KRK_OBJ_FLAGS_IN_REPR);
+	return NONE_VAL();
+}
+
+FUNC_SIG(dequeiterator,__init__);
+
+KRK_Method(deque,__iter__) {
+	METHOD_TAKES_NONE();
+	KrkInstance * output = krk_newInstance(dequeiterator);
+	krk_push(OBJECT_VAL(output));
+	FUNC_NAME(dequeiterator,__init__)(2, (KrkValue[]){krk_peek(0), argv[0]}, 0);
+	return krk_pop();
+}
+
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct DequeIterator *
+#define IS_dequeiterator(o) (krk_isInstanceOf(o,dequeiterator))
+#define AS_dequeiterator(o) ((struct DequeIterator*)AS_OBJECT(o))
+
+static void _dequeiterator_gcscan(KrkInstance * self) {
+	krk_markValue(((struct DequeIterator*)self)->deque);
+}
+
+KRK_Method(dequeiterator,__init__) {
+	METHOD_TAKES_EXACTLY(1);
+	if (!IS_deque(argv[1])) return TYPE_ERROR(deque,argv[1]);
+	struct Deque * source = AS_deque(argv[1]);
+	self->deque = argv[1];
+	self->block = source->left;
+	self->index = source->leftIndex;
+	self->remaining = source->count;
+	self->state = source->state;
+	return NONE_VAL();
+}
+
+KRK_Method(dequeiterator,__call__) {
+	if (!self->remaining || !IS_deque(self->deque)) return argv[0];
+	if (AS_deque(self->deque)->state != self->state) {
+		self->remaining = 0;
+		return krk_runtimeError(vm.exceptions->Exception, "deque mutated during iteration");
+	}
+	struct DequeCursor cursor = {self->block, self->index};
+	KrkValue out = _next(&cursor);
+	self->block = cursor.block;
+	self->index = cursor.index;
+	self->remaining--;
+	return out;
+}
+
+KRK_Module(_collections) {
+	KRK_DOC(module, "@brief Native implementations of collection types.");
+
+	krk_makeClass(module, &deque, "deque", vm.baseClasses->objectClass);
+	KRK_DOC(deque,
+		"@brief Double-ended queue with constant-time appends and pops at either end.\n\n"
+		"Items are kept in linked blocks of values. Indexing is linear in the distance "
+		"from the nearer end. A deque with a @c maxlen discards items from the opposite "
+		"end when it is full.");
+	deque->allocSize = sizeof(struct Deque);
+	deque->_ongcscan = _deque_gcscan;
+	deque->_ongcsweep = _deque_gcsweep;
+	KRK_DOC(BIND_METHOD(deque,__init__),
+		"@brief Create a deque from the items of an iterable.\n"
+		"@arguments iterable=None,maxlen=None");
+	KRK_DOC(BIND_PROP(deque,maxlen),
+		"@brief Maximum size of the deque, or @c None if it is unbounded.");
+	BIND_METHOD(deque,__len__);
+	BIND_METHOD(deque,__getitem__);
+	BIND_METHOD(deque,__setitem__);
+	BIND_METHOD(deque,__delitem__);
+	BIND_METHOD(deque,__contains__);
+	BIND_METHOD(deque,__iter__);
+	BIND_METHOD(deque,__repr__);
+	BIND_METHOD(deque,__eq__);
+	BIND_METHOD(deque,__add__);
+	BIND_METHOD(deque,__iadd__);
+	KRK_DOC(BIND_METHOD(deque,append),
+		"@brief Add an item to the right end.\n"
+		"@arguments x");
+	KRK_DOC(BIND_METHOD(deque,appendleft),
+		"@brief Add an item to the left end.\n"
+		"@arguments x");
+	KRK_DOC(BIND_METHOD(deque,pop),
+		"@brief Remove and return the item at the right end.");
+	KRK_DOC(BIND_METHOD(deque,popleft),
+		"@brief Remove and return the item at the left end.");
+	KRK_DOC(BIND_METHOD(deque,extend),
+		"@brief Append the items of an iterable to the right end.\n"
+		"@arguments iterable");
+	KRK_DOC(BIND_METHOD(deque,extendleft),
+		"@brief Append the items of an iterable to the left end, reversing their order.\n"
+		"@arguments iterable");
+	KRK_DOC(BIND_METHOD(deque,clear),
+		"@brief Remove all items.");
+	KRK_DOC(BIND_METHOD(deque,copy),
+		"@brief Return a shallow copy with the same @c maxlen.");
+	KRK_DOC(BIND_METHOD(deque,rotate),
+		"@brief Rotate @p n steps to the right, or to the left if @p n is negative.\n"
+		"@arguments n=1");
+	KRK_DOC(BIND_METHOD(deque,reverse),
+		"@brief Reverse the order of the items in place.");
+	KRK_DOC(BIND_METHOD(deque,insert),
+		"@brief Insert an item before position @p i.\n"
+		"@arguments i,x");
+	KRK_DOC(BIND_METHOD(deque,index),
+		"@brief Find the position of the first item equal to @p x.\n"
+		"@arguments x,start=0,stop=None");
+	KRK_DOC(BIND_METHOD(deque,count),
+		"@brief Count the items equal to @p x.\n"
+		"@arguments x");
+	KRK_DOC(BIND_METHOD(deque,remove),
+		"@brief Remove the first item equal to @p x.\n"
+		"@arguments x");
+	krk_finalizeClass(deque);
+
+	krk_makeClass(module, &dequeiterator, "dequeiterator", vm.baseClasses->objectClass);
+	dequeiterator->allocSize = sizeof(struct DequeIterator);
+	dequeiterator->_ongcscan = _dequeiterator_gcscan;
+	BIND_METHOD(dequeiterator,__init__);
+	BIND_METHOD(dequeiterator,__call__);
+	krk_finalizeClass(dequeiterator);
+}
@@ -0,0 +1,1216 @@
+/**
+ * @file    module_array.c
+ * @brief   Typed arrays of numbers with contiguous, unboxed storage.
+ *
+ * An @c array holds machine numbers of a single type, as in Python's module
+ * of the same name: eight bytes per @c double instead of a boxed value with
+ * type dispatch on every operation. The storage is exported through the
+ * buffer protocol, so arrays can be passed to @c memoryview, files and
+ * sockets without copying.
+ *
+ * On top of the sequence interface, arrays provide elementwise arithmetic
+ * (@c add, @c sub, @c mul, @c div) and reductions (@c sum, @c min, @c max,
+ * @c dot) as typed loops. The loops run over fixed-size blocks so the
+ * compiler can turn them into vector instructions.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <kuroko/vm.h>
+#include <kuroko/util.h>
+#include <kuroko/memory.h>
+
+static KrkClass * array;
+static KrkClass * arrayiterator;
+
+extern KrkValue krk_operator_add(KrkValue a, KrkValue b);
+extern KrkValue krk_operator_mul(KrkValue a, KrkValue b);
+
+/** Elements per block in the vectorizable loops */
+#define BLOCK 16
+
+struct ArrayType;
+
+struct Array {
+	KrkInstance inst;
+	const struct ArrayType * type;
+	size_t count;
+	size_t capacity;
+	char * data;
+};
+
+struct ArrayIterator {
+	KrkInstance inst;
+	KrkValue array;
+	size_t i;
+};
+
+/**
+ * @brief Operations on one element type.
+ *
+ * @c store converts and range checks a value, raising on failure.
+ * @c exact converts without raising, failing if no element could
+ * compare equal to the value. The elementwise kernels take the second
+ * operand as a single element when @p scalar is set. Integer overflow
+ * in the arithmetic kernels wraps around.
+ */
+struct ArrayType {
+	char code;
+	unsigned char size;
+	char isfloat;
+	KrkValue (*load)(const void * data, size_t i);
+	int (*store)(void * data, size_t i, KrkValue value);
+	int (*exact)(void * out, KrkValue value);
+	size_t (*find)(const void * data, size_t start, size_t n, const void * elem);
+	void (*ops[4])(void * out, const void * a, const void * b, size_t n, int scalar);
+	int (*anyzero)(const void * data, size_t n);
+	KrkValue (*sum)(const void * data, size_t n);
+	KrkValue (*min)(const void * data, size_t n);
+	KrkValue (*max)(const void * data, size_t n);
+	KrkValue (*dot)(const void * a, const void * b, size_t n);
+};
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_DIV };
+
+/**
+ * Element types: code, C type, unsigned type for wrapping arithmetic, and
+ * family. The unsigned type is at least as wide as int so that products of
+ * small types can not overflow in the promoted type.
+ */
+#define ARRAY_TYPES(X) \
+	X(b, int8_t,        unsigned int,  SIGNED) \
+	X(B, uint8_t,       unsigned int,  UNSIGNED) \
+	X(h, int16_t,       unsigned int,  SIGNED) \
+	X(H, uint16_t,      unsigned int,  UNSIGNED) \
+	X(i, int32_t,       uint32_t,      SIGNED) \
+	X(I, uint32_t,      uint32_t,      UNSIGNED) \
+	X(l, long,          unsigned long, SIGNED) \
+	X(L, unsigned long, unsigned long, UNSIGNED) \
+	X(q, int64_t,       uint64_t,      SIGNED) \
+	X(Q, uint64_t,      uint64_t,      UNSIGNED) \
+	X(f, float,         float,         FLOAT) \
+	X(d, double,        double,        FLOAT)
+
+#define TYPE_MIN_SIGNED(type)   ((type)((uint64_t)1 << (sizeof(type) * 8 - 1)))
+#define TYPE_MAX_SIGNED(type)   ((type)~TYPE_MIN_SIGNED(type))
+#define TYPE_MAX_UNSIGNED(type) ((type)~(type)0)
+
+/* Loading elements as values */
+
+#define LOAD_SIGNED(type)   (sizeof(type) < 6 ? INTEGER_VAL(x) : krk_int_from_ll(x))
+#define LOAD_UNSIGNED(type) (sizeof(type) < 6 ? INTEGER_VAL(x) : krk_int_from_ull(x))
+#define LOAD_FLOAT(type)    FLOATING_VAL(x)
+
+#define DEFINE_LOAD(code,type,utype,kind) \
+	static KrkValue _load_ ## code(const void * data, size_t i) { \
+		type x = ((const type *)data)[i]; \
+		return LOAD_ ## kind(type); \
+	}
+
+/* Storing values as elements, with range checks */
+
+static int _storeError(char code, KrkValue value) {
+	if (IS_INTEGER(value) || krk_isInstanceOf(value, KRK_BASE_CLASS(long))) {
+		krk_runtimeError(vm.exceptions->valueError, "array item out of range for type code '%c'", code);
+	} else {
+		krk_runtimeError(vm.exceptions->typeError, "array item must be %s, not '%T'", code == 'f' || code == 'd' ? "real number" : "int", value);
+	}
+	return 0;
+}
+
+/* Wide types convert longs and then check that the conversion was exact. */
+#define STORE_WIDE(code,type,from) { \
+	if (!krk_isInstanceOf(value, KRK_BASE_CLASS(long))) return _storeError(#code[0], value); \
+	type x; \
+	if (!krk_long_to_int(value, sizeof(type), &x)) return 0; \
+	krk_push(from(x)); \
+	int same = krk_valuesEqual(krk_peek(0), value); \
+	krk_pop(); \
+	if (!same) return _storeError(#code[0], value); \
+	((type *)data)[i] = x; \
+	return 1; }
+
+#define STORE_SIGNED(code,type) \
+	if (IS_INTEGER(value)) { \
+		krk_integer_type x = AS_INTEGER(value); \
+		if (sizeof(type) < 6 && (x < (krk_integer_type)TYPE_MIN_SIGNED(type) || x > (krk_integer_type)TYPE_MAX_SIGNED(type))) return _storeError(#code[0], value); \
+		((type *)data)[i] = x; \
+		return 1; \
+	} \
+	STORE_WIDE(code,type,krk_int_from_ll)
+
+#define STORE_UNSIGNED(code,type) \
+	if (IS_INTEGER(value)) { \
+		krk_integer_type x = AS_INTEGER(value); \
+		if (x < 0 || (sizeof(type) < 6 && x > (krk_integer_type)TYPE_MAX_UNSIGNED(type))) return _storeError(#code[0], value); \
+		((type *)data)[i] = x; \
+		return 1; \
+	} \
+	STORE_WIDE(code,type,krk_int_from_ull)
+
+#define STORE_FLOAT(code,type) \
+	if (IS_FLOATING(value)) { \
+		((type *)data)[i] = AS_FLOATING(value); \
+		return 1; \
+	} else if (IS_INTEGER(value)) { \
+		((type *)data)[i] = AS_INTEGER(value); \
+		return 1; \
+	} \
+	if (IS_STRING(value)) return _storeError(#code[0], value); \
+	krk_push(value); \
+	if (!krk_bindMethod(krk_getType(value), S("__float__"))) { \
+		krk_pop(); \
+		return _storeError(#code[0], value); \
+	} \
+	KrkValue result = krk_callStack(0); \
+	if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return 0; \
+	if (!IS_FLOATING(result)) return _storeError(#code[0], result); \
+	((type *)data)[i] = AS_FLOATING(result); \
+	return 1;
+
+#define DEFINE_STORE(code,type,utype,kind) \
+	static int _store_ ## code(void * data, size_t i, KrkValue value) { \
+		STORE_ ## kind(code,type) \
+	}
+
+/* Exact conversions for searching */
+
+#define EXACT_SIGNED(type) \
+	if (IS_INTEGER(value)) { \
+		krk_integer_type x = AS_INTEGER(value); \
+		if (sizeof(type) < 6 && (x < (krk_integer_type)TYPE_MIN_SIGNED(type) || x > (krk_integer_type)TYPE_MAX_SIGNED(type))) return 0; \
+		*(type *)out = x; \
+		return 1; \
+	} else if (IS_FLOATING(value)) { \
+		double x = AS_FLOATING(value); \
+		if (!(x >= -0x1p63 && x < 0x1p63) || (double)(int64_t)x != x) return 0; \
+		krk_integer_type y = (int64_t)x; \
+		if (sizeof(type) < 8 && (y < (krk_integer_type)TYPE_MIN_SIGNED(type) || y > (krk_integer_type)TYPE_MAX_SIGNED(type))) return 0; \
+		*(type *)out = y; \
+		return 1; \
+	} \
+	return 0;
+
+#define EXACT_UNSIGNED(type) \
+	if (IS_INTEGER(value)) { \
+		krk_integer_type x = AS_INTEGER(value); \
+		if (x < 0 || (sizeof(type) < 6 && x > (krk_integer_type)TYPE_MAX_UNSIGNED(type))) return 0; \
+		*(type *)out = x; \
+		return 1; \
+	} else if (IS_FLOATING(value)) { \
+		double x = AS_FLOATING(value); \
+		if (!(x >= 0 && x < 0x1p64) || (double)(uint64_t)x != x) return 0; \
+		uint64_t y = x; \
+		if (sizeof(type) < 8 && y > (uint64_t)TYPE_MAX_UNSIGNED(type)) return 0; \
+		*(type *)out = y; \
+		return 1; \
+	} \
+	return 0;
+
+#define EXACT_FLOAT(type) \
+	if (IS_INTEGER(value)) { \
+		type x = AS_INTEGER(value); \
+		if ((krk_integer_type)x != AS_INTEGER(value)) return 0; \
+		*(type *)out = x; \
+		return 1; \
+	} else if (IS_FLOATING(value)) { \
+		type x = AS_FLOATING(value); \
+		if ((double)x != AS_FLOATING(value)) return 0; \
+		*(type *)out = x; \
+		return 1; \
+	} \
+	return 0;
+
+#define DEFINE_EXACT(code,type,utype,kind) \
+	static int _exact_ ## code(void * out, KrkValue value) { \
+		EXACT_ ## kind(type) \
+	} \
+	static size_t _find_ ## code(const void * data, size_t start, size_t n, const void * elem) { \
+		const type * a = data; \
+		type y = *(const type *)elem; \
+		for (size_t i = start; i < n; ++i) if (a[i] == y) return i; \
+		return n; \
+	}
+
+/* Elementwise arithmetic */
+
+#define ELEMENTWISE(code,type,name,expr) \
+	static void _ ## name ## _ ## code(void * restrict _out, const void * restrict _a, const void * restrict _b, size_t n, int scalar) { \
+		type * out = _out; \
+		const type * a = _a; \
+		const type * b = _b; \
+		size_t i = 0; \
+		if (scalar) { \
+			const type y = b[0]; \
+			for (; i + BLOCK <= n; i += BLOCK) for (size_t j = 0; j < BLOCK; ++j) { type x = a[i+j]; out[i+j] = (expr); } \
+			for (; i < n; ++i) { type x = a[i]; out[i] = (expr); } \
+		} else { \
+			for (; i + BLOCK <= n; i += BLOCK) for (size_t j = 0; j < BLOCK; ++j) { type x = a[i+j], y = b[i+j]; out[i+j] = (expr); } \
+			for (; i < n; ++i) { type x = a[i], y = b[i]; out[i] = (expr); } \
+		} \
+	}
+
+#define FLOORDIV_SIGNED(code,type,utype) \
+	static inline type _floordiv_ ## code(type x, type y) { \
+		if (y == -1) return (type)(0 - (utype)x); \
+		type q = x / y; \
+		if (x % y != 0 && ((x < 0) != (y < 0))) q--; \
+		return q; \
+	}
+#define FLOORDIV_UNSIGNED(code,type,utype) \
+	static inline type _floordiv_ ## code(type x, type y) { \
+		return x / y; \
+	}
+
+#define DEFINE_OPS_INTEGER(code,type,utype,kind) \
+	ELEMENTWISE(code,type,add,(type)((utype)x + (utype)y)) \
+	ELEMENTWISE(code,type,sub,(type)((utype)x - (utype)y)) \
+	ELEMENTWISE(code,type,mul,(type)((utype)x * (utype)y)) \
+	FLOORDIV_ ## kind(code,type,utype) \
+	static void _div_ ## code(void * _out, const void * _a, const void * _b, size_t n, int scalar) { \
+		type * out = _out; \
+		const type * a = _a; \
+		const type * b = _b; \
+		for (size_t i = 0; i < n; ++i) out[i] = _floordiv_ ## code(a[i], b[scalar ? 0 : i]); \
+	} \
+	static int _anyzero_ ## code(const void * data, size_t n) { \
+		const type * a = data; \
+		for (size_t i = 0; i < n; ++i) if (a[i] == 0) return 1; \
+		return 0; \
+	}
+
+#define DEFINE_OPS_FLOAT(code,type,utype,kind) \
+	ELEMENTWISE(code,type,add,x + y) \
+	ELEMENTWISE(code,type,sub,x - y) \
+	ELEMENTWISE(code,type,mul,x * y) \
+	ELEMENTWISE(code,type,div,x / y) \
+	static int _anyzero_ ## code(const void * data, size_t n) { \
+		return 0; \
+	}
+
+#define DEFINE_OPS_SIGNED   DEFINE_OPS_INTEGER
+#define DEFINE_OPS_UNSIGNED DEFINE_OPS_INTEGER
+#define DEFINE_OPS(code,type,utype,kind) DEFINE_OPS_ ## kind(code,type,utype,kind)
+
+/* Reductions */
+
+/**
+ * Finish an integer reduction with boxed arithmetic once the machine word
+ * would overflow: @p acc is the total so far, and the terms from @p i on
+ * are added to it (multiplied pairwise if @p b is set).
+ */
+static KrkValue _reduceBoxed(const struct ArrayType * type, KrkValue acc, const void * a, const void * b, size_t i, size_t n) {
+	krk_push(acc);
+	for (; i < n; ++i) {
+		KrkValue term = type->load(a, i);
+		if (b) {
+			krk_push(term);
+			krk_push(type->load(b, i));
+			term = krk_operator_mul(krk_peek(1), krk_peek(0));
+			krk_pop();
+			krk_pop();
+		}
+		krk_push(term);
+		krk_currentThread.stackTop[-2] = krk_operator_add(krk_peek(1), krk_peek(0));
+		krk_pop();
+	}
+	return krk_pop();
+}
+
+/* Narrow integers and floats add up in blocks of independent lanes. */
+#define SUM_LANES(type,acctype,make) { \
+	const type * a = data; \
+	acctype lanes[BLOCK] = {0}; \
+	size_t i = 0; \
+	for (; i + BLOCK <= n; i += BLOCK) for (size_t j = 0; j < BLOCK; ++j) lanes[j] += a[i+j]; \
+	acctype total = 0; \
+	for (; i < n; ++i) total += a[i]; \
+	for (size_t j = 0; j < BLOCK; ++j) total += lanes[j]; \
+	return make(total); }
+
+#define DOT_LANES(type,acctype,make) { \
+	const type * a = _a; \
+	const type * b = _b; \
+	acctype lanes[BLOCK] = {0}; \
+	size_t i = 0; \
+	for (; i + BLOCK <= n; i += BLOCK) for (size_t j = 0; j < BLOCK; ++j) lanes[j] += (acctype)a[i+j] * b[i+j]; \
+	acctype total = 0; \
+	for (; i < n; ++i) total += (acctype)a[i] * b[i]; \
+	for (size_t j = 0; j < BLOCK; ++j) total += lanes[j]; \
+	return make(total); }
+
+/* Wide integers add up in one word until it would overflow. */
+#define SUM_CHECKED(code,type,make) { \
+	const type * a = data; \
+	type total = 0; \
+	for (size_t i = 0; i < n; ++i) { \
+		type next; \
+		if (__builtin_add_overflow(total, a[i], &next)) return _reduceBoxed(&_type_ ## code, make(total), a, NULL, i, n); \
+		total = next; \
+	} \
+	return make(total); }
+
+#define DOT_CHECKED(code,type,acctype,make) { \
+	const type * a = _a; \
+	const type * b = _b; \
+	acctype total = 0; \
+	for (size_t i = 0; i < n; ++i) { \
+		acctype term; \
+		if (__builtin_mul_overflow((acctype)a[i], (acctype)b[i], &term) || __builtin_add_overflow(total, term, &term)) { \
+			return _reduceBoxed(&_type_ ## code, make(total), a, b, i, n); \
+		} \
+		total = term; \
+	} \
+	return make(total); }
+
+#define SUM_SIGNED(code,type) \
+	if (sizeof(type) < 8) SUM_LANES(type,int64_t,krk_int_from_ll) else SUM_CHECKED(code,type,krk_int_from_ll)
+#define SUM_UNSIGNED(code,type) \
+	if (sizeof(type) < 8) SUM_LANES(type,uint64_t,krk_int_from_ull) else SUM_CHECKED(code,type,krk_int_from_ull)
+#define SUM_FLOAT(code,type) \
+	SUM_LANES(type,double,FLOATING_VAL)
+
+#define DOT_SIGNED(code,type) \
+	if (sizeof(type) < 4) DOT_LANES(type,int64_t,krk_int_from_ll) else DOT_CHECKED(code,type,int64_t,krk_int_from_ll)
+#define DOT_UNSIGNED(code,type) \
+	if (sizeof(type) < 4) DOT_LANES(type,uint64_t,krk_int_from_ull) else DOT_CHECKED(code,type,uint64_t,krk_int_from_ull)
+#define DOT_FLOAT(code,type) \
+	DOT_LANES(type,double,FLOATING_VAL)
+
+/* Integer extremes are found in lanes; floats keep a plain scan so that NaNs compare as they would in min(). */
+#define EXTREME_SIGNED(code,type,cmp)   EXTREME_LANES(code,type,cmp)
+#define EXTREME_UNSIGNED(code,type,cmp) EXTREME_LANES(code,type,cmp)
+#define EXTREME_LANES(code,type,cmp) { \
+	const type * a = data; \
+	type lanes[BLOCK]; \
+	for (size_t j = 0; j < BLOCK; ++j) lanes[j] = a[0]; \
+	size_t i = 0; \
+	for (; i + BLOCK <= n; i += BLOCK) for (size_t j = 0; j < BLOCK; ++j) lanes[j] = a[i+j] cmp lanes[j] ? a[i+j] : lanes[j]; \
+	type best = a[0]; \
+	for (; i < n; ++i) if (a[i] cmp best) best = a[i]; \
+	for (size_t j = 0; j < BLOCK; ++j) if (lanes[j] cmp best) best = lanes[j]; \
+	return _load_ ## code(&best, 0); }
+#define EXTREME_FLOAT(code,type,cmp) { \
+	const type * a = data; \
+	type best = a[0]; \
+	for (size_t i = 1; i < n; ++i) if (a[i] cmp best) best = a[i]; \
+	return FLOATING_VAL(best); }
+
+#define DEFINE_REDUCE(code,type,utype,kind) \
+	static const struct ArrayType _type_ ## code; \
+	static KrkValue _sum_ ## code(const void * data, size_t n) { SUM_ ## kind(code,type) } \
+	static KrkValue _dot_ ## code(const void * _a, const void * _b, size_t n) { DOT_ ## kind(code,type) } \
+	static KrkValue _min_ ## code(const void * data, size_t n) { EXTREME_ ## kind(code,type,<) } \
+	static KrkValue _max_ ## code(const void * data, size_t n) { EXTREME_ ## kind(code,type,>) }
+
+#define DEFINE_TYPE(code,type,utype,kind) \
+	DEFINE_LOAD(code,type,utype,kind) \
+	DEFINE_STORE(code,type,utype,kind) \
+	DEFINE_EXACT(code,type,utype,kind) \
+	DEFINE_OPS(code,type,utype,kind) \
+	DEFINE_REDUCE(code,type,utype,kind) \
+	static const struct ArrayType _type_ ## code = { \
+		#code[0], sizeof(type), KIND_IS_FLOAT_ ## kind, \
+		_load_ ## code, _store_ ## code, _exact_ ## code, _find_ ## code, \
+		{ _add_ ## code, _sub_ ## code, _mul_ ## code, _div_ ## code }, \
+		_anyzero_ ## code, _sum_ ## code, _min_ ## code, _max_ ## code, _dot_ ## code, \
+	};
+
+#define KIND_IS_FLOAT_SIGNED   0
+#define KIND_IS_FLOAT_UNSIGNED 0
+#define KIND_IS_FLOAT_FLOAT    1
+
+ARRAY_TYPES(DEFINE_TYPE)
+
+#define TYPE_ENTRY(code,type,utype,kind) &_type_ ## code,
+static const struct ArrayType * _types[] = { ARRAY_TYPES(TYPE_ENTRY) NULL };
+
+static const struct ArrayType * _typeFor(const char * code) {
+	if (code[0] && !code[1]) {
+		for (const struct ArrayType ** t = _types; *t; ++t) {
+			if ((*t)->code == code[0]) return *t;
+		}
+	}
+	krk_runtimeError(vm.exceptions->valueError, "bad typecode (must be b, B, h, H, i, I, l, L, q, Q, f or d)");
+	return NULL;
+}
+
+#define IS_array(o) (krk_isInstanceOf(o,array))
+#define AS_array(o) ((struct Array*)AS_OBJECT(o))
+#define CURRENT_CTYPE struct Array *
+#define CURRENT_NAME  self
+
+#define ITEM(arr,i) ((arr)->data + (size_t)(i) * (arr)->type->size)
+
+static void _array_gcsweep(KrkInstance * _self) {
+	struct Array * self = (struct Array*)_self;
+	if (self->data) krk_reallocate(self->data, self->capacity * (self->type ? self->type->size : 1), 0);
+}
+
+static int _array_getbuffer(KrkValue value, KrkBuffer * buffer) {
+	struct Array * self = AS_array(value);
+	if (!self->type) {
+		krk_runtimeError(vm.exceptions->valueError, "uninitialized array");
+		return 0;
+	}
+	/* Formats are exported as strings, so point at one of these. */
+	static const char formats[] = "b\0B\0h\0H\0i\0I\0l\0L\0q\0Q\0f\0d\0";
+	const char * format = formats;
+	while (*format != self->type->code) format += 2;
+	buffer->buf = self->data;
+	buffer->len = self->count * self->type->size;
+	buffer->itemsize = self->type->size;
+	buffer->format = format;
+	buffer->readonly = 0;
+	return 1;
+}
+
+/**
+ * @brief Make room for @p count items; existing items are kept.
+ */
+static void _reserve(struct Array * self, size_t count) {
+	if (count <= self->capacity && self->data) return;
+	size_t capacity = self->capacity < 8 ? 8 : self->capacity + self->capacity / 2;
+	if (capacity < count) capacity = count;
+	self->data = krk_reallocate(self->data, self->capacity * self->type->size, capacity * self->type->size);
+	self->capacity = capacity;
+}
+
+static struct Array * _newArray(const struct ArrayType * type, size_t count) {
+	struct Array * out = (struct Array*)krk_newInstance(array);
+	krk_push(OBJECT_VAL(out));
+	out->type = type;
+	_reserve(out, count);
+	out->count = count;
+	krk_pop();
+	return out;
+}
+
+static int _checkArray(struct Array * self, const char * _method_name) {
+	if (!self->type) {
+		krk_runtimeError(vm.exceptions->valueError, "uninitialized array");
+		return 0;
+	}
+	return 1;
+}
+#define CHECK_INIT() do { if (!_checkArray(self, _method_name)) return NONE_VAL(); } while (0)
+
+/**
+ * @brief Convert @p value and add it to the end of the array.
+ *
+ * Conversion may run a __float__ that changes this same array, so the
+ * element is converted into a temporary before the buffer is touched.
+ */
+static int _append(struct Array * self, KrkValue value) {
+	char elem[8];
+	if (!self->type->store(elem, 0, value)) return 0;
+	_reserve(self, self->count + 1);
+	memcpy(ITEM(self, self->count), elem, self->type->size);
+	self->count++;
+	return 1;
+}
+
+static int _extend_callback(void * context, const KrkValue * values, size_t count) {
+	struct Array * self = context;
+	_reserve(self, self->count + count);
+	for (size_t i = 0; i < count; ++i) {
+		if (!_append(self, values[i])) return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Append the items of an iterable, converting each one.
+ *
+ * Other arrays are copied directly when their type matches; bytes-like
+ * objects are not treated specially here, as in Python.
+ */
+static int _extend(struct Array * self, KrkValue iterable) {
+	if (IS_array(iterable) && AS_array(iterable)->type) {
+		struct Array * other = AS_array(iterable);
+		size_t start = self->count, count = other->count;
+		if (other->type == self->type) {
+			_reserve(self, start + count);
+			memmove(ITEM(self, start), other->data, count * self->type->size);
+			self->count += count;
+			return 1;
+		}
+		_reserve(self, start + count);
+		for (size_t i = 0; i < count && i < other->count; ++i) {
+			if (!_append(self, other->type->load(other->data, i))) return 0;
+		}
+		return 1;
+	}
+	krk_unpackIterable(iterable, self, _extend_callback);
+	return !(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION);
+}
+
+static int _frombytes(struct Array * self, KrkValue data) {
+	KrkBuffer buffer;
+	if (!krk_getBuffer(data, &buffer, 0)) return 0;
+	if (buffer.len % self->type->size) {
+		krk_runtimeError(vm.exceptions->valueError, "bytes length not a multiple of item size");
+		return 0;
+	}
+	size_t count = buffer.len / self->type->size;
+	size_t start = self->count;
+	_reserve(self, start + count);
+	/* Reserving may have collected garbage, but not the buffer's owner, which is still an argument. */
+	if (!krk_getBuffer(data, &buffer, 0)) return 0;
+	memmove(ITEM(self, start), buffer.buf, buffer.len);
+	self->count += count;
+	return 1;
+}
+
+KRK_Method(array,__init__) {
+	const char * typecode;
+	KrkValue initializer = NONE_VAL();
+	if (!krk_parseArgs(".s|V:array", (const char*[]){"typecode","initializer"}, &typecode, &initializer)) return NONE_VAL();
+	if (self->type) return krk_runtimeError(vm.exceptions->valueError, "array already initialized");
+	const struct ArrayType * type = _typeFor(typecode);
+	if (!type) return NONE_VAL();
+	self->type = type;
+	_reserve(self, 0);
+	if (IS_NONE(initializer)) return NONE_VAL();
+	if (IS_STRING(initializer)) return krk_runtimeError(vm.exceptions->typeError, "cannot use a str to initialize an array with typecode '%c'", type->code);
+	if (IS_BYTES(initializer) || (!IS_array(initializer) && krk_getType(initializer)->_getbuffer)) {
+		_frombytes(self, initializer);
+	} else {
+		_extend(self, initializer);
+	}
+	return NONE_VAL();
+}
+
+KRK_Method(array,typecode) {
+	CHECK_INIT();
+	return OBJECT_VAL(krk_copyString(&self->type->code, 1));
+}
+
+KRK_Method(array,itemsize) {
+	CHECK_INIT();
+	return INTEGER_VAL(self->type->size);
+}
+
+KRK_Method(array,__len__) {
+	METHOD_TAKES_NONE();
+	return INTEGER_VAL(self->count);
+}
+
+static int _index(struct Array * self, KrkValue value, size_t * out, const char * _method_name) {
+	if (!IS_INTEGER(value)) {
+		krk_runtimeError(vm.exceptions->typeError, "array indices must be integers, not '%T'", value);
+		return 0;
+	}
+	krk_integer_type index = AS_INTEGER(value);
+	if (index < 0) index += self->count;
+	if (index < 0 || index >= (krk_integer_type)self->count) {
+		krk_runtimeError(vm.exceptions->indexError, "array index out of range: " PRIkrk_int, AS_INTEGER(value));
+		return 0;
+	}
+	*out = index;
+	return 1;
+}
+
+KRK_Method(array,__getitem__) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (IS_slice(argv[1])) {
+		KRK_SLICER(argv[1], self->count) {
+			return NONE_VAL();
+		}
+		size_t count = (step > 0) ? (end > start ? (end - start + step - 1) / step : 0) : (start > end ? (start - end - step - 1) / -step : 0);
+		struct Array * out = _newArray(self->type, count);
+		size_t size = self->type->size;
+		if (step == 1) {
+			memcpy(out->data, ITEM(self, start), count * size);
+		} else {
+			for (size_t i = 0; i < count; ++i) {
+				memcpy(ITEM(out, i), ITEM(self, start + (krk_integer_type)i * step), size);
+			}
+		}
+		return OBJECT_VAL(out);
+	}
+	size_t index;
+	if (!_index(self, argv[1], &index, _method_name)) return NONE_VAL();
+	return self->type->load(self->data, index);
+}
+
+KRK_Method(array,__setitem__) {
+	METHOD_TAKES_EXACTLY(2);
+	CHECK_INIT();
+	if (IS_slice(argv[1])) {
+		KRK_SLICER(argv[1], self->count) {
+			return NONE_VAL();
+		}
+		if (!IS_array(argv[2]) || AS_array(argv[2])->type != self->type) {
+			return krk_runtimeError(vm.exceptions->typeError, "can only assign an array of the same type code to an array slice");
+		}
+		struct Array * other = AS_array(argv[2]);
+		size_t size = self->type->size;
+		if (step == 1) {
+			/* Contiguous slices can change length. */
+			size_t count = end > start ? end - start : 0;
+			size_t ocount = other->count;
+			size_t tail = self->count - start - count;
+			if (ocount > count) _reserve(self, self->count + ocount - count);
+			memmove(ITEM(self, start + ocount), ITEM(self, start + count), tail * size);
+			/* The source may be this same array, in which case it has just moved. */
+			memmove(ITEM(self, start), other == self ? ITEM(self, 0) : other->data, ocount * size);
+			self->count = self->count - count + ocount;
+			return argv[2];
+		}
+		size_t count = (step > 0) ? (end > start ? (end - start + step - 1) / step : 0) : (start > end ? (start - end - step - 1) / -step : 0);
+		if (other->count != count) {
+			return krk_runtimeError(vm.exceptions->valueError, "attempt to assign array of size %zu to extended slice of size %zu", other->count, count);
+		}
+		char * tmp = malloc(count * size);
+		memcpy(tmp, other->data, count * size);
+		for (size_t i = 0; i < count; ++i) {
+			memcpy(ITEM(self, start + (krk_integer_type)i * step), tmp + i * size, size);
+		}
+		free(tmp);
+		return argv[2];
+	}
+	/* A __float__ may resize the array, so the index is checked again after converting. */
+	size_t index;
+	if (!_index(self, argv[1], &index, _method_name)) return NONE_VAL();
+	char elem[8];
+	if (!self->type->store(elem, 0, argv[2])) return NONE_VAL();
+	if (!_index(self, argv[1], &index, _method_name)) return NONE_VAL();
+	memcpy(ITEM(self, index), elem, self->type->size);
+	return argv[2];
+}
+
+KRK_Method(array,__delitem__) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	size_t size = self->type->size;
+	if (IS_slice(argv[1])) {
+		KRK_SLICER(argv[1], self->count) {
+			return NONE_VAL();
+		}
+		if (step < 0) {
+			/* Same items as the forward slice that ends where this one starts */
+			size_t count = start > end ? (start - end - step - 1) / -step : 0;
+			if (!count) return NONE_VAL();
+			start = start + (krk_integer_type)(count - 1) * step;
+			step = -step;
+			end = start + (krk_integer_type)(count - 1) * step + 1;
+		}
+		if (end <= start) return NONE_VAL();
+		size_t out = start;
+		for (size_t i = start; i < self->count; ++i) {
+			if (i < (size_t)end && (i - start) % step == 0) continue;
+			memmove(ITEM(self, out), ITEM(self, i), size);
+			out++;
+		}
+		self->count = out;
+		return NONE_VAL();
+	}
+	size_t index;
+	if (!_index(self, argv[1], &index, _method_name)) return NONE_VAL();
+	memmove(ITEM(self, index), ITEM(self, index + 1), (self->count - index - 1) * size);
+	self->count--;
+	return NONE_VAL();
+}
+
+KRK_Method(array,append) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	_append(self, argv[1]);
+	return NONE_VAL();
+}
+
+KRK_Method(array,extend) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (IS_array(argv[1]) && AS_array(argv[1])->type != self->type) {
+		return krk_runtimeError(vm.exceptions->typeError, "can only extend with array of same kind");
+	}
+	_extend(self, argv[1]);
+	return NONE_VAL();
+}
+
+KRK_Method(array,insert) {
+	METHOD_TAKES_EXACTLY(2);
+	CHECK_INIT();
+	if (!IS_INTEGER(argv[1])) return TYPE_ERROR(int,argv[1]);
+	krk_integer_type index = AS_INTEGER(argv[1]);
+	if (index < 0) index += self->count;
+	if (index < 0) index = 0;
+	if (index > (krk_integer_type)self->count) index = self->count;
+	char elem[8];
+	if (!self->type->store(elem, 0, argv[2])) return NONE_VAL();
+	_reserve(self, self->count + 1);
+	memmove(ITEM(self, index + 1), ITEM(self, index), (self->count - index) * self->type->size);
+	memcpy(ITEM(self, index), elem, self->type->size);
+	self->count++;
+	return NONE_VAL();
+}
+
+KRK_Method(array,pop) {
+	METHOD_TAKES_AT_MOST(1);
+	CHECK_INIT();
+	if (!self->count) return krk_runtimeError(vm.exceptions->indexError, "pop from empty array");
+	size_t index = self->count - 1;
+	if (argc > 1 && !_index(self, argv[1], &index, _method_name)) return NONE_VAL();
+	KrkValue out = self->type->load(self->data, index);
+	memmove(ITEM(self, index), ITEM(self, index + 1), (self->count - index - 1) * self->type->size);
+	self->count--;
+	return out;
+}
+
+/**
+ * @brief Find the first item equal to @p value at or after @p start.
+ *
+ * Numbers are converted to the element type and searched for in place;
+ * anything else is compared with each item as a value.
+ */
+static size_t _search(struct Array * self, KrkValue value, size_t start) {
+	if (IS_INTEGER(value) || IS_FLOATING(value)) {
+		char elem[8];
+		if (!self->type->exact(elem, value)) return self->count;
+		return self->type->find(self->data, start, self->count, elem);
+	}
+	for (size_t i = start; i < self->count; ++i) {
+		if (krk_valuesSameOrEqual(self->type->load(self->data, i), value)) return i;
+	}
+	return self->count;
+}
+
+KRK_Method(array,index) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	size_t i = _search(self, argv[1], 0);
+	if (i == self->count) return krk_runtimeError(vm.exceptions->valueError, "array.index(x): x not in array");
+	return INTEGER_VAL(i);
+}
+
+KRK_Method(array,count) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	size_t count = 0;
+	for (size_t i = _search(self, argv[1], 0); i < self->count; i = _search(self, argv[1], i + 1)) count++;
+	return INTEGER_VAL(count);
+}
+
+KRK_Method(array,remove) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	size_t i = _search(self, argv[1], 0);
+	if (i == self->count) return krk_runtimeError(vm.exceptions->valueError, "array.remove(x): x not in array");
+	memmove(ITEM(self, i), ITEM(self, i + 1), (self->count - i - 1) * self->type->size);
+	self->count--;
+	return NONE_VAL();
+}
+
+KRK_Method(array,__contains__) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	return BOOLEAN_VAL(_search(self, argv[1], 0) != self->count);
+}
+
+KRK_Method(array,reverse) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	size_t size = self->type->size;
+	char tmp[8];
+	for (size_t i = 0, j = self->count; i + 1 < j; ++i, --j) {
+		memcpy(tmp, ITEM(self, i), size);
+		memcpy(ITEM(self, i), ITEM(self, j - 1), size);
+		memcpy(ITEM(self, j - 1), tmp, size);
+	}
+	return NONE_VAL();
+}
+
+KRK_Method(array,byteswap) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	size_t size = self->type->size;
+	for (size_t i = 0; i < self->count; ++i) {
+		char * p = ITEM(self, i);
+		for (size_t j = 0; j < size / 2; ++j) {
+			char c = p[j];
+			p[j] = p[size - j - 1];
+			p[size - j - 1] = c;
+		}
+	}
+	return NONE_VAL();
+}
+
+KRK_Method(array,buffer_info) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	KrkValue address = krk_int_from_ull((uintptr_t)self->data);
+	krk_push(address);
+	KrkValue out = krk_tuple_of(2, (KrkValue[]){address, INTEGER_VAL(self->count)}, 0);
+	krk_pop();
+	return out;
+}
+
+KRK_Method(array,tobytes) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	return OBJECT_VAL(krk_newBytes(self->count * self->type->size, (uint8_t*)self->data));
+}
+
+KRK_Method(array,frombytes) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	_frombytes(self, argv[1]);
+	return NONE_VAL();
+}
+
+KRK_Method(array,tolist) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	KrkValue list = krk_list_of(0, NULL, 0);
+	krk_push(list);
+	for (size_t i = 0; i < self->count; ++i) {
+		krk_push(self->type->load(self->data, i));
+		krk_writeValueArray(AS_LIST(list), krk_peek(0));
+		krk_pop();
+	}
+	return krk_pop();
+}
+
+KRK_Method(array,fromlist) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (!IS_list(argv[1])) return TYPE_ERROR(list,argv[1]);
+	/* If any item fails to convert, none of them are added. */
+	size_t start = self->count;
+	KrkValueArray * values = AS_LIST(argv[1]);
+	_reserve(self, start + values->count);
+	for (size_t i = 0; i < values->count; ++i) {
+		if (!_append(self, values->values[i])) {
+			if (self->count > start) self->count = start;
+			return NONE_VAL();
+		}
+	}
+	return NONE_VAL();
+}
+
+KRK_Method(array,tofile) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	/* The file takes the array itself as a bytes-like object. */
+	KrkValue write = krk_valueGetAttribute(argv[1], "write");
+	if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+	krk_push(write);
+	krk_push(argv[0]);
+	krk_callStack(1);
+	return NONE_VAL();
+}
+
+KRK_Method(array,fromfile) {
+	KrkValue file;
+	size_t n;
+	if (!krk_parseArgs(".VN", (const char*[]){"f","n"}, &file, &n)) return NONE_VAL();
+	CHECK_INIT();
+	KrkValue read = krk_valueGetAttribute(file, "read");
+	if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+	krk_push(read);
+	krk_push(INTEGER_VAL(n * self->type->size));
+	KrkValue data = krk_callStack(1);
+	if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+	if (!IS_BYTES(data)) return krk_runtimeError(vm.exceptions->typeError, "read() didn't return bytes");
+	krk_push(data);
+	size_t whole = AS_BYTES(data)->length / self->type->size;
+	size_t start = self->count;
+	_reserve(self, start + whole);
+	if (whole) memcpy(ITEM(self, start), AS_BYTES(data)->bytes, whole * self->type->size);
+	self->count += whole;
+	krk_pop();
+	if (whole < n) return krk_runtimeError(vm.exceptions->ioError, "not enough items in file");
+	return NONE_VAL();
+}
+
+FUNC_SIG(arrayiterator,__init__);
+
+KRK_Method(array,__iter__) {
+	METHOD_TAKES_NONE();
+	KrkInstance * output = krk_newInstance(arrayiterator);
+	krk_push(OBJECT_VAL(output));
+	FUNC_NAME(arrayiterator,__init__)(2, (KrkValue[]){krk_peek(0), argv[0]}, 0);
+	return krk_pop();
+}
+
+KRK_Method(array,__repr__) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	if (!self->count) return krk_stringFromFormat("array('%c')", self->type->code);
+	KrkValue list = FUNC_NAME(array,tolist)(1, argv, 0);
+	if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+	krk_push(list);
+	KrkValue out = krk_stringFromFormat("array('%c', %R)", self->type->code, list);
+	krk_pop();
+	return out;
+}
+
+KRK_Method(array,__eq__) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (!IS_array(argv[1]) || !AS_array(argv[1])->type) return NOTIMPL_VAL();
+	struct Array * other = AS_array(argv[1]);
+	if (other->count != self->count) return BOOLEAN_VAL(0);
+	if (other->type == self->type && !self->type->isfloat) {
+		return BOOLEAN_VAL(!memcmp(self->data, other->data, self->count * self->type->size));
+	}
+	for (size_t i = 0; i < self->count; ++i) {
+		KrkValue a = self->type->load(self->data, i);
+		krk_push(a);
+		KrkValue b = other->type->load(other->data, i);
+		krk_push(b);
+		int same = krk_valuesEqual(a, b);
+		krk_pop();
+		krk_pop();
+		if (!same) return BOOLEAN_VAL(0);
+	}
+	return BOOLEAN_VAL(1);
+}
+
+KRK_Method(array,__add__) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (!IS_array(argv[1])) return NOTIMPL_VAL();
+	struct Array * other = AS_array(argv[1]);
+	if (other->type != self->type) return krk_runtimeError(vm.exceptions->typeError, "bad argument type for built-in operation");
+	struct Array * out = _newArray(self->type, self->count + other->count);
+	memcpy(out->data, self->data, self->count * self->type->size);
+	memcpy(ITEM(out, self->count), other->data, other->count * self->type->size);
+	return OBJECT_VAL(out);
+}
+
+KRK_Method(array,__iadd__) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (!IS_array(argv[1])) return NOTIMPL_VAL();
+	if (AS_array(argv[1])->type != self->type) return krk_runtimeError(vm.exceptions->typeError, "can only extend with array of same kind");
+	if (!_extend(self, argv[1])) return NONE_VAL();
+	return argv[0];
+}
+
+KRK_Method(array,__mul__) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (!IS_INTEGER(argv[1])) return NOTIMPL_VAL();
+	size_t times = AS_INTEGER(argv[1]) < 0 ? 0 : AS_INTEGER(argv[1]);
+	size_t bytes = self->count * self->type->size;
+	struct Array * out = _newArray(self->type, self->count * times);
+	for (size_t i = 0; i < times; ++i) memcpy(out->data + i * bytes, self->data, bytes);
+	return OBJECT_VAL(out);
+}
+
+KRK_Method(array,__rmul__) {
+	return FUNC_NAME(array,__mul__)(argc, argv, hasKw);
+}
+
+/**
+ * @brief Shared implementation of the elementwise methods.
+ *
+ * The other operand is an array of the same type and length, or a single
+ * number, which must be representable in the element type.
+ */
+static KrkValue _elementwise(struct Array * self, KrkValue other, int op, const char * _method_name) {
+	const struct ArrayType * type = self->type;
+	const void * b;
+	char scalar[8];
+	int isScalar = !IS_array(other);
+	if (isScalar) {
+		if (!type->store(scalar, 0, other)) return NONE_VAL();
+		b = scalar;
+	} else {
+		struct Array * them = AS_array(other);
+		if (them->type != type) return krk_runtimeError(vm.exceptions->typeError, "%s() requires an array of type code '%c', not '%c'", _method_name, type->code, them->type ? them->type->code : '?');
+		if (them->count != self->count) return krk_runtimeError(vm.exceptions->valueError, "%s() requires arrays of the same length (%zu and %zu)", _method_name, self->count, them->count);
+		b = them->data;
+	}
+	if (op == OP_DIV && type->anyzero(b, isScalar ? 1 : self->count)) {
+		return krk_runtimeError(vm.exceptions->zeroDivisionError, "integer division by zero");
+	}
+	struct Array * out = _newArray(type, self->count);
+	/* Allocating may have run the collector, but both operands are still arguments. */
+	if (!isScalar) b = AS_array(other)->data;
+	type->ops[op](out->data, self->data, b, self->count, isScalar);
+	return OBJECT_VAL(out);
+}
+
+#define ELEMENTWISE_METHOD(name,op) \
+	KRK_Method(array,name) { \
+		METHOD_TAKES_EXACTLY(1); \
+		CHECK_INIT(); \
+		return _elementwise(self, argv[1], op, _method_name); \
+	}
+
+ELEMENTWISE_METHOD(add,OP_ADD)
+ELEMENTWISE_METHOD(sub,OP_SUB)
+ELEMENTWISE_METHOD(mul,OP_MUL)
+ELEMENTWISE_METHOD(div,OP_DIV)
+
+KRK_Method(array,sum) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	return self->type->sum(self->data, self->count);
+}
+
+KRK_Method(array,min) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	if (!self->count) return krk_runtimeError(vm.exceptions->valueError, "min() of empty array");
+	return self->type->min(self->data, self->count);
+}
+
+KRK_Method(array,max) {
+	METHOD_TAKES_NONE();
+	CHECK_INIT();
+	if (!self->count) return krk_runtimeError(vm.exceptions->valueError, "max() of empty array");
+	return self->type->max(self->data, self->count);
+}
+
+KRK_Method(array,dot) {
+	METHOD_TAKES_EXACTLY(1);
+	CHECK_INIT();
+	if (!IS_array(argv[1])) return TYPE_ERROR(array,argv[1]);
+	struct Array * other = AS_array(argv[1]);
+	if (other->type != self->type) return krk_runtimeError(vm.exceptions->typeError, "%s() requires an array of type code '%c', not '%c'", _method_name, self->type->code, other->type ? other->type->code : '?');
+	if (other->count != self->count) return krk_runtimeError(vm.exceptions->valueError, "%s() requires arrays of the same length (%zu and %zu)", _method_name, self->count, other->count);
+	return self->type->dot(self->data, other->data, self->count);
+}
+
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct ArrayIterator *
+#define IS_arrayiterator(o) (krk_isInstanceOf(o,arrayiterator))
+#define AS_arrayiterator(o) ((struct ArrayIterator*)AS_OBJECT(o))
+
+static void _arrayiterator_gcscan(KrkInstance * self) {
+	krk_markValue(((struct ArrayIterator*)self)->array);
+}
+
+KRK_Method(arrayiterator,__init__) {
+	METHOD_TAKES_EXACTLY(1);
+	if (!IS_array(argv[1])) return TYPE_ERROR(array,argv[1]);
+	self->array = argv[1];
+	self->i = 0;
+	return NONE_VAL();
+}
+
+KRK_Method(arrayiterator,__call__) {
+	if (!IS_array(self->array)) return argv[0];
+	struct Array * arr = AS_array(self->array);
+	if (!arr->type || self->i >= arr->count) return argv[0];
+	return arr->type->load(arr->data, self->i++);
+}
+
+KRK_Module(array) {
+	KRK_DOC(module, "@brief Typed arrays of numbers with contiguous storage.");
+
+	krk_makeClass(module, &array, "array", vm.baseClasses->objectClass);
+	KRK_DOC(array,
+		"@brief A mutable sequence of numbers of one machine type.\n\n"
+		"Items are stored unboxed and contiguously, and the storage is available "
+		"through the buffer protocol. Besides the sequence methods, arrays provide "
+		"elementwise arithmetic and reductions that run as typed loops.");
+	array->allocSize = sizeof(struct Array);
+	array->_ongcsweep = _array_gcsweep;
+	array->_getbuffer = _array_getbuffer;
+	KRK_DOC(BIND_METHOD(array,__init__),
+		"@brief Create an array of the given type.\n"
+		"@arguments typecode,initializer=None\n\n"
+		"@p typecode is one of @c b, @c B, @c h, @c H, @c i, @c I, @c l, @c L, @c q, @c Q "
+		"(signed and unsigned integers of 1, 2, 4, 8 and 8 bytes) or @c f and @c d "
+		"(single and double precision floats). @p initializer may be an iterable of "
+		"numbers or a bytes-like object holding the raw items.");
+	BIND_PROP(array,typecode);
+	BIND_PROP(array,itemsize);
+	BIND_METHOD(array,__len__);
+	BIND_METHOD(array,__getitem__);
+	BIND_METHOD(array,__setitem__);
+	BIND_METHOD(array,__delitem__);
+	BIND_METHOD(array,__iter__);
+	BIND_METHOD(array,__repr__);
+	BIND_METHOD(array,__eq__);
+	BIND_METHOD(array,__contains__);
+	BIND_METHOD(array,__add__);
+	BIND_METHOD(array,__iadd__);
+	BIND_METHOD(array,__mul__);
+	BIND_METHOD(array,__rmul__);
+	KRK_DOC(BIND_METHOD(array,append),
+		"@brief Add an item to the end of the array.\n"
+		"@arguments x");
+	KRK_DOC(BIND_METHOD(array,extend),
+		"@brief Add the items of an iterable, or another array of the same type, to the end of the array.\n"
+		"@arguments iterable");
+	KRK_DOC(BIND_METHOD(array,insert),
+		"@brief Insert an item before position @p i.\n"
+		"@arguments i,x");
+	KRK_DOC(BIND_METHOD(array,pop),
+		"@brief Remove and return the item at position @p i, by default the last.\n"
+		"@arguments i=-1");
+	KRK_DOC(BIND_METHOD(array,remove),
+		"@brief Remove the first item equal to @p x.\n"
+		"@arguments x");
+	KRK_DOC(BIND_METHOD(array,index),
+		"@brief Find the position of the first item equal to @p x.\n"
+		"@arguments x");
+	KRK_DOC(BIND_METHOD(array,count),
+		"@brief Count the items equal to @p x.\n"
+		"@arguments x");
+	KRK_DOC(BIND_METHOD(array,reverse),
+		"@brief Reverse the order of the items in place.");
+	KRK_DOC(BIND_METHOD(array,byteswap),
+		"@brief Reverse the byte order of every item, for data from a machine of the other endianness.");
+	KRK_DOC(BIND_METHOD(array,buffer_info),
+		"@brief Return a tuple of the address of the storage and the number of items.");
+	KRK_DOC(BIND_METHOD(array,tobytes),
+		"@brief Return the raw items as a bytes object.");
+	KRK_DOC(BIND_METHOD(array,frombytes),
+		"@brief Append raw items from a bytes-like object.\n"
+		"@arguments data");
+	KRK_DOC(BIND_METHOD(array,tolist),
+		"@brief Return the items as a list.");
+	KRK_DOC(BIND_METHOD(array,fromlist),
+		"@brief Append the items of a list; nothing is added if any item can not be converted.\n"
+		"@arguments list");
+	KRK_DOC(BIND_METHOD(array,tofile),
+		"@brief Write the raw items to a binary file.\n"
+		"@arguments f");
+	KRK_DOC(BIND_METHOD(array,fromfile),
+		"@brief Read @p n raw items from a binary file and append them.\n"
+		"@arguments f,n");
+	KRK_DOC(BIND_METHOD(array,add),
+		"@brief Elementwise sum with an array of the same type and length, or with a number.\n"
+		"@arguments other\n\n"
+		"Returns a new array. Integer arithmetic wraps around on overflow.");
+	KRK_DOC(BIND_METHOD(array,sub),
+		"@brief Elementwise difference with an array of the same type and length, or with a number.\n"
+		"@arguments other");
+	KRK_DOC(BIND_METHOD(array,mul),
+		"@brief Elementwise product with an array of the same type and length, or with a number.\n"
+		"@arguments other");
+	KRK_DOC(BIND_METHOD(array,div),
+		"@brief Elementwise quotient with an array of the same type and length, or with a number.\n"
+		"@arguments other\n\n"
+		"Integer arrays use floor division and raise @c ZeroDivisionError for a zero divisor; "
+		"float arrays follow IEEE 754 and produce infinities or NaNs instead.");
+	KRK_DOC(BIND_METHOD(array,sum),
+		"@brief Sum of the items, as an int for integer arrays or a float for float arrays.\n\n"
+		"Floats are added in double precision across several independent partial sums, so the "
+		"result can differ in the last bits from adding the items one at a time.");
+	KRK_DOC(BIND_METHOD(array,min),
+		"@brief Smallest item.");
+	KRK_DOC(BIND_METHOD(array,max),
+		"@brief Largest item.");
+	KRK_DOC(BIND_METHOD(array,dot),
+		"@brief Sum of the products of the items of this array and another of the same type and length.\n"
+		"@arguments other");
+	krk_finalizeClass(array);
+
+	krk_makeClass(module, &arrayiterator, "arrayiterator", vm.baseClasses->objectClass);
+	arrayiterator->allocSize = sizeof(struct ArrayIterator);
+	arrayiterator->_ongcscan = _arrayiterator_gcscan;
+	BIND_METHOD(arrayiterator,__init__);
+	BIND_METHOD(arrayiterator,__call__);
+	krk_finalizeClass(arrayiterator);
+
+	krk_attachNamedObject(&module->fields, "typecodes", (KrkObj*)S("bBhHiIlLqQfd"));
+}
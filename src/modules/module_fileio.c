@@ -400,9 +400,29 @@ KRK_Method(BinaryFile,read) {
 	return OBJECT_VAL(out);
 }
 
+KRK_Method(BinaryFile,readinto) {
+	METHOD_TAKES_EXACTLY(1);
+	KrkBuffer buffer;
+	if (!krk_getBuffer(argv[1], &buffer, 1)) return NONE_VAL();
+
+	FILE * file = self->filePtr;
+
+	if (!file || feof(file)) {
+		return INTEGER_VAL(0);
+	}
+
+	size_t sizeRead = fread(buffer.buf, 1, buffer.len, file);
+	if (sizeRead < buffer.len && ferror(file)) {
+		return krk_runtimeError(vm.exceptions->ioError, "Read error.");
+	}
+
+	return krk_int_from_ull(sizeRead);
+}
+
 KRK_Method(BinaryFile,write) {
 	METHOD_TAKES_EXACTLY(1);
-	if (!IS_BYTES(argv[1])) return TYPE_ERROR(bytes,argv[1]);
+	KrkBuffer buffer;
+	if (!krk_getBuffer(argv[1], &buffer, 0)) return NONE_VAL();
 	/* Find the file ptr reference */
 	FILE * file = self->filePtr;
 
@@ -410,7 +430,7 @@ KRK_Method(BinaryFile,write) {
 		return NONE_VAL();
 	}
 
-	return krk_int_from_ull(fwrite(AS_BYTES(argv[1])->bytes, 1, AS_BYTES(argv[1])->length, file));
+	return krk_int_from_ull(fwrite(buffer.buf, 1, buffer.len, file));
 }
 
 #undef CURRENT_CTYPE
@@ -534,7 +554,11 @@ KRK_Module(fileio) {
 	BIND_METHOD(BinaryFile,read);
 	BIND_METHOD(BinaryFile,readline);
 	BIND_METHOD(BinaryFile,readlines);
-	BIND_METHOD(BinaryFile,write);
+	KRK_DOC(BIND_METHOD(BinaryFile,readinto), "@brief Read from the stream into an existing buffer.\n"
+		"@arguments buffer\n\n"
+		"Reads up to the length of the writable bytes-like object @p buffer, such as a "
+		"@ref bytearray or @ref memoryview, and returns the number of bytes read.");
+	KRK_DOC(BIND_METHOD(BinaryFile,write), "@brief Write a bytes-like object to the stream.");
 	krk_finalizeClass(BinaryFile);
 
 	KrkClass * Directory = krk_makeClass(module, &fileio_Directory, "Directory", KRK_BASE_CLASS(object));
@@ -0,0 +1,497 @@
+/**
+ * @file    module_heapq.c
+ * @brief   Heap queue algorithms on plain lists.
+ *
+ * Provides Python's @c heapq: a list is a min-heap when
+ * <tt>heap[k] <= heap[2*k+1]</tt> and <tt>heap[k] <= heap[2*k+2]</tt> for
+ * every @c k. The sift loops follow CPython's, which move the new item all
+ * the way down before bubbling it back up and so compare fewer times.
+ *
+ * Ints, floats, strings and tuples whose leading items are of those types
+ * are compared directly; anything else goes through @c __lt__. A
+ * comparison may call back into the VM and change the heap, so every sift
+ * checks the list's length after each comparison.
+ *
+ * @c nsmallest, @c nlargest and @c merge keep heaps of indices instead,
+ * with ties broken by position so their results are stable.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <kuroko/vm.h>
+#include <kuroko/util.h>
+
+#include "../private.h"
+
+static KrkClass * merge;
+
+static int _lt(KrkValue a, KrkValue b);
+
+/** @brief a == b for the directly compared types, or -1 to ask the VM */
+static int _fastEqual(KrkValue a, KrkValue b) {
+	if (krk_valuesSame(a, b)) return 1;
+	if (krk_isNumber(a) && krk_isNumber(b)) return krk_numbersEqual(a, b);
+	if (IS_STRING(a) && IS_STRING(b)) return 0; /* strings are interned */
+	return -1;
+}
+
+/** @brief Tuples compare as in tuple.__lt__: by the first pair of items that are not equal. */
+static int _tupleLess(KrkTuple * a, KrkTuple * b) {
+	size_t lesser = a->values.count < b->values.count ? a->values.count : b->values.count;
+	for (size_t i = 0; i < lesser; ++i) {
+		KrkValue x = a->values.values[i];
+		KrkValue y = b->values.values[i];
+		int same = _fastEqual(x, y);
+		if (same < 0) {
+			same = krk_valuesSameOrEqual(x, y);
+			if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return -1;
+		}
+		if (!same) return _lt(x, y);
+	}
+	return a->values.count < b->values.count;
+}
+
+/**
+ * @brief a < b, or -1 if the comparison raised.
+ */
+static int _lt(KrkValue a, KrkValue b) {
+	if (IS_INTEGER(a) && IS_INTEGER(b)) return AS_INTEGER(a) < AS_INTEGER(b);
+	if (krk_isNumber(a) && krk_isNumber(b)) return krk_numbersLess(a, b);
+	if (IS_STRING(a) && IS_STRING(b)) {
+		size_t aLen = AS_STRING(a)->length;
+		size_t bLen = AS_STRING(b)->length;
+		int c = memcmp(AS_CSTRING(a), AS_CSTRING(b), aLen < bLen ? aLen : bLen);
+		return c < 0 || (c == 0 && aLen < bLen);
+	}
+	if (IS_TUPLE(a) && IS_TUPLE(b)) return _tupleLess(AS_TUPLE(a), AS_TUPLE(b));
+	KrkValue result = krk_operator_lt(a, b);
+	if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return -1;
+	return !krk_isFalsey(result);
+}
+
+/**
+ * @brief Check a comparison result, and that the heap kept its length.
+ *
+ * Returns the result, or -1 with an exception set.
+ */
+static int _compare(KrkList * heap, size_t count, KrkValue a, KrkValue b) {
+	int lt = _lt(a, b);
+	if (lt < 0) return -1;
+	if (heap->values.count != count) {
+		krk_runtimeError(vm.exceptions->Exception, "list changed size during iteration");
+		return -1;
+	}
+	return lt;
+}
+
+/**
+ * @brief Move the item at @p pos towards the root, but not above @p start.
+ *
+ * The item is kept on the stack while it has no slot in the list. Returns
+ * 0 if a comparison raised; the heap then still holds the same items.
+ */
+static int _siftdown(KrkList * heap, size_t start, size_t pos) {
+	size_t count = heap->values.count;
+	KrkValue item = heap->values.values[pos];
+	krk_push(item);
+	int ok = 1;
+	while (pos > start) {
+		size_t parentpos = (pos - 1) >> 1;
+		KrkValue parent = heap->values.values[parentpos];
+		int lt = _compare(heap, count, item, parent);
+		if (lt < 0) {
+			ok = 0;
+			break;
+		}
+		if (!lt) break;
+		heap->values.values[pos] = parent;
+		pos = parentpos;
+	}
+	if (pos < heap->values.count) heap->values.values[pos] = item;
+	krk_pop();
+	return ok;
+}
+
+/** @brief Move the item at @p pos down to a leaf along the smaller children, then back up. */
+static int _siftup(KrkList * heap, size_t pos) {
+	size_t count = heap->values.count;
+	size_t start = pos;
+	KrkValue item = heap->values.values[pos];
+	krk_push(item);
+	size_t child = 2 * pos + 1;
+	while (child < count) {
+		size_t right = child + 1;
+		if (right < count) {
+			int lt = _compare(heap, count, heap->values.values[child], heap->values.values[right]);
+			if (lt < 0) {
+				if (pos < heap->values.count) heap->values.values[pos] = item;
+				krk_pop();
+				return 0;
+			}
+			if (!lt) child = right;
+		}
+		heap->values.values[pos] = heap->values.values[child];
+		pos = child;
+		child = 2 * pos + 1;
+	}
+	heap->values.values[pos] = item;
+	krk_pop();
+	return _siftdown(heap, start, pos);
+}
+
+KRK_Function(heappush) {
+	FUNCTION_TAKES_EXACTLY(2);
+	CHECK_ARG(0,list,KrkList*,heap);
+	krk_writeValueArray(&heap->values, argv[1]);
+	_siftdown(heap, 0, heap->values.count - 1);
+	return NONE_VAL();
+}
+
+KRK_Function(heappop) {
+	FUNCTION_TAKES_EXACTLY(1);
+	CHECK_ARG(0,list,KrkList*,heap);
+	if (!heap->values.count) return krk_runtimeError(vm.exceptions->indexError, "index out of range");
+	KrkValue last = heap->values.values[--heap->values.count];
+	if (!heap->values.count) return last;
+	KrkValue out = heap->values.values[0];
+	heap->values.values[0] = last;
+	krk_push(out);
+	_siftup(heap, 0);
+	return krk_pop();
+}
+
+KRK_Function(heapify) {
+	FUNCTION_TAKES_EXACTLY(1);
+	CHECK_ARG(0,list,KrkList*,heap);
+	for (size_t i = heap->values.count / 2; i > 0; --i) {
+		if (!_siftup(heap, i - 1)) break;
+	}
+	return NONE_VAL();
+}
+
+KRK_Function(heapreplace) {
+	FUNCTION_TAKES_EXACTLY(2);
+	CHECK_ARG(0,list,KrkList*,heap);
+	if (!heap->values.count) return krk_runtimeError(vm.exceptions->indexError, "index out of range");
+	KrkValue out = heap->values.values[0];
+	heap->values.values[0] = argv[1];
+	krk_push(out);
+	_siftup(heap, 0);
+	return krk_pop();
+}
+
+KRK_Function(heappushpop) {
+	FUNCTION_TAKES_EXACTLY(2);
+	CHECK_ARG(0,list,KrkList*,heap);
+	if (!heap->values.count) return argv[1];
+	int lt = _compare(heap, heap->values.count, heap->values.values[0], argv[1]);
+	if (lt <= 0) return lt < 0 ? NONE_VAL() : argv[1];
+	KrkValue out = heap->values.values[0];
+	heap->values.values[0] = argv[1];
+	krk_push(out);
+	_siftup(heap, 0);
+	return krk_pop();
+}
+
+/**
+ * @brief Ordering of an index heap.
+ *
+ * Index @c i sits above @c j when <tt>keys[i] < keys[j]</tt>, or
+ * <tt>keys[j] < keys[i]</tt> if @c descending is set; indices with
+ * equivalent keys are ordered by position, earliest first unless
+ * @c laterFirst is set.
+ */
+struct Ranking {
+	KrkValue * keys;
+	int descending;
+	int laterFirst;
+};
+
+/** @brief Whether index @p i belongs above @p j, or -1 if a comparison raised. */
+static int _above(struct Ranking * r, size_t i, size_t j) {
+	KrkValue a = r->keys[r->descending ? j : i];
+	KrkValue b = r->keys[r->descending ? i : j];
+	int lt = _lt(a, b);
+	if (lt) return lt;
+	lt = _lt(b, a);
+	if (lt) return lt < 0 ? -1 : 0;
+	return r->laterFirst ? i > j : i < j;
+}
+
+/** @brief _siftup for index heaps, which have no items to keep alive. */
+static int _rankSiftup(struct Ranking * r, size_t * heap, size_t count, size_t pos) {
+	size_t start = pos;
+	size_t item = heap[pos];
+	size_t child = 2 * pos + 1;
+	while (child < count) {
+		size_t right = child + 1;
+		if (right < count) {
+			int above = _above(r, heap[right], heap[child]);
+			if (above < 0) goto _error;
+			if (above) child = right;
+		}
+		heap[pos] = heap[child];
+		pos = child;
+		child = 2 * pos + 1;
+	}
+	while (pos > start) {
+		size_t parent = (pos - 1) >> 1;
+		int above = _above(r, item, heap[parent]);
+		if (above < 0) goto _error;
+		if (!above) break;
+		heap[pos] = heap[parent];
+		pos = parent;
+	}
+	heap[pos] = item;
+	return 1;
+_error:
+	heap[pos] = item;
+	return 0;
+}
+
+static int _collect_callback(void * context, const KrkValue * values, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		krk_writeValueArray(context, values[i]);
+	}
+	return 0;
+}
+
+/**
+ * @brief Shared implementation of nsmallest and nlargest.
+ *
+ * Keeps the best @p n indices seen so far in a heap with the worst at the
+ * top, then sorts them in place. The result is what a stable sort of the
+ * items (descending for nlargest) would start with.
+ */
+static KrkValue _select(ssize_t n, KrkValue iterable, KrkValue key, int largest) {
+	KrkValue items = krk_list_of(0, NULL, 0);
+	krk_push(items);
+	if (n <= 0) return krk_pop();
+	krk_unpackIterable(iterable, AS_LIST(items), _collect_callback);
+	if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return NONE_VAL();
+
+	size_t count = AS_LIST(items)->count;
+	KrkValue keys = items;
+	if (!IS_NONE(key)) {
+		keys = krk_list_of(0, NULL, 0);
+		krk_push(keys);
+		for (size_t i = 0; i < count; ++i) {
+			krk_push(key);
+			krk_push(AS_LIST(items)->values[i]);
+			krk_push(krk_callStack(1));
+			if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return NONE_VAL();
+			krk_writeValueArray(AS_LIST(keys), krk_peek(0));
+			krk_pop();
+		}
+	}
+
+	size_t kept = (size_t)n < count ? (size_t)n : count;
+	size_t * heap = malloc(sizeof(size_t) * (kept ? kept : 1));
+	struct Ranking r = { AS_LIST(keys)->values, !largest, 1 };
+	KrkValue result = NONE_VAL();
+
+	for (size_t i = 0; i < kept; ++i) heap[i] = i;
+	for (size_t i = kept / 2; i > 0; --i) {
+		if (!_rankSiftup(&r, heap, kept, i - 1)) goto _done;
+	}
+	for (size_t i = kept; i < count; ++i) {
+		int better = _above(&r, heap[0], i);
+		if (better < 0) goto _done;
+		if (better) {
+			heap[0] = i;
+			if (!_rankSiftup(&r, heap, kept, 0)) goto _done;
+		}
+	}
+	for (size_t end = kept; end > 1; --end) {
+		size_t worst = heap[0];
+		heap[0] = heap[end - 1];
+		heap[end - 1] = worst;
+		if (!_rankSiftup(&r, heap, end - 1, 0)) goto _done;
+	}
+
+	result = krk_list_of(0, NULL, 0);
+	krk_push(result);
+	for (size_t i = 0; i < kept; ++i) {
+		krk_writeValueArray(AS_LIST(result), AS_LIST(items)->values[heap[i]]);
+	}
+	krk_pop();
+
+_done:
+	free(heap);
+	if (!IS_NONE(key)) krk_pop();
+	krk_pop();
+	return result;
+}
+
+KRK_Function(nsmallest) {
+	ssize_t n;
+	KrkValue iterable;
+	KrkValue key = NONE_VAL();
+	if (!krk_parseArgs("nV|V", (const char*[]){"n","iterable","key"}, &n, &iterable, &key)) return NONE_VAL();
+	return _select(n, iterable, key, 0);
+}
+
+KRK_Function(nlargest) {
+	ssize_t n;
+	KrkValue iterable;
+	KrkValue key = NONE_VAL();
+	if (!krk_parseArgs("nV|V", (const char*[]){"n","iterable","key"}, &n, &iterable, &key)) return NONE_VAL();
+	return _select(n, iterable, key, 1);
+}
+
+/**
+ * @brief State of a merge.
+ *
+ * @c heads holds the next item of each source and @c keys their keys (the
+ * same list when there is no key function). @c heap holds the indices of
+ * the sources that are not yet exhausted.
+ */
+struct Merge {
+	KrkInstance inst;
+	KrkValue iterators;
+	KrkValue heads;
+	KrkValue keys;
+	KrkValue key;
+	int reverse;
+	int started;
+	size_t * heap;
+	size_t count;
+};
+
+#define IS_merge(o) (krk_isInstanceOf(o,merge))
+#define AS_merge(o) ((struct Merge*)AS_OBJECT(o))
+#define CURRENT_CTYPE struct Merge *
+#define CURRENT_NAME  self
+
+static void _merge_gcscan(KrkInstance * _self) {
+	struct Merge * self = (struct Merge*)_self;
+	krk_markValue(self->iterators);
+	krk_markValue(self->heads);
+	krk_markValue(self->keys);
+	krk_markValue(self->key);
+}
+
+static void _merge_gcsweep(KrkInstance * _self) {
+	free(((struct Merge*)_self)->heap);
+}
+
+/** @brief Fetch the next item of source @p i; returns 0 when it is exhausted or raised. */
+static int _merge_advance(struct Merge * self, size_t i) {
+	KrkValue iterator = AS_LIST(self->iterators)->values[i];
+	krk_push(iterator);
+	KrkValue item = krk_callStack(0);
+	if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return 0;
+	if (krk_valuesSame(iterator, item)) return 0;
+	AS_LIST(self->heads)->values[i] = item;
+	if (!IS_NONE(self->key)) {
+		krk_push(item);
+		krk_push(self->key);
+		krk_push(item);
+		KrkValue k = krk_callStack(1);
+		krk_pop();
+		if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return 0;
+		AS_LIST(self->keys)->values[i] = k;
+	}
+	return 1;
+}
+
+KRK_Method(merge,__init__) {
+	int remArgc;
+	const KrkValue * remArgv;
+	KrkValue key = NONE_VAL();
+	int reverse = 0;
+	if (!krk_parseArgs(".*Vp", (const char*[]){"key","reverse"}, &remArgc, &remArgv, &key, &reverse)) return NONE_VAL();
+	if (self->heap) return krk_runtimeError(vm.exceptions->valueError, "merge already initialized");
+
+	self->key = key;
+	self->reverse = reverse;
+	self->iterators = krk_list_of(0, NULL, 0);
+	self->heads = krk_list_of(0, NULL, 0);
+	self->keys = IS_NONE(key) ? self->heads : krk_list_of(0, NULL, 0);
+	for (int i = 0; i < remArgc; ++i) {
+		KrkClass * type = krk_getType(remArgv[i]);
+		if (!type->_iter) return krk_runtimeError(vm.exceptions->typeError, "'%T' object is not iterable", remArgv[i]);
+		krk_push(remArgv[i]);
+		KrkValue iterator = krk_callDirect(type->_iter, 1);
+		if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return NONE_VAL();
+		krk_writeValueArray(AS_LIST(self->iterators), iterator);
+		krk_writeValueArray(AS_LIST(self->heads), NONE_VAL());
+		if (!IS_NONE(key)) krk_writeValueArray(AS_LIST(self->keys), NONE_VAL());
+	}
+	self->heap = malloc(sizeof(size_t) * (remArgc ? remArgc : 1));
+	return NONE_VAL();
+}
+
+KRK_Method(merge,__iter__) {
+	METHOD_TAKES_NONE();
+	return argv[0];
+}
+
+KRK_Method(merge,__call__) {
+	if (!self->heap) return argv[0];
+	struct Ranking r = { AS_LIST(self->keys)->values, self->reverse, 0 };
+
+	if (!self->started) {
+		self->started = 1;
+		for (size_t i = 0; i < AS_LIST(self->iterators)->count; ++i) {
+			if (_merge_advance(self, i)) self->heap[self->count++] = i;
+			else if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+		}
+		for (size_t i = self->count / 2; i > 0; --i) {
+			if (!_rankSiftup(&r, self->heap, self->count, i - 1)) return NONE_VAL();
+		}
+	}
+
+	if (!self->count) return argv[0];
+
+	size_t source = self->heap[0];
+	KrkValue out = AS_LIST(self->heads)->values[source];
+	krk_push(out);
+	if (!_merge_advance(self, source)) {
+		if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+		self->heap[0] = self->heap[--self->count];
+	}
+	if (self->count && !_rankSiftup(&r, self->heap, self->count, 0)) return NONE_VAL();
+	return krk_pop();
+}
+
+KRK_Module(heapq) {
+	KRK_DOC(module, "@brief Heap queue algorithms on lists.");
+
+	KRK_DOC(BIND_FUNC(module,heappush),
+		"@brief Push @p item onto @p heap, keeping it a heap.\n"
+		"@arguments heap,item");
+	KRK_DOC(BIND_FUNC(module,heappop),
+		"@brief Pop and return the smallest item of @p heap, keeping it a heap.\n"
+		"@arguments heap");
+	KRK_DOC(BIND_FUNC(module,heapify),
+		"@brief Rearrange the list @p x into a heap in linear time.\n"
+		"@arguments x");
+	KRK_DOC(BIND_FUNC(module,heapreplace),
+		"@brief Pop and return the smallest item of @p heap, then push @p item.\n"
+		"@arguments heap,item\n\n"
+		"Raises @c IndexError if the heap is empty. The returned value may be larger than @p item.");
+	KRK_DOC(BIND_FUNC(module,heappushpop),
+		"@brief Push @p item onto @p heap, then pop and return the smallest item.\n"
+		"@arguments heap,item");
+	KRK_DOC(BIND_FUNC(module,nsmallest),
+		"@brief Return the @p n smallest items of @p iterable, in order.\n"
+		"@arguments n,iterable,key=None\n\n"
+		"Equivalent to <tt>sorted(iterable, key=key)[:n]</tt>.");
+	KRK_DOC(BIND_FUNC(module,nlargest),
+		"@brief Return the @p n largest items of @p iterable, in order.\n"
+		"@arguments n,iterable,key=None\n\n"
+		"Equivalent to <tt>sorted(iterable, key=key, reverse=True)[:n]</tt>.");
+
+	krk_makeClass(module, &merge, "merge", vm.baseClasses->objectClass);
+	KRK_DOC(merge,
+		"@brief Merge sorted iterables into a single sorted iterator.\n\n"
+		"Items are read lazily. Equal items come out in the order of the iterables they came from.");
+	merge->allocSize = sizeof(struct Merge);
+	merge->_ongcscan = _merge_gcscan;
+	merge->_ongcsweep = _merge_gcsweep;
+	KRK_DOC(BIND_METHOD(merge,__init__),
+		"@arguments *iterables,key=None,reverse=False");
+	BIND_METHOD(merge,__iter__);
+	BIND_METHOD(merge,__call__);
+	krk_finalizeClass(merge);
+}
@@ -0,0 +1,1259 @@
+/**
+ * @file    module_itertools.c
+ * @brief   Iterator building blocks.
+ *
+ * Provides Python's @c itertools. Every tool is an iterator class in the
+ * style of the builtin @c map and @c zip: calling it yields the next item,
+ * and it returns itself once exhausted. State is kept in C structs rather
+ * than instance fields, so advancing a pipeline costs one native call per
+ * stage and never resumes a generator frame.
+ *
+ * @c product, @c permutations and @c combinations read their inputs into
+ * tuples up front, as Python does, and walk arrays of indices over them.
+ * @c tee buffers items in chunks shared by all of its iterators; a chunk is
+ * released once every iterator has moved past it.
+ */
+#include <stdlib.h>
+#include <kuroko/vm.h>
+#include <kuroko/util.h>
+
+extern KrkValue krk_operator_add(KrkValue a, KrkValue b);
+
+#define HAS_EXCEPTION() (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)
+
+static KrkClass * count;
+static KrkClass * cycle;
+static KrkClass * repeat;
+static KrkClass * accumulate;
+static KrkClass * chain;
+static KrkClass * islice;
+static KrkClass * dropwhile;
+static KrkClass * takewhile;
+static KrkClass * starmap;
+static KrkClass * zip_longest;
+static KrkClass * groupby;
+static KrkClass * _grouper;
+static KrkClass * product;
+static KrkClass * permutations;
+static KrkClass * combinations;
+static KrkClass * _tee;
+static KrkClass * _tee_dataobject;
+
+/** @brief iter(iterable), or None with an exception set. */
+static KrkValue _iterOf(KrkValue iterable) {
+	KrkClass * type = krk_getType(iterable);
+	if (!type->_iter) return krk_runtimeError(vm.exceptions->typeError, "'%T' object is not iterable", iterable);
+	krk_push(iterable);
+	return krk_callDirect(type->_iter, 1);
+}
+
+/**
+ * @brief Advance @p iterator.
+ *
+ * Returns 1 with the item in @p out, 0 when the iterator is exhausted,
+ * or -1 with an exception set. The item is not kept alive by anything;
+ * push it before allocating.
+ */
+static int _next(KrkValue iterator, KrkValue * out) {
+	krk_push(iterator);
+	KrkValue item = krk_callStack(0);
+	if (unlikely(HAS_EXCEPTION())) return -1;
+	if (krk_valuesSame(iterator, item)) return 0;
+	*out = item;
+	return 1;
+}
+
+/** @brief func(arg) */
+static KrkValue _call1(KrkValue func, KrkValue arg) {
+	krk_push(func);
+	krk_push(arg);
+	return krk_callStack(1);
+}
+
+/** @brief func(a, b) */
+static KrkValue _call2(KrkValue func, KrkValue a, KrkValue b) {
+	krk_push(func);
+	krk_push(a);
+	krk_push(b);
+	return krk_callStack(2);
+}
+
+/** @brief a + b, without dispatch when both are ints. */
+static KrkValue _add(KrkValue a, KrkValue b) {
+	if (IS_INTEGER(a) && IS_INTEGER(b)) {
+		long long out;
+		if (!__builtin_add_overflow(AS_INTEGER(a), AS_INTEGER(b), &out)) return krk_int_from_ll(out);
+	}
+	return krk_operator_add(a, b);
+}
+
+/** @brief tuple(iterable) */
+static KrkValue _tupleOf(KrkValue iterable) {
+	if (IS_TUPLE(iterable)) return iterable;
+	return _call1(OBJECT_VAL(vm.baseClasses->tupleClass), iterable);
+}
+
+/** @brief A tuple of @p pool's items at @p indices. */
+static KrkValue _pick(KrkTuple * pool, size_t * indices, size_t n) {
+	KrkTuple * out = krk_newTuple(n);
+	for (size_t i = 0; i < n; ++i) out->values.values[out->values.count++] = pool->values.values[indices[i]];
+	return OBJECT_VAL(out);
+}
+
+/** @brief Shared @c __iter__ for all of the iterators here. */
+static KrkValue _iter_self(int argc, const KrkValue argv[], int hasKw) {
+	if (argc != 1 || hasKw) return krk_runtimeError(vm.exceptions->argumentError, "__iter__() takes no arguments");
+	return argv[0];
+}
+
+#define CURRENT_NAME  self
+
+/*
+ * count(start=0, step=1)
+ */
+struct Count {
+	KrkInstance inst;
+	KrkValue value;
+	KrkValue step;
+};
+
+#define IS_count(o) (krk_isInstanceOf(o,count))
+#define AS_count(o) ((struct Count*)AS_OBJECT(o))
+#define CURRENT_CTYPE struct Count *
+
+static void _count_gcscan(KrkInstance * _self) {
+	struct Count * self = (struct Count*)_self;
+	krk_markValue(self->value);
+	krk_markValue(self->step);
+}
+
+KRK_Method(count,__init__) {
+	KrkValue start = INTEGER_VAL(0);
+	KrkValue step = INTEGER_VAL(1);
+	if (!krk_parseArgs(".|VV", (const char*[]){"start","step"}, &start, &step)) return NONE_VAL();
+	self->value = start;
+	self->step = step;
+	return NONE_VAL();
+}
+
+KRK_Method(count,__call__) {
+	KrkValue out = self->value;
+	krk_push(out);
+	self->value = _add(out, self->step);
+	if (unlikely(HAS_EXCEPTION())) {
+		self->value = out;
+		return NONE_VAL();
+	}
+	return krk_pop();
+}
+
+KRK_Method(count,__repr__) {
+	if (IS_INTEGER(self->step) && AS_INTEGER(self->step) == 1) return krk_stringFromFormat("count(%R)", self->value);
+	return krk_stringFromFormat("count(%R, %R)", self->value, self->step);
+}
+
+/*
+ * cycle(iterable)
+ */
+struct Cycle {
+	KrkInstance inst;
+	KrkValue iterator;
+	KrkValue saved;
+	size_t index;
+	int replaying;
+};
+
+#define IS_cycle(o) (krk_isInstanceOf(o,cycle))
+#define AS_cycle(o) ((struct Cycle*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Cycle *
+
+static void _cycle_gcscan(KrkInstance * _self) {
+	struct Cycle * self = (struct Cycle*)_self;
+	krk_markValue(self->iterator);
+	krk_markValue(self->saved);
+}
+
+KRK_Method(cycle,__init__) {
+	KrkValue iterable;
+	if (!krk_parseArgs(".V", (const char*[]){"iterable"}, &iterable)) return NONE_VAL();
+	self->saved = krk_list_of(0, NULL, 0);
+	self->index = 0;
+	self->replaying = 0;
+	self->iterator = _iterOf(iterable);
+	return NONE_VAL();
+}
+
+KRK_Method(cycle,__call__) {
+	if (!IS_list(self->saved)) return argv[0];
+	if (!self->replaying) {
+		KrkValue item;
+		int r = _next(self->iterator, &item);
+		if (r < 0) return NONE_VAL();
+		if (r) {
+			krk_writeValueArray(AS_LIST(self->saved), item);
+			return item;
+		}
+		self->replaying = 1;
+		self->iterator = NONE_VAL();
+	}
+	KrkValueArray * saved = AS_LIST(self->saved);
+	if (!saved->count) return argv[0];
+	if (self->index >= saved->count) self->index = 0;
+	return saved->values[self->index++];
+}
+
+/*
+ * repeat(object, times=None)
+ */
+struct Repeat {
+	KrkInstance inst;
+	KrkValue object;
+	ssize_t times; /* -1 for forever */
+};
+
+#define IS_repeat(o) (krk_isInstanceOf(o,repeat))
+#define AS_repeat(o) ((struct Repeat*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Repeat *
+
+static void _repeat_gcscan(KrkInstance * _self) {
+	krk_markValue(((struct Repeat*)_self)->object);
+}
+
+KRK_Method(repeat,__init__) {
+	KrkValue object;
+	KrkValue times = NONE_VAL();
+	if (!krk_parseArgs(".V|V", (const char*[]){"object","times"}, &object, &times)) return NONE_VAL();
+	if (!IS_NONE(times) && !IS_INTEGER(times)) return TYPE_ERROR(int,times);
+	self->object = object;
+	self->times = IS_NONE(times) ? -1 : (AS_INTEGER(times) < 0 ? 0 : AS_INTEGER(times));
+	return NONE_VAL();
+}
+
+KRK_Method(repeat,__call__) {
+	if (self->times == 0) return argv[0];
+	if (self->times > 0) self->times--;
+	return self->object;
+}
+
+KRK_Method(repeat,__repr__) {
+	if (self->times < 0) return krk_stringFromFormat("repeat(%R)", self->object);
+	return krk_stringFromFormat("repeat(%R, %zd)", self->object, self->times);
+}
+
+/*
+ * accumulate(iterable, func=None, *, initial=None)
+ */
+struct Accumulate {
+	KrkInstance inst;
+	KrkValue iterator;
+	KrkValue func;
+	KrkValue total;
+	KrkValue initial;
+	int started;
+};
+
+#define IS_accumulate(o) (krk_isInstanceOf(o,accumulate))
+#define AS_accumulate(o) ((struct Accumulate*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Accumulate *
+
+static void _accumulate_gcscan(KrkInstance * _self) {
+	struct Accumulate * self = (struct Accumulate*)_self;
+	krk_markValue(self->iterator);
+	krk_markValue(self->func);
+	krk_markValue(self->total);
+	krk_markValue(self->initial);
+}
+
+KRK_Method(accumulate,__init__) {
+	KrkValue iterable;
+	KrkValue func = NONE_VAL();
+	KrkValue initial = NONE_VAL();
+	if (!krk_parseArgs(".V|V$V", (const char*[]){"iterable","func","initial"}, &iterable, &func, &initial)) return NONE_VAL();
+	self->func = func;
+	self->initial = initial;
+	self->total = NONE_VAL();
+	self->started = 0;
+	self->iterator = _iterOf(iterable);
+	return NONE_VAL();
+}
+
+KRK_Method(accumulate,__call__) {
+	if (!self->started && !IS_NONE(self->initial)) {
+		self->started = 1;
+		self->total = self->initial;
+		return self->total;
+	}
+	KrkValue item;
+	int r = _next(self->iterator, &item);
+	if (r <= 0) return r ? NONE_VAL() : argv[0];
+	if (!self->started) {
+		self->started = 1;
+		self->total = item;
+		return item;
+	}
+	krk_push(item);
+	KrkValue total = IS_NONE(self->func) ? _add(self->total, item) : _call2(self->func, self->total, item);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	self->total = total;
+	return total;
+}
+
+/*
+ * chain(*iterables), chain.from_iterable(iterable)
+ */
+struct Chain {
+	KrkInstance inst;
+	KrkValue sources;
+	KrkValue active;
+};
+
+#define IS_chain(o) (krk_isInstanceOf(o,chain))
+#define AS_chain(o) ((struct Chain*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Chain *
+
+static void _chain_gcscan(KrkInstance * _self) {
+	struct Chain * self = (struct Chain*)_self;
+	krk_markValue(self->sources);
+	krk_markValue(self->active);
+}
+
+KRK_Method(chain,__init__) {
+	int remArgc;
+	const KrkValue * remArgv;
+	if (!krk_parseArgs(".*", (const char*[]){NULL}, &remArgc, &remArgv)) return NONE_VAL();
+	self->active = NONE_VAL();
+	self->sources = _iterOf(krk_tuple_of(remArgc, remArgv, 0));
+	return NONE_VAL();
+}
+
+KRK_StaticMethod(chain,from_iterable) {
+	KrkClass * cls;
+	KrkValue iterable;
+	if (!krk_parseArgs("O!V", (const char*[]){"cls","iterable"}, vm.baseClasses->typeClass, &cls, &iterable)) return NONE_VAL();
+	if (!krk_isSubClass(cls, chain)) return krk_runtimeError(vm.exceptions->typeError, "%S is not a subclass of chain", cls->name);
+	struct Chain * self = (struct Chain*)krk_newInstance(cls);
+	krk_push(OBJECT_VAL(self));
+	self->active = NONE_VAL();
+	self->sources = NONE_VAL();
+	KrkValue sources = _iterOf(iterable);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	self->sources = sources;
+	return krk_pop();
+}
+
+KRK_Method(chain,__call__) {
+	for (;;) {
+		if (IS_NONE(self->active)) {
+			if (IS_NONE(self->sources)) return argv[0];
+			KrkValue source;
+			int r = _next(self->sources, &source);
+			if (r <= 0) {
+				if (r == 0) self->sources = NONE_VAL();
+				return r ? NONE_VAL() : argv[0];
+			}
+			KrkValue active = _iterOf(source);
+			if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+			self->active = active;
+		}
+		KrkValue item;
+		int r = _next(self->active, &item);
+		if (r > 0) return item;
+		if (r < 0) return NONE_VAL();
+		self->active = NONE_VAL();
+	}
+}
+
+/*
+ * islice(iterable, stop), islice(iterable, start, stop[, step])
+ */
+struct ISlice {
+	KrkInstance inst;
+	KrkValue iterator;
+	ssize_t next;
+	ssize_t stop; /* -1 for None */
+	ssize_t step;
+	ssize_t consumed;
+};
+
+#define IS_islice(o) (krk_isInstanceOf(o,islice))
+#define AS_islice(o) ((struct ISlice*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct ISlice *
+
+static void _islice_gcscan(KrkInstance * _self) {
+	krk_markValue(((struct ISlice*)_self)->iterator);
+}
+
+/** @brief An islice() argument: None, or an int that is at least @p least. */
+static int _sliceArg(KrkValue value, ssize_t fallback, ssize_t least, ssize_t * out) {
+	if (IS_NONE(value)) {
+		*out = fallback;
+		return 1;
+	}
+	if (!IS_INTEGER(value) || AS_INTEGER(value) < least) return 0;
+	*out = AS_INTEGER(value);
+	return 1;
+}
+
+KRK_Method(islice,__init__) {
+	KrkValue iterable;
+	KrkValue a;
+	KrkValue b = NONE_VAL();
+	KrkValue c = NONE_VAL();
+	if (!krk_parseArgs(".VV|VV", (const char*[]){"iterable","start","stop","step"}, &iterable, &a, &b, &c)) return NONE_VAL();
+	KrkValue start = argc > 3 ? a : NONE_VAL();
+	KrkValue stop = argc > 3 ? b : a;
+	if (!_sliceArg(stop, -1, 0, &self->stop)) {
+		return krk_runtimeError(vm.exceptions->valueError, "Stop argument for islice() must be None or an integer: 0 <= x <= sys.maxsize.");
+	}
+	if (!_sliceArg(start, 0, 0, &self->next)) {
+		return krk_runtimeError(vm.exceptions->valueError, "Indices for islice() must be None or an integer: 0 <= x <= sys.maxsize.");
+	}
+	if (!_sliceArg(c, 1, 1, &self->step)) {
+		return krk_runtimeError(vm.exceptions->valueError, "Step for islice() must be a positive integer or None.");
+	}
+	self->consumed = 0;
+	self->iterator = _iterOf(iterable);
+	return NONE_VAL();
+}
+
+KRK_Method(islice,__call__) {
+	if (IS_NONE(self->iterator)) return argv[0];
+	KrkValue item;
+	while (self->consumed < self->next) {
+		int r = _next(self->iterator, &item);
+		if (r <= 0) goto _exhausted;
+		self->consumed++;
+	}
+	if (self->stop != -1 && self->consumed >= self->stop) goto _exhausted;
+	int r = _next(self->iterator, &item);
+	if (r <= 0) goto _exhausted;
+	self->consumed++;
+	if (__builtin_add_overflow(self->next, self->step, &self->next) || (self->stop != -1 && self->next > self->stop)) {
+		self->next = self->stop;
+	}
+	return item;
+
+_exhausted:
+	self->iterator = NONE_VAL();
+	return HAS_EXCEPTION() ? NONE_VAL() : argv[0];
+}
+
+/*
+ * dropwhile(predicate, iterable), takewhile(predicate, iterable)
+ */
+struct PredicateIterator {
+	KrkInstance inst;
+	KrkValue predicate;
+	KrkValue iterator;
+	int done;
+};
+
+#define IS_dropwhile(o) (krk_isInstanceOf(o,dropwhile))
+#define AS_dropwhile(o) ((struct PredicateIterator*)AS_OBJECT(o))
+#define IS_takewhile(o) (krk_isInstanceOf(o,takewhile))
+#define AS_takewhile(o) ((struct PredicateIterator*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct PredicateIterator *
+
+static void _predicate_gcscan(KrkInstance * _self) {
+	struct PredicateIterator * self = (struct PredicateIterator*)_self;
+	krk_markValue(self->predicate);
+	krk_markValue(self->iterator);
+}
+
+static KrkValue _predicate_init(const char * _method_name, struct PredicateIterator * self, int argc, const KrkValue argv[], int hasKw) {
+	KrkValue predicate;
+	KrkValue iterable;
+	if (!krk_parseArgs(".VV", (const char*[]){"predicate","iterable"}, &predicate, &iterable)) return NONE_VAL();
+	self->predicate = predicate;
+	self->done = 0;
+	self->iterator = _iterOf(iterable);
+	return NONE_VAL();
+}
+
+KRK_Method(dropwhile,__init__) {
+	return _predicate_init(_method_name, self, argc, argv, hasKw);
+}
+
+KRK_Method(dropwhile,__call__) {
+	for (;;) {
+		KrkValue item;
+		int r = _next(self->iterator, &item);
+		if (r <= 0) return r ? NONE_VAL() : argv[0];
+		if (self->done) return item;
+		krk_push(item);
+		KrkValue keep = _call1(self->predicate, item);
+		if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+		if (krk_isFalsey(keep)) {
+			self->done = 1;
+			return krk_pop();
+		}
+		krk_pop();
+	}
+}
+
+KRK_Method(takewhile,__init__) {
+	return _predicate_init(_method_name, self, argc, argv, hasKw);
+}
+
+KRK_Method(takewhile,__call__) {
+	if (self->done) return argv[0];
+	KrkValue item;
+	int r = _next(self->iterator, &item);
+	if (r <= 0) return r ? NONE_VAL() : argv[0];
+	krk_push(item);
+	KrkValue keep = _call1(self->predicate, item);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	if (krk_isFalsey(keep)) {
+		self->done = 1;
+		return argv[0];
+	}
+	return krk_pop();
+}
+
+/*
+ * starmap(function, iterable)
+ */
+struct StarMap {
+	KrkInstance inst;
+	KrkValue function;
+	KrkValue iterator;
+};
+
+#define IS_starmap(o) (krk_isInstanceOf(o,starmap))
+#define AS_starmap(o) ((struct StarMap*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct StarMap *
+
+static void _starmap_gcscan(KrkInstance * _self) {
+	struct StarMap * self = (struct StarMap*)_self;
+	krk_markValue(self->function);
+	krk_markValue(self->iterator);
+}
+
+KRK_Method(starmap,__init__) {
+	KrkValue function;
+	KrkValue iterable;
+	if (!krk_parseArgs(".VV", (const char*[]){"function","iterable"}, &function, &iterable)) return NONE_VAL();
+	self->function = function;
+	self->iterator = _iterOf(iterable);
+	return NONE_VAL();
+}
+
+KRK_Method(starmap,__call__) {
+	KrkValue item;
+	int r = _next(self->iterator, &item);
+	if (r <= 0) return r ? NONE_VAL() : argv[0];
+	krk_push(item);
+	KrkValue args = _tupleOf(item);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	krk_push(args);
+	KrkTuple * tuple = AS_TUPLE(args);
+	krk_push(self->function);
+	for (size_t i = 0; i < tuple->values.count; ++i) krk_push(tuple->values.values[i]);
+	KrkValue result = krk_callStack(tuple->values.count);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	krk_pop();
+	krk_pop();
+	return result;
+}
+
+/*
+ * zip_longest(*iterables, fillvalue=None)
+ */
+struct ZipLongest {
+	KrkInstance inst;
+	KrkValue iterators; /* exhausted entries are replaced with None */
+	KrkValue fillvalue;
+	size_t active;
+};
+
+#define IS_zip_longest(o) (krk_isInstanceOf(o,zip_longest))
+#define AS_zip_longest(o) ((struct ZipLongest*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct ZipLongest *
+
+static void _zip_longest_gcscan(KrkInstance * _self) {
+	struct ZipLongest * self = (struct ZipLongest*)_self;
+	krk_markValue(self->iterators);
+	krk_markValue(self->fillvalue);
+}
+
+KRK_Method(zip_longest,__init__) {
+	int remArgc;
+	const KrkValue * remArgv;
+	KrkValue fillvalue = NONE_VAL();
+	if (!krk_parseArgs(".*V", (const char*[]){"fillvalue"}, &remArgc, &remArgv, &fillvalue)) return NONE_VAL();
+	self->fillvalue = fillvalue;
+	self->active = 0;
+	self->iterators = krk_list_of(0, NULL, 0);
+	for (int i = 0; i < remArgc; ++i) {
+		KrkValue iterator = _iterOf(remArgv[i]);
+		if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+		krk_writeValueArray(AS_LIST(self->iterators), iterator);
+	}
+	self->active = remArgc;
+	return NONE_VAL();
+}
+
+KRK_Method(zip_longest,__call__) {
+	if (!self->active || !IS_list(self->iterators)) return argv[0];
+	size_t n = AS_LIST(self->iterators)->count;
+	KrkTuple * out = krk_newTuple(n);
+	krk_push(OBJECT_VAL(out));
+	for (size_t i = 0; i < n; ++i) {
+		KrkValue iterator = AS_LIST(self->iterators)->values[i];
+		KrkValue item = self->fillvalue;
+		if (!IS_NONE(iterator)) {
+			int r = _next(iterator, &item);
+			if (r < 0) return NONE_VAL();
+			if (r == 0) {
+				AS_LIST(self->iterators)->values[i] = NONE_VAL();
+				if (!--self->active) return argv[0];
+				item = self->fillvalue;
+			}
+		}
+		out->values.values[out->values.count++] = item;
+	}
+	return krk_pop();
+}
+
+/*
+ * groupby(iterable, key=None)
+ *
+ * As in CPython, the groupby holds the current item and its key, and the
+ * key of the group being produced. Only the most recent group may be read;
+ * advancing the groupby invalidates older groups.
+ */
+struct GroupBy {
+	KrkInstance inst;
+	KrkValue iterator;
+	KrkValue keyfunc;
+	KrkValue targetKey;
+	KrkValue currentKey;
+	KrkValue currentValue;
+	KrkValue currentGroup;
+	int hasTarget;
+	int hasCurrent;
+	int hasValue;
+};
+
+struct Grouper {
+	KrkInstance inst;
+	KrkValue parent;
+	KrkValue targetKey;
+};
+
+#define IS_groupby(o) (krk_isInstanceOf(o,groupby))
+#define AS_groupby(o) ((struct GroupBy*)AS_OBJECT(o))
+#define IS__grouper(o) (krk_isInstanceOf(o,_grouper))
+#define AS__grouper(o) ((struct Grouper*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct GroupBy *
+
+static void _groupby_gcscan(KrkInstance * _self) {
+	struct GroupBy * self = (struct GroupBy*)_self;
+	krk_markValue(self->iterator);
+	krk_markValue(self->keyfunc);
+	krk_markValue(self->targetKey);
+	krk_markValue(self->currentKey);
+	krk_markValue(self->currentValue);
+	krk_markValue(self->currentGroup);
+}
+
+static void _grouper_gcscan(KrkInstance * _self) {
+	struct Grouper * self = (struct Grouper*)_self;
+	krk_markValue(self->parent);
+	krk_markValue(self->targetKey);
+}
+
+/** @brief Read the next item and its key; returns as @ref _next does. */
+static int _groupby_step(struct GroupBy * self) {
+	KrkValue item;
+	int r = _next(self->iterator, &item);
+	if (r <= 0) return r;
+	krk_push(item);
+	KrkValue key = item;
+	if (!IS_NONE(self->keyfunc)) {
+		key = _call1(self->keyfunc, item);
+		if (unlikely(HAS_EXCEPTION())) return -1;
+	}
+	self->currentValue = item;
+	self->currentKey = key;
+	self->hasCurrent = 1;
+	self->hasValue = 1;
+	krk_pop();
+	return 1;
+}
+
+KRK_Method(groupby,__init__) {
+	KrkValue iterable;
+	KrkValue key = NONE_VAL();
+	if (!krk_parseArgs(".V|V", (const char*[]){"iterable","key"}, &iterable, &key)) return NONE_VAL();
+	self->keyfunc = key;
+	self->targetKey = self->currentKey = self->currentValue = self->currentGroup = NONE_VAL();
+	self->hasTarget = self->hasCurrent = self->hasValue = 0;
+	self->iterator = _iterOf(iterable);
+	return NONE_VAL();
+}
+
+KRK_Method(groupby,__call__) {
+	self->currentGroup = NONE_VAL();
+	/* Skip what is left of the current group */
+	for (;;) {
+		if (self->hasCurrent) {
+			if (!self->hasTarget) break;
+			int same = krk_valuesSameOrEqual(self->targetKey, self->currentKey);
+			if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+			if (!same) break;
+		}
+		int r = _groupby_step(self);
+		if (r <= 0) return r ? NONE_VAL() : argv[0];
+	}
+	self->targetKey = self->currentKey;
+	self->hasTarget = 1;
+
+	struct Grouper * group = (struct Grouper*)krk_newInstance(_grouper);
+	group->parent = argv[0];
+	group->targetKey = self->targetKey;
+	self->currentGroup = OBJECT_VAL(group);
+	krk_push(OBJECT_VAL(group));
+
+	KrkTuple * out = krk_newTuple(2);
+	out->values.values[out->values.count++] = self->currentKey;
+	out->values.values[out->values.count++] = OBJECT_VAL(group);
+	krk_pop();
+	return OBJECT_VAL(out);
+}
+
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Grouper *
+
+KRK_Method(_grouper,__call__) {
+	if (!IS_groupby(self->parent)) return argv[0];
+	struct GroupBy * parent = AS_groupby(self->parent);
+	if (!krk_valuesSame(parent->currentGroup, argv[0])) return argv[0];
+	if (!parent->hasValue) {
+		int r = _groupby_step(parent);
+		if (r <= 0) return r ? NONE_VAL() : argv[0];
+	}
+	int same = krk_valuesSameOrEqual(self->targetKey, parent->currentKey);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	if (!same) return argv[0];
+	KrkValue out = parent->currentValue;
+	parent->currentValue = NONE_VAL();
+	parent->hasValue = 0;
+	return out;
+}
+
+/*
+ * product(*iterables, repeat=1)
+ */
+struct Product {
+	KrkInstance inst;
+	KrkValue pools; /* tuple of tuples, already repeated */
+	size_t * indices;
+	size_t n;
+	int started;
+	int done;
+};
+
+#define IS_product(o) (krk_isInstanceOf(o,product))
+#define AS_product(o) ((struct Product*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Product *
+
+static void _product_gcscan(KrkInstance * _self) {
+	krk_markValue(((struct Product*)_self)->pools);
+}
+
+static void _product_gcsweep(KrkInstance * _self) {
+	free(((struct Product*)_self)->indices);
+}
+
+KRK_Method(product,__init__) {
+	int remArgc;
+	const KrkValue * remArgv;
+	ssize_t times = 1;
+	if (!krk_parseArgs(".*n", (const char*[]){"repeat"}, &remArgc, &remArgv, &times)) return NONE_VAL();
+	if (self->indices) return krk_runtimeError(vm.exceptions->valueError, "product already initialized");
+	if (times < 0) return krk_runtimeError(vm.exceptions->valueError, "repeat argument cannot be negative");
+
+	KrkTuple * unique = krk_newTuple(remArgc);
+	krk_push(OBJECT_VAL(unique));
+	for (int i = 0; i < remArgc; ++i) {
+		KrkValue pool = _tupleOf(remArgv[i]);
+		if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+		unique->values.values[unique->values.count++] = pool;
+	}
+
+	size_t n = (size_t)remArgc * times;
+	KrkTuple * pools = krk_newTuple(n);
+	krk_push(OBJECT_VAL(pools));
+	for (size_t i = 0; i < n; ++i) {
+		KrkValue pool = unique->values.values[i % remArgc];
+		if (!AS_TUPLE(pool)->values.count) self->done = 1;
+		pools->values.values[pools->values.count++] = pool;
+	}
+	self->pools = OBJECT_VAL(pools);
+	self->n = n;
+	self->indices = calloc(n ? n : 1, sizeof(size_t));
+	return NONE_VAL();
+}
+
+KRK_Method(product,__call__) {
+	if (!self->indices || self->done) return argv[0];
+	KrkTuple * pools = AS_TUPLE(self->pools);
+
+	if (self->started) {
+		size_t i = self->n;
+		for (;;) {
+			if (!i) {
+				self->done = 1;
+				return argv[0];
+			}
+			i--;
+			if (++self->indices[i] < AS_TUPLE(pools->values.values[i])->values.count) break;
+			self->indices[i] = 0;
+		}
+	}
+	self->started = 1;
+
+	KrkTuple * out = krk_newTuple(self->n);
+	for (size_t i = 0; i < self->n; ++i) {
+		out->values.values[out->values.count++] = AS_TUPLE(pools->values.values[i])->values.values[self->indices[i]];
+	}
+	return OBJECT_VAL(out);
+}
+
+/*
+ * permutations(iterable, r=None)
+ */
+struct Permutations {
+	KrkInstance inst;
+	KrkValue pool;
+	size_t * indices;
+	size_t * cycles;
+	size_t r;
+	int started;
+	int done;
+};
+
+#define IS_permutations(o) (krk_isInstanceOf(o,permutations))
+#define AS_permutations(o) ((struct Permutations*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Permutations *
+
+static void _permutations_gcscan(KrkInstance * _self) {
+	krk_markValue(((struct Permutations*)_self)->pool);
+}
+
+static void _permutations_gcsweep(KrkInstance * _self) {
+	free(((struct Permutations*)_self)->indices);
+	free(((struct Permutations*)_self)->cycles);
+}
+
+KRK_Method(permutations,__init__) {
+	KrkValue iterable;
+	KrkValue r = NONE_VAL();
+	if (!krk_parseArgs(".V|V", (const char*[]){"iterable","r"}, &iterable, &r)) return NONE_VAL();
+	if (self->indices) return krk_runtimeError(vm.exceptions->valueError, "permutations already initialized");
+	if (!IS_NONE(r) && !IS_INTEGER(r)) return TYPE_ERROR(int,r);
+	if (IS_INTEGER(r) && AS_INTEGER(r) < 0) return krk_runtimeError(vm.exceptions->valueError, "r must be non-negative");
+
+	KrkValue pool = _tupleOf(iterable);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	self->pool = pool;
+
+	size_t n = AS_TUPLE(pool)->values.count;
+	self->r = IS_NONE(r) ? n : (size_t)AS_INTEGER(r);
+	self->done = self->r > n;
+	self->indices = malloc(sizeof(size_t) * (n ? n : 1));
+	self->cycles = calloc(self->r + 1, sizeof(size_t));
+	for (size_t i = 0; i < n; ++i) self->indices[i] = i;
+	for (size_t i = 0; i < self->r && i < n; ++i) self->cycles[i] = n - i;
+	return NONE_VAL();
+}
+
+KRK_Method(permutations,__call__) {
+	if (!self->indices || self->done) return argv[0];
+	KrkTuple * pool = AS_TUPLE(self->pool);
+	size_t n = pool->values.count;
+
+	if (self->started) {
+		size_t i = self->r;
+		for (;;) {
+			if (!i || !n) {
+				self->done = 1;
+				return argv[0];
+			}
+			i--;
+			if (--self->cycles[i] == 0) {
+				/* Rotate indices[i:] left by one */
+				size_t first = self->indices[i];
+				for (size_t j = i; j + 1 < n; ++j) self->indices[j] = self->indices[j+1];
+				self->indices[n-1] = first;
+				self->cycles[i] = n - i;
+			} else {
+				size_t j = n - self->cycles[i];
+				size_t swap = self->indices[i];
+				self->indices[i] = self->indices[j];
+				self->indices[j] = swap;
+				break;
+			}
+		}
+	}
+	self->started = 1;
+	return _pick(pool, self->indices, self->r);
+}
+
+/*
+ * combinations(iterable, r)
+ */
+struct Combinations {
+	KrkInstance inst;
+	KrkValue pool;
+	size_t * indices;
+	size_t r;
+	int started;
+	int done;
+};
+
+#define IS_combinations(o) (krk_isInstanceOf(o,combinations))
+#define AS_combinations(o) ((struct Combinations*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Combinations *
+
+static void _combinations_gcscan(KrkInstance * _self) {
+	krk_markValue(((struct Combinations*)_self)->pool);
+}
+
+static void _combinations_gcsweep(KrkInstance * _self) {
+	free(((struct Combinations*)_self)->indices);
+}
+
+KRK_Method(combinations,__init__) {
+	KrkValue iterable;
+	ssize_t r;
+	if (!krk_parseArgs(".Vn", (const char*[]){"iterable","r"}, &iterable, &r)) return NONE_VAL();
+	if (self->indices) return krk_runtimeError(vm.exceptions->valueError, "combinations already initialized");
+	if (r < 0) return krk_runtimeError(vm.exceptions->valueError, "r must be non-negative");
+
+	KrkValue pool = _tupleOf(iterable);
+	if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+	self->pool = pool;
+
+	self->r = r;
+	self->done = self->r > AS_TUPLE(pool)->values.count;
+	if (self->done) self->r = 0;
+	self->indices = malloc(sizeof(size_t) * (r ? r : 1));
+	for (size_t i = 0; i < self->r; ++i) self->indices[i] = i;
+	return NONE_VAL();
+}
+
+KRK_Method(combinations,__call__) {
+	if (!self->indices || self->done) return argv[0];
+	KrkTuple * pool = AS_TUPLE(self->pool);
+	size_t n = pool->values.count;
+	size_t r = self->r;
+
+	if (self->started) {
+		/* Find the rightmost index that is not at its highest position */
+		size_t i = r;
+		for (;;) {
+			if (!i) {
+				self->done = 1;
+				return argv[0];
+			}
+			i--;
+			if (self->indices[i] != i + n - r) break;
+		}
+		self->indices[i]++;
+		for (size_t j = i + 1; j < r; ++j) self->indices[j] = self->indices[j-1] + 1;
+	}
+	self->started = 1;
+	return _pick(pool, self->indices, r);
+}
+
+/*
+ * tee(iterable, n=2)
+ *
+ * Items are buffered in fixed-size chunks linked in reading order. Each
+ * tee holds the chunk it is reading and its position in it; the source
+ * is only advanced by whichever tee is furthest ahead.
+ */
+#define TEE_CHUNK 57
+
+struct TeeData {
+	KrkInstance inst;
+	KrkValue iterator;
+	KrkValue next;
+	size_t count;
+	int running;
+	KrkValue values[TEE_CHUNK];
+};
+
+struct Tee {
+	KrkInstance inst;
+	KrkValue data;
+	size_t index;
+};
+
+#define IS__tee_dataobject(o) (krk_isInstanceOf(o,_tee_dataobject))
+#define AS__tee_dataobject(o) ((struct TeeData*)AS_OBJECT(o))
+#define IS__tee(o) (krk_isInstanceOf(o,_tee))
+#define AS__tee(o) ((struct Tee*)AS_OBJECT(o))
+#undef CURRENT_CTYPE
+#define CURRENT_CTYPE struct Tee *
+
+static void _tee_dataobject_gcscan(KrkInstance * _self) {
+	struct TeeData * self = (struct TeeData*)_self;
+	krk_markValue(self->iterator);
+	krk_markValue(self->next);
+	for (size_t i = 0; i < self->count; ++i) krk_markValue(self->values[i]);
+}
+
+static void _tee_gcscan(KrkInstance * _self) {
+	krk_markValue(((struct Tee*)_self)->data);
+}
+
+static KrkValue _newTeeData(KrkValue iterator) {
+	struct TeeData * data = (struct TeeData*)krk_newInstance(_tee_dataobject);
+	data->iterator = iterator;
+	data->next = NONE_VAL();
+	return OBJECT_VAL(data);
+}
+
+static KrkValue _newTee(KrkValue data, size_t index) {
+	struct Tee * tee = (struct Tee*)krk_newInstance(_tee);
+	tee->data = data;
+	tee->index = index;
+	return OBJECT_VAL(tee);
+}
+
+KRK_Method(_tee,__call__) {
+	if (!IS__tee_dataobject(self->data)) return argv[0];
+	struct TeeData * data = AS__tee_dataobject(self->data);
+
+	if (self->index == TEE_CHUNK) {
+		if (IS_NONE(data->next)) data->next = _newTeeData(data->iterator);
+		self->data = data->next;
+		self->index = 0;
+		data = AS__tee_dataobject(self->data);
+	}
+
+	if (self->index < data->count) return data->values[self->index++];
+
+	if (data->running) return krk_runtimeError(vm.exceptions->Exception, "cannot re-enter the tee iterator");
+	KrkValue item;
+	data->running = 1;
+	int r = _next(data->iterator, &item);
+	data->running = 0;
+	if (r <= 0) return r ? NONE_VAL() : argv[0];
+	data->values[data->count++] = item;
+	self->index++;
+	return item;
+}
+
+KRK_Method(_tee,__copy__) {
+	return _newTee(self->data, self->index);
+}
+
+KRK_Function(tee) {
+	KrkValue iterable;
+	ssize_t n = 2;
+	if (!krk_parseArgs("V|n", (const char*[]){"iterable","n"}, &iterable, &n)) return NONE_VAL();
+	if (n < 0) return krk_runtimeError(vm.exceptions->valueError, "n must be >= 0");
+
+	/* Like CPython, an existing tee is reused as the first of the new ones. */
+	KrkValue first = iterable;
+	if (!IS__tee(iterable)) {
+		KrkValue iterator = _iterOf(iterable);
+		if (unlikely(HAS_EXCEPTION())) return NONE_VAL();
+		krk_push(iterator);
+		KrkValue data = _newTeeData(iterator);
+		krk_push(data);
+		first = _newTee(data, 0);
+		krk_pop();
+		krk_pop();
+	}
+	krk_push(first);
+
+	KrkTuple * out = krk_newTuple(n);
+	krk_push(OBJECT_VAL(out));
+	for (ssize_t i = 0; i < n; ++i) {
+		out->values.values[out->values.count++] = i ? _newTee(AS__tee(first)->data, AS__tee(first)->index) : first;
+	}
+	krk_pop();
+	krk_pop();
+	return OBJECT_VAL(out);
+}
+
+/** @brief Make an iterator class with a C struct of @p size and the shared @c __iter__. */
+static KrkClass * _makeIterator(KrkInstance * module, KrkClass ** out, const char * name, size_t size, void (*gcscan)(KrkInstance*)) {
+	KrkClass * klass = krk_makeClass(module, out, name, vm.baseClasses->objectClass);
+	klass->allocSize = size;
+	klass->_ongcscan = gcscan;
+	krk_defineNative(&klass->methods, "__iter__", _iter_self);
+	return klass;
+}
+
+KRK_Module(itertools) {
+	KRK_DOC(module, "@brief Functions creating iterators for efficient looping.");
+
+	_makeIterator(module, &count, "count", sizeof(struct Count), _count_gcscan);
+	KRK_DOC(count,
+		"@brief Count from @p start by @p step, forever.\n"
+		"@arguments start=0,step=1");
+	BIND_METHOD(count,__init__);
+	BIND_METHOD(count,__call__);
+	BIND_METHOD(count,__repr__);
+	krk_finalizeClass(count);
+
+	_makeIterator(module, &cycle, "cycle", sizeof(struct Cycle), _cycle_gcscan);
+	KRK_DOC(cycle,
+		"@brief Yield the items of @p iterable, then repeat them forever.\n"
+		"@arguments iterable\n\n"
+		"Items are saved on the first pass, so @p iterable is only read once.");
+	BIND_METHOD(cycle,__init__);
+	BIND_METHOD(cycle,__call__);
+	krk_finalizeClass(cycle);
+
+	_makeIterator(module, &repeat, "repeat", sizeof(struct Repeat), _repeat_gcscan);
+	KRK_DOC(repeat,
+		"@brief Yield @p object @p times times, or forever.\n"
+		"@arguments object,times=None");
+	BIND_METHOD(repeat,__init__);
+	BIND_METHOD(repeat,__call__);
+	BIND_METHOD(repeat,__repr__);
+	krk_finalizeClass(repeat);
+
+	_makeIterator(module, &accumulate, "accumulate", sizeof(struct Accumulate), _accumulate_gcscan);
+	KRK_DOC(accumulate,
+		"@brief Yield running totals of @p iterable.\n"
+		"@arguments iterable,func=None,*,initial=None\n\n"
+		"Totals are sums, or the results of <tt>func(total, item)</tt>. "
+		"If @p initial is given it is yielded first and starts the total.");
+	BIND_METHOD(accumulate,__init__);
+	BIND_METHOD(accumulate,__call__);
+	krk_finalizeClass(accumulate);
+
+	_makeIterator(module, &chain, "chain", sizeof(struct Chain), _chain_gcscan);
+	KRK_DOC(chain,
+		"@brief Yield the items of each iterable in turn.\n"
+		"@arguments *iterables");
+	BIND_METHOD(chain,__init__);
+	BIND_METHOD(chain,__call__);
+	KRK_DOC(BIND_CLASSMETHOD(chain,from_iterable),
+		"@brief Chain the iterables yielded by @p iterable, which is read lazily.\n"
+		"@arguments iterable");
+	krk_finalizeClass(chain);
+
+	_makeIterator(module, &islice, "islice", sizeof(struct ISlice), _islice_gcscan);
+	KRK_DOC(islice,
+		"@brief Yield selected items of @p iterable, like slicing a list.\n"
+		"@arguments iterable,[start,]stop[,step]\n\n"
+		"Indices may not be negative. Items before @p start are read and discarded.");
+	BIND_METHOD(islice,__init__);
+	BIND_METHOD(islice,__call__);
+	krk_finalizeClass(islice);
+
+	_makeIterator(module, &dropwhile, "dropwhile", sizeof(struct PredicateIterator), _predicate_gcscan);
+	KRK_DOC(dropwhile,
+		"@brief Skip items of @p iterable while @p predicate is true, then yield the rest.\n"
+		"@arguments predicate,iterable");
+	BIND_METHOD(dropwhile,__init__);
+	BIND_METHOD(dropwhile,__call__);
+	krk_finalizeClass(dropwhile);
+
+	_makeIterator(module, &takewhile, "takewhile", sizeof(struct PredicateIterator), _predicate_gcscan);
+	KRK_DOC(takewhile,
+		"@brief Yield items of @p iterable while @p predicate is true.\n"
+		"@arguments predicate,iterable");
+	BIND_METHOD(takewhile,__init__);
+	BIND_METHOD(takewhile,__call__);
+	krk_finalizeClass(takewhile);
+
+	_makeIterator(module, &starmap, "starmap", sizeof(struct StarMap), _starmap_gcscan);
+	KRK_DOC(starmap,
+		"@brief Yield <tt>function(*args)</tt> for each @c args in @p iterable.\n"
+		"@arguments function,iterable");
+	BIND_METHOD(starmap,__init__);
+	BIND_METHOD(starmap,__call__);
+	krk_finalizeClass(starmap);
+
+	_makeIterator(module, &zip_longest, "zip_longest", sizeof(struct ZipLongest), _zip_longest_gcscan);
+	KRK_DOC(zip_longest,
+		"@brief Like @c zip, but continue until the longest iterable is exhausted.\n"
+		"@arguments *iterables,fillvalue=None\n\n"
+		"Missing items are replaced with @p fillvalue.");
+	BIND_METHOD(zip_longest,__init__);
+	BIND_METHOD(zip_longest,__call__);
+	krk_finalizeClass(zip_longest);
+
+	_makeIterator(module, &groupby, "groupby", sizeof(struct GroupBy), _groupby_gcscan);
+	KRK_DOC(groupby,
+		"@brief Yield <tt>(key, group)</tt> for runs of items of @p iterable with equal keys.\n"
+		"@arguments iterable,key=None\n\n"
+		"Each group is an iterator sharing @p iterable with the groupby, so it is "
+		"emptied when the groupby moves on.");
+	BIND_METHOD(groupby,__init__);
+	BIND_METHOD(groupby,__call__);
+	krk_finalizeClass(groupby);
+
+	_makeIterator(module, &_grouper, "_grouper", sizeof(struct Grouper), _grouper_gcscan);
+	BIND_METHOD(_grouper,__call__);
+	krk_finalizeClass(_grouper);
+
+	_makeIterator(module, &product, "product", sizeof(struct Product), _product_gcscan);
+	product->_ongcsweep = _product_gcsweep;
+	KRK_DOC(product,
+		"@brief Cartesian product of the iterables, as tuples.\n"
+		"@arguments *iterables,repeat=1\n\n"
+		"The rightmost item advances fastest. With @p repeat, the iterables are "
+		"repeated that many times, as in <tt>product(a, a)</tt> for <tt>product(a, repeat=2)</tt>.");
+	BIND_METHOD(product,__init__);
+	BIND_METHOD(product,__call__);
+	krk_finalizeClass(product);
+
+	_makeIterator(module, &permutations, "permutations", sizeof(struct Permutations), _permutations_gcscan);
+	permutations->_ongcsweep = _permutations_gcsweep;
+	KRK_DOC(permutations,
+		"@brief Successive @p r length permutations of the items of @p iterable, as tuples.\n"
+		"@arguments iterable,r=None\n\n"
+		"@p r defaults to the length of @p iterable. Permutations are produced in "
+		"lexicographic order of positions.");
+	BIND_METHOD(permutations,__init__);
+	BIND_METHOD(permutations,__call__);
+	krk_finalizeClass(permutations);
+
+	_makeIterator(module, &combinations, "combinations", sizeof(struct Combinations), _combinations_gcscan);
+	combinations->_ongcsweep = _combinations_gcsweep;
+	KRK_DOC(combinations,
+		"@brief Successive @p r length subsequences of the items of @p iterable, as tuples.\n"
+		"@arguments iterable,r");
+	BIND_METHOD(combinations,__init__);
+	BIND_METHOD(combinations,__call__);
+	krk_finalizeClass(combinations);
+
+	krk_makeClass(module, &_tee_dataobject, "_tee_dataobject", vm.baseClasses->objectClass);
+	_tee_dataobject->allocSize = sizeof(struct TeeData);
+	_tee_dataobject->_ongcscan = _tee_dataobject_gcscan;
+	krk_finalizeClass(_tee_dataobject);
+
+	_makeIterator(module, &_tee, "_tee", sizeof(struct Tee), _tee_gcscan);
+	BIND_METHOD(_tee,__call__);
+	BIND_METHOD(_tee,__copy__);
+	krk_finalizeClass(_tee);
+
+	KRK_DOC(BIND_FUNC(module,tee),
+		"@brief Return @p n independent iterators over @p iterable.\n"
+		"@arguments iterable,n=2\n\n"
+		"Items are buffered until every iterator has read them, so @p iterable "
+		"should not be used directly afterwards.");
+}
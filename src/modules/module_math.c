@@ -146,6 +146,29 @@ MATH_IS(isfinite)
 MATH_IS(isinf)
 MATH_IS(isnan)
 
+extern KrkValue krk_long_gcd(KrkValue a, KrkValue b);
+extern KrkValue krk_long_isqrt(KrkValue n);
+
+static KrkValue _math_gcd(int argc, const KrkValue argv[], int hasKw) {
+	KrkValue result = INTEGER_VAL(0);
+	for (int i = 0; i < argc; ++i) {
+		result = krk_long_gcd(result, argv[i]);
+		if (IS_NOTIMPL(result)) {
+			return krk_runtimeError(vm.exceptions->typeError, "'%T' object cannot be interpreted as an integer", argv[i]);
+		}
+	}
+	return result;
+}
+
+static KrkValue _math_isqrt(int argc, const KrkValue argv[], int hasKw) {
+	ONE_ARGUMENT(isqrt)
+	KrkValue result = krk_long_isqrt(argv[0]);
+	if (IS_NOTIMPL(result)) {
+		return krk_runtimeError(vm.exceptions->typeError, "'%T' object cannot be interpreted as an integer", argv[0]);
+	}
+	return result;
+}
+
 #define bind(name) krk_defineNative(&module->fields, #name, _math_ ## name)
 
 KRK_Module(math) {
@@ -255,6 +278,14 @@ KRK_Module(math) {
 	KRK_DOC(bind(isnan),
 		"@brief Determines if the input is the floating point `NaN`.\n"
 		"@arguments x\n");
+	KRK_DOC(bind(gcd),
+		"@brief Calculates the greatest common divisor of the integer arguments.\n"
+		"@arguments *integers\n\n"
+		"The result is always non-negative, and is 0 if all arguments are 0 or there are none.");
+	KRK_DOC(bind(isqrt),
+		"@brief Calculates the integer square root of a non-negative integer.\n"
+		"@arguments n\n\n"
+		"The result is the floor of the exact square root of @p n.");
 
 	/**
 	 * Maybe the math library should be a core one, but I'm not sure if I want
@@ -346,17 +346,28 @@ KRK_Function(read) {
 	}
 }
 
-#ifndef IS_bytes
-#define IS_bytes(o) IS_BYTES(o)
-#define AS_bytes(o) AS_BYTES(o)
-#endif
+KRK_Function(readinto) {
+	int fd;
+	KrkValue buf;
+	if (!krk_parseArgs("iV",(const char*[]){"fd","buffer"}, &fd, &buf)) return NONE_VAL();
+	KrkBuffer buffer;
+	if (!krk_getBuffer(buf, &buffer, 1)) return NONE_VAL();
+
+	ssize_t result = read(fd,buffer.buf,buffer.len);
+	if (result == -1) {
+		return krk_runtimeError(KRK_EXC(OSError), "%s", strerror(errno));
+	}
+	return krk_int_from_ll(result);
+}
 
 KRK_Function(write) {
 	int fd;
-	KrkBytes * buf;
-	if (!krk_parseArgs("iO!",(const char*[]){"fd","buf"}, &fd, KRK_BASE_CLASS(bytes), &buf)) return NONE_VAL();
+	KrkValue buf;
+	if (!krk_parseArgs("iV",(const char*[]){"fd","buf"}, &fd, &buf)) return NONE_VAL();
+	KrkBuffer buffer;
+	if (!krk_getBuffer(buf, &buffer, 0)) return NONE_VAL();
 
-	ssize_t result = write(fd,buf->bytes,buf->length);
+	ssize_t result = write(fd,buffer.buf,buffer.len);
 	if (result == -1) {
 		return krk_runtimeError(KRK_EXC(OSError), "%s", strerror(errno));
 	}
@@ -771,7 +782,12 @@ KRK_Module(os) {
 	KRK_DOC(BIND_FUNC(module,write),
 		"@brief Write to an open file descriptor.\n"
 		"@arguments fd,data\n\n"
-		"Writes the @ref bytes object @p data to the open file descriptor @p fd.");
+		"Writes the bytes-like object @p data to the open file descriptor @p fd.");
+	KRK_DOC(BIND_FUNC(module,readinto),
+		"@brief Read from an open file descriptor into an existing buffer.\n"
+		"@arguments fd,buffer\n\n"
+		"Reads at most the length of the writable bytes-like object @p buffer from the "
+		"open file descriptor @p fd, and returns the number of bytes read.");
 	KRK_DOC(BIND_FUNC(module,mkdir),
 		"@brief Create a directory.\n"
 		"@arguments path,mode=0o777\n\n"
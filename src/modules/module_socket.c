@@ -438,17 +438,44 @@ KRK_Method(socket,recv) {
 	return OBJECT_VAL(out);
 }
 
+KRK_Method(socket,recv_into) {
+	METHOD_TAKES_AT_LEAST(1);
+	METHOD_TAKES_AT_MOST(3);
+	KrkBuffer buffer;
+	if (!krk_getBuffer(argv[1], &buffer, 1)) return NONE_VAL();
+	size_t nbytes = buffer.len;
+	if (argc > 2) {
+		CHECK_ARG(2,int,krk_integer_type,_nbytes);
+		if (_nbytes < 0) return krk_runtimeError(vm.exceptions->valueError, "negative buffersize in recv_into");
+		if ((size_t)_nbytes > buffer.len) return krk_runtimeError(vm.exceptions->valueError, "buffer too small for requested bytes");
+		if (_nbytes) nbytes = _nbytes;
+	}
+	int flags = 0;
+	if (argc > 3) {
+		CHECK_ARG(3,int,krk_integer_type,_flags);
+		flags = _flags;
+	}
+
+	ssize_t result = recv(self->sockfd, buffer.buf, nbytes, flags);
+	if (result < 0) {
+		return krk_runtimeError(SocketError, "Socket error: %s", strerror(errno));
+	}
+
+	return INTEGER_VAL(result);
+}
+
 KRK_Method(socket,send) {
 	METHOD_TAKES_AT_LEAST(1);
 	METHOD_TAKES_AT_MOST(2);
-	CHECK_ARG(1,bytes,KrkBytes*,buf);
+	KrkBuffer buffer;
+	if (!krk_getBuffer(argv[1], &buffer, 0)) return NONE_VAL();
 	int flags = 0;
 	if (argc > 2) {
 		CHECK_ARG(2,int,krk_integer_type,_flags);
 		flags = _flags;
 	}
 
-	ssize_t result = send(self->sockfd, (void*)buf->bytes, buf->length, flags);
+	ssize_t result = send(self->sockfd, buffer.buf, buffer.len, flags);
 	if (result < 0) {
 		return krk_runtimeError(SocketError, "Socket error: %s", strerror(errno));
 	}
@@ -459,7 +486,8 @@ KRK_Method(socket,send) {
 KRK_Method(socket,sendto) {
 	METHOD_TAKES_AT_LEAST(1);
 	METHOD_TAKES_AT_MOST(3);
-	CHECK_ARG(1,bytes,KrkBytes*,buf);
+	KrkBuffer buffer;
+	if (!krk_getBuffer(argv[1], &buffer, 0)) return NONE_VAL();
 	int flags = 0;
 	if (argc > 3) {
 		CHECK_ARG(2,int,krk_integer_type,_flags);
@@ -477,7 +505,9 @@ KRK_Method(socket,sendto) {
 		return NONE_VAL();
 	}
 
-	ssize_t result = sendto(self->sockfd, (void*)buf->bytes, buf->length, flags, (struct sockaddr*)&sock_addr, sock_size);
+	/* Parsing the address may have allocated, so look up the buffer again. */
+	if (!krk_getBuffer(argv[1], &buffer, 0)) return NONE_VAL();
+	ssize_t result = sendto(self->sockfd, buffer.buf, buffer.len, flags, (struct sockaddr*)&sock_addr, sock_size);
 	if (result < 0) {
 		return krk_runtimeError(SocketError, "Socket error: %s", strerror(errno));
 	}
@@ -569,15 +599,20 @@ KRK_Module(socket) {
 		"@brief Receive data from a connected socket.\n"
 		"@arguments bufsize,[flags]\n\n"
 		"Receive up to @p bufsize bytes of data, which is returned as a @ref bytes object.");
+	KRK_DOC(BIND_METHOD(socket,recv_into),
+		"@brief Receive data from a connected socket into an existing buffer.\n"
+		"@arguments buffer,[nbytes],[flags]\n\n"
+		"Receive up to @p nbytes bytes of data, or the length of @p buffer if @p nbytes is not given "
+		"or is 0, into the writable bytes-like object @p buffer. Returns the number of bytes received.");
 	KRK_DOC(BIND_METHOD(socket,send),
 		"@brief Send data to a connected socket.\n"
 		"@arguments buf,[flags]\n\n"
-		"Send the data in the @ref bytes object @p buf to the socket. Returns the number "
+		"Send the data in the bytes-like object @p buf to the socket. Returns the number "
 		"of bytes written to the socket.");
 	KRK_DOC(BIND_METHOD(socket,sendto),
 		"@brief Send data to an socket with a particular destination.\n"
 		"@arguments buf,[flags],addr\n\n"
-		"Send the data in the @ref bytes object @p buf to the socket. Returns the number "
+		"Send the data in the bytes-like object @p buf to the socket. Returns the number "
 		"of bytes written to the socket.");
 	KRK_DOC(BIND_METHOD(socket,fileno),
 		"@brief Get the file descriptor number for the underlying socket.");
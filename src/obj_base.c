@@ -76,6 +76,10 @@ KRK_StaticMethod(type,__new__) {
 	krk_push(OBJECT_VAL(_class));
 	_class->_class = metaclass;
 
+	/* Instances of managed classes share one layout of attribute names. */
+	_class->sharedKeys = KRK_ALLOCATE(KrkTable, 1);
+	krk_initTable(_class->sharedKeys);
+
 	/* Now copy the values over */
 	krk_tableAddAll(&nspace->entries, &_class->methods);
 
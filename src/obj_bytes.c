@@ -38,10 +38,10 @@ KRK_StaticMethod(bytes,__new__) {
 	if (argc < 2) return OBJECT_VAL(krk_newBytes(0,NULL));
 	METHOD_TAKES_AT_MOST(1);
 
-	if (IS_bytearray(argv[1])) {
-		return OBJECT_VAL(krk_newBytes(
-			AS_BYTES(AS_bytearray(argv[1])->actual)->length,
-			AS_BYTES(AS_bytearray(argv[1])->actual)->bytes));
+	if (IS_BYTES(argv[1]) || krk_getType(argv[1])->_getbuffer) {
+		KrkBuffer buffer;
+		if (!krk_getBuffer(argv[1], &buffer, 0)) return NONE_VAL();
+		return OBJECT_VAL(krk_newBytes(buffer.len, buffer.buf));
 	} else if (IS_STRING(argv[1])) {
 		return OBJECT_VAL(krk_newBytes(AS_STRING(argv[1])->length, (uint8_t*)AS_CSTRING(argv[1])));
 	} else if (IS_INTEGER(argv[1])) {
@@ -61,13 +61,7 @@ KRK_StaticMethod(bytes,__new__) {
 
 KRK_Method(bytes,__hash__) {
 	METHOD_TAKES_NONE();
-	uint32_t hash = 0;
-	/* This is the so-called "sdbm" hash. It comes from a piece of
-	 * public domain code from a clone of ndbm. */
-	for (size_t i = 0; i < self->length; ++i) {
-		krk_hash_advance(hash,self->bytes[i]);
-	}
-	return INTEGER_VAL(hash);
+	return INTEGER_VAL(krk_hashBytes(self->bytes, self->length));
 }
 
 /* bytes objects are not interned; need to do this the old-fashioned way. */
@@ -143,7 +137,7 @@ KRK_Method(bytes,__getitem__) {
 
 		if (step == 1) {
 			krk_integer_type len = end - start;
-			return OBJECT_VAL(krk_newBytes(len, &self->bytes[start]));
+			return OBJECT_VAL(krk_bytesSlice(self, start, len));
 		} else {
 			struct StringBuilder sb = {0};
 			krk_integer_type i = start;
@@ -162,27 +156,85 @@ KRK_Method(bytes,__len__) {
 	return INTEGER_VAL(AS_BYTES(argv[0])->length);
 }
 
-KRK_Method(bytes,__contains__) {
-	METHOD_TAKES_EXACTLY(1);
-
-	if (IS_BYTES(argv[1])) {
-		return krk_runtimeError(vm.exceptions->notImplementedError, "not implemented: bytes.__contains__(bytes)");
+/**
+ * Substring searches accept any bytes-like object, or a single byte value.
+ */
+static int _bytes_needle(KrkValue sub, const char ** needle, size_t * length, char * single) {
+	if (IS_BYTES(sub) || krk_getType(sub)->_getbuffer) {
+		KrkBuffer buffer;
+		if (!krk_getBuffer(sub, &buffer, 0)) return 0;
+		*needle = buffer.buf;
+		*length = buffer.len;
+	} else if (IS_INTEGER(sub)) {
+		if (AS_INTEGER(sub) < 0 || AS_INTEGER(sub) > 255) {
+			krk_runtimeError(vm.exceptions->valueError, "byte must be in range(0, 256)");
+			return 0;
+		}
+		*single = AS_INTEGER(sub);
+		*needle = single;
+		*length = 1;
+	} else {
+		krk_runtimeError(vm.exceptions->typeError, "argument should be integer or bytes-like object, not '%T'", sub);
+		return 0;
 	}
+	return 1;
+}
 
-	if (!IS_INTEGER(argv[1])) {
-		return TYPE_ERROR(int,argv[1]);
+static KrkValue _bytes_search(KrkBytes * self, KrkValue sub, ssize_t start, ssize_t end, int counting) {
+	const char * needle;
+	size_t length;
+	char single;
+	if (!_bytes_needle(sub, &needle, &length, &single)) return NONE_VAL();
+
+	/* As in CPython, a start past the end finds nothing, not even b'' */
+	if (start < 0) start += self->length;
+	if (start < 0) start = 0;
+	if (start > (ssize_t)self->length) return INTEGER_VAL(counting ? 0 : -1);
+	if (end < 0) end += self->length;
+	if (end < 0) end = 0;
+	if (end > (ssize_t)self->length) end = self->length;
+
+	if (start > end) return INTEGER_VAL(counting ? 0 : -1);
+
+	/* An empty bytes object has no buffer at all, so don't ask krk_memmem */
+	if (length == 0) return INTEGER_VAL(counting ? end - start + 1 : start);
+
+	const char * c = (const char *)self->bytes + start;
+	const char * stop = (const char *)self->bytes + end;
+	if (!counting) {
+		const char * found = krk_memmem(c, stop - c, needle, length);
+		return INTEGER_VAL(found ? found - (const char *)self->bytes : -1);
 	}
 
-	krk_integer_type val = AS_INTEGER(argv[1]);
-	if (val < 0 || val > 255) {
-		return krk_runtimeError(vm.exceptions->valueError, "byte must be in range(0, 256)");
+	krk_integer_type count = 0;
+	while ((c = krk_memmem(c, stop - c, needle, length))) {
+		count++;
+		c += length;
 	}
+	return INTEGER_VAL(count);
+}
 
-	for (size_t i = 0; i < self->length; ++i) {
-		if (self->bytes[i] == val) return BOOLEAN_VAL(1);
-	}
+KRK_Method(bytes,__contains__) {
+	METHOD_TAKES_EXACTLY(1);
+	KrkValue result = _bytes_search(self, argv[1], 0, self->length, 0);
+	if (!IS_INTEGER(result)) return result;
+	return BOOLEAN_VAL(AS_INTEGER(result) != -1);
+}
+
+KRK_Method(bytes,find) {
+	KrkValue sub;
+	ssize_t start = 0;
+	ssize_t end = self->length;
+	if (!krk_parseArgs(".V|nn", (const char*[]){"sub","start","end"}, &sub, &start, &end)) return NONE_VAL();
+	return _bytes_search(self, sub, start, end, 0);
+}
 
-	return BOOLEAN_VAL(0);
+KRK_Method(bytes,count) {
+	KrkValue sub;
+	ssize_t start = 0;
+	ssize_t end = self->length;
+	if (!krk_parseArgs(".V|nn", (const char*[]){"sub","start","end"}, &sub, &start, &end)) return NONE_VAL();
+	return _bytes_search(self, sub, start, end, 1);
 }
 
 KRK_Method(bytes,decode) {
@@ -298,12 +350,28 @@ static void _bytearray_gcscan(KrkInstance * self) {
 	krk_markValue(((struct ByteArray*)self)->actual);
 }
 
+static int _bytearray_getbuffer(KrkValue value, KrkBuffer * buffer) {
+	struct ByteArray * self = AS_bytearray(value);
+	if (!IS_BYTES(self->actual)) {
+		krk_runtimeError(vm.exceptions->valueError, "uninitialized bytearray");
+		return 0;
+	}
+	buffer->buf = AS_BYTES(self->actual)->bytes;
+	buffer->len = AS_BYTES(self->actual)->length;
+	buffer->itemsize = 1;
+	buffer->format = "B";
+	buffer->readonly = 0;
+	return 1;
+}
+
 KRK_Method(bytearray,__init__) {
 	METHOD_TAKES_AT_MOST(1);
 	if (argc < 2) {
 		self->actual = OBJECT_VAL(krk_newBytes(0,NULL));
-	} else if (IS_BYTES(argv[1])) {
-		self->actual = OBJECT_VAL(krk_newBytes(AS_BYTES(argv[1])->length, AS_BYTES(argv[1])->bytes));
+	} else if (IS_BYTES(argv[1]) || krk_getType(argv[1])->_getbuffer) {
+		KrkBuffer buffer;
+		if (!krk_getBuffer(argv[1], &buffer, 0)) return NONE_VAL();
+		self->actual = OBJECT_VAL(krk_newBytes(buffer.len, buffer.buf));
 	} else if (IS_INTEGER(argv[1])) {
 		self->actual = OBJECT_VAL(krk_newBytes(AS_INTEGER(argv[1]),NULL));
 		memset(AS_BYTES(self->actual)->bytes, 0, AS_BYTES(self->actual)->length);
@@ -390,11 +458,25 @@ KRK_Method(bytearray,__len__) {
 
 KRK_Method(bytearray,__contains__) {
 	METHOD_TAKES_EXACTLY(1);
-	CHECK_ARG(1,int,krk_integer_type,val);
-	for (size_t i = 0; i < AS_BYTES(self->actual)->length; ++i) {
-		if (AS_BYTES(self->actual)->bytes[i] == val) return BOOLEAN_VAL(1);
-	}
-	return BOOLEAN_VAL(0);
+	KrkValue result = _bytes_search(AS_BYTES(self->actual), argv[1], 0, AS_BYTES(self->actual)->length, 0);
+	if (!IS_INTEGER(result)) return result;
+	return BOOLEAN_VAL(AS_INTEGER(result) != -1);
+}
+
+KRK_Method(bytearray,find) {
+	KrkValue sub;
+	ssize_t start = 0;
+	ssize_t end = AS_BYTES(self->actual)->length;
+	if (!krk_parseArgs(".V|nn", (const char*[]){"sub","start","end"}, &sub, &start, &end)) return NONE_VAL();
+	return _bytes_search(AS_BYTES(self->actual), sub, start, end, 0);
+}
+
+KRK_Method(bytearray,count) {
+	KrkValue sub;
+	ssize_t start = 0;
+	ssize_t end = AS_BYTES(self->actual)->length;
+	if (!krk_parseArgs(".V|nn", (const char*[]){"sub","start","end"}, &sub, &start, &end)) return NONE_VAL();
+	return _bytes_search(AS_BYTES(self->actual), sub, start, end, 1);
 }
 
 KRK_Method(bytearray,decode) {
@@ -434,6 +516,8 @@ void _createAndBind_bytesClass(void) {
 	BIND_METHOD(bytes,__hash__);
 	BIND_METHOD(bytes,decode);
 	BIND_METHOD(bytes,join);
+	BIND_METHOD(bytes,find);
+	BIND_METHOD(bytes,count);
 	krk_finalizeClass(bytes);
 
 	KrkClass * bytesiterator = ADD_BASE_CLASS(vm.baseClasses->bytesiteratorClass, "bytesiterator", vm.baseClasses->objectClass);
@@ -447,6 +531,7 @@ void _createAndBind_bytesClass(void) {
 	KrkClass * bytearray = ADD_BASE_CLASS(vm.baseClasses->bytearrayClass, "bytearray", vm.baseClasses->objectClass);
 	bytearray->allocSize = sizeof(struct ByteArray);
 	bytearray->_ongcscan = _bytearray_gcscan;
+	bytearray->_getbuffer = _bytearray_getbuffer;
 	KRK_DOC(BIND_METHOD(bytearray,__init__),
 		"@brief A mutable array of bytes.\n"
 		"@arguments bytes=None");
@@ -458,5 +543,7 @@ void _createAndBind_bytesClass(void) {
 	BIND_METHOD(bytearray,__eq__);
 	BIND_METHOD(bytearray,__iter__);
 	BIND_METHOD(bytearray,decode);
+	BIND_METHOD(bytearray,find);
+	BIND_METHOD(bytearray,count);
 	krk_finalizeClass(bytearray);
 }
@@ -219,6 +219,12 @@ KRK_Method(dict,clear) {
 	return NONE_VAL();
 }
 
+KRK_Method(dict,compact) {
+	METHOD_TAKES_NONE();
+	krk_tableCompact(&self->entries);
+	return NONE_VAL();
+}
+
 KRK_Method(dict,get) {
 	METHOD_TAKES_AT_LEAST(1);
 	METHOD_TAKES_AT_MOST(2);
@@ -517,6 +523,7 @@ void _createAndBind_dictClass(void) {
 	BIND_METHOD(dict,capacity);
 	BIND_METHOD(dict,copy);
 	BIND_METHOD(dict,clear);
+	BIND_METHOD(dict,compact);
 	BIND_METHOD(dict,get);
 	BIND_METHOD(dict,setdefault);
 	BIND_METHOD(dict,update);
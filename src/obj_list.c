@@ -5,15 +5,105 @@
 #include <kuroko/util.h>
 #include <kuroko/threads.h>
 
-#define LIST_WRAP_INDEX() \
+#include "private.h"
+
+#define LIST_WRAP_INDEX(unlock) \
 	if (index < 0) index += self->values.count; \
-	if (unlikely(index < 0 || index >= (krk_integer_type)self->values.count)) return krk_runtimeError(vm.exceptions->indexError, "list index out of range: %zd", (ssize_t)index)
+	if (unlikely(index < 0 || index >= (krk_integer_type)self->values.count)) return (unlock), krk_runtimeError(vm.exceptions->indexError, "list index out of range: %zd", (ssize_t)index)
 
 #define LIST_WRAP_SOFT(val) \
 	if (val < 0) val += self->values.count; \
 	if (val < 0) val = 0; \
 	if (val > (krk_integer_type)self->values.count) val = self->values.count
 
+/**
+ * @brief Per-list locking.
+ *
+ * Until a second thread is started nothing can contend for a list, so the
+ * lock word is updated with plain arithmetic. The counts stay exact either
+ * way, which keeps them valid if a thread is started while a lock is held.
+ *
+ * The writer is recorded so that it can take the lock again: sort and
+ * extend keep the write lock while running key functions and iterators,
+ * and those may read or change the list. Readers are not recorded, so a
+ * read lock is never held across a call into the VM; see @ref _list_search_equal.
+ */
+#ifndef KRK_DISABLE_THREADS
+static inline int _list_owned(KrkList * self) {
+	return __atomic_load_n(&self->rwowner, __ATOMIC_RELAXED) == (void*)&krk_currentThread;
+}
+#endif
+
+static inline void _list_rdlock(KrkList * self) {
+#ifndef KRK_DISABLE_THREADS
+	if (_list_owned(self)) self->rwdepth++;
+	else if (vm.globalFlags & KRK_GLOBAL_THREADS) _krk_rwlock_rdlock(&self->rwlock);
+	else self->rwlock += 1;
+#endif
+}
+
+static inline void _list_rdunlock(KrkList * self) {
+#ifndef KRK_DISABLE_THREADS
+	if (_list_owned(self)) self->rwdepth--;
+	else if (vm.globalFlags & KRK_GLOBAL_THREADS) _krk_rwlock_rdunlock(&self->rwlock);
+	else self->rwlock -= 1;
+#endif
+}
+
+static inline void _list_wrlock(KrkList * self) {
+#ifndef KRK_DISABLE_THREADS
+	if (_list_owned(self)) {
+		self->rwdepth++;
+		return;
+	}
+	if (vm.globalFlags & KRK_GLOBAL_THREADS) _krk_rwlock_wrlock(&self->rwlock);
+	else self->rwlock += KRK_RWLOCK_WRITER;
+	__atomic_store_n(&self->rwowner, (void*)&krk_currentThread, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline void _list_wrunlock(KrkList * self) {
+#ifndef KRK_DISABLE_THREADS
+	if (self->rwdepth) {
+		self->rwdepth--;
+		return;
+	}
+	__atomic_store_n(&self->rwowner, NULL, __ATOMIC_RELAXED);
+	if (vm.globalFlags & KRK_GLOBAL_THREADS) _krk_rwlock_wrunlock(&self->rwlock);
+	else self->rwlock -= KRK_RWLOCK_WRITER;
+#endif
+}
+
+/**
+ * @brief Equality test for the searching methods.
+ *
+ * Pairs of numbers and of strings are compared directly; anything else goes
+ * through krk_valuesSameOrEqual with the operands in the same order.
+ */
+static inline int _list_equal(KrkValue a, KrkValue b) {
+	if (krk_valuesSame(a,b)) return 1;
+	if (krk_isNumber(a) && krk_isNumber(b)) return krk_numbersEqual(a,b);
+	if (IS_STRING(a) && IS_STRING(b)) return 0; /* strings are interned */
+	return krk_valuesSameOrEqual(a,b);
+}
+
+/**
+ * @brief @ref _list_equal for loops holding the read lock.
+ *
+ * An @c __eq__ may change the list, so the lock is released around anything
+ * that is not compared directly, and callers must re-check their bounds
+ * after every call.
+ */
+static inline int _list_search_equal(KrkList * self, KrkValue a, KrkValue b) {
+	if (krk_valuesSame(a,b)) return 1;
+	if (krk_isNumber(a) && krk_isNumber(b)) return krk_numbersEqual(a,b);
+	if (IS_STRING(a) && IS_STRING(b)) return 0;
+	_list_rdunlock(self);
+	int result = krk_valuesSameOrEqual(a,b);
+	_list_rdlock(self);
+	return result;
+}
+
 static void _list_gcscan(KrkInstance * self) {
 	for (size_t i = 0; i < ((KrkList*)self)->values.count; ++i) {
 		krk_markValue(((KrkList*)self)->values.values[i]);
@@ -39,7 +129,6 @@ KrkValue krk_list_of(int argc, const KrkValue argv[], int hasKw) {
 		AS_LIST(outList)->count = argc;
 	}
 
-	pthread_rwlock_init(&((KrkList*)AS_OBJECT(outList))->rwlock, NULL);
 	return krk_pop();
 }
 
@@ -50,23 +139,23 @@ KRK_Method(list,__getitem__) {
 	METHOD_TAKES_EXACTLY(1);
 	if (IS_INTEGER(argv[1])) {
 		CHECK_ARG(1,int,krk_integer_type,index);
-		if (vm.globalFlags & KRK_GLOBAL_THREADS) pthread_rwlock_rdlock(&self->rwlock);
-		LIST_WRAP_INDEX();
+		_list_rdlock(self);
+		LIST_WRAP_INDEX(_list_rdunlock(self));
 		KrkValue result = self->values.values[index];
-		if (vm.globalFlags & KRK_GLOBAL_THREADS) pthread_rwlock_unlock(&self->rwlock);
+		_list_rdunlock(self);
 		return result;
 	} else if (IS_slice(argv[1])) {
-		pthread_rwlock_rdlock(&self->rwlock);
+		_list_rdlock(self);
 
 		KRK_SLICER(argv[1],self->values.count) {
-			pthread_rwlock_unlock(&self->rwlock);
+			_list_rdunlock(self);
 			return NONE_VAL();
 		}
 
 		if (step == 1) {
 			krk_integer_type len = end - start;
 			KrkValue result = krk_list_of(len, &AS_LIST(argv[0])->values[start], 0);
-			pthread_rwlock_unlock(&self->rwlock);
+			_list_rdunlock(self);
 			return result;
 		} else {
 			/* iterate and push */
@@ -87,7 +176,7 @@ KRK_Method(list,__getitem__) {
 				len--;
 			}
 
-			pthread_rwlock_unlock(&self->rwlock);
+			_list_rdunlock(self);
 			return krk_pop();
 		}
 	} else {
@@ -100,24 +189,24 @@ KRK_Method(list,__eq__) {
 	if (!IS_list(argv[1])) return NOTIMPL_VAL();
 	KrkList * them = AS_list(argv[1]);
 	if (self->values.count != them->values.count) return BOOLEAN_VAL(0);
-	for (size_t i = 0; i < self->values.count; ++i) {
-		if (!krk_valuesSameOrEqual(self->values.values[i], them->values.values[i])) return BOOLEAN_VAL(0);
+	for (size_t i = 0; i < self->values.count && i < them->values.count; ++i) {
+		if (!_list_equal(self->values.values[i], them->values.values[i])) return BOOLEAN_VAL(0);
 	}
-	return BOOLEAN_VAL(1);
+	return BOOLEAN_VAL(self->values.count == them->values.count);
 }
 
 KRK_Method(list,append) {
 	METHOD_TAKES_EXACTLY(1);
-	pthread_rwlock_wrlock(&self->rwlock);
+	_list_wrlock(self);
 	krk_writeValueArray(&self->values, argv[1]);
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_wrunlock(self);
 	return NONE_VAL();
 }
 
 KRK_Method(list,insert) {
 	METHOD_TAKES_EXACTLY(2);
 	CHECK_ARG(1,int,krk_integer_type,index);
-	pthread_rwlock_wrlock(&self->rwlock);
+	_list_wrlock(self);
 	LIST_WRAP_SOFT(index);
 	krk_writeValueArray(&self->values, NONE_VAL());
 	memmove(
@@ -126,7 +215,7 @@ KRK_Method(list,insert) {
 		sizeof(KrkValue) * (self->values.count - index - 1)
 	);
 	self->values.values[index] = argv[2];
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_wrunlock(self);
 	return NONE_VAL();
 }
 
@@ -136,14 +225,18 @@ KRK_Method(list,__repr__) {
 	((KrkObj*)self)->flags |= KRK_OBJ_FLAGS_IN_REPR;
 	struct StringBuilder sb = {0};
 	pushStringBuilder(&sb, '[');
-	pthread_rwlock_rdlock(&self->rwlock);
+	/* An item's __repr__ may change the list, so no lock is held across it */
+	_list_rdlock(self);
 	for (size_t i = 0; i < self->values.count; ++i) {
-		if (!krk_pushStringBuilderFormat(&sb,"%R",self->values.values[i])) goto _error;
+		KrkValue item = self->values.values[i];
+		_list_rdunlock(self);
+		if (!krk_pushStringBuilderFormat(&sb,"%R",item)) goto _error;
+		_list_rdlock(self);
 		if (i + 1 < self->values.count) {
 			pushStringBuilderStr(&sb, ", ", 2);
 		}
 	}
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_rdunlock(self);
 
 	pushStringBuilder(&sb,']');
 	((KrkObj*)self)->flags &= ~(KRK_OBJ_FLAGS_IN_REPR);
@@ -151,7 +244,6 @@ KRK_Method(list,__repr__) {
 
 _error:
 	krk_discardStringBuilder(&sb);
-	pthread_rwlock_unlock(&self->rwlock);
 	((KrkObj*)self)->flags &= ~(KRK_OBJ_FLAGS_IN_REPR);
 	return NONE_VAL();
 }
@@ -173,7 +265,7 @@ static int _list_extend_callback(void * context, const KrkValue * values, size_t
 
 KRK_Method(list,extend) {
 	METHOD_TAKES_EXACTLY(1);
-	pthread_rwlock_wrlock(&self->rwlock);
+	_list_wrlock(self);
 	KrkValueArray *  positionals = AS_LIST(argv[0]);
 	KrkValue other = argv[1];
 	if (krk_valuesSame(argv[0],other)) {
@@ -182,14 +274,13 @@ KRK_Method(list,extend) {
 
 	krk_unpackIterable(other, positionals, _list_extend_callback);
 
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_wrunlock(self);
 	return NONE_VAL();
 }
 
 KRK_Method(list,__init__) {
 	METHOD_TAKES_AT_MOST(1);
 	krk_initValueArray(AS_LIST(argv[0]));
-	pthread_rwlock_init(&self->rwlock, NULL);
 	if (argc == 2) {
 		_list_extend(2,(KrkValue[]){argv[0],argv[1]},0);
 	}
@@ -218,31 +309,31 @@ KRK_Method(list,__len__) {
 
 KRK_Method(list,__contains__) {
 	METHOD_TAKES_EXACTLY(1);
-	pthread_rwlock_rdlock(&self->rwlock);
+	_list_rdlock(self);
 	for (size_t i = 0; i < self->values.count; ++i) {
-		if (krk_valuesSameOrEqual(argv[1], self->values.values[i])) {
-			pthread_rwlock_unlock(&self->rwlock);
+		if (_list_search_equal(self, argv[1], self->values.values[i])) {
+			_list_rdunlock(self);
 			return BOOLEAN_VAL(1);
 		}
 		if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) break;
 	}
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_rdunlock(self);
 	return BOOLEAN_VAL(0);
 }
 
 KRK_Method(list,pop) {
 	METHOD_TAKES_AT_MOST(1);
-	pthread_rwlock_wrlock(&self->rwlock);
-	krk_integer_type index = self->values.count - 1;
+	krk_integer_type index = -1;
 	if (argc == 2) {
 		CHECK_ARG(1,int,krk_integer_type,ind);
 		index = ind;
 	}
-	LIST_WRAP_INDEX();
+	_list_wrlock(self);
+	LIST_WRAP_INDEX(_list_wrunlock(self));
 	KrkValue outItem = AS_LIST(argv[0])->values[index];
 	if (index == (long)AS_LIST(argv[0])->count-1) {
 		AS_LIST(argv[0])->count--;
-		pthread_rwlock_unlock(&self->rwlock);
+		_list_wrunlock(self);
 		return outItem;
 	} else {
 		/* Need to move up */
@@ -250,7 +341,7 @@ KRK_Method(list,pop) {
 		memmove(&AS_LIST(argv[0])->values[index], &AS_LIST(argv[0])->values[index+1],
 			sizeof(KrkValue) * remaining);
 		AS_LIST(argv[0])->count--;
-		pthread_rwlock_unlock(&self->rwlock);
+		_list_wrunlock(self);
 		return outItem;
 	}
 }
@@ -259,10 +350,10 @@ KRK_Method(list,__setitem__) {
 	METHOD_TAKES_EXACTLY(2);
 	if (IS_INTEGER(argv[1])) {
 		CHECK_ARG(1,int,krk_integer_type,index);
-		if (vm.globalFlags & KRK_GLOBAL_THREADS) pthread_rwlock_rdlock(&self->rwlock);
-		LIST_WRAP_INDEX();
+		_list_wrlock(self);
+		LIST_WRAP_INDEX(_list_wrunlock(self));
 		self->values.values[index] = argv[2];
-		if (vm.globalFlags & KRK_GLOBAL_THREADS) pthread_rwlock_unlock(&self->rwlock);
+		_list_wrunlock(self);
 		return argv[2];
 	} else if (IS_slice(argv[1])) {
 		if (!IS_list(argv[2])) {
@@ -329,26 +420,26 @@ KRK_Method(list,__delitem__) {
 
 KRK_Method(list,remove) {
 	METHOD_TAKES_EXACTLY(1);
-	pthread_rwlock_wrlock(&self->rwlock);
+	_list_rdlock(self);
 	for (size_t i = 0; i < self->values.count; ++i) {
-		if (krk_valuesSameOrEqual(self->values.values[i], argv[1])) {
-			pthread_rwlock_unlock(&self->rwlock);
+		if (_list_search_equal(self, self->values.values[i], argv[1])) {
+			_list_rdunlock(self);
 			return FUNC_NAME(list,pop)(2,(KrkValue[]){argv[0], INTEGER_VAL(i)},0);
 		}
 		if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) {
-			pthread_rwlock_unlock(&self->rwlock);
+			_list_rdunlock(self);
 			return NONE_VAL();
 		}
 	}
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_rdunlock(self);
 	return krk_runtimeError(vm.exceptions->valueError, "not found");
 }
 
 KRK_Method(list,clear) {
 	METHOD_TAKES_NONE();
-	pthread_rwlock_wrlock(&self->rwlock);
+	_list_wrlock(self);
 	krk_freeValueArray(&self->values);
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_wrunlock(self);
 	return NONE_VAL();
 }
 
@@ -373,22 +464,22 @@ KRK_Method(list,index) {
 			return krk_runtimeError(vm.exceptions->typeError, "%s must be int, not '%T'", "max", argv[3]);
 	}
 
-	pthread_rwlock_rdlock(&self->rwlock);
+	_list_rdlock(self);
 	LIST_WRAP_SOFT(min);
 	LIST_WRAP_SOFT(max);
 
-	for (krk_integer_type i = min; i < max; ++i) {
-		if (krk_valuesSameOrEqual(self->values.values[i], argv[1])) {
-			pthread_rwlock_unlock(&self->rwlock);
+	for (krk_integer_type i = min; i < max && i < (krk_integer_type)self->values.count; ++i) {
+		if (_list_search_equal(self, self->values.values[i], argv[1])) {
+			_list_rdunlock(self);
 			return INTEGER_VAL(i);
 		}
 		if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) {
-			pthread_rwlock_unlock(&self->rwlock);
+			_list_rdunlock(self);
 			return NONE_VAL();
 		}
 	}
 
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_rdunlock(self);
 	return krk_runtimeError(vm.exceptions->valueError, "not found");
 }
 
@@ -396,21 +487,21 @@ KRK_Method(list,count) {
 	METHOD_TAKES_EXACTLY(1);
 	krk_integer_type count = 0;
 
-	pthread_rwlock_rdlock(&self->rwlock);
+	_list_rdlock(self);
 	for (size_t i = 0; i < self->values.count; ++i) {
-		if (krk_valuesSameOrEqual(self->values.values[i], argv[1])) count++;
+		if (_list_search_equal(self, self->values.values[i], argv[1])) count++;
 		if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) break;
 	}
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_rdunlock(self);
 
 	return INTEGER_VAL(count);
 }
 
 KRK_Method(list,copy) {
 	METHOD_TAKES_NONE();
-	pthread_rwlock_rdlock(&self->rwlock);
+	_list_rdlock(self);
 	KrkValue result = krk_list_of(self->values.count, self->values.values, 0);
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_rdunlock(self);
 	return result;
 }
 
@@ -429,9 +520,9 @@ static void reverse_values(KrkValue * values, size_t n) {
 
 KRK_Method(list,reverse) {
 	METHOD_TAKES_NONE();
-	pthread_rwlock_wrlock(&self->rwlock);
+	_list_wrlock(self);
 	if (self->values.count > 1) reverse_values(self->values.values, self->values.count);
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_wrunlock(self);
 	return NONE_VAL();
 }
 
@@ -465,17 +556,17 @@ static inline void slice_decrement(struct SortSlice * slice) {
 
 
 /* @brief s + 1 */
-static struct SortSlice slice_next(struct SortSlice slice) {
+static inline struct SortSlice slice_next(struct SortSlice slice) {
 	return (struct SortSlice){slice.keys + 1, slice.values ? slice.values + 1 : NULL};
 }
 
 /** @brief s + n */
-static struct SortSlice slice_plus(struct SortSlice slice, ssize_t n) {
+static inline struct SortSlice slice_plus(struct SortSlice slice, ssize_t n) {
 	return (struct SortSlice){slice.keys + n, slice.values ? slice.values + n : NULL};
 }
 
 /** @brief Copy start-end to buffer */
-static void copy_slice(struct SortSlice start, struct SortSlice end, struct SortSlice buffer) {
+static inline void copy_slice(struct SortSlice start, struct SortSlice end, struct SortSlice buffer) {
 	while (start.keys != end.keys) {
 		*buffer.keys = *start.keys;
 		if (buffer.values) *buffer.values = *start.values;
@@ -484,21 +575,59 @@ static void copy_slice(struct SortSlice start, struct SortSlice end, struct Sort
 	}
 }
 
+/** @brief Strict a < b used to order the keys */
+typedef int (*SortComparator)(KrkValue a, KrkValue b);
+
 /** @brief Very strictly a < b */
 static int _list_sorter(KrkValue a, KrkValue b) {
 	KrkValue comp = krk_operator_lt(a,b);
 	return (IS_NONE(comp) || (IS_BOOLEAN(comp) && AS_BOOLEAN(comp)));
 }
 
+/** @brief a < b for ints */
+static inline int _list_sorter_int(KrkValue a, KrkValue b) {
+	return AS_INTEGER(a) < AS_INTEGER(b);
+}
+
+/** @brief a < b for ints and floats */
+static inline int _list_sorter_number(KrkValue a, KrkValue b) {
+	return krk_numbersLess(a,b);
+}
+
+/** @brief a < b for strings, which order by their UTF-8 bytes */
+static inline int _list_sorter_str(KrkValue a, KrkValue b) {
+	size_t aLen = AS_STRING(a)->length;
+	size_t bLen = AS_STRING(b)->length;
+	int c = memcmp(AS_CSTRING(a), AS_CSTRING(b), aLen < bLen ? aLen : bLen);
+	return c < 0 || (c == 0 && aLen < bLen);
+}
+
+/**
+ * Tuples are ordered by their first items when those differ; ties go
+ * through the full tuple comparison.
+ */
+#define TUPLE_SORTER(name) \
+	static inline int _list_sorter_tuple_ ## name(KrkValue a, KrkValue b) { \
+		KrkValue x = AS_TUPLE(a)->values.values[0]; \
+		KrkValue y = AS_TUPLE(b)->values.values[0]; \
+		if (_list_sorter_ ## name(x,y)) return 1; \
+		if (_list_sorter_ ## name(y,x)) return 0; \
+		return _list_sorter(a,b); \
+	}
+
+TUPLE_SORTER(int)
+TUPLE_SORTER(number)
+TUPLE_SORTER(str)
+
 /** @brief While next is strictly < current, advance current */
-static struct SortSlice powersort_strictlyDecreasingPrefix(struct SortSlice begin, struct SortSlice end) {
-	while (begin.keys + 1 < end.keys && _list_sorter(*(begin.keys + 1), *begin.keys)) slice_advance(&begin);
+static inline struct SortSlice powersort_strictlyDecreasingPrefix(struct SortSlice begin, struct SortSlice end, SortComparator lt) {
+	while (begin.keys + 1 < end.keys && lt(*(begin.keys + 1), *begin.keys)) slice_advance(&begin);
 	return slice_next(begin);
 }
 
 /** @brief While next is greater than or equal to current, advance current */
-static struct SortSlice powersort_weaklyIncreasingPrefix(struct SortSlice begin, struct SortSlice end) {
-	while (begin.keys + 1 < end.keys && !_list_sorter(*(begin.keys + 1), *begin.keys)) slice_advance(&begin);
+static inline struct SortSlice powersort_weaklyIncreasingPrefix(struct SortSlice begin, struct SortSlice end, SortComparator lt) {
+	while (begin.keys + 1 < end.keys && !lt(*(begin.keys + 1), *begin.keys)) slice_advance(&begin);
 	return slice_next(begin);
 }
 
@@ -511,21 +640,22 @@ static struct SortSlice powersort_weaklyIncreasingPrefix(struct SortSlice begin,
  *
  * @param begin Start of run
  * @param end   End of available input to scan; always end of list.
+ * @param lt    Comparator for the keys
  * @returns Slice pointing to end of run
  */
-static struct SortSlice powersort_extend_and_reverse_right(struct SortSlice begin, struct SortSlice end) {
+static inline struct SortSlice powersort_extend_and_reverse_right(struct SortSlice begin, struct SortSlice end, SortComparator lt) {
 	struct SortSlice j = begin;
 	if (j.keys == end.keys) return j;
 	if (j.keys + 1 == end.keys) return slice_next(j);
-	if (_list_sorter(*slice_next(j).keys, *j.keys)) {
+	if (lt(*slice_next(j).keys, *j.keys)) {
 		/* If next is strictly less than current, begin a reversed chain; we already know
 		 * we can advance by one, so do that before continuing to save a comparison. */
-		j = powersort_strictlyDecreasingPrefix(slice_next(begin), end);
+		j = powersort_strictlyDecreasingPrefix(slice_next(begin), end, lt);
 		reverse_values(begin.keys, j.keys - begin.keys);
 		if (begin.values) reverse_values(begin.values, j.values - begin.values);
 	} else {
 		/* Weakly increasing means j+1 >= j; continue with that chain*/
-		j = powersort_weaklyIncreasingPrefix(slice_next(begin), end);
+		j = powersort_weaklyIncreasingPrefix(slice_next(begin), end, lt);
 	}
 	return j;
 }
@@ -568,8 +698,9 @@ static size_t powersort_power(size_t begin, size_t end, size_t beginA, size_t be
  * @param mid    End of first run, start of second run
  * @param right  End of second run
  * @param buffer Scratch space
+ * @param lt     Comparator for the keys
  */
-static void powersort_merge(struct SortSlice left, struct SortSlice mid, struct SortSlice right, struct SortSlice buffer) {
+static inline void powersort_merge(struct SortSlice left, struct SortSlice mid, struct SortSlice right, struct SortSlice buffer, SortComparator lt) {
 	size_t n1 = mid.keys - left.keys;
 	size_t n2 = right.keys - mid.keys;
 
@@ -579,7 +710,7 @@ static void powersort_merge(struct SortSlice left, struct SortSlice mid, struct
 		struct SortSlice c2 = mid, e2 = right, o = left;
 
 		while (c1.keys < e1.keys && c2.keys < e2.keys) {
-			if (!_list_sorter(*c2.keys, *c1.keys)) {
+			if (!lt(*c2.keys, *c1.keys)) {
 				*o.keys = *c1.keys;
 				if (o.values) *o.values = *c1.values;
 				slice_advance(&c1);
@@ -604,7 +735,7 @@ static void powersort_merge(struct SortSlice left, struct SortSlice mid, struct
 		struct SortSlice c2 = slice_plus(buffer, n2 - 1), s2 = buffer;
 
 		while (c1.keys >= s1.keys && c2.keys >= s2.keys) {
-			if (!_list_sorter(*c2.keys, *c1.keys)) {
+			if (!lt(*c2.keys, *c1.keys)) {
 				*o.keys = *c2.keys;
 				if (o.values) *o.values = *c2.values;
 				slice_decrement(&c2);
@@ -625,6 +756,227 @@ static void powersort_merge(struct SortSlice left, struct SortSlice mid, struct
 	}
 }
 
+/**
+ * @brief Sort runs and merge them
+ *
+ * The main loop of powersort over [begin, end), which must hold @p n keys,
+ * using @p buffer as scratch space for merges.
+ */
+static inline void powersort_run(struct SortSlice begin, struct SortSlice end, size_t n, struct SortSlice buffer, SortComparator lt) {
+	/* Supposedly the absolute maximum for this is strictly less than the number of bits
+	 * we can fit in a size_t, so 64 ought to cover us until someone tries porting Kuroko
+	 * to one of the 128-bit architectures, but even then I don't think we can handle
+	 * holding that many values in a list to begin with.
+	 *
+	 * stack[0] should always be empty. */
+	struct SliceAndPower stack[64] = {0};
+	int top = 0;
+
+	/* Our first run starts from the left and extends as far as it can. */
+	struct Run a = {begin, powersort_extend_and_reverse_right(begin,end,lt), 0};
+
+	while (a.end.keys < end.keys) {
+		/* Our next run is whatever is after that, assuming the initial run isn't the whole list. */
+		struct Run b = {a.end, powersort_extend_and_reverse_right(a.end, end, lt), 0};
+		/* I don't really understand the power part of powersort, but whatever. */
+		a.power = powersort_power(0, n, a.start.keys - begin.keys, b.start.keys - begin.keys, b.end.keys - begin.keys);
+
+		/* While the stack has things with higher power, merge them into a */
+		while (stack[top].power > a.power) {
+			struct SliceAndPower top_run = stack[top--];
+			powersort_merge(top_run.begin, a.start, a.end, buffer, lt);
+			a.start = top_run.begin;
+		}
+		/* Put a on top of the stack, and then replace a with b */
+		stack[++top] = (struct SliceAndPower){a.start, a.power};
+		a = (struct Run){b.start, b.end, 0};
+	}
+
+	/* While there are things in the stack (excluding the empty 0 slot), merge them into the last a */
+	while (top > 0) {
+		struct SliceAndPower top_run = stack[top--];
+		powersort_merge(top_run.begin, a.start, end, buffer, lt);
+		a.start = top_run.begin;
+	}
+}
+
+#if __has_attribute(flatten)
+# define _flatten __attribute__((flatten))
+#else
+# define _flatten
+#endif
+
+/**
+ * Each comparator gets its own copy of the sorting loops with the
+ * comparison inlined, rather than an indirect call per comparison.
+ */
+#define POWERSORT_WITH(name) \
+	static _flatten void powersort_with ## name(struct SortSlice begin, struct SortSlice end, size_t n, struct SortSlice buffer) { \
+		powersort_run(begin, end, n, buffer, _list_sorter ## name); \
+	} \
+	static _flatten void powersort_merge_with ## name(struct SortSlice left, struct SortSlice mid, struct SortSlice right, struct SortSlice buffer) { \
+		powersort_merge(left, mid, right, buffer, _list_sorter ## name); \
+	}
+
+POWERSORT_WITH()
+POWERSORT_WITH(_int)
+POWERSORT_WITH(_number)
+POWERSORT_WITH(_str)
+POWERSORT_WITH(_tuple_int)
+POWERSORT_WITH(_tuple_number)
+POWERSORT_WITH(_tuple_str)
+
+/**
+ * @brief Sorting loops for one comparator.
+ *
+ * Comparators that never call into the VM are safe to run on worker
+ * threads; the tuple comparators fall back to __lt__ on ties, so they are not.
+ */
+struct SortStrategy {
+	void (*sort)(struct SortSlice begin, struct SortSlice end, size_t n, struct SortSlice buffer);
+	void (*merge)(struct SortSlice left, struct SortSlice mid, struct SortSlice right, struct SortSlice buffer);
+	int parallel;
+};
+
+#define STRATEGY(name,parallel) {powersort_with ## name, powersort_merge_with ## name, parallel}
+
+/** @brief Strategies that can order all of the keys, from most to least specific */
+enum {
+	SORT_INT,
+	SORT_NUMBER,
+	SORT_STR,
+	SORT_GENERIC,
+};
+
+/** @brief Which strategy fits one key */
+static inline int powersort_kind(KrkValue key) {
+	if (IS_INTEGER(key)) return SORT_INT;
+	if (krk_isNumber(key)) return SORT_NUMBER;
+	if (IS_STRING(key)) return SORT_STR;
+	return SORT_GENERIC;
+}
+
+/** @brief Combine the strategies of two sets of keys */
+static inline int powersort_join(int a, int b) {
+	if (a == b) return a;
+	if (a <= SORT_NUMBER && b <= SORT_NUMBER) return SORT_NUMBER;
+	return SORT_GENERIC;
+}
+
+/**
+ * @brief Pick the sorting loops for a set of keys.
+ *
+ * Keys that are all ints, all numbers or all strings can be compared
+ * directly rather than through __lt__, and so can tuples whose first
+ * items are. Checking costs one pass over the keys, which is small next
+ * to the sort itself, and stops at the first key that fits nothing.
+ */
+static const struct SortStrategy * powersort_strategy(const KrkValue * keys, size_t n) {
+	static const struct SortStrategy direct[] = {STRATEGY(_int,1), STRATEGY(_number,1), STRATEGY(_str,1), STRATEGY(,0)};
+	static const struct SortStrategy tuples[] = {STRATEGY(_tuple_int,0), STRATEGY(_tuple_number,0), STRATEGY(_tuple_str,0), STRATEGY(,0)};
+
+	if (IS_TUPLE(keys[0])) {
+		int kind = SORT_INT;
+		for (size_t i = 0; i < n && kind != SORT_GENERIC; ++i) {
+			if (!IS_TUPLE(keys[i]) || !AS_TUPLE(keys[i])->values.count) return &direct[SORT_GENERIC];
+			kind = powersort_join(kind, powersort_kind(AS_TUPLE(keys[i])->values.values[0]));
+		}
+		return &tuples[kind];
+	}
+
+	int kind = powersort_kind(keys[0]);
+	for (size_t i = 1; i < n && kind != SORT_GENERIC; ++i) {
+		kind = powersort_join(kind, powersort_kind(keys[i]));
+	}
+	return &direct[kind];
+}
+
+#ifndef KRK_DISABLE_THREADS
+/** @brief Lists shorter than this are always sorted on the calling thread */
+#define PARALLEL_SORT_MIN   (1 << 21)
+/** @brief Fewest keys worth handing to one thread */
+#define PARALLEL_SORT_CHUNK (1 << 19)
+/** @brief Most threads used by one sort */
+#define PARALLEL_SORT_MAX   64
+
+/** @brief Sort [begin,end), or if @c mid is set, merge [begin,mid) with [mid,end) */
+struct SortTask {
+	const struct SortStrategy * strategy;
+	struct SortSlice begin, mid, end, buffer;
+};
+
+static void * powersort_task(void * _task) {
+	struct SortTask * task = _task;
+	if (task->mid.keys) {
+		task->strategy->merge(task->begin, task->mid, task->end, task->buffer);
+	} else {
+		task->strategy->sort(task->begin, task->end, task->end.keys - task->begin.keys, task->buffer);
+	}
+	return NULL;
+}
+
+/** @brief Run tasks on their own threads, doing the first one on this thread */
+static void powersort_tasks(struct SortTask * tasks, size_t count) {
+	pthread_t threads[PARALLEL_SORT_MAX];
+	int started[PARALLEL_SORT_MAX];
+	for (size_t i = 1; i < count; ++i) {
+		started[i] = !pthread_create(&threads[i], NULL, powersort_task, &tasks[i]);
+	}
+	powersort_task(&tasks[0]);
+	for (size_t i = 1; i < count; ++i) {
+		if (started[i]) pthread_join(threads[i], NULL);
+		else powersort_task(&tasks[i]);
+	}
+}
+
+/**
+ * @brief Sort a very large list on several threads.
+ *
+ * The keys are split into equal chunks that are sorted concurrently, and
+ * then neighbouring chunks are merged pairwise, each round of merges also
+ * running concurrently, until one run remains. Merging only neighbours
+ * keeps the sort stable. Each merge uses the part of @p buffer at the same
+ * offset as its left run, so concurrent merges never share scratch space.
+ *
+ * Only strategies whose comparisons never call into the VM qualify. The
+ * number of threads comes from vm.sortThreads.
+ *
+ * @returns 1 if the list was sorted, 0 if it should be sorted on this thread.
+ */
+static int powersort_parallel(const struct SortStrategy * strategy, struct SortSlice begin, size_t n, struct SortSlice buffer) {
+	size_t threads = vm.sortThreads;
+	if (!strategy->parallel || n < PARALLEL_SORT_MIN || threads < 2) return 0;
+	if (threads > n / PARALLEL_SORT_CHUNK) threads = n / PARALLEL_SORT_CHUNK;
+	if (threads > PARALLEL_SORT_MAX) threads = PARALLEL_SORT_MAX;
+
+	size_t bounds[PARALLEL_SORT_MAX + 1];
+	struct SortTask tasks[PARALLEL_SORT_MAX];
+	for (size_t i = 0; i <= threads; ++i) bounds[i] = n * i / threads;
+
+	for (size_t i = 0; i < threads; ++i) {
+		tasks[i] = (struct SortTask){strategy, slice_plus(begin, bounds[i]), {NULL,NULL},
+			slice_plus(begin, bounds[i+1]), slice_plus(buffer, bounds[i])};
+	}
+	powersort_tasks(tasks, threads);
+
+	for (size_t chunks = threads; chunks > 1; chunks = (chunks + 1) / 2) {
+		size_t merges = chunks / 2;
+		for (size_t i = 0; i < merges; ++i) {
+			tasks[i] = (struct SortTask){strategy, slice_plus(begin, bounds[2*i]), slice_plus(begin, bounds[2*i+1]),
+				slice_plus(begin, bounds[2*i+2]), slice_plus(buffer, bounds[2*i])};
+		}
+		powersort_tasks(tasks, merges);
+		/* Merged runs now end at every other boundary; an odd run out keeps its end. */
+		size_t remaining = (chunks + 1) / 2;
+		for (size_t i = 0; i <= remaining; ++i) bounds[i] = bounds[2*i < chunks ? 2*i : chunks];
+	}
+
+	return 1;
+}
+#else
+# define powersort_parallel(strategy,begin,n,buffer) 0
+#endif
+
 /**
  * @brief Powersort - merge-sort sorted runs
  *
@@ -657,7 +1009,8 @@ static void powersort(KrkList * list, KrkValue key, int reverse) {
 
 	/* If there is a key function, create a separate array to store
 	 * the resulting key values; shove it in a tuple so we can keep
-	 * those key values from being garbage collected. */
+	 * those key values from being garbage collected. Each key is
+	 * computed once, and the sort only ever looks at this array. */
 	if (!IS_NONE(key)) {
 		KrkTuple * _keys = krk_newTuple(n);
 		krk_push(OBJECT_VAL(_keys));
@@ -676,21 +1029,14 @@ static void powersort(KrkList * list, KrkValue key, int reverse) {
 		slice.keys   = _keys->values.values;
 	}
 
+	const struct SortStrategy * strategy = powersort_strategy(slice.keys, n);
+
 	/* We handle reverse sort by reversing, sorting normally, and then reversing again */
 	if (reverse) {
 		reverse_values(slice.keys, n);
 		if (slice.values) reverse_values(slice.values, n);
 	}
 
-	/* Supposedly the absolute maximum for this is strictly less than the number of bits
-	 * we can fit in a size_t, so 64 ought to cover us until someone tries porting Kuroko
-	 * to one of the 128-bit architectures, but even then I don't think we can handle
-	 * holding that many values in a list to begin with.
-	 *
-	 * stack[0] should always be empty. */
-	struct SliceAndPower stack[64] = {0};
-	int top = 0;
-
 	/* Buffer space for the merges. We shouldn't need anywhere close to this much space,
 	 * but best to be safe, and we're already allocating a bunch of space for key tuples */
 	KrkTuple * bufferSpace = krk_newTuple(slice.values ? (n * 2) : n);
@@ -702,32 +1048,7 @@ static void powersort(KrkList * list, KrkValue key, int reverse) {
 	struct SortSlice begin = {slice.keys, slice.values};
 	struct SortSlice end   = {slice.keys + n, slice.values ? slice.values + n : NULL};
 
-	/* Our first run starts from the left and extends as far as it can. */
-	struct Run a = {begin, powersort_extend_and_reverse_right(begin,end), 0};
-
-	while (a.end.keys < end.keys) {
-		/* Our next run is whatever is after that, assuming the initial run isn't the whole list. */
-		struct Run b = {a.end, powersort_extend_and_reverse_right(a.end, end), 0};
-		/* I don't really understand the power part of powersort, but whatever. */
-		a.power = powersort_power(0, n, a.start.keys - begin.keys, b.start.keys - begin.keys, b.end.keys - begin.keys);
-
-		/* While the stack has things with higher power, merge them into a */
-		while (stack[top].power > a.power) {
-			struct SliceAndPower top_run = stack[top--];
-			powersort_merge(top_run.begin, a.start, a.end, buffer);
-			a.start = top_run.begin;
-		}
-		/* Put a on top of the stack, and then replace a with b */
-		stack[++top] = (struct SliceAndPower){a.start, a.power};
-		a = (struct Run){b.start, b.end, 0};
-	}
-
-	/* While there are things in the stack (excluding the empty 0 slot), merge them into the last a */
-	while (top > 0) {
-		struct SliceAndPower top_run = stack[top--];
-		powersort_merge(top_run.begin, a.start, end, buffer);
-		a.start = top_run.begin;
-	}
+	if (!powersort_parallel(strategy, begin, n, buffer)) strategy->sort(begin, end, n, buffer);
 
 	krk_pop(); /* tuple with buffer space */
 _end_sort:
@@ -744,9 +1065,9 @@ KRK_Method(list,sort) {
 
 	if (self->values.count < 2) return NONE_VAL();
 
-	pthread_rwlock_wrlock(&self->rwlock);
+	_list_wrlock(self);
 	powersort(self, key, reverse);
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_wrunlock(self);
 
 	return NONE_VAL();
 }
@@ -755,9 +1076,9 @@ KRK_Method(list,__add__) {
 	METHOD_TAKES_EXACTLY(1);
 	if (!IS_list(argv[1])) return TYPE_ERROR(list,argv[1]);
 
-	pthread_rwlock_rdlock(&self->rwlock);
+	_list_rdlock(self);
 	KrkValue outList = krk_list_of(self->values.count, self->values.values, 0); /* copy */
-	pthread_rwlock_unlock(&self->rwlock);
+	_list_rdunlock(self);
 	FUNC_NAME(list,extend)(2,(KrkValue[]){outList,argv[1]},0); /* extend */
 	return outList;
 }
@@ -780,8 +1101,7 @@ KRK_Method(list,__iter__) {
 		METHOD_TAKES_EXACTLY(1); \
 		if (!IS_list(argv[1])) return NOTIMPL_VAL(); \
 		KrkList * them = AS_list(argv[1]); \
-		size_t lesser = self->values.count < them->values.count ? self->values.count : them->values.count; \
-		for (size_t i = 0; i < lesser; ++i) { \
+		for (size_t i = 0; i < self->values.count && i < them->values.count; ++i) { \
 			KrkValue a = self->values.values[i]; \
 			KrkValue b = them->values.values[i]; \
 			if (krk_valuesSameOrEqual(a,b)) continue; \
@@ -5,7 +5,7 @@
  *
  * Simple, slightly incomplete implementation of a 'long' type.
  * Conceptually, several things were learned from Python: we store
- * our longs as a sequence of 31-bit unsigned digits, combined with
+ * our longs as a sequence of 31- or 62-bit unsigned digits, combined with
  * a signed count of digits - negative for a negative number, positive
  * for a positive number, and 0 for 0.
  *
@@ -14,20 +14,51 @@
  * - Expose better functions for extracting and converting native integers,
  *   which would be useful in modules that want to take 64-bit values,
  *   extracted unsigned values, etc.
- * - Faster division for large divisors?
- * - Shifts without multiply/divide...
  */
 #include <kuroko/vm.h>
 #include <kuroko/value.h>
 #include <kuroko/util.h>
+#include <kuroko/threads.h>
 #include "private.h"
 
+/**
+ * Digits are 62 bits wide where the compiler offers 128-bit integers for
+ * intermediate products (x86-64 and aarch64), which halves the digit count
+ * and quarters the work of the quadratic algorithms. Elsewhere, or when
+ * built with KRK_LONG_DIGIT_BITS=31, digits are 31 bits with 64-bit
+ * intermediates. Either way a digit leaves its top bit free, so sums of
+ * two digits and borrows out of a difference fit in a digit.
+ */
+#ifndef KRK_LONG_DIGIT_BITS
+# if defined(__SIZEOF_INT128__) && (defined(__x86_64__) || defined(__aarch64__))
+#  define KRK_LONG_DIGIT_BITS 62
+# else
+#  define KRK_LONG_DIGIT_BITS 31
+# endif
+#endif
+
+#if KRK_LONG_DIGIT_BITS == 62
+typedef uint64_t digit_t;            /**< One digit */
+__extension__ typedef unsigned __int128 twodigit_t; /**< Holds the product of two digits */
+__extension__ typedef __int128 stwodigit_t;        /**< Signed, for borrows */
+#define DIGIT_SHIFT 62
+#define DIGIT_MAX   0x3FFFFFFFFFFFFFFFULL
+#elif KRK_LONG_DIGIT_BITS == 31
+typedef uint32_t digit_t;
+typedef uint64_t twodigit_t;
+typedef int64_t stwodigit_t;
 #define DIGIT_SHIFT 31
 #define DIGIT_MAX   0x7FFFFFFF
+#else
+# error "KRK_LONG_DIGIT_BITS must be 31 or 62"
+#endif
+
+/** Number of leading zero bits in a non-zero digit, out of DIGIT_SHIFT */
+#define DIGIT_CLZ(d) (__builtin_clzll((uint64_t)(d)) - (64 - DIGIT_SHIFT))
 
 struct KrkLong_Internal {
 	ssize_t    width;
-	uint32_t *digits;
+	digit_t *digits;
 };
 
 typedef struct KrkLong_Internal KrkLong;
@@ -48,12 +79,12 @@ static int krk_long_init_si(KrkLong * num, int64_t val) {
 
 	/* Digits store unsigned values, so flip things over. */
 	int sign = (val < 0) ? -1 : 1;
-	uint64_t abs = (val < 0) ? -val : val;
+	uint64_t abs = (val < 0) ? -(uint64_t)val : (uint64_t)val;
 
 	/* Quick case for things that fit in our digits... */
 	if (abs <= DIGIT_MAX) {
 		num->width = sign;
-		num->digits = malloc(sizeof(uint32_t));
+		num->digits = malloc(sizeof(digit_t));
 		num->digits[0] = abs;
 		return 0;
 	}
@@ -69,7 +100,7 @@ static int krk_long_init_si(KrkLong * num, int64_t val) {
 
 	/* Allocate space */
 	num->width = cnt * sign;
-	num->digits = malloc(sizeof(uint32_t) * cnt);
+	num->digits = malloc(sizeof(digit_t) * cnt);
 
 	/* Extract digits. */
 	for (int64_t i = 0; i < cnt; ++i) {
@@ -94,7 +125,7 @@ static int krk_long_init_ui(KrkLong * num, uint64_t val) {
 
 	if (val <= DIGIT_MAX) {
 		num->width = 1;
-		num->digits = malloc(sizeof(uint32_t));
+		num->digits = malloc(sizeof(digit_t));
 		num->digits[0] = val;
 		return 0;
 	}
@@ -110,7 +141,7 @@ static int krk_long_init_ui(KrkLong * num, uint64_t val) {
 
 	/* Allocate space */
 	num->width = cnt;
-	num->digits = malloc(sizeof(uint32_t) * cnt);
+	num->digits = malloc(sizeof(digit_t) * cnt);
 
 	/* Extract digits. */
 	for (uint64_t i = 0; i < cnt; ++i) {
@@ -149,7 +180,7 @@ static int krk_long_init_many(KrkLong *a, ...) {
 static int krk_long_init_copy(KrkLong * out, const KrkLong * in) {
 	size_t abs_width = in->width < 0 ? -in->width : in->width;
 	out->width = in->width;
-	out->digits = out->width ? malloc(sizeof(uint32_t) * abs_width) : NULL;
+	out->digits = out->width ? malloc(sizeof(digit_t) * abs_width) : NULL;
 	for (size_t i = 0; i < abs_width; ++i) {
 		out->digits[i] = in->digits[i];
 	}
@@ -203,10 +234,10 @@ static int krk_long_resize(KrkLong * num, ssize_t newdigits) {
 	size_t abs = newdigits < 0 ? -newdigits : newdigits;
 	size_t eabs = num->width < 0 ? -num->width : num->width;
 	if (num->width == 0) {
-		num->digits = calloc(sizeof(uint32_t), newdigits);
+		num->digits = calloc(sizeof(digit_t), newdigits);
 	} else if (eabs < abs) {
-		num->digits = realloc(num->digits, sizeof(uint32_t) * newdigits);
-		memset(&num->digits[eabs], 0, sizeof(uint32_t)*(abs-eabs));
+		num->digits = realloc(num->digits, sizeof(digit_t) * newdigits);
+		memset(&num->digits[eabs], 0, sizeof(digit_t)*(abs-eabs));
 	}
 
 	num->width = newdigits;
@@ -288,6 +319,47 @@ static int krk_long_compare_abs(const KrkLong * a, const KrkLong * b) {
 	return 0; /* they are the same */
 }
 
+/**
+ * @brief Add the digits of @p a into @p r in place.
+ *
+ * @p r has room for @p rn digits, at least @p an. Returns the carry out of the top digit.
+ */
+static digit_t _add_digits(digit_t * r, size_t rn, const digit_t * a, size_t an) {
+	digit_t carry = 0;
+	size_t i = 0;
+	for (; i < an; ++i) {
+		digit_t out = r[i] + a[i] + carry;
+		r[i] = out & DIGIT_MAX;
+		carry = out >> DIGIT_SHIFT;
+	}
+	for (; carry && i < rn; ++i) {
+		digit_t out = r[i] + carry;
+		r[i] = out & DIGIT_MAX;
+		carry = out >> DIGIT_SHIFT;
+	}
+	return carry;
+}
+
+/**
+ * @brief Subtract the digits of @p a from @p r in place.
+ *
+ * The value in @p r must not be smaller than the value in @p a.
+ */
+static void _sub_digits(digit_t * r, size_t rn, const digit_t * a, size_t an) {
+	digit_t borrow = 0;
+	size_t i = 0;
+	for (; i < an; ++i) {
+		digit_t out = r[i] - a[i] - borrow;
+		r[i] = out & DIGIT_MAX;
+		borrow = (out >> DIGIT_SHIFT) & 1;
+	}
+	for (; borrow && i < rn; ++i) {
+		digit_t out = r[i] - borrow;
+		r[i] = out & DIGIT_MAX;
+		borrow = (out >> DIGIT_SHIFT) & 1;
+	}
+}
+
 /**
  * @brief Add the absolute value of two longs to make a third.
  *
@@ -297,53 +369,39 @@ static int krk_long_compare_abs(const KrkLong * a, const KrkLong * b) {
 static int krk_long_add_ignore_sign(KrkLong * res, const KrkLong * a, const KrkLong * b) {
 	size_t awidth = a->width < 0 ? -a->width : a->width;
 	size_t bwidth = b->width < 0 ? -b->width : b->width;
-	size_t owidth = awidth < bwidth ? bwidth + 1 : awidth + 1;
-	size_t carry  = 0;
-	krk_long_resize(res, owidth);
-	for (size_t i = 0; i < owidth - 1; ++i) {
-		uint32_t out = (i < awidth ? a->digits[i] : 0) + (i < bwidth ? b->digits[i] : 0) + carry;
-		res->digits[i] = out & DIGIT_MAX;
-		carry = out > DIGIT_MAX;
-	}
-	if (carry) {
-		res->digits[owidth-1] = 1;
-	} else {
-		krk_long_resize(res, owidth - 1);
+	if (awidth < bwidth) {
+		const KrkLong * t = a; a = b; b = t;
+		size_t w = awidth; awidth = bwidth; bwidth = w;
 	}
+	krk_long_resize(res, awidth + 1);
+	memcpy(res->digits, a->digits, sizeof(digit_t) * awidth);
+	res->digits[awidth] = _add_digits(res->digits, awidth, b->digits, bwidth);
+	if (!res->digits[awidth]) krk_long_resize(res, awidth);
 	return 0;
 }
 
 /**
  * @brief Subtract a smaller number from a bigger number.
  *
- * Performs res = |a|-|b|, assuming |a|>|b|.
+ * Performs res = |a|-|b|, assuming |a|>|b|. @p res may be either input.
  */
 static int _sub_big_small(KrkLong * res, const KrkLong * a, const KrkLong * b) {
 	/* Subtract b from a, where a is bigger */
 	size_t awidth = a->width < 0 ? -a->width : a->width;
 	size_t bwidth = b->width < 0 ? -b->width : b->width;
-	size_t owidth = awidth;
-
-	krk_long_resize(res, owidth);
-
-	int carry = 0;
-
-	for (size_t i = 0; i < owidth; ++i) {
-		/* We'll do long subtraction? */
-		int64_t a_digit = (int64_t)(i < awidth ? a->digits[i] : 0) - carry;
-		int64_t b_digit = i < bwidth ? b->digits[i] : 0;
-		if (a_digit < b_digit) {
-			a_digit += (int64_t)1 << DIGIT_SHIFT;
-			carry = 1;
-		} else {
-			carry = 0;
-		}
 
-		res->digits[i] = (a_digit - b_digit) & DIGIT_MAX;
+	KrkLong copy = {0, NULL};
+	if (res == b) {
+		krk_long_init_copy(&copy, b);
+		b = &copy;
 	}
 
+	krk_long_resize(res, awidth);
+	if (res != a) memcpy(res->digits, a->digits, sizeof(digit_t) * awidth);
+	_sub_digits(res->digits, awidth, b->digits, bwidth);
 	krk_long_trim(res);
 
+	krk_long_clear(&copy);
 	return 0;
 }
 
@@ -352,7 +410,7 @@ static int _sub_big_small(KrkLong * res, const KrkLong * a, const KrkLong * b) {
  */
 static int _swap(KrkLong * a, KrkLong * b) {
 	ssize_t width = a->width;
-	uint32_t * digits = a->digits;
+	digit_t * digits = a->digits;
 	a->width = b->width;
 	a->digits = b->digits;
 	b->width = width;
@@ -479,25 +537,268 @@ static int krk_long_sub(KrkLong * res, const KrkLong * a, const KrkLong * b) {
 }
 
 /**
- * @brief Zero all of the digits in @p num
+ * Operands with at least this many digits (in the shorter of the two) are
+ * multiplied with Karatsuba's method, and from TOOM3_CUTOFF with Toom-3.
+ * Squares get a separate cutoff as the chalkboard method does half the
+ * work for them. Tuned with bench/bigint.krk; they can be overridden at
+ * build time.
+ */
+#ifndef KARATSUBA_CUTOFF
+#define KARATSUBA_CUTOFF 40
+#endif
+#ifndef KARATSUBA_SQUARE_CUTOFF
+#define KARATSUBA_SQUARE_CUTOFF 64
+#endif
+#ifndef TOOM3_CUTOFF
+#define TOOM3_CUTOFF 800
+#endif
+
+/**
+ * @brief Chalkboard long multiplication, using the result as the accumulator.
+ */
+static void _mul_school(digit_t * r, const digit_t * a, size_t an, const digit_t * b, size_t bn) {
+	memset(r, 0, sizeof(digit_t) * (an + bn));
+	for (size_t i = 0; i < bn; ++i) {
+		twodigit_t b_digit = b[i];
+		twodigit_t carry = 0;
+		for (size_t j = 0; j < an; ++j) {
+			twodigit_t a_digit = a[j];
+			twodigit_t tmp = carry + a_digit * b_digit + r[i+j];
+			carry = tmp >> DIGIT_SHIFT;
+			r[i+j] = tmp & DIGIT_MAX;
+		}
+		r[i + an] = carry;
+	}
+}
+
+/**
+ * @brief Chalkboard squaring.
  *
- * @p num remains untrimmed and will maintain these extra zeros.
+ * Each cross product appears twice in a square, so they are only
+ * computed once and doubled before the diagonal is added in.
  */
-static int krk_long_zero(KrkLong * num) {
-	size_t abs_width = num->width < 0 ? -num->width : num->width;
-	for (size_t i = 0; i < abs_width; ++i) {
-		num->digits[i] = 0;
+static void _sqr_school(digit_t * r, const digit_t * a, size_t n) {
+	memset(r, 0, sizeof(digit_t) * (2 * n));
+	for (size_t i = 0; i < n; ++i) {
+		twodigit_t a_digit = a[i];
+		twodigit_t carry = 0;
+		for (size_t j = i + 1; j < n; ++j) {
+			twodigit_t tmp = carry + a_digit * a[j] + r[i+j];
+			carry = tmp >> DIGIT_SHIFT;
+			r[i+j] = tmp & DIGIT_MAX;
+		}
+		r[i + n] = carry;
+	}
+
+	digit_t shift_in = 0;
+	for (size_t i = 0; i < 2 * n; ++i) {
+		digit_t digit = r[i];
+		r[i] = ((digit << 1) | shift_in) & DIGIT_MAX;
+		shift_in = digit >> (DIGIT_SHIFT - 1);
+	}
+
+	twodigit_t carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		twodigit_t square = (twodigit_t)a[i] * a[i];
+		twodigit_t tmp = carry + r[2*i] + (square & DIGIT_MAX);
+		r[2*i] = tmp & DIGIT_MAX;
+		tmp = r[2*i+1] + (square >> DIGIT_SHIFT) + (tmp >> DIGIT_SHIFT);
+		r[2*i+1] = tmp & DIGIT_MAX;
+		carry = tmp >> DIGIT_SHIFT;
 	}
-	return 0;
 }
 
+static void _mul_digits(digit_t * r, const digit_t * a, size_t an, const digit_t * b, size_t bn);
+
 /**
- * @brief Multiply the absolute values of two longs.
+ * @brief Karatsuba multiplication, for an >= bn > an / 2.
+ *
+ * With a = a1 * B^m + a0 and b = b1 * B^m + b0, the product is
+ * z2 * B^2m + z1 * B^m + z0 where z0 = a0 * b0, z2 = a1 * b1, and
+ * z1 = (a0 + a1) * (b0 + b1) - z0 - z2, for three half-size
+ * multiplications instead of four.
+ */
+static void _mul_karatsuba(digit_t * r, const digit_t * a, size_t an, const digit_t * b, size_t bn) {
+	size_t m  = an / 2;
+	size_t rn = an + bn;
+	int square = (a == b && an == bn);
+
+	/* z0 and z2 go directly into the low and high parts of the result */
+	_mul_digits(r, a, m, b, m);
+	_mul_digits(r + 2 * m, a + m, an - m, b + m, bn - m);
+
+	size_t sn = (an - m) + 1;
+	size_t tn = (bn - m > m ? bn - m : m) + 1;
+	digit_t * sa = malloc(sizeof(digit_t) * 2 * (sn + tn));
+	digit_t * sb = sa + sn;
+	digit_t * z1 = sb + tn;
+
+	memset(sa, 0, sizeof(digit_t) * sn);
+	memcpy(sa, a + m, sizeof(digit_t) * (an - m));
+	_add_digits(sa, sn, a, m);
+
+	if (square) {
+		sb = sa;
+	} else {
+		memset(sb, 0, sizeof(digit_t) * tn);
+		if (bn - m > m) {
+			memcpy(sb, b + m, sizeof(digit_t) * (bn - m));
+			_add_digits(sb, tn, b, m);
+		} else {
+			memcpy(sb, b, sizeof(digit_t) * m);
+			_add_digits(sb, tn, b + m, bn - m);
+		}
+	}
+
+	/* The sums rarely carry into their top digit; don't multiply it if they didn't. */
+	size_t zc = sn + tn;
+	while (sn > 1 && !sa[sn-1]) sn--;
+	if (square) tn = sn;
+	else while (tn > 1 && !sb[tn-1]) tn--;
+
+	_mul_digits(z1, sa, sn, sb, tn);
+	memset(z1 + sn + tn, 0, sizeof(digit_t) * (zc - sn - tn));
+	_sub_digits(z1, zc, r, 2 * m);
+	_sub_digits(z1, zc, r + 2 * m, rn - 2 * m);
+
+	/* What's left of z1 fits in the result; anything above that is zeros. */
+	_add_digits(r + m, rn - m, z1, zc < rn - m ? zc : rn - m);
+
+	free(sa);
+}
+
+/**
+ * @brief Point a long at a range of digits without copying them.
+ *
+ * The result must not be cleared or resized.
+ */
+static void _digits_view(KrkLong * out, const digit_t * digits, size_t count) {
+	while (count && digits[count-1] == 0) count--;
+	out->width = count;
+	out->digits = count ? (digit_t*)digits : NULL;
+}
+
+static digit_t _div_inplace(KrkLong * a, digit_t base);
+static int krk_long_mul(KrkLong * res, const KrkLong * a, const KrkLong * b);
+
+/**
+ * @brief Divide a long that is known to be a multiple of a small @p divisor.
+ */
+static void _div_exact_small(KrkLong * num, digit_t divisor) {
+	int sign = num->width < 0 ? -1 : 1;
+	krk_long_set_sign(num, 1);
+	_div_inplace(num, divisor);
+	krk_long_set_sign(num, sign);
+}
+
+/**
+ * @brief Toom-3 multiplication, for an >= bn > an / 2.
  *
- * Performs a simple chalkboard long multiplication, using the
- * result as the accumulator.
+ * Splits both operands into three parts, treats them as polynomials in
+ * B^k, multiplies the polynomials at the five points 0, 1, -1, -2 and
+ * infinity, and interpolates the product with Bodrato's sequence. The
+ * evaluated values can be negative, so this works in terms of signed longs.
+ */
+static void _mul_toom3(digit_t * r, const digit_t * a, size_t an, const digit_t * b, size_t bn) {
+	size_t k  = (an + 2) / 3;
+	size_t rn = an + bn;
+	int square = (a == b && an == bn);
+
+	KrkLong a0, a1, a2, b0, b1, b2;
+	_digits_view(&a0, a, k);
+	_digits_view(&a1, a + k, k);
+	_digits_view(&a2, a + 2 * k, an - 2 * k);
+	_digits_view(&b0, b, bn < k ? bn : k);
+	_digits_view(&b1, b + k, bn < k ? 0 : (bn < 2 * k ? bn - k : k));
+	_digits_view(&b2, b + 2 * k, bn < 2 * k ? 0 : bn - 2 * k);
+
+	KrkLong ap1, am1, am2, bp1, bm1, bm2, r0, r1, rm1, rm2, rinf, r2, r3;
+	krk_long_init_many(&ap1, &am1, &am2, &bp1, &bm1, &bm2, &r0, &r1, &rm1, &rm2, &rinf, &r2, &r3, NULL);
+
+	/* Evaluation */
+	krk_long_add(&am2, &a0, &a2);
+	krk_long_add(&ap1, &am2, &a1);
+	krk_long_sub(&am1, &am2, &a1);
+	krk_long_add(&am2, &am1, &a2);
+	krk_long_add(&am2, &am2, &am2);
+	krk_long_sub(&am2, &am2, &a0);
+
+	if (!square) {
+		krk_long_add(&bm2, &b0, &b2);
+		krk_long_add(&bp1, &bm2, &b1);
+		krk_long_sub(&bm1, &bm2, &b1);
+		krk_long_add(&bm2, &bm1, &b2);
+		krk_long_add(&bm2, &bm2, &bm2);
+		krk_long_sub(&bm2, &bm2, &b0);
+	}
+
+	/* Pointwise multiplication; passing the same long twice lets squares stay squares */
+	krk_long_mul(&r0, &a0, square ? &a0 : &b0);
+	krk_long_mul(&r1, &ap1, square ? &ap1 : &bp1);
+	krk_long_mul(&rm1, &am1, square ? &am1 : &bm1);
+	krk_long_mul(&rm2, &am2, square ? &am2 : &bm2);
+	krk_long_mul(&rinf, &a2, square ? &a2 : &b2);
+
+	/* Interpolation */
+	krk_long_sub(&r3, &rm2, &r1);
+	_div_exact_small(&r3, 3);
+	krk_long_sub(&r1, &r1, &rm1);
+	_div_exact_small(&r1, 2);
+	krk_long_sub(&r2, &rm1, &r0);
+	krk_long_sub(&r3, &r2, &r3);
+	_div_exact_small(&r3, 2);
+	krk_long_add(&r3, &r3, &rinf);
+	krk_long_add(&r3, &r3, &rinf);
+	krk_long_add(&r2, &r2, &r1);
+	krk_long_sub(&r2, &r2, &rinf);
+	krk_long_sub(&r1, &r1, &r3);
+
+	/* Recomposition; every coefficient of the product is non-negative */
+	memset(r, 0, sizeof(digit_t) * rn);
+	KrkLong * coefficients[] = {&r0, &r1, &r2, &r3, &rinf};
+	for (size_t i = 0; i < 5; ++i) {
+		if (coefficients[i]->width) _add_digits(r + i * k, rn - i * k, coefficients[i]->digits, coefficients[i]->width);
+	}
+
+	krk_long_clear_many(&ap1, &am1, &am2, &bp1, &bm1, &bm2, &r0, &r1, &rm1, &rm2, &rinf, &r2, &r3, NULL);
+}
+
+/**
+ * @brief Multiply two digit arrays, writing all @p an + @p bn digits of @p r.
+ *
+ * Picks an algorithm by operand size. Very unbalanced operands are
+ * multiplied in slices the size of the shorter one.
+ */
+static void _mul_digits(digit_t * r, const digit_t * a, size_t an, const digit_t * b, size_t bn) {
+	if (an < bn) {
+		const digit_t * t = a; a = b; b = t;
+		size_t tn = an; an = bn; bn = tn;
+	}
+
+	if (a == b && an == bn && an < KARATSUBA_SQUARE_CUTOFF) {
+		_sqr_school(r, a, an);
+	} else if (bn < KARATSUBA_CUTOFF) {
+		_mul_school(r, a, an, b, bn);
+	} else if (an >= 2 * bn) {
+		digit_t * slice = malloc(sizeof(digit_t) * 2 * bn);
+		memset(r, 0, sizeof(digit_t) * (an + bn));
+		for (size_t offset = 0; offset < an; offset += bn) {
+			size_t count = an - offset < bn ? an - offset : bn;
+			_mul_digits(slice, a + offset, count, b, bn);
+			_add_digits(r + offset, an + bn - offset, slice, count + bn);
+		}
+		free(slice);
+	} else if (bn >= TOOM3_CUTOFF) {
+		_mul_toom3(r, a, an, b, bn);
+	} else {
+		_mul_karatsuba(r, a, an, b, bn);
+	}
+}
+
+/**
+ * @brief Multiply the absolute values of two longs.
  *
- * @p res must be initialized, but will be resized and zeroed on entry; it
+ * @p res must be initialized, but will be resized and overwritten; it
  * must not be equal to either of @p a or @p b.
  */
 static int _mul_abs(KrkLong * res, const KrkLong * a, const KrkLong * b) {
@@ -505,21 +806,15 @@ static int _mul_abs(KrkLong * res, const KrkLong * a, const KrkLong * b) {
 	size_t awidth = a->width < 0 ? -a->width : a->width;
 	size_t bwidth = b->width < 0 ? -b->width : b->width;
 
-	krk_long_resize(res, awidth+bwidth);
-	krk_long_zero(res);
-
-	for (size_t i = 0; i < bwidth; ++i) {
-		uint64_t b_digit = b->digits[i];
-		uint64_t carry = 0;
-		for (size_t j = 0; j < awidth; ++j) {
-			uint64_t a_digit = a->digits[j];
-			uint64_t tmp = carry + a_digit * b_digit + res->digits[i+j];
-			carry = tmp >> DIGIT_SHIFT;
-			res->digits[i+j] = tmp & DIGIT_MAX;
-		}
-		res->digits[i + awidth] = carry;
+	/* Operands usually arrive as copies, so spot squares by their digits. */
+	const digit_t * b_digits = b->digits;
+	if (awidth == bwidth && (a->digits == b->digits || !memcmp(a->digits, b->digits, sizeof(digit_t) * awidth))) {
+		b_digits = a->digits;
 	}
 
+	krk_long_resize(res, awidth+bwidth);
+	_mul_digits(res->digits, a->digits, awidth, b_digits, bwidth);
+
 	krk_long_trim(res);
 
 	return 0;
@@ -584,7 +879,7 @@ static int _lshift_one(KrkLong * in) {
 	int carry = 0;
 
 	for (size_t i = 0; i < abs_width; ++i) {
-		uint32_t digit = in->digits[i];
+		digit_t digit = in->digits[i];
 		in->digits[i] = ((digit << 1) + carry) & DIGIT_MAX;
 		carry = (digit >> (DIGIT_SHIFT -1));
 	}
@@ -609,12 +904,8 @@ static size_t _bits_in(const KrkLong * num) {
 	size_t abs_width = num->width < 0 ? -num->width : num->width;
 
 	/* Top bit in digits[abs_width-1] */
-	size_t c = 0;
-	uint32_t digit = num->digits[abs_width-1];
-	while (digit) {
-		c++;
-		digit >>= 1;
-	}
+	digit_t digit = num->digits[abs_width-1];
+	size_t c = digit ? DIGIT_SHIFT - DIGIT_CLZ(digit) : 0;
 
 	return c + (abs_width-1) * DIGIT_SHIFT;
 }
@@ -625,7 +916,7 @@ static size_t _bits_in(const KrkLong * num) {
 static size_t _bit_is_set(const KrkLong * num, size_t bit) {
 	size_t digit_offset = bit / DIGIT_SHIFT;
 	size_t digit_bit    = bit % DIGIT_SHIFT;
-	return !!(num->digits[digit_offset] & (1 << digit_bit));
+	return !!(num->digits[digit_offset] & ((digit_t)1 << digit_bit));
 }
 
 /**
@@ -643,27 +934,272 @@ static int _bit_set_zero(KrkLong * num, int val) {
 }
 
 /**
- * @brief Set a given bit in a long.
+ * Divisors with at least this many digits, with at least as many more in
+ * the dividend, are divided with Burnikel and Ziegler's recursive method.
+ */
+#ifndef BURNIKEL_ZIEGLER_CUTOFF
+#define BURNIKEL_ZIEGLER_CUTOFF 60
+#endif
+
+/**
+ * @brief Shift @p n digits left by @p s bits, returning the bits shifted out.
  *
- * Because of how we use it, this only supports setting the bit,
- * eg. it performs: num |= (1 << bit)
+ * @p s must be less than DIGIT_SHIFT. @p out may be @p in. Each output digit
+ * depends only on two input digits, so this loop vectorizes.
+ */
+static digit_t _shift_digits_left(digit_t * out, const digit_t * in, size_t n, unsigned int s) {
+	if (!n) return 0;
+	digit_t carry = in[n-1] >> (DIGIT_SHIFT - s);
+	for (size_t i = n - 1; i > 0; --i) {
+		out[i] = ((in[i] << s) | (in[i-1] >> (DIGIT_SHIFT - s))) & DIGIT_MAX;
+	}
+	out[0] = (in[0] << s) & DIGIT_MAX;
+	return carry;
+}
+
+/**
+ * @brief Shift @p n digits right by @p s bits, dropping the bits shifted out.
  *
- * @p num will be resized as needed.
+ * @p out may be @p in.
  */
-static int krk_long_bit_set(KrkLong * num, size_t bit) {
-	size_t abs_width = num->width < 0 ? -num->width : num->width;
-	size_t digit_offset = bit / DIGIT_SHIFT;
-	size_t digit_bit    = bit % DIGIT_SHIFT;
+static void _shift_digits_right(digit_t * out, const digit_t * in, size_t n, unsigned int s) {
+	if (!n) return;
+	for (size_t i = 0; i < n - 1; ++i) {
+		out[i] = ((in[i] >> s) | (in[i+1] << (DIGIT_SHIFT - s))) & DIGIT_MAX;
+	}
+	out[n-1] = in[n-1] >> s;
+}
+
+/**
+ * @brief Long division of digit arrays, per Knuth's Algorithm D.
+ *
+ * Divides the @p an digits of @p a by the @p bn digits of @p b, where
+ * an >= bn >= 2 and the top digit of @p b is not zero. Writes an - bn + 1
+ * quotient digits to @p q and bn remainder digits to @p r.
+ *
+ * The divisor is normalized so that its top digit has its high bit set,
+ * which lets each quotient digit be estimated from the top two digits of
+ * the running remainder and is off by at most one after correction.
+ */
+static void _div_knuth(digit_t * q, digit_t * r, const digit_t * a, size_t an, const digit_t * b, size_t bn) {
+	unsigned int s = DIGIT_CLZ(b[bn-1]);
+	digit_t * u = malloc(sizeof(digit_t) * (an + 1 + bn));
+	digit_t * v = u + an + 1;
+	_shift_digits_left(v, b, bn, s);
+	u[an] = _shift_digits_left(u, a, an, s);
+
+	twodigit_t v1 = v[bn-1];
+	twodigit_t v2 = v[bn-2];
+
+	for (size_t j = an - bn + 1; j-- > 0; ) {
+		/* Estimate the next quotient digit */
+		twodigit_t top  = ((twodigit_t)u[j+bn] << DIGIT_SHIFT) | u[j+bn-1];
+		twodigit_t qhat = top / v1;
+		twodigit_t rhat = top % v1;
+		while (qhat > DIGIT_MAX || qhat * v2 > ((rhat << DIGIT_SHIFT) | u[j+bn-2])) {
+			qhat--;
+			rhat += v1;
+			if (rhat > DIGIT_MAX) break;
+		}
 
-	if (digit_offset >= abs_width) {
-		krk_long_resize(num, digit_offset+1);
-		for (size_t i = abs_width; i < digit_offset + 1; ++i) {
-			num->digits[i] = 0;
+		/* Multiply and subtract */
+		twodigit_t carry = 0;
+		stwodigit_t borrow = 0;
+		for (size_t i = 0; i < bn; ++i) {
+			twodigit_t p = qhat * v[i] + carry;
+			carry = p >> DIGIT_SHIFT;
+			stwodigit_t t = (stwodigit_t)u[i+j] - (stwodigit_t)(p & DIGIT_MAX) + borrow;
+			u[i+j] = t & DIGIT_MAX;
+			borrow = t >> DIGIT_SHIFT;
 		}
+		stwodigit_t t = (stwodigit_t)u[j+bn] - (stwodigit_t)carry + borrow;
+		u[j+bn] = t & DIGIT_MAX;
+
+		if (t < 0) {
+			/* The estimate was one too large; add a divisor back */
+			qhat--;
+			digit_t c = 0;
+			for (size_t i = 0; i < bn; ++i) {
+				digit_t sum = u[i+j] + v[i] + c;
+				u[i+j] = sum & DIGIT_MAX;
+				c = sum >> DIGIT_SHIFT;
+			}
+			u[j+bn] = (u[j+bn] + c) & DIGIT_MAX;
+		}
+
+		q[j] = qhat;
 	}
 
-	num->digits[digit_offset] |= (1 << digit_bit);
-	return 0;
+	_shift_digits_right(r, u, bn, s);
+	free(u);
+}
+
+/**
+ * @brief Divide non-negative longs with @p b at least two digits wide.
+ *
+ * Base case for the recursive division; @p a and @p b may be views.
+ */
+static void _div_knuth_long(KrkLong * quot, KrkLong * rem, const KrkLong * a, const KrkLong * b) {
+	krk_long_clear(quot);
+	krk_long_clear(rem);
+	if (a->width < b->width) {
+		krk_long_init_copy(rem, a);
+		return;
+	}
+	krk_long_resize(quot, a->width - b->width + 1);
+	krk_long_resize(rem, b->width);
+	_div_knuth(quot->digits, rem->digits, a->digits, a->width, b->digits, b->width);
+	krk_long_trim(quot);
+	krk_long_trim(rem);
+}
+
+/**
+ * @brief View @p count digits of @p in starting at @p offset, clamped to its width.
+ */
+static void _digits_range(KrkLong * out, const KrkLong * in, size_t offset, size_t count) {
+	size_t width = in->width;
+	if (offset >= width) {
+		_digits_view(out, NULL, 0);
+		return;
+	}
+	_digits_view(out, in->digits + offset, width - offset < count ? width - offset : count);
+}
+
+/**
+ * @brief Set @p out to @p hi * B^n + @p lo, where @p lo < B^n.
+ *
+ * @p out must not be either of the inputs.
+ */
+static void _digits_join(KrkLong * out, const KrkLong * hi, size_t n, const KrkLong * lo) {
+	krk_long_clear(out);
+	size_t width = hi->width ? (size_t)hi->width + n : (size_t)lo->width;
+	if (!width) return;
+	krk_long_resize(out, width);
+	if (lo->width) memcpy(out->digits, lo->digits, sizeof(digit_t) * lo->width);
+	if (hi->width) memcpy(out->digits + n, hi->digits, sizeof(digit_t) * hi->width);
+}
+
+static void _div2n1n(KrkLong * quot, KrkLong * rem, const KrkLong * a, const KrkLong * b, size_t n);
+
+/**
+ * @brief Divide the 3-half-digit value @p a12 * B^n + @p a3 by the 2-half value @p b.
+ *
+ * @p b1 and @p b2 are the upper and lower halves of @p b.
+ */
+static void _div3n2n(KrkLong * quot, KrkLong * rem, const KrkLong * a12, const KrkLong * a3,
+		const KrkLong * b, const KrkLong * b1, const KrkLong * b2, size_t n) {
+	KrkLong a1, tmp, one;
+	_digits_range(&a1, a12, n, SIZE_MAX);
+	krk_long_init_many(&tmp, &one, NULL);
+
+	if (krk_long_compare(&a1, b1) == 0) {
+		/* The quotient would overflow a half; it's B^n - 1, and the remainder is a12 - b1 * B^n + b1 */
+		krk_long_clear(quot);
+		krk_long_resize(quot, n);
+		for (size_t i = 0; i < n; ++i) quot->digits[i] = DIGIT_MAX;
+		_digits_join(&tmp, b1, n, &one);
+		krk_long_sub(rem, a12, &tmp);
+		krk_long_add(rem, rem, b1);
+	} else {
+		_div2n1n(quot, rem, a12, b1, n);
+	}
+
+	/* Bring down a3 and account for the lower half of the divisor */
+	_digits_join(&tmp, rem, n, a3);
+	krk_long_mul(rem, quot, b2);
+	krk_long_sub(rem, &tmp, rem);
+
+	/* With a normalized divisor, this runs at most twice */
+	krk_long_init_si(&one, 1);
+	while (rem->width < 0) {
+		krk_long_sub(quot, quot, &one);
+		krk_long_add(rem, rem, b);
+	}
+
+	krk_long_clear_many(&tmp, &one, NULL);
+}
+
+/**
+ * @brief Divide @p a by @p b, where @p b is n digits with its high bit set and @p a < @p b * B^n.
+ */
+static void _div2n1n(KrkLong * quot, KrkLong * rem, const KrkLong * a, const KrkLong * b, size_t n) {
+	if (n < BURNIKEL_ZIEGLER_CUTOFF) {
+		_div_knuth_long(quot, rem, a, b);
+		return;
+	}
+
+	if (n & 1) {
+		/* Pad both by a digit so they split evenly */
+		KrkLong zero, pa, pb, prem;
+		krk_long_init_many(&zero, &pa, &pb, &prem, NULL);
+		_digits_join(&pa, a, 1, &zero);
+		_digits_join(&pb, b, 1, &zero);
+		_div2n1n(quot, &prem, &pa, &pb, n + 1);
+		KrkLong shifted;
+		_digits_range(&shifted, &prem, 1, SIZE_MAX);
+		krk_long_clear(rem);
+		krk_long_init_copy(rem, &shifted);
+		krk_long_clear_many(&pa, &pb, &prem, NULL);
+		return;
+	}
+
+	size_t half = n / 2;
+	KrkLong b1, b2, a12, a3, a4, q1, q2, r1;
+	_digits_range(&b1, b, half, SIZE_MAX);
+	_digits_range(&b2, b, 0, half);
+	_digits_range(&a12, a, n, SIZE_MAX);
+	_digits_range(&a3, a, half, half);
+	_digits_range(&a4, a, 0, half);
+	krk_long_init_many(&q1, &q2, &r1, NULL);
+
+	_div3n2n(&q1, &r1, &a12, &a3, b, &b1, &b2, half);
+	_div3n2n(&q2, rem, &r1, &a4, b, &b1, &b2, half);
+	_digits_join(quot, &q1, half, &q2);
+
+	krk_long_clear_many(&q1, &q2, &r1, NULL);
+}
+
+/**
+ * @brief Burnikel-Ziegler division of non-negative longs.
+ *
+ * The divisor is normalized, then the dividend is divided a divisor-sized
+ * chunk at a time, carrying the remainder down, with each step split
+ * recursively into half-size divisions so the work is dominated by
+ * (fast) multiplication.
+ */
+static void _div_burnikel_ziegler(KrkLong * quot, KrkLong * rem, const KrkLong * a, const KrkLong * b) {
+	size_t an = a->width;
+	size_t n  = b->width;
+	unsigned int s = DIGIT_CLZ(b->digits[n-1]);
+
+	KrkLong na, nb, r, x, qd, chunk;
+	krk_long_init_many(&na, &nb, &r, &x, &qd, NULL);
+	krk_long_resize(&nb, n);
+	_shift_digits_left(nb.digits, b->digits, n, s);
+	krk_long_resize(&na, an + 1);
+	na.digits[an] = _shift_digits_left(na.digits, a->digits, an, s);
+	krk_long_trim(&na);
+
+	size_t chunks = (na.width + n - 1) / n;
+	krk_long_clear(quot);
+	krk_long_resize(quot, chunks * n);
+
+	for (size_t c = chunks; c-- > 0; ) {
+		_digits_range(&chunk, &na, c * n, n);
+		_digits_join(&x, &r, n, &chunk);
+		_div2n1n(&qd, &r, &x, &nb, n);
+		if (qd.width) memcpy(quot->digits + c * n, qd.digits, sizeof(digit_t) * qd.width);
+	}
+	krk_long_trim(quot);
+
+	krk_long_clear(rem);
+	if (r.width) {
+		krk_long_resize(rem, r.width);
+		_shift_digits_right(rem->digits, r.digits, r.width, s);
+		krk_long_trim(rem);
+	}
+
+	krk_long_clear_many(&na, &nb, &r, &x, &qd, NULL);
 }
 
 /**
@@ -671,9 +1207,8 @@ static int krk_long_bit_set(KrkLong * num, size_t bit) {
  *
  * Divides @p |a| by @p |b| placing the remainder in @p rem and the quotient in @p quot.
  *
- * Performs one of two division operations. For single-digit divisor, we perform
- * a quicker division. For anything else, performs a binary long division, which
- * is terribly slow, but is at least correct...
+ * Single-digit divisors get a simple short division. Wider divisors use
+ * Knuth's Algorithm D, or Burnikel-Ziegler when both operands are large.
  *
  * @return 1 if divisor is 0, otherwise 0.
  */
@@ -702,47 +1237,37 @@ static int _div_abs(KrkLong * quot, KrkLong * rem, const KrkLong * a, const KrkL
 		return 0;
 	}
 
-	KrkLong absa, absb;
-	krk_long_init_copy(&absa, a);
-	krk_long_set_sign(&absa, 1);
-	krk_long_init_copy(&absb, b);
-	krk_long_set_sign(&absb, 1);
-
 	if (bwidth == 1) {
-		uint64_t remainder = 0;
+		KrkLong absa;
+		krk_long_init_copy(&absa, a);
+		krk_long_set_sign(&absa, 1);
+
+		twodigit_t remainder = 0;
 		for (size_t i = 0; i < awidth; ++i) {
 			size_t _i = awidth - i - 1;
 			remainder = (remainder << DIGIT_SHIFT) | absa.digits[_i];
-			absa.digits[_i] = (uint32_t)(remainder / absb.digits[0]) & DIGIT_MAX;
-			remainder -= (uint64_t)(absa.digits[_i]) * absb.digits[0];
+			absa.digits[_i] = (digit_t)(remainder / b->digits[0]) & DIGIT_MAX;
+			remainder -= (twodigit_t)(absa.digits[_i]) * b->digits[0];
 		}
 
 		krk_long_init_si(rem, remainder);
 		_swap(quot, &absa);
 		krk_long_trim(quot);
 
-		krk_long_clear_many(&absa, &absb, NULL);
+		krk_long_clear(&absa);
 		return 0;
 	}
 
-	size_t bits = _bits_in(a);
-	for (size_t i = 0; i < bits; ++i) {
-		size_t _i = bits - i - 1;
-
-		/* Shift remainder by one */
-		_lshift_one(rem);
+	KrkLong absa, absb;
+	_digits_view(&absa, a->digits, awidth);
+	_digits_view(&absb, b->digits, bwidth);
 
-		int is_set = _bit_is_set(&absa, _i);
-		_bit_set_zero(rem, is_set);
-		if (krk_long_compare(rem,&absb) >= 0) {
-			_sub_big_small(rem,rem,&absb);
-			krk_long_bit_set(quot, _i);
-		}
+	if (bwidth >= BURNIKEL_ZIEGLER_CUTOFF && awidth - bwidth >= BURNIKEL_ZIEGLER_CUTOFF) {
+		_div_burnikel_ziegler(quot, rem, &absa, &absb);
+	} else {
+		_div_knuth_long(quot, rem, &absa, &absb);
 	}
 
-	krk_long_trim(quot);
-	krk_long_clear_many(&absa,&absb,NULL);
-
 	return 0;
 }
 
@@ -839,13 +1364,13 @@ static int64_t krk_long_medium(KrkLong * num) {
 	if (num->width < 0) {
 		uint64_t val = num->digits[0];
 		if (num->width < -1) {
-			val |= (num->digits[1]) << 31;
+			val |= (uint64_t)num->digits[1] << DIGIT_SHIFT;
 		}
 		return -val;
 	} else {
 		uint64_t val = num->digits[0];
 		if (num->width > 1) {
-			val |= (num->digits[1]) << 31;
+			val |= (uint64_t)num->digits[1] << DIGIT_SHIFT;
 		}
 		return val;
 	}
@@ -875,20 +1400,39 @@ static int do_bin_op(KrkLong * res, const KrkLong * a, const KrkLong * b, char o
 
 	krk_long_resize(res, owidth);
 
+	if (!aneg && !bneg) {
+		/* No two's complement carries to track, so this is a simple loop
+		 * over the common digits the compiler can vectorize. */
+		size_t common = awidth < bwidth ? awidth : bwidth;
+		const digit_t * restrict ad = a->digits;
+		const digit_t * restrict bd = b->digits;
+		digit_t * restrict rd = res->digits;
+		switch (op) {
+			case '|': for (size_t i = 0; i < common; ++i) rd[i] = ad[i] | bd[i]; break;
+			case '^': for (size_t i = 0; i < common; ++i) rd[i] = ad[i] ^ bd[i]; break;
+			case '&': for (size_t i = 0; i < common; ++i) rd[i] = ad[i] & bd[i]; break;
+		}
+		/* Past the shorter operand, | and ^ copy the longer one and & is zero */
+		const digit_t * rest = awidth > bwidth ? ad : bd;
+		for (size_t i = common; i < owidth; ++i) rd[i] = (op != '&' && i < owidth - 1) ? rest[i] : 0;
+		krk_long_trim(res);
+		return 0;
+	}
+
 	int acarry = aneg ? 1 : 0;
 	int bcarry = bneg ? 1 : 0;
 	int rcarry = rneg ? 1 : 0;
 
 	for (size_t i = 0; i < owidth; ++i) {
-		uint32_t a_digit = (i < awidth ? a->digits[i] : 0);
+		digit_t a_digit = (i < awidth ? a->digits[i] : 0);
 		a_digit = aneg ? ((a_digit ^ DIGIT_MAX) + acarry) : a_digit;
 		acarry = a_digit >> DIGIT_SHIFT;
 
-		uint32_t b_digit = (i < bwidth ? b->digits[i] : 0);
+		digit_t b_digit = (i < bwidth ? b->digits[i] : 0);
 		b_digit = bneg ? ((b_digit ^ DIGIT_MAX) + bcarry) : b_digit;
 		bcarry = b_digit >> DIGIT_SHIFT;
 
-		uint32_t r;
+		digit_t r;
 		switch (op) {
 			case '|': r = a_digit | b_digit; break;
 			case '^': r = a_digit ^ b_digit; break;
@@ -967,17 +1511,17 @@ static int krk_long_and(KrkLong * res, const KrkLong * a, const KrkLong * b) {
 /**
  * Small divisor in-place division specifically for printers.
  */
-static uint32_t _div_inplace(KrkLong * a, uint32_t base) {
+static digit_t _div_inplace(KrkLong * a, digit_t base) {
 	if (a->width == 0) {
 		return 0;
 	}
 	size_t awidth = a->width;
-	uint64_t remainder = 0;
+	twodigit_t remainder = 0;
 	for (size_t i = 0; i < awidth; ++i) {
 		size_t _i = awidth - i - 1;
 		remainder = (remainder << DIGIT_SHIFT) | a->digits[_i];
-		a->digits[_i] = (uint32_t)(remainder / base) & DIGIT_MAX;
-		remainder -= (uint64_t)(a->digits[_i]) * base;
+		a->digits[_i] = (digit_t)(remainder / base) & DIGIT_MAX;
+		remainder -= (twodigit_t)(a->digits[_i]) * base;
 	}
 
 	krk_long_trim(a);
@@ -986,14 +1530,14 @@ static uint32_t _div_inplace(KrkLong * a, uint32_t base) {
 
 static const char _vals[] = "0123456789abcdef";
 static char * _fast_conversion(const KrkLong * abs, unsigned int bits, char * writer) {
-	uint64_t buf  = abs->digits[0];
+	twodigit_t buf = abs->digits[0];
 	uint32_t cnt  = DIGIT_SHIFT;
 	ssize_t  ind  = 1;
 	uint32_t out  = 0;
 
 	while (ind < abs->width || buf) {
 		if (ind < abs->width && cnt < bits) {
-			buf |= (uint64_t)abs->digits[ind] << (uint64_t)cnt;
+			buf |= (twodigit_t)abs->digits[ind] << cnt;
 			ind++;
 			cnt += DIGIT_SHIFT;
 		}
@@ -1008,6 +1552,145 @@ static char * _fast_conversion(const KrkLong * abs, unsigned int bits, char * wr
 	return writer;
 }
 
+/**
+ * Values with more than this many digits in a non-power-of-two base are
+ * converted by splitting them on powers of the base, so the work is done
+ * by fast multiplication and division instead of one small step per digit.
+ */
+#ifndef BASE_CONVERSION_CUTOFF
+#define BASE_CONVERSION_CUTOFF 300
+#endif
+
+/**
+ * @brief Powers of a base used when converting to or from strings.
+ *
+ * @c pows[j] is @c base raised to <tt>BASE_CONVERSION_CUTOFF << j</tt>, each
+ * the square of the last. They are computed as they are needed.
+ */
+struct BasePowers {
+	unsigned int base;
+	digit_t chunkMult;   /**< Largest power of @c base that fits in a digit */
+	size_t chunkDigits;  /**< Number of base digits that power represents */
+	size_t count;        /**< Number of entries in @c pows computed so far */
+	KrkLong pows[64];
+};
+
+static void _base_powers_init(struct BasePowers * p, unsigned int base) {
+	p->base = base;
+	p->chunkMult = base;
+	p->chunkDigits = 1;
+	while ((twodigit_t)p->chunkMult * base <= DIGIT_MAX) {
+		p->chunkMult *= base;
+		p->chunkDigits++;
+	}
+	p->count = 0;
+}
+
+static void _base_powers_clear(struct BasePowers * p) {
+	for (size_t i = 0; i < p->count; ++i) krk_long_clear(&p->pows[i]);
+}
+
+/**
+ * @brief Multiply @p num by @p mult and add @p add, in place.
+ *
+ * @p num must not be negative.
+ */
+static void _mul_small_add(KrkLong * num, digit_t mult, digit_t add) {
+	size_t width = num->width;
+	twodigit_t carry = add;
+	for (size_t i = 0; i < width; ++i) {
+		twodigit_t t = (twodigit_t)num->digits[i] * mult + carry;
+		num->digits[i] = t & DIGIT_MAX;
+		carry = t >> DIGIT_SHIFT;
+	}
+	if (carry) {
+		krk_long_resize(num, width + 1);
+		num->digits[width] = carry;
+	}
+}
+
+static const KrkLong * _base_power(struct BasePowers * p, size_t j) {
+	while (p->count <= j) {
+		KrkLong * next = &p->pows[p->count];
+		if (p->count == 0) {
+			krk_long_init_si(next, 1);
+			size_t digits = 0;
+			while (digits + p->chunkDigits <= BASE_CONVERSION_CUTOFF) {
+				_mul_small_add(next, p->chunkMult, 0);
+				digits += p->chunkDigits;
+			}
+			while (digits < BASE_CONVERSION_CUTOFF) {
+				_mul_small_add(next, p->base, 0);
+				digits++;
+			}
+		} else {
+			krk_long_init_si(next, 0);
+			krk_long_mul(next, &p->pows[p->count-1], &p->pows[p->count-1]);
+		}
+		p->count++;
+	}
+	return &p->pows[j];
+}
+
+/**
+ * @brief Write the digits of a non-negative long in a non-power-of-two base.
+ *
+ * Digits are written least significant first, as @c krk_long_to_str expects.
+ * If @p pad is non-zero, exactly that many digits are written, including
+ * leading zeros; @p v must be less than <tt>pows[level+1]</tt> in that case.
+ * Otherwise no leading zeros are written, and nothing at all for zero.
+ */
+static char * _write_digits(const KrkLong * v, struct BasePowers * p, ssize_t level, size_t pad, char * writer) {
+	if (!pad) {
+		while (level >= 0 && krk_long_compare(v, _base_power(p, level)) < 0) level--;
+	}
+
+	if (level < 0) {
+		char * start = writer;
+		KrkLong tmp;
+		krk_long_init_copy(&tmp, v);
+		while (tmp.width) {
+			digit_t rem = _div_inplace(&tmp, p->chunkMult);
+			for (size_t i = 0; i < p->chunkDigits && (pad ? (size_t)(writer - start) < pad : (rem || tmp.width)); ++i) {
+				*writer++ = _vals[rem % p->base];
+				rem /= p->base;
+			}
+		}
+		while ((size_t)(writer - start) < pad) *writer++ = '0';
+		krk_long_clear(&tmp);
+		return writer;
+	}
+
+	size_t low = (size_t)BASE_CONVERSION_CUTOFF << level;
+	KrkLong hi, lo;
+	krk_long_init_many(&hi, &lo, NULL);
+	_div_abs(&hi, &lo, v, _base_power(p, level));
+	writer = _write_digits(&lo, p, level - 1, low, writer);
+	writer = _write_digits(&hi, p, level - 1, pad ? pad - low : 0, writer);
+	krk_long_clear_many(&hi, &lo, NULL);
+	return writer;
+}
+
+/**
+ * @brief Write the digits of a positive long in a non-power-of-two base.
+ */
+static char * _slow_conversion(const KrkLong * abs, unsigned int base, char * writer) {
+	struct BasePowers p;
+	_base_powers_init(&p, base);
+
+	/* Find the largest power to split on that is not greater than the value */
+	ssize_t level = -1;
+	size_t width = abs->width;
+	while (level < 0 || 2 * (size_t)_base_power(&p, level)->width - 1 <= width) {
+		if (krk_long_compare(abs, _base_power(&p, level + 1)) < 0) break;
+		level++;
+	}
+
+	writer = _write_digits(abs, &p, level, 0, writer);
+	_base_powers_clear(&p);
+	return writer;
+}
+
 /**
  * @brief Convert a long to a string in a given base.
  */
@@ -1031,11 +1714,7 @@ static char * krk_long_to_str(const KrkLong * n, int _base, const char * prefix,
 			case 4:  writer = _fast_conversion(&abs,2,writer); break;
 			case 8:  writer = _fast_conversion(&abs,3,writer); break;
 			case 16: writer = _fast_conversion(&abs,4,writer); break;
-			default:
-				while (krk_long_sign(&abs) > 0) {
-					uint32_t rem = _div_inplace(&abs,_base);
-					*writer++ = _vals[rem];
-				}
+			default: writer = _slow_conversion(&abs,_base,writer); break;
 		}
 	}
 
@@ -1044,14 +1723,11 @@ static char * krk_long_to_str(const KrkLong * n, int _base, const char * prefix,
 
 	char * rev = malloc(len);
 	char * out = rev;
-	uint32_t hash = 0;
 	while (writer != tmp) {
-		*out = *--writer;
-		krk_hash_advance(hash,*out);
-		out++;
+		*out++ = *--writer;
 	}
 	*out = '\0';
-	*_hash = hash;
+	*_hash = krk_hashBytes(rev, out - rev);
 
 	free(tmp);
 
@@ -1061,13 +1737,52 @@ static char * krk_long_to_str(const KrkLong * n, int _base, const char * prefix,
 	return rev;
 }
 
-static const unsigned char _convert_table[256] = {
-255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,255,255,255,255,255,255,
-255, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,255,255,255,255,255,
-255, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,255,255,255,255,255,
-255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+/**
+ * @brief Raise ValueError if @p digits exceeds the limit for decimal conversions.
+ *
+ * The limit, @c vm.maxIntStrDigits, guards against spending unbounded
+ * time converting untrusted input; it does not apply to power-of-two bases.
+ *
+ * @return 1 if an exception was raised.
+ */
+static int _str_digits_too_long(size_t digits) {
+	if (vm.maxIntStrDigits && digits > vm.maxIntStrDigits) {
+		krk_runtimeError(vm.exceptions->valueError,
+			"Exceeds the limit (%zu digits) for integer string conversion: value has %zu digits; "
+			"use kuroko.set_int_max_str_digits() to increase the limit", vm.maxIntStrDigits, digits);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Check the digit limit before converting @p num to decimal.
+ *
+ * Values whose bit length alone shows they are over the limit are rejected
+ * without doing the conversion. The caller must still check the length of
+ * the result, as values within a digit of the limit may pass.
+ */
+static int _str_digits_exceeded(const KrkLong * num) {
+	if (!vm.maxIntStrDigits) return 0;
+	size_t bits = _bits_in(num);
+	if (!bits) return 0;
+	/* A value of n bits has at least (n-1) * log10(2) + 1 decimal digits */
+	if ((size_t)((bits - 1) * 0.30102) + 1 > vm.maxIntStrDigits) {
+		krk_runtimeError(vm.exceptions->valueError,
+			"Exceeds the limit (%zu digits) for integer string conversion; "
+			"use kuroko.set_int_max_str_digits() to increase the limit", vm.maxIntStrDigits);
+		return 1;
+	}
+	return 0;
+}
+
+static const unsigned char _convert_table[256] = {
+255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,255,255,255,255,255,255,
+255, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,255,255,255,255,255,
+255, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,255,255,255,255,255,
+255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
 255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
 255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
 };
@@ -1085,15 +1800,53 @@ static int is_whitespace(char c) {
 	return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
 }
 
+/**
+ * @brief Parse digit values in a non-power-of-two base into a long.
+ *
+ * Long runs of digits are split so that the upper part is scaled by one of
+ * the precomputed powers of the base, which keeps the halves balanced and
+ * lets fast multiplication do most of the work.
+ */
+static void _parse_digits(KrkLong * num, const uint8_t * vals, size_t count, struct BasePowers * p) {
+	if (count <= BASE_CONVERSION_CUTOFF) {
+		size_t i = 0;
+		while (i < count) {
+			digit_t accum = 0;
+			digit_t mult = 1;
+			for (size_t j = 0; j < p->chunkDigits && i < count; ++j, ++i) {
+				accum = accum * p->base + vals[i];
+				mult *= p->base;
+			}
+			_mul_small_add(num, mult, accum);
+		}
+		return;
+	}
+
+	size_t level = 0;
+	while (((size_t)BASE_CONVERSION_CUTOFF << (level + 1)) < count) level++;
+	size_t low = (size_t)BASE_CONVERSION_CUTOFF << level;
+
+	KrkLong hi, lo;
+	krk_long_init_many(&hi, &lo, NULL);
+	_parse_digits(&hi, vals, count - low, p);
+	_parse_digits(&lo, vals + count - low, low, p);
+	krk_long_mul(num, &hi, _base_power(p, level));
+	krk_long_add(num, num, &lo);
+	krk_long_clear_many(&hi, &lo, NULL);
+}
+
 /**
  * @brief Parse a number into a long.
  *
  * This is now the main number parse for the compiler as well as being
  * used when you pass a string to @c int or @c long.
  *
- * @return 0 on success, something else on failure.
+ * If @p limited is set, numbers in non-power-of-two bases with more digits
+ * than @c vm.maxIntStrDigits raise ValueError.
+ *
+ * @return 0 on success, 3 if an exception was raised, something else on failure.
  */
-static int krk_long_parse_string(const char * str, KrkLong * num, unsigned int base, size_t len) {
+static int krk_long_parse_string(const char * str, KrkLong * num, unsigned int base, size_t len, int limited) {
 	const char * end = str + len;
 	const char * c = str;
 	int sign = 1;
@@ -1186,7 +1939,7 @@ static int krk_long_parse_string(const char * str, KrkLong * num, unsigned int b
 		krk_long_resize(num, digit_offset + 1);
 
 		uint32_t cnt = 0;
-		uint64_t buf = 0;
+		twodigit_t buf = 0;
 		const char * x = end;
 		size_t i = 0;
 
@@ -1194,7 +1947,7 @@ static int krk_long_parse_string(const char * str, KrkLong * num, unsigned int b
 
 		while (x != c || buf) {
 			while (cnt < DIGIT_SHIFT && x > c) {
-				buf |=  (uint64_t)convert_digit(x[-1]) << cnt;
+				buf |=  (twodigit_t)convert_digit(x[-1]) << cnt;
 				cnt += bits;
 				x--;
 				while (x != c && x[-1] == '_') x--;
@@ -1207,33 +1960,29 @@ static int krk_long_parse_string(const char * str, KrkLong * num, unsigned int b
 
 		krk_long_trim(num);
 	} else {
-		KrkLong _base, scratch;
-		krk_long_init_si(&_base, 0);
-		krk_long_init_si(&scratch, 0);
-
-		while (c < end && *c) {
-			uint64_t accum = 0;
-			uint64_t basediv = 1;
-			while (c < end && *c && (basediv * base < 0x10000000000000UL)) {
-				if (*c == '_') { c++; continue; }
-				if (!is_valid(base, *c)) {
-					krk_long_clear_many(&_base, &scratch, num, NULL);
-					return 1;
-				}
-
-				basediv *= base;
-				accum *= base;
-				accum += convert_digit(*c);
-				c++;
+		uint8_t * vals = malloc(end - c);
+		size_t digits = 0;
+		for (const char * x = c; x < end; ++x) {
+			if (*x == '_') continue;
+			if (unlikely(!is_valid(base, *x))) {
+				free(vals);
+				krk_long_clear(num);
+				return 1;
 			}
-			krk_long_init_ui(&_base, basediv);
-			krk_long_mul(num, num, &_base);
-			krk_long_clear_many(&scratch, &_base, NULL);
-			krk_long_init_ui(&scratch, accum);
-			krk_long_add(num, num, &scratch);
+			vals[digits++] = convert_digit(*x);
+		}
+
+		if (!digits || (limited && _str_digits_too_long(digits))) {
+			free(vals);
+			krk_long_clear(num);
+			return digits ? 3 : 1;
 		}
 
-		krk_long_clear_many(&_base, &scratch, NULL);
+		struct BasePowers powers;
+		_base_powers_init(&powers, base);
+		_parse_digits(num, vals, digits, &powers);
+		_base_powers_clear(&powers);
+		free(vals);
 	}
 
 	if (sign == -1) {
@@ -1288,7 +2037,9 @@ KRK_StaticMethod(long,__new__) {
 		/* XXX This should probably work like int(...) does and default to base 10... and take a base at all... */
 		struct BigInt * self = (struct BigInt*)krk_newInstance(KRK_BASE_CLASS(long));
 		krk_push(OBJECT_VAL(self));
-		if (krk_long_parse_string(AS_CSTRING(argv[1]),self->value,0,AS_STRING(argv[1])->length)) {
+		int status = krk_long_parse_string(AS_CSTRING(argv[1]),self->value,0,AS_STRING(argv[1])->length,1);
+		if (status == 3) return NONE_VAL();
+		if (status) {
 			return krk_runtimeError(vm.exceptions->valueError, "invalid literal for long() with base 0: %R", argv[1]);
 		}
 		return krk_pop();
@@ -1302,6 +2053,22 @@ KRK_StaticMethod(long,__new__) {
 	}
 }
 
+/**
+ * @brief Get the 64 bits of |value| starting at bit @p shift.
+ */
+static uint64_t _bits_at(const KrkLong * value, size_t shift) {
+	size_t awidth = value->width < 0 ? -value->width : value->width;
+	size_t i = shift / DIGIT_SHIFT;
+	if (i >= awidth) return 0;
+	size_t have = DIGIT_SHIFT - shift % DIGIT_SHIFT;
+	uint64_t out = value->digits[i++] >> (DIGIT_SHIFT - have);
+	while (have < 64 && i < awidth) {
+		out |= (uint64_t)value->digits[i++] << have;
+		have += DIGIT_SHIFT;
+	}
+	return out;
+}
+
 #ifndef KRK_NO_FLOAT
 /**
  * Float conversions.
@@ -1317,28 +2084,12 @@ static double krk_long_get_double(const KrkLong * value) {
 
 	uint64_t sign = value->width < 0 ? 1 : 0;
 
-	/* We only need the top two digits if this value is normalized */
-	uint64_t mantissa = 0;
-	uint64_t high = value->digits[awidth-1];
-	uint64_t med  = awidth > 1 ? value->digits[awidth-2] : 0;
-	uint64_t low  = awidth > 2 ? value->digits[awidth-3] : 0;
-
-	int s = 0;
-	for (s = DIGIT_SHIFT; s >= 0; s--) {
-		if (high & (1 << s)) break;
-	}
-
-	int high_shift = 52 - s;
-	int med_shift  = 21 - s;
-	int low_shift  = 10 + s;
-
-	mantissa |= high << high_shift;
-	mantissa |= med_shift >= 0 ? (med << med_shift) : (med >> -med_shift);
-	mantissa |= low >> low_shift;
-
+	/* Take the 53 bits from the top set bit down, truncating the rest */
+	size_t bits = _bits_in(value);
+	uint64_t mantissa = bits > 53 ? _bits_at(value, bits - 53) : (_bits_at(value, 0) << (53 - bits));
 	mantissa &= 0xfffffffffffffUL;
 
-	uint64_t exp = (s + (awidth - 1) * DIGIT_SHIFT) + 0x3FF;
+	uint64_t exp = (bits - 1) + 0x3FF;
 
 	if (exp > 0x7Fe) {
 		krk_runtimeError(vm.exceptions->valueError, "overflow, too large for float conversion");
@@ -1378,8 +2129,9 @@ static KrkValue _krk_long_truediv(KrkLong * _top, KrkLong * _bottom) {
 #define NEEDED_BITS 53
 	int bits_wanted = NEEDED_BITS;
 	size_t bits = _bits_in(&top);
+	ssize_t _i = bits;
 	for (ssize_t i = 0; bits_wanted >= 0; ++i) {
-		ssize_t _i = bits - i - 1;
+		_i = bits - i - 1;
 		_lshift_one(&rem);
 		_bit_set_zero(&rem, (_i >= 0 ? _bit_is_set(&top, _i) : 0));
 		if (krk_long_compare(&rem,&bottom) >= 0) {
@@ -1395,9 +2147,13 @@ static KrkValue _krk_long_truediv(KrkLong * _top, KrkLong * _bottom) {
 	}
 #undef NEEDED_BITS
 
+	/* Bits of the numerator we did not get to still count towards rounding up */
+	int sticky = rem.width != 0;
+	for (ssize_t j = 0; !sticky && j < _i; ++j) sticky = _bit_is_set(&top, j);
+
 	if (exp < 1) quot >>= -exp + 1;
 	if ((quot & 1) && !(quot & 2)) {
-		if (rem.width != 0) quot += 2;
+		if (sticky) quot += 2;
 	} else if (quot & 1) quot += 2;
 	quot &= ~1;
 	if (exp < 1) quot <<= -exp + 1;
@@ -1537,34 +2293,37 @@ PRINTER(oct,8,"o0")
 PRINTER(bin,2,"b0")
 
 KRK_Method(long,__hash__) {
-	return INTEGER_VAL((uint32_t)(krk_long_medium(self->value)));
+	/* Reduce modulo 2**61-1 so this agrees with int and float hashes. */
+	uint64_t residue = 0;
+	size_t width = self->value->width < 0 ? -self->value->width : self->value->width;
+	const unsigned int rot = DIGIT_SHIFT % 61;
+	for (size_t i = width; i > 0; --i) {
+		residue = ((residue << rot) & KRK_HASH_MODULUS) | (residue >> (61 - rot));
+		uint64_t digit = self->value->digits[i-1];
+		digit = (digit & KRK_HASH_MODULUS) + (digit >> 61);
+		if (digit >= KRK_HASH_MODULUS) digit -= KRK_HASH_MODULUS;
+		residue += digit;
+		if (residue >= KRK_HASH_MODULUS) residue -= KRK_HASH_MODULUS;
+	}
+	return INTEGER_VAL(krk_hashReduced(residue, self->value->width < 0));
 }
 
 static KrkValue make_long_obj(KrkLong * val) {
-	krk_integer_type maybe = 0;
-	if (val->width == 0) {
-		maybe = 0;
-	} else if (val->width == 1) {
-		maybe = val->digits[0];
-	} else if (val->width == -1) {
-		maybe = -(int64_t)val->digits[0];
-	} else if (val->width == 2 && (val->digits[1] & 0xFFFF0000) == 0) {
-		maybe = ((uint64_t)val->digits[1] << 31) | val->digits[0];
-	} else if (val->width == -2 && (val->digits[1] & 0xFFFF0000) == 0) {
-		maybe = -(((uint64_t)val->digits[1] << 31) | val->digits[0]);
-	} else {
+	/* Anything that fits in 47 bits and a sign can be a plain int */
+	if (_bits_in(val) > 47) {
 		krk_push(OBJECT_VAL(krk_newInstance(KRK_BASE_CLASS(long))));
 		*AS_long(krk_peek(0))->value = *val;
 		return krk_pop();
 	}
 
+	krk_integer_type maybe = krk_long_medium(val);
 	krk_long_clear(val);
 	return INTEGER_VAL(maybe);
 }
 
 KrkValue krk_parse_int(const char * start, size_t width, unsigned int base) {
 	KrkLong _value;
-	if (krk_long_parse_string(start, &_value, base, width)) {
+	if (krk_long_parse_string(start, &_value, base, width, 1)) {
 		return NONE_VAL();
 	}
 
@@ -1641,29 +2400,16 @@ static void _krk_long_lshift_z(krk_long out, krk_long val, size_t amount) {
 		return;
 	}
 
-	int64_t count = _bits_in(val);
+	size_t count = _bits_in(val);
 	krk_long_clear(out);
 	if (count == 0) return;
 
-	size_t offset = amount % 31;
-	size_t cycles = amount / 31;
-	ssize_t w = val->width < 0 ? -val->width : val->width;
-	krk_long_bit_set(out, count - 1 + amount);
-
-	if (!offset) {
-		for (ssize_t i = 0; i < w; ++i) {
-			out->digits[i+cycles] = val->digits[i];
-		}
-	} else {
-		uint32_t shift_in = 0;
-		for (ssize_t i = 0; i < w; ++i) {
-			out->digits[i+cycles] = ((val->digits[i] << offset) & DIGIT_MAX) | shift_in;
-			shift_in = (val->digits[i] >> (31 - offset)) & DIGIT_MAX;
-		}
-		if (shift_in) {
-			out->digits[w+cycles] = shift_in;
-		}
-	}
+	size_t offset = amount % DIGIT_SHIFT;
+	size_t cycles = amount / DIGIT_SHIFT;
+	size_t w = val->width < 0 ? -val->width : val->width;
+	krk_long_resize(out, w + cycles + 1);
+	out->digits[w+cycles] = _shift_digits_left(out->digits + cycles, val->digits, w, offset);
+	krk_long_trim(out);
 
 	if (krk_long_sign(val) < 0) krk_long_set_sign(out,-1);
 }
@@ -1681,30 +2427,17 @@ static void _krk_long_rshift_z(krk_long out, krk_long val, size_t amount) {
 		return;
 	}
 
-	int64_t count = _bits_in(val);
+	size_t count = _bits_in(val);
 	krk_long_clear(out);
 	if (count == 0) return;
 
-	if (amount < (size_t)count) {
-		size_t offset = amount % 31;
-		size_t cycles = amount / 31;
-		ssize_t w = val->width < 0 ? -val->width : val->width;
-		krk_long_bit_set(out, count - 1 - amount);
-
-		if (!offset) {
-			for (ssize_t i = cycles; i < w; ++i) {
-				out->digits[i-cycles] = val->digits[i];
-			}
-		} else {
-			out->digits[0] = (val->digits[cycles] >> offset) & DIGIT_MAX;
-			for (size_t i = 1; i < (size_t)out->width; ++i) {
-				out->digits[i-1] |= (val->digits[i+cycles] << (31 - offset)) & DIGIT_MAX;
-				out->digits[i] = (val->digits[i+cycles] >> offset) & DIGIT_MAX;
-			}
-			if (out->width+cycles < (size_t)w) {
-				out->digits[out->width-1] |= (val->digits[out->width+cycles] << (31 - offset)) & DIGIT_MAX;
-			}
-		}
+	if (amount < count) {
+		size_t offset = amount % DIGIT_SHIFT;
+		size_t cycles = amount / DIGIT_SHIFT;
+		size_t w = val->width < 0 ? -val->width : val->width;
+		krk_long_resize(out, w - cycles);
+		_shift_digits_right(out->digits, val->digits + cycles, w - cycles, offset);
+		krk_long_trim(out);
 	}
 
 	if (krk_long_sign(val) < 0) {
@@ -1772,9 +2505,9 @@ static void _krk_long_pow(krk_long out, krk_long a, krk_long b) {
 	krk_long_init_si(scratch, 0);
 
 	for (ssize_t i = b[0].width-1; i >= 0; --i) {
-		uint32_t b_i = b[0].digits[i];
+		digit_t b_i = b[0].digits[i];
 
-		for (size_t j = (uint32_t)1 << (DIGIT_SHIFT-1); j != 0; j >>= 1) {
+		for (digit_t j = (digit_t)1 << (DIGIT_SHIFT-1); j != 0; j >>= 1) {
 			krk_long_mul(scratch, out, out);
 			_swap(out, scratch);
 
@@ -1797,6 +2530,483 @@ static void _krk_long_pow(krk_long out, krk_long a, krk_long b) {
 	FINISH_OUTPUT(out);
 }
 
+/**
+ * Modular exponentiation, gcd, and integer square roots.
+ *
+ * These back the three-argument form of @c pow and @c math.gcd and
+ * @c math.isqrt, and work on the digit arrays directly rather than
+ * going through the general arithmetic for every step.
+ */
+
+/**
+ * @brief Residue arithmetic modulo an @c n digit modulus.
+ *
+ * Odd moduli use Montgomery form, where a residue a is kept as aR mod m
+ * with R = B^n, so each product is reduced by n multiply-and-shift passes
+ * instead of a long division. Even moduli fall back to dividing.
+ */
+struct ModContext {
+	const KrkLong * mod;
+	size_t n;
+	int montgomery;
+	digit_t minv;       /**< -m^-1 mod B, for Montgomery reduction */
+	digit_t * product;  /**< 2n+1 digits of scratch */
+	KrkLong quot, rem;  /**< for reduction by division */
+};
+
+/**
+ * @brief Montgomery reduction of the 2n digit value in @p t into @p out.
+ *
+ * Each pass adds the multiple of m that clears the lowest remaining digit,
+ * leaving t / R, which is below 2m and needs at most one subtraction.
+ */
+static void _mont_redc(struct ModContext * ctx, digit_t * out, digit_t * t) {
+	size_t n = ctx->n;
+	const digit_t * m = ctx->mod->digits;
+	t[2*n] = 0;
+	for (size_t i = 0; i < n; ++i) {
+		digit_t u = (t[i] * ctx->minv) & DIGIT_MAX;
+		twodigit_t carry = 0;
+		for (size_t j = 0; j < n; ++j) {
+			carry += (twodigit_t)u * m[j] + t[i+j];
+			t[i+j] = carry & DIGIT_MAX;
+			carry >>= DIGIT_SHIFT;
+		}
+		digit_t top = carry;
+		_add_digits(t + i + n, n + 1 - i, &top, 1);
+	}
+
+	digit_t * r = t + n;
+	int ge = r[n] != 0;
+	if (!ge) {
+		ge = 1;
+		for (size_t j = n; j-- > 0;) {
+			if (r[j] != m[j]) {
+				ge = r[j] > m[j];
+				break;
+			}
+		}
+	}
+	if (ge) _sub_digits(r, n + 1, m, n);
+	memcpy(out, r, sizeof(digit_t) * n);
+}
+
+/**
+ * @brief Set @p out to a * b in the context's residue form; @p out may alias either.
+ */
+static void _mod_mul(struct ModContext * ctx, digit_t * out, const digit_t * a, const digit_t * b) {
+	size_t n = ctx->n;
+	_mul_digits(ctx->product, a, n, b, n);
+	if (ctx->montgomery) {
+		_mont_redc(ctx, out, ctx->product);
+		return;
+	}
+	KrkLong prod;
+	_digits_view(&prod, ctx->product, 2 * n);
+	_div_abs(&ctx->quot, &ctx->rem, &prod, ctx->mod);
+	size_t w = ctx->rem.width;
+	if (w) memcpy(out, ctx->rem.digits, sizeof(digit_t) * w);
+	memset(out + w, 0, sizeof(digit_t) * (n - w));
+}
+
+/**
+ * @brief Load @p value, which is less than the modulus, into residue form.
+ */
+static void _mod_load(struct ModContext * ctx, digit_t * out, const KrkLong * value) {
+	KrkLong shifted;
+	krk_long_init_si(&shifted, 0);
+	if (ctx->montgomery) {
+		_krk_long_lshift_z(&shifted, (KrkLong*)value, ctx->n * DIGIT_SHIFT);
+		_div_abs(&ctx->quot, &ctx->rem, &shifted, ctx->mod);
+		value = &ctx->rem;
+	}
+	size_t w = value->width;
+	if (w) memcpy(out, value->digits, sizeof(digit_t) * w);
+	memset(out + w, 0, sizeof(digit_t) * (ctx->n - w));
+	krk_long_clear(&shifted);
+}
+
+/**
+ * @brief Set @p out to the inverse of @p a modulo @p m, with the extended Euclidean algorithm.
+ *
+ * @p a must be in [0, m). @return 0 if there is no inverse.
+ */
+static int _mod_inverse(KrkLong * out, const KrkLong * a, const KrkLong * m) {
+	KrkLong r0, r1, s0, s1, q, t;
+	krk_long_init_copy(&r0, m);
+	krk_long_init_copy(&r1, a);
+	krk_long_init_si(&s0, 0);
+	krk_long_init_si(&s1, 1);
+	krk_long_init_many(&q, &t, NULL);
+
+	/* Invariant: s_i * a = r_i (mod m) */
+	while (r1.width) {
+		_div_abs(&q, &t, &r0, &r1);
+		_swap(&r0, &r1);
+		_swap(&r1, &t);
+		krk_long_mul(&t, &q, &s1);
+		krk_long_sub(&t, &s0, &t);
+		_swap(&s0, &s1);
+		_swap(&s1, &t);
+	}
+
+	int invertible = r0.width == 1 && r0.digits[0] == 1;
+	if (invertible) krk_long_div_rem(&q, out, &s0, m);
+	krk_long_clear_many(&r0, &r1, &s0, &s1, &q, &t, NULL);
+	return invertible;
+}
+
+/**
+ * @brief Compute (base ** exp) % mod with Python's sign conventions.
+ *
+ * All three arguments are clobbered. The base is reduced, or inverted for a
+ * negative exponent, and then the exponent is scanned from the top with a
+ * sliding window over a table of the odd powers of the base, which takes
+ * one multiplication per window instead of one per set bit.
+ */
+static KrkValue _long_pow_mod(KrkLong * base, KrkLong * exp, KrkLong * mod) {
+	if (mod->width == 0) return krk_runtimeError(vm.exceptions->valueError, "pow() 3rd argument cannot be 0");
+
+	int negative_mod = mod->width < 0;
+	krk_long_set_sign(mod, 1);
+
+	KrkLong result, garbage;
+	krk_long_init_many(&result, &garbage, NULL);
+	krk_long_div_rem(&garbage, base, base, mod);
+
+	if (exp->width < 0) {
+		if (!_mod_inverse(base, base, mod)) {
+			krk_long_clear_many(&result, &garbage, NULL);
+			return krk_runtimeError(vm.exceptions->valueError, "base is not invertible for the given modulus");
+		}
+		krk_long_set_sign(exp, 1);
+	}
+
+	size_t n = mod->width;
+	size_t bits = _bits_in(exp);
+
+	if (n == 1 && mod->digits[0] == 1) {
+		/* Everything is 0 mod 1 */
+	} else if (bits == 0) {
+		krk_long_init_si(&result, 1);
+	} else if (n == 1) {
+		/* Single digit modulus, products fit in a twodigit_t */
+		twodigit_t m = mod->digits[0];
+		twodigit_t b = base->width ? base->digits[0] : 0;
+		twodigit_t acc = b;
+		for (size_t i = bits - 1; i-- > 0;) {
+			acc = acc * acc % m;
+			if (_bit_is_set(exp, i)) acc = acc * b % m;
+		}
+		krk_long_init_ui(&result, acc);
+	} else {
+		struct ModContext ctx;
+		ctx.mod = mod;
+		ctx.n = n;
+		ctx.montgomery = mod->digits[0] & 1;
+		ctx.product = malloc(sizeof(digit_t) * (2 * n + 1));
+		krk_long_init_many(&ctx.quot, &ctx.rem, NULL);
+		if (ctx.montgomery) {
+			/* Newton's iteration for m^-1 mod 2^64, doubling the correct low bits each step */
+			uint64_t m0 = mod->digits[0], inv = m0;
+			for (int i = 0; i < 6; ++i) inv *= 2 - m0 * inv;
+			ctx.minv = (digit_t)(0 - inv) & DIGIT_MAX;
+		}
+
+		int k = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : bits > 7 ? 2 : 1;
+		size_t tsize = (size_t)1 << (k - 1);
+		digit_t * table = malloc(sizeof(digit_t) * n * (tsize + 1));
+		digit_t * acc = table + n * tsize;
+
+		/* table[i] = base ** (2i+1) */
+		_mod_load(&ctx, table, base);
+		_mod_mul(&ctx, acc, table, table);
+		for (size_t i = 1; i < tsize; ++i) {
+			_mod_mul(&ctx, table + n * i, table + n * (i - 1), acc);
+		}
+
+		int started = 0;
+		ssize_t i = bits - 1;
+		while (i >= 0) {
+			if (!_bit_is_set(exp, i)) {
+				_mod_mul(&ctx, acc, acc, acc);
+				i--;
+				continue;
+			}
+
+			/* Longest window of at most k bits that starts and ends with a one */
+			ssize_t l = i - k + 1 < 0 ? 0 : i - k + 1;
+			while (!_bit_is_set(exp, l)) l++;
+			size_t window = 0;
+			for (ssize_t j = i; j >= l; --j) {
+				window = (window << 1) | _bit_is_set(exp, j);
+				if (started) _mod_mul(&ctx, acc, acc, acc);
+			}
+
+			if (started) {
+				_mod_mul(&ctx, acc, acc, table + n * (window >> 1));
+			} else {
+				memcpy(acc, table + n * (window >> 1), sizeof(digit_t) * n);
+				started = 1;
+			}
+			i = l - 1;
+
+			if (krk_currentThread.flags & KRK_THREAD_SIGNALLED) break;
+		}
+
+		/* Leave Montgomery form by reducing acc * 1 */
+		if (ctx.montgomery) {
+			memcpy(ctx.product, acc, sizeof(digit_t) * n);
+			memset(ctx.product + n, 0, sizeof(digit_t) * n);
+			_mont_redc(&ctx, acc, ctx.product);
+		}
+
+		krk_long_resize(&result, n);
+		memcpy(result.digits, acc, sizeof(digit_t) * n);
+		krk_long_trim(&result);
+
+		free(table);
+		free(ctx.product);
+		krk_long_clear_many(&ctx.quot, &ctx.rem, NULL);
+	}
+
+	/* The result takes the sign of the modulus */
+	if (negative_mod && result.width) krk_long_sub(&result, &result, mod);
+
+	krk_long_clear(&garbage);
+	return make_long_obj(&result);
+}
+
+/**
+ * @brief Initialize @p out from an @c int or @c long value.
+ *
+ * @return 0, leaving @p out uninitialized, if @p value is not an integer.
+ */
+static int _long_from_value(KrkLong * out, KrkValue value) {
+	if (IS_long(value)) krk_long_init_copy(out, AS_long(value)->value);
+	else if (IS_INTEGER(value)) krk_long_init_si(out, AS_INTEGER(value));
+	else return 0;
+	return 1;
+}
+
+/**
+ * @brief Three-argument @c pow for integers.
+ *
+ * @return @c NotImplemented if any of the arguments is not an integer.
+ */
+_noexport
+KrkValue krk_long_pow_mod(KrkValue base, KrkValue exp, KrkValue mod) {
+	if (!(IS_INTEGER(base) || IS_long(base)) || !(IS_INTEGER(exp) || IS_long(exp)) || !(IS_INTEGER(mod) || IS_long(mod))) return NOTIMPL_VAL();
+	krk_long b, e, m;
+	_long_from_value(b, base);
+	_long_from_value(e, exp);
+	_long_from_value(m, mod);
+	KrkValue result = _long_pow_mod(b, e, m);
+	krk_long_clear_many(b, e, m, NULL);
+	return result;
+}
+
+/**
+ * @brief Binary gcd of two machine words.
+ */
+static uint64_t _gcd64(uint64_t x, uint64_t y) {
+	if (!x) return y;
+	if (!y) return x;
+	int shift = __builtin_ctzll(x | y);
+	x >>= __builtin_ctzll(x);
+	while (y) {
+		y >>= __builtin_ctzll(y);
+		if (x > y) {
+			uint64_t t = x;
+			x = y;
+			y = t;
+		}
+		y -= x;
+	}
+	return x << shift;
+}
+
+/**
+ * @brief Set @p out to the greatest common divisor of |a| and |b|.
+ *
+ * Lehmer's algorithm: run Euclid's algorithm on the leading 60 bits of
+ * both values for as long as the quotients are sure to match those of the
+ * full values, collecting the steps into a matrix of single-digit
+ * cofactors, then apply that matrix to the full values in one pass.
+ * Once the values fit in a machine word, finish with a binary gcd.
+ */
+static void _long_gcd(KrkLong * out, const KrkLong * _a, const KrkLong * _b) {
+	KrkLong a, b, q, r;
+	krk_long_init_copy(&a, _a);
+	krk_long_init_copy(&b, _b);
+	krk_long_set_sign(&a, 1);
+	krk_long_set_sign(&b, 1);
+	krk_long_init_many(&q, &r, NULL);
+	if (krk_long_compare(&a, &b) < 0) _swap(&a, &b);
+
+	while (1) {
+		size_t nbits = _bits_in(&a);
+		if (nbits <= 64) {
+			krk_long_clear(out);
+			krk_long_init_ui(out, _gcd64(_bits_at(&a, 0), _bits_at(&b, 0)));
+			break;
+		}
+		if (b.width == 0) {
+			_swap(out, &a);
+			break;
+		}
+
+		int64_t x = _bits_at(&a, nbits - 60);
+		int64_t y = _bits_at(&b, nbits - 60);
+		int64_t A = 1, B = 0, C = 0, D = 1;
+		int k;
+		for (k = 0;; k++) {
+			if (y - C == 0) break;
+			int64_t q = (x + (A - 1)) / (y - C);
+			int64_t s, t;
+			if (__builtin_mul_overflow(q, D, &s) || __builtin_mul_overflow(q, y, &t)) break;
+			s += B;
+			t = x - t;
+			if (s > t) break;
+			x = y; y = t;
+			t = A + q * C; A = D; B = C; C = s; D = t;
+		}
+
+		if (k == 0) {
+			/* No progress from the leading bits, take a full Euclidean step */
+			_div_abs(&q, &r, &a, &b);
+			_swap(&a, &b);
+			_swap(&b, &r);
+			continue;
+		}
+
+		/* a, b = A*a - B*b, D*b - C*a, with the signs flipped for an odd number of steps */
+		if (k & 1) {
+			int64_t T = -A; A = -B; B = T;
+			T = -C; C = -D; D = T;
+		}
+
+		size_t an = a.width;
+		krk_long_resize(&b, an);
+		stwodigit_t ca = 0, cb = 0;
+		for (size_t i = 0; i < an; ++i) {
+			stwodigit_t ad = a.digits[i], bd = b.digits[i];
+			ca += (stwodigit_t)A * ad - (stwodigit_t)B * bd;
+			cb += (stwodigit_t)D * bd - (stwodigit_t)C * ad;
+			a.digits[i] = (digit_t)(ca & DIGIT_MAX);
+			b.digits[i] = (digit_t)(cb & DIGIT_MAX);
+			ca >>= DIGIT_SHIFT;
+			cb >>= DIGIT_SHIFT;
+		}
+		krk_long_trim(&a);
+		krk_long_trim(&b);
+	}
+
+	krk_long_clear_many(&a, &b, &q, &r, NULL);
+}
+
+/**
+ * @brief Integer square root of a machine word.
+ */
+static uint64_t _isqrt64(uint64_t n) {
+	if (!n) return 0;
+	unsigned int c = (63 - __builtin_clzll(n)) / 2;
+	uint64_t a = 1;
+	unsigned int d = 0;
+	for (int s = c ? 31 - __builtin_clz(c) : -1; s >= 0; --s) {
+		unsigned int e = d;
+		d = c >> s;
+		a = (a << (d - e - 1)) + (n >> (2 * c - e - d + 1)) / a;
+	}
+	return a - (a > n / a);
+}
+
+/**
+ * @brief Set @p out to the integer square root of the non-negative @p n.
+ *
+ * Newton's iteration run at doubling precision, as in CPython: each step
+ * refines a root of the leading bits of @p n into a root of twice as many
+ * leading bits, so the work is dominated by the final full-size division.
+ */
+static void _long_isqrt(KrkLong * out, const KrkLong * n) {
+	size_t bits = _bits_in(n);
+	krk_long_clear(out);
+	if (bits <= 64) {
+		krk_long_init_ui(out, _isqrt64(_bits_at(n, 0)));
+		return;
+	}
+
+	size_t c = (bits - 1) / 2;
+	int s = 0;
+	while ((c >> s) > 1) s++;
+
+	KrkLong hi, lo, q, r;
+	krk_long_init_many(&hi, &lo, &q, &r, NULL);
+	krk_long_init_si(out, 1);
+	size_t d = 0;
+	for (; s >= 0; --s) {
+		size_t e = d;
+		d = c >> s;
+		/* a = (a << (d - e - 1)) + (n >> (2c - e - d + 1)) / a */
+		_krk_long_lshift_z(&hi, out, d - e - 1);
+		_krk_long_rshift_z(&lo, (KrkLong*)n, 2 * c - e - d + 1);
+		_div_abs(&q, &r, &lo, out);
+		krk_long_add(out, &hi, &q);
+	}
+
+	krk_long_mul(&hi, out, out);
+	if (krk_long_compare(&hi, n) > 0) {
+		krk_long_clear(&lo);
+		krk_long_init_si(&lo, 1);
+		krk_long_sub(out, out, &lo);
+	}
+	krk_long_clear_many(&hi, &lo, &q, &r, NULL);
+}
+
+/**
+ * @brief Greatest common divisor of two integers, for @c math.gcd
+ *
+ * @return @c NotImplemented if either argument is not an integer.
+ */
+KrkValue krk_long_gcd(KrkValue a, KrkValue b) {
+	if (IS_INTEGER(a) && IS_INTEGER(b)) {
+		krk_integer_type x = AS_INTEGER(a), y = AS_INTEGER(b);
+		krk_long out;
+		krk_long_init_ui(out, _gcd64(x < 0 ? -(uint64_t)x : (uint64_t)x, y < 0 ? -(uint64_t)y : (uint64_t)y));
+		return make_long_obj(out);
+	}
+	krk_long x, y;
+	if (!_long_from_value(x, a)) return NOTIMPL_VAL();
+	if (!_long_from_value(y, b)) {
+		krk_long_clear(x);
+		return NOTIMPL_VAL();
+	}
+	krk_long out;
+	krk_long_init_si(out, 0);
+	_long_gcd(out, x, y);
+	krk_long_clear_many(x, y, NULL);
+	return make_long_obj(out);
+}
+
+/**
+ * @brief Integer square root, for @c math.isqrt
+ *
+ * @return @c NotImplemented if the argument is not an integer.
+ */
+KrkValue krk_long_isqrt(KrkValue value) {
+	krk_long n;
+	if (!_long_from_value(n, value)) return NOTIMPL_VAL();
+	if (krk_long_sign(n) < 0) {
+		krk_long_clear(n);
+		return krk_runtimeError(vm.exceptions->valueError, "isqrt() argument must be nonnegative");
+	}
+	krk_long out;
+	krk_long_init_si(out, 0);
+	_long_isqrt(out, n);
+	krk_long_clear(n);
+	return make_long_obj(out);
+}
+
 BASIC_BIN_OP(lshift,_krk_long_lshift)
 BASIC_BIN_OP(rshift,_krk_long_rshift)
 BASIC_BIN_OP(mod,_krk_long_mod)
@@ -1892,15 +3102,12 @@ static int formatLongCallback(void * a, int base, int *more) {
 	return 0;
 }
 
-static char * krk_long_to_decimal_str(const KrkLong * value, size_t * len);
 static fmtCallback prepLongCallback(void * a, int base) {
 	struct _private * val = a;
-	if (base != 10 || (val->val->width > -10 && val->val->width < 10)) {
-		uint32_t hash = 0;
-		val->asStr = krk_long_to_str(val->val, base, "", &val->len, &hash);
-	} else {
-		val->asStr = krk_long_to_decimal_str(val->val, &val->len);
-	}
+	if (base == 10 && _str_digits_exceeded(val->val)) return formatLongCallback;
+	uint32_t hash = 0;
+	val->asStr = krk_long_to_str(val->val, base, "", &val->len, &hash);
+	if (base == 10 && _str_digits_too_long(val->len - (val->asStr[0] == '-'))) return formatLongCallback;
 	val->next = &val->asStr[val->len-1];
 	return formatLongCallback;
 }
@@ -1926,10 +3133,10 @@ KRK_Method(long,__format__) {
 
 static KrkValue long_bit_count(KrkLong * val) {
 	size_t count = 0;
-	size_t bits = _bits_in(val);
+	size_t awidth = val->width < 0 ? -val->width : val->width;
 
-	for (size_t i = 0; i < bits; ++i) {
-		count += _bit_is_set(val, i);
+	for (size_t i = 0; i < awidth; ++i) {
+		count += __builtin_popcountll(val->digits[i]);
 	}
 
 	KrkLong tmp;
@@ -2008,25 +3215,25 @@ static KrkValue long_to_bytes(KrkLong * val, size_t argc, const KrkValue argv[],
 
 	/* We'll use a 'bit reader':
 	 * - We want 8 bits for each byte.
-	 * - We can collect 31 bits from each digit.
+	 * - We can collect DIGIT_SHIFT bits from each digit.
 	 * - If we run out of digits, we're done.
 	 */
 	ssize_t i = 0;
 	ssize_t j = 0;
 
-	uint64_t accum = 0;
+	twodigit_t accum = 0;
 	int32_t remaining = 0;
 	int break_here = 0;
 
 	while (i < length && !break_here) {
 		if (remaining < 8) {
 			if (j < tmp.width) {
-				accum |= ((uint64_t)tmp.digits[j]) << remaining;
+				accum |= ((twodigit_t)tmp.digits[j]) << remaining;
 				j++;
 			} else {
 				break_here = 1;
 			}
-			remaining += 31;
+			remaining += DIGIT_SHIFT;
 		}
 
 		uint8_t byte = accum & 0xFF;
@@ -2074,7 +3281,8 @@ KRK_Method(long,_digit_count) {
  *
  * Internal. Obtain an int value representative of a digit of a long.
  *
- * Basically (|n| >> (31 * index)) & 0x7FFFFFFF
+ * Basically (|n| >> (DIGIT_SHIFT * index)) & DIGIT_MAX, where digits are
+ * 31 or 62 bits depending on how the interpreter was built.
  *
  * @param index Digit to get. May be an @c int or a @c long >= 0 and <= 2.
  * @return An int representation of the unsigned digit @p index of the long.
@@ -2103,402 +3311,429 @@ KRK_Method(long,_get_digit) {
 		return krk_runtimeError(vm.exceptions->indexError, "digit index out of range");
 	}
 
-	return INTEGER_VAL(_self->digits[index]);
+	return krk_int_from_ull(_self->digits[index]);
 }
 
-/**
- * Huge decimals for fast conversion.
- *
- * This is a lightweight implementation of decimal-based bigints that only supports
- * addition, inplace subtraction, and multiplication (via Karatsuba). With this, we
- * can much more quickly produce decimal conversions of (binary) longs.
- */
-typedef uint32_t digit_t;
-#define DEC_DIGIT_SIZE sizeof(digit_t)
-#define DEC_DIGIT_CNT  9
-#define DEC_DIGIT_MAX 1000000000
-
-/**
- * Adds @c a and @c b to create a new results.
- */
-static digit_t * dec_add(const digit_t * a, size_t awidth, const digit_t * b, size_t bwidth, size_t * outwidth) {
-	*outwidth = (awidth > bwidth ? awidth : bwidth) + 1;
-	digit_t * out = calloc(*outwidth, DEC_DIGIT_SIZE);
-	int64_t carry = 0;
-	for (size_t i  = 0; i < *outwidth - 1; ++i) {
-		digit_t n = ((i < awidth) ? a[i] : 0) + ((i < bwidth) ? b[i] : 0) + carry;
-		out[i] = n % DEC_DIGIT_MAX;
-		carry = (n >= DEC_DIGIT_MAX);
-	}
-	if (carry) {
-		out[*outwidth-1] = 1;
-	} else {
-		*outwidth -= 1;
+KRK_Method(long,__repr__) {
+	if (_str_digits_exceeded(self->value)) return NONE_VAL();
+	size_t len;
+	uint32_t hash;
+	char * rev = krk_long_to_str(self->value, 10, "", &len, &hash);
+	if (_str_digits_too_long(len - (rev[0] == '-'))) {
+		free(rev);
+		return NONE_VAL();
 	}
+	return OBJECT_VAL(krk_takeStringVetted(rev,len,len,KRK_OBJ_FLAGS_STRING_ASCII,hash));
+}
+
+#ifndef KRK_NO_FLOAT
+KrkValue krk_int_from_float(double a) {
+	union { double d; uint64_t u; } val = {.d = a};
+
+	int sign  = (val.u >> 63ULL) ? 1 : 0;
+	int64_t m = val.u & 0x000fffffffffffffULL;
+	int64_t e = ((val.u >> 52ULL) & 0x7FF) - 0x3FF;
+
+	if (e < 0) return INTEGER_VAL(0);
+	if (e == 1024) return krk_runtimeError(vm.exceptions->valueError, "can not convert float %s to int", m ? "Nan" : "infinity");
+	if (e < 47) return INTEGER_VAL((int64_t)a);
+
+	KrkLong _value, _tmp;
+	krk_long_init_si(&_value, 0x10000000000000ULL | m);
+	krk_long_init_si(&_tmp, 0);
 
-	if (*outwidth == 0) {
-		*outwidth = 1;
-		out[0] = 0;
+	if (e > 52) {
+		_krk_long_lshift_z(&_tmp, &_value, e - 52);
+		krk_long_clear(&_value);
+		_value = _tmp;
+	} else if (e < 52) {
+		_krk_long_rshift_z(&_tmp, &_value, 52 - e);
+		krk_long_clear(&_value);
+		_value = _tmp;
+	} else {
+		krk_long_clear(&_tmp);
 	}
 
-	return out;
+	krk_long_set_sign(&_value, sign == 1 ? -1 : 1);
+	return make_long_obj(&_value);
 }
 
+#if defined(__SIZEOF_INT128__)
 /**
- * Subtracts a smaller @c b from a larger @c a in-place.
+ * Where 128-bit products are available, floats are printed with Ulf Adams'
+ * Ryu (the shortest decimal that reads back as the same double) and parsed
+ * with the Eisel-Lemire algorithm. Both fall back to the exact conversions
+ * below when they can not be sure of the answer.
  */
-static void dec_isub(digit_t * a, size_t awidth, const digit_t * b, size_t bwidth) {
-	int64_t carry = 0;
-	for (size_t i = 0; i < awidth; ++i) {
-		int64_t a_digit = (int64_t)((i < awidth) ? a[i] : 0) - carry;
-		int64_t b_digit = (int64_t)((i < bwidth) ? b[i] : 0);
-		if (a_digit < b_digit) {
-			a_digit += DEC_DIGIT_MAX;
-			carry = 1;
-		} else {
-			carry = 0;
-		}
-		a[i] = (a_digit - b_digit) % DEC_DIGIT_MAX;
-	}
-}
+#define FAST_FLOAT_CONVERSION
+__extension__ typedef unsigned __int128 uint128_t;
+
+#define RYU_POW5_BITS      125
+#define RYU_POW5_COUNT     326
+#define RYU_POW5_INV_COUNT 342
+#define LEMIRE_MIN_POW10   (-342)
+#define LEMIRE_MAX_POW10   308
 
 /**
- * Decimal left shift. Multiply a by 1000000000^amount and return a new result value.
+ * 128-bit approximations of powers of five, as { low, high } halves:
+ * 5^i and 2^k/5^i with 125 significant bits for Ryu, and 5^q truncated
+ * to 128 bits for Eisel-Lemire. These are built from exact longs rather
+ * than carried around as a few thousand lines of constants.
  */
-static digit_t * dec_shift(const digit_t * a, size_t awidth, size_t amount, size_t * outwidth) {
-	if (awidth == 1 && a[0] == 0) {
-		*outwidth = 1;
-		return calloc(1,DEC_DIGIT_SIZE);
-	}
-	*outwidth = awidth + amount;
-	digit_t * out = calloc(*outwidth,DEC_DIGIT_SIZE);
+static uint64_t ryu_pow5[RYU_POW5_COUNT][2];
+static uint64_t ryu_pow5_inv[RYU_POW5_INV_COUNT][2];
+static uint64_t lemire_pow5[LEMIRE_MAX_POW10 - LEMIRE_MIN_POW10 + 1][2];
 
-	for (size_t i = 0; i < awidth; ++i) {
-		out[i+amount] = a[i];
-	}
+/** Bits in 5^e, for 0 <= e <= 3528 */
+static inline int32_t _pow5_bits(int32_t e) {
+	return ((e * 1217359) >> 19) + 1;
+}
 
-	return out;
+/** Store the low 128 bits of @p v, after shifting it right by @p s bits (or left, if negative). */
+static void _store_pow5(uint64_t out[2], const KrkLong * v, ssize_t s) {
+	KrkLong shifted;
+	krk_long_init_si(&shifted, 0);
+	if (s > 0) _krk_long_rshift_z(&shifted, (KrkLong*)v, s);
+	else _krk_long_lshift_z(&shifted, (KrkLong*)v, -s);
+	out[0] = _bits_at(&shifted, 0);
+	out[1] = _bits_at(&shifted, 64);
+	krk_long_clear(&shifted);
 }
 
-/**
- * Multiply a by b and return a new result value.
- *
- * Uses the Karatsuba algorithm for larger values; degrades to brute-force
- * chalkboard multiplication for smaller values.
- */
-static digit_t * dec_mul(const digit_t * a, size_t a_width, const digit_t * b, size_t b_width, size_t * outwidth) {
-	/* We want a to be bigger than b */
-	if (a_width < b_width) {
-		const digit_t * t = a;
-		a = b;
-		b = t;
-		size_t tmp = a_width;
-		a_width = b_width;
-		b_width = tmp;
+#ifndef KRK_DISABLE_THREADS
+static volatile int _floatTablesLock = 0;
+#endif
+static int _floatTablesReady = 0;
+
+/** Build the tables above on first use; this takes longer than the rest of startup. */
+static void _float_tables_init(void) {
+	if (__atomic_load_n(&_floatTablesReady, __ATOMIC_ACQUIRE)) return;
+	_obtain_lock(_floatTablesLock);
+	if (_floatTablesReady) {
+		_release_lock(_floatTablesLock);
+		return;
 	}
 
-	*outwidth = a_width + b_width;
+	KrkLong pow5, one, num, quot, rem;
+	krk_long_init_many(&pow5, &one, &num, &quot, &rem, NULL);
+	krk_long_init_si(&pow5, 1);
+	krk_long_init_si(&one, 1);
 
-	/* Degenerate case where a or b is 0: return 0 */
-	if ((a_width == 1 && a[0] == 0) || (b_width == 1 && b[0] == 0)) {
-		*outwidth = 1;
-		return calloc(1,DEC_DIGIT_SIZE);
-	}
+	for (int32_t i = 0; i <= -LEMIRE_MIN_POW10; ++i) {
+		ssize_t bits = _bits_in(&pow5);
 
-	/* Degenerate case where a is 1, return b */
-	if (a_width == 1 && a[0] == 1) {
-		*outwidth = b_width;
-		digit_t * out = malloc(*outwidth * DEC_DIGIT_SIZE);
-		memcpy(out, b, *outwidth * DEC_DIGIT_SIZE);
-		return out;
-	}
+		if (i < RYU_POW5_COUNT) _store_pow5(ryu_pow5[i], &pow5, _pow5_bits(i) - RYU_POW5_BITS);
 
-	/* Degenerate case where b is 1, return a */
-	if (b_width == 1 && b[0] == 1) {
-		*outwidth = a_width;
-		digit_t * out = malloc(*outwidth * DEC_DIGIT_SIZE);
-		memcpy(out, a, *outwidth * DEC_DIGIT_SIZE);
-		return out;
-	}
+		if (i < RYU_POW5_INV_COUNT) {
+			/* floor(2^k / 5^i) + 1 */
+			_krk_long_lshift_z(&num, &one, _pow5_bits(i) - 1 + RYU_POW5_BITS);
+			krk_long_div_rem(&quot, &rem, &num, &pow5);
+			krk_long_add(&quot, &quot, &one);
+			_store_pow5(ryu_pow5_inv[i], &quot, 0);
+		}
 
-	if (b_width < 50) {
-		/* Fallback brute-force multiplication */
-		digit_t * out = calloc(*outwidth,DEC_DIGIT_SIZE);
-		for (size_t i = 0; i < b_width; ++i) {
-			digit_t bdigit = (i < b_width) ? b[i] : 0;
-			int64_t carry = 0;
-			for (size_t j = 0; j < a_width; ++j) {
-				digit_t adigit = (j < a_width) ? a[j] : 0;
-				uint64_t t = carry + (int64_t)adigit * (int64_t)bdigit + out[i+j];
-				carry = t / DEC_DIGIT_MAX;
-				out[i+j] = t % DEC_DIGIT_MAX;
-			}
-			out[i+a_width] = carry;
+		if (i <= LEMIRE_MAX_POW10) _store_pow5(lemire_pow5[i - LEMIRE_MIN_POW10], &pow5, bits - 128);
+
+		if (i >= 1) {
+			/* 2^b / 5^i + 1, with enough bits for the full product, truncated to 128 bits */
+			_krk_long_lshift_z(&num, &one, i <= 27 ? bits + 127 : 2 * bits + 128);
+			krk_long_div_rem(&quot, &rem, &num, &pow5);
+			krk_long_add(&quot, &quot, &one);
+			ssize_t qbits = _bits_in(&quot);
+			_store_pow5(lemire_pow5[-i - LEMIRE_MIN_POW10], &quot, qbits > 128 ? qbits - 128 : 0);
 		}
-		while (*outwidth > 1 && out[(*outwidth)-1] == 0) (*outwidth)--;
-		return out;
-	} else {
-		size_t m2  = a_width / 2;
-
-		/* Split a into its high and low halves */
-		const digit_t * low1  = a;
-		size_t    low1_width = (m2 <= a_width) ? m2 : a_width;
-		while (low1_width > 1 && low1[low1_width-1] == 0) low1_width--;
-		digit_t   a_zero = 0;
-		const digit_t * high1 = (m2 <= a_width) ? (a + m2) : &a_zero;
-		size_t    high1_width = (m2 <= a_width) ? (a_width - m2) : 1;
-
-		/* Split b into its high and low halves */
-		const digit_t * low2  = b;
-		size_t    low2_width = (m2 <= b_width) ? m2 : b_width;
-		while (low2_width > 1 && low2[low2_width-1] == 0) low2_width--;
-		digit_t   b_zero = 0;
-		const digit_t * high2 = (m2 <= b_width) ? (b + m2) : &b_zero;
-		size_t    high2_width = (m2 <= b_width) ? (b_width - m2) : 1;
-
-		size_t z0_width, z1_width, z2_width;
-
-		/* z0 = low1 * low2; z2 = high1 * high2 */
-		digit_t * z0 = dec_mul(low1, low1_width, low2, low2_width, &z0_width);
-		digit_t * z2 = dec_mul(high1, high1_width, high2, high2_width, &z2_width);
-
-		/* z1 = (low1 + high1) * (low2 + high2) */
-		size_t sleft_width, sright_width;
-		digit_t * sleft  = dec_add(low1, low1_width, high1, high1_width, &sleft_width);
-		digit_t * sright = dec_add(low2, low2_width, high2, high2_width, &sright_width);
-		digit_t * z1 = dec_mul(sleft, sleft_width, sright, sright_width, &z1_width);
-		free(sleft);
-		free(sright);
-
-		/* Store (z1 - z2 - z0) into z1 */
-		dec_isub(z1, z1_width, z2, z2_width);
-		dec_isub(z1, z1_width, z0, z0_width);
-
-		/* Calculate (z1 - z2 - z0) * 10 ^ m2 */
-		size_t m2_shift_width;
-		digit_t * m2_shift = dec_shift(z1, z1_width, m2, &m2_shift_width);
-		free(z1);
-
-		/* Add z0 to that */
-		size_t add_width;
-		digit_t * add = dec_add(m2_shift, m2_shift_width, z0, z0_width, &add_width);
-		free(m2_shift);
-		free(z0);
-
-		/* Then calculate z2 * 10 ^ (m2 * 2) */
-		size_t m2_2_width;
-		digit_t * m2_2 = dec_shift(z2, z2_width, m2 * 2, &m2_2_width);
-		free(z2);
-
-		/* And add everything up */
-		size_t result_width;
-		digit_t * result = dec_add(m2_2, m2_2_width, add, add_width, &result_width);
-		free(m2_2);
-		free(add);
-
-		*outwidth = result_width;
-		return result;
+
+		_mul_small_add(&pow5, 5, 0);
+	}
+
+	krk_long_clear_many(&pow5, &one, &num, &quot, &rem, NULL);
+	__atomic_store_n(&_floatTablesReady, 1, __ATOMIC_RELEASE);
+	_release_lock(_floatTablesLock);
+}
+
+/** (m * mul) >> j, for a 125-bit @p mul and j > 64 */
+static inline uint64_t _ryu_mul_shift(uint64_t m, const uint64_t mul[2], int32_t j) {
+	uint128_t low = (uint128_t)m * mul[0];
+	uint128_t high = (uint128_t)m * mul[1];
+	return (uint64_t)(((low >> 64) + high) >> (j - 64));
+}
+
+static inline int _multiple_of_pow5(uint64_t value, uint32_t p) {
+	uint32_t count = 0;
+	while (value % 5 == 0) {
+		value /= 5;
+		count++;
 	}
+	return count >= p;
 }
 
 /**
- * @brief Raise 2 to the wth power, as a huge decimal.
+ * @brief Shortest decimal that reads back as a given finite, non-zero double.
  *
- * Creates a decimal representation of 2 raised to the requested power.
+ * Ryu, from Ulf Adams' "Ryū: fast float-to-string conversion" (PLDI 2018):
+ * the bounds of the interval that rounds to the double are scaled to a
+ * power of ten with a single 64x128 multiplication each, and then digits
+ * are removed from all three until the bounds agree.
  *
- * If @p w is very small (eg. 2**w would fit in one decimal digit), then
- * we can create this value directly. Otherwise, we recursively break
- * down @p w into smaller values and build huge decimals out of them
- * through repeated multiplication.
- *
- * An older prototype of this used a cache, which did save some time,
- * but not a whole lot in the long run, and this implementation is
- * considerably simpler without the cache.
- *
- * @param w Power to raise 2 to.
- * @param sizeOut Resulting size of the huge decimal.
- * @returns A huge decimal representing 2 ** w.
+ * @param mantissa Mantissa bits of the double.
+ * @param exponent Biased exponent bits of the double.
+ * @param out      Receives the decimal digits, as an integer.
+ * @returns The power of ten to multiply @p out by.
  */
-static digit_t * dec_two_raised(size_t w, size_t * sizeOut) {
-	if (w <= 29) {
-		*sizeOut = 1;
-		digit_t * out = malloc(DEC_DIGIT_SIZE);
-		out[0] = 1 << w;
-		return out;
+static int32_t _ryu_shortest(uint64_t mantissa, uint32_t exponent, uint64_t * out) {
+	int32_t e2;
+	uint64_t m2;
+	if (exponent == 0) {
+		e2 = 1 - 1023 - 52 - 2;
+		m2 = mantissa;
 	} else {
-		/* w2 = w >> 1 */
-		size_t w2 = w >> 1;
-
-		/* t = Decimal(1 << w2) */
-		size_t tSize;
-		digit_t * t = dec_two_raised(w2, &tSize);
-
-		if ((w & 1) == 0) {
-			/* Result = t * t */
-			digit_t * result = dec_mul(t, tSize, t, tSize, sizeOut);
-			free(t);
-			return result;
-		} else {
-			/* wmw2 = w - w2 */
-			size_t wmw2 = w - w2;
+		e2 = (int32_t)exponent - 1023 - 52 - 2;
+		m2 = (1ULL << 52) | mantissa;
+	}
+	int accept_bounds = (m2 & 1) == 0;
+
+	/* The value and its neighbours, as four times the mantissa, with the lower
+	 * neighbour closer when the mantissa is a power of two. */
+	uint64_t mv = 4 * m2;
+	uint32_t mm_shift = mantissa != 0 || exponent <= 1;
+
+	uint64_t vr, vp, vm;
+	int32_t e10;
+	int vm_trailing_zeros = 0;
+	int vr_trailing_zeros = 0;
+
+	if (e2 >= 0) {
+		uint32_t q = ((e2 * 78913) >> 18) - (e2 > 3);
+		e10 = q;
+		int32_t k = RYU_POW5_BITS + _pow5_bits(q) - 1;
+		int32_t i = -e2 + (int32_t)q + k;
+		vr = _ryu_mul_shift(4 * m2, ryu_pow5_inv[q], i);
+		vp = _ryu_mul_shift(4 * m2 + 2, ryu_pow5_inv[q], i);
+		vm = _ryu_mul_shift(4 * m2 - 1 - mm_shift, ryu_pow5_inv[q], i);
+		if (q <= 21) {
+			/* Only one of mv, mp, and mm can be a multiple of 5, if any. */
+			if (mv % 5 == 0) {
+				vr_trailing_zeros = _multiple_of_pow5(mv, q);
+			} else if (accept_bounds) {
+				vm_trailing_zeros = _multiple_of_pow5(mv - 1 - mm_shift, q);
+			} else {
+				vp -= _multiple_of_pow5(mv + 2, q);
+			}
+		}
+	} else {
+		uint32_t q = ((-e2 * 732923) >> 20) - (-e2 > 1);
+		e10 = (int32_t)q + e2;
+		int32_t i = -e2 - (int32_t)q;
+		int32_t k = _pow5_bits(i) - RYU_POW5_BITS;
+		int32_t j = (int32_t)q - k;
+		vr = _ryu_mul_shift(4 * m2, ryu_pow5[i], j);
+		vp = _ryu_mul_shift(4 * m2 + 2, ryu_pow5[i], j);
+		vm = _ryu_mul_shift(4 * m2 - 1 - mm_shift, ryu_pow5[i], j);
+		if (q <= 1) {
+			/* mv has at least q trailing zeros in binary, so vr is exact */
+			vr_trailing_zeros = 1;
+			if (accept_bounds) {
+				vm_trailing_zeros = mm_shift == 1;
+			} else {
+				--vp;
+			}
+		} else if (q < 63) {
+			vr_trailing_zeros = (mv & ((1ULL << q) - 1)) == 0;
+		}
+	}
 
-			/* right = 1 << wmw2 */
-			size_t rightSize;
-			digit_t * right = dec_two_raised(wmw2, &rightSize);
+	int32_t removed = 0;
+	unsigned int last_removed = 0;
+	uint64_t output;
 
-			/* result = t * right */
-			digit_t * result = dec_mul(t, tSize, right, rightSize, sizeOut);
-			free(t);
-			free(right);
-			return result;
+	if (vm_trailing_zeros || vr_trailing_zeros) {
+		/* The exact value may be on a bound, or a tie; track the digits we remove. */
+		while (vp / 10 > vm / 10) {
+			vm_trailing_zeros &= vm % 10 == 0;
+			vr_trailing_zeros &= last_removed == 0;
+			last_removed = vr % 10;
+			vr /= 10; vp /= 10; vm /= 10;
+			removed++;
+		}
+		if (vm_trailing_zeros) {
+			while (vm % 10 == 0) {
+				vr_trailing_zeros &= last_removed == 0;
+				last_removed = vr % 10;
+				vr /= 10; vp /= 10; vm /= 10;
+				removed++;
+			}
+		}
+		if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+			/* Round to even on an exact tie */
+			last_removed = 4;
+		}
+		output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+	} else {
+		/* The common case: just round to nearest. */
+		int round_up = 0;
+		if (vp / 100 > vm / 100) {
+			round_up = vr % 100 >= 50;
+			vr /= 100; vp /= 100; vm /= 100;
+			removed += 2;
 		}
+		while (vp / 10 > vm / 10) {
+			round_up = vr % 10 >= 5;
+			vr /= 10; vp /= 10; vm /= 10;
+			removed++;
+		}
+		output = vr + (vr == vm || round_up);
 	}
+
+	*out = output;
+	return e10 + removed;
 }
 
 /**
- * @brief Convert a KrkLong to a series of huge decimal digits.
+ * @brief Shortest round-trip digits for a finite, non-zero double.
  *
- * Takes a KrkLong @p n of bitwidth @p w and converts it into an array of
- * @c digit_t huge decimal digits, storing the size in @p sizeOut.
+ * Fills in @p str, @p len, and @p b the same way as @c _exact_decimal, if
+ * rounding those digits for this formatter and precision gives the same
+ * result as rounding the exact expansion would. Rounding to fewer digits
+ * always agrees, unless the shortest digits stop on a 5 that may or may
+ * not have been a tie; padding with zeros agrees up to 15 digits.
  *
- * @param n KrkLong to convert.
- * @param w Bitwidth of @p n.
- * @param sizeOut Resulting size of the huge decimal.
- * @returns Huge decimal of equivalent value.
+ * @returns 1 if @p str was filled in, 0 if the exact expansion is needed.
  */
-static digit_t * long_to_dec_inner(KrkLong * n, size_t w, size_t * sizeOut) {
-	if (n->width == 0) {
-		*sizeOut = 1;
-		return calloc(1,DEC_DIGIT_SIZE);
-	}
-	if (w <= 29) {
-		*sizeOut = 1;
-		digit_t * out = malloc(DEC_DIGIT_SIZE);
-		out[0] = n->digits[0];
-		return out;
+static int _shortest_decimal(uint64_t bits, char formatter, unsigned int digits, char ** str, size_t * len, int * b) {
+	_float_tables_init();
+
+	uint64_t output;
+	int32_t e10 = _ryu_shortest(bits & 0x000fffffffffffffULL, (bits >> 52) & 0x7FF, &output);
+
+	char dec[20];
+	int count = 0;
+	do {
+		dec[count++] = '0' + output % 10;
+		output /= 10;
+	} while (output);
+	for (int i = 0; i < count / 2; ++i) {
+		char t = dec[i];
+		dec[i] = dec[count - 1 - i];
+		dec[count - 1 - i] = t;
+	}
+
+	if (formatter != ' ') {
+		/* Subnormals have too few bits for the precision argument below. */
+		if (!(bits & 0x7ff0000000000000ULL)) return 0;
+		int significant = count;
+		while (significant > 1 && dec[significant-1] == '0') significant--;
+		int ten_exponent = count - 1 + e10;
+		int wanted = (formatter | 0x20) == 'f' ? ten_exponent + 1 + (int)digits :
+		             (formatter | 0x20) == 'e' ? (int)digits + 1 : (digits ? (int)digits : 1);
+		if (significant > wanted) {
+			if (wanted >= 0 && significant == wanted + 1 && dec[wanted] == '5') return 0;
+		} else if (wanted > 15) {
+			return 0;
+		}
 	}
 
-	size_t aSize, bSize, cSize;
-	digit_t * a, * b, * c;
-	KrkLong hi, lo, tmp;
-	krk_long_init_many(&hi, &lo, &tmp, NULL);
-	/* w2 = w >> 1 */
-	size_t w2 = w >> 1;
-	/* hi = n >> w2 */
-	_krk_long_rshift_z(&hi, n, w2);
-	/* tmp = hi << w2 */
-	_krk_long_lshift_z(&tmp, &hi, w2);
-	/* lo = n - (hi << w2) */
-	krk_long_sub(&lo, n, &tmp);
-	krk_long_clear_many(&tmp, NULL);
-	/* a = Dec(hi) */
-	a = long_to_dec_inner(&hi, w - w2, &aSize);
-	krk_long_clear_many(&hi, NULL);
-	/* b = Dec(1 << w2) */
-	b = dec_two_raised(w2, &bSize);
-	/* c = a * b */
-	c = dec_mul(a, aSize, b, bSize, &cSize);
-	free(a);
-	free(b);
-	/* a = Dec(lo) */
-	a = long_to_dec_inner(&lo, w2, &aSize);
-	krk_long_clear_many(&lo,NULL);
-	/* result = a + c */
-	digit_t * result = dec_add(a, aSize, c, cSize, sizeOut);
-	free(a);
-	free(c);
-	return result;
+	size_t pad = e10 > 0 ? (size_t)e10 : 0;
+	char * out = malloc(count + pad + 1);
+	memcpy(out, dec, count);
+	memset(out + count, '0', pad);
+	out[count + pad] = '\0';
+
+	*str = out;
+	*len = count + pad;
+	*b = e10 > 0 ? 0 : -e10;
+	return 1;
 }
 
-static char * krk_long_to_decimal_str(const KrkLong * value, size_t * len) {
-	/* We can only do this on positive values, but we can re-use the digits
-	 * of the current number while processing, since longs are generally
-	 * not mutable by any other operations. */
-	KrkLong abs = *value;
-	int inv = (krk_long_sign(&abs) == -1);
-	krk_long_set_sign(&abs, 1);
+/**
+ * @brief Convert a decimal to the nearest double, if that is quick to be sure of.
+ *
+ * Exact products of doubles when both @p w and 10^q fit in them (Clinger);
+ * otherwise, Daniel Lemire's "Number Parsing at a Gigabyte per Second"
+ * (2021), after Michael Eisel: multiply the normalized significand by a
+ * truncated 128-bit power of five and take the top 54 bits.
+ *
+ * @param w   Decimal significand, exact.
+ * @param q   Power of ten to scale @p w by.
+ * @param out Receives the result, without a sign.
+ * @returns 1 on success, 0 if the exact conversion is needed.
+ */
+static int _eisel_lemire(uint64_t w, int64_t q, double * out) {
+	static const double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	union { double d; uint64_t u; } result;
+
+	if (w == 0 || q < LEMIRE_MIN_POW10) {
+		*out = 0.0;
+		return 1;
+	}
+	if (q > LEMIRE_MAX_POW10) {
+		result.u = 0x7ff0000000000000ULL;
+		*out = result.d;
+		return 1;
+	}
+	if (w <= (1ULL << 53) && q >= -22 && q <= 22) {
+		*out = q < 0 ? (double)w / powers[-q] : (double)w * powers[q];
+		return 1;
+	}
 
-	/* Calculate bit width for halving */
-	size_t w = _bits_in(&abs);
+	_float_tables_init();
 
-	/* Convert to big decimal digits */
-	size_t size;
-	digit_t * digits = long_to_dec_inner(&abs, w, &size);
+	int lz = __builtin_clzll(w);
+	w <<= lz;
 
-	/* Count number of leading zeros */
-	int leading = 0;
-	for (size_t j = 0, div = DEC_DIGIT_MAX/10; j < DEC_DIGIT_CNT; j++, div/=10) {
-		if (((digits[size-1] / div) % 10)) break;
-		leading += 1;
+	const uint64_t * pow5 = lemire_pow5[q - LEMIRE_MIN_POW10];
+	uint128_t first = (uint128_t)w * pow5[1];
+	uint64_t high = first >> 64;
+	uint64_t low = (uint64_t)first;
+	if ((high & 0x1FF) == 0x1FF) {
+		/* The truncated part of the power may still carry into our bits */
+		uint64_t second = ((uint128_t)w * pow5[0]) >> 64;
+		low += second;
+		if (second > low) high++;
 	}
+	if (low == 0xFFFFFFFFFFFFFFFFULL && (q < -27 || q > 55)) return 0;
 
-	/* Allocate space for output */
-	char * out = malloc(size * DEC_DIGIT_CNT + 1 - leading + inv);
-	char * writer = out;
+	int upper = high >> 63;
+	uint64_t mantissa = high >> (upper + 9);
+	int32_t power2 = (int32_t)(((217706 * q) >> 16) + 63) + upper - lz + 1023;
 
-	/* Write negative sign if original value was negative. */
-	if (inv) *(writer++) = '-';
-
-	/* Collect digits */
-	for (size_t i = 0; i < size; ++i) {
-		for (size_t j = 0, div = DEC_DIGIT_MAX/10; j < DEC_DIGIT_CNT; j++, div/=10) {
-			if (leading) { leading--; continue; }
-			*(writer++) = ((digits[size-i-1] / div) % 10) + '0';
+	if (power2 <= 0) {
+		/* Subnormal, or zero */
+		if (-power2 + 1 >= 64) {
+			*out = 0.0;
+			return 1;
 		}
+		mantissa >>= -power2 + 1;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		/* Rounding may have carried up into the smallest normal exponent */
+		result.u = mantissa;
+		*out = result.d;
+		return 1;
 	}
-	*writer = '\0';
-
-	free(digits);
-	*len = writer - out;
 
-	return out;
-}
-
-KRK_Method(long,__repr__) {
-	/* For rather small values (10 was chosen arbitrarily), use the older approach */
-	size_t len;
-
-	if (self->value->width > -10 && self->value->width < 10) {
-		uint32_t hash;
-		char * rev = krk_long_to_str(self->value, 10, "", &len, &hash);
-		return OBJECT_VAL(krk_takeStringVetted(rev,len,len,KRK_OBJ_FLAGS_STRING_ASCII,hash));
+	/* Round half to even if we are exactly between two doubles. */
+	if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << (upper + 9)) == high) {
+		mantissa &= ~1ULL;
 	}
-
-	char * out = krk_long_to_decimal_str(self->value, &len);
-	return OBJECT_VAL(krk_takeString(out, len));
-}
-
-#ifndef KRK_NO_FLOAT
-KrkValue krk_int_from_float(double a) {
-	union { double d; uint64_t u; } val = {.d = a};
-
-	int sign  = (val.u >> 63ULL) ? 1 : 0;
-	int64_t m = val.u & 0x000fffffffffffffULL;
-	int64_t e = ((val.u >> 52ULL) & 0x7FF) - 0x3FF;
-
-	if (e < 0) return INTEGER_VAL(0);
-	if (e == 1024) return krk_runtimeError(vm.exceptions->valueError, "can not convert float %s to int", m ? "Nan" : "infinity");
-	if (e < 47) return INTEGER_VAL((int64_t)a);
-
-	KrkLong _value, _tmp;
-	krk_long_init_si(&_value, 0x10000000000000ULL | m);
-	krk_long_init_si(&_tmp, 0);
-
-	if (e > 52) {
-		_krk_long_lshift_z(&_tmp, &_value, e - 52);
-		krk_long_clear(&_value);
-		_value = _tmp;
-	} else if (e < 52) {
-		_krk_long_rshift_z(&_tmp, &_value, 52 - e);
-		krk_long_clear(&_value);
-		_value = _tmp;
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if (mantissa >= (2ULL << 52)) {
+		mantissa = 1ULL << 52;
+		power2++;
+	}
+	mantissa &= ~(1ULL << 52);
+	if (power2 >= 0x7FF) {
+		result.u = 0x7ff0000000000000ULL;
 	} else {
-		krk_long_clear(&_tmp);
+		result.u = mantissa | ((uint64_t)power2 << 52);
 	}
-
-	krk_long_set_sign(&_value, sign == 1 ? -1 : 1);
-	return make_long_obj(&_value);
+	*out = result.d;
+	return 1;
 }
+#endif
 
 #include <assert.h>
 
@@ -2551,7 +3786,7 @@ static size_t round_to(char * str, size_t len, size_t actual, size_t digits) {
 }
 
 /**
- * @brief Convert a double to a KrkString.
+ * @brief Exact decimal expansion of a finite, non-zero double.
  *
  * We approach the problem of string conversion by converting the mantissa of the
  * double to a bigint. We then treat that bigint as part of a fraction with a large
@@ -2560,57 +3795,15 @@ static size_t round_to(char * str, size_t len, size_t actual, size_t digits) {
  * by multiplying the top and bottom repeatedly by 10^31, so that the multiplication
  * (actually a right shift) by the 2^n part does not lose any bits. The result of
  * all of this is an exact representation of the numerator of "x" in "x * 10^y = m * 2^n"
- * with a denominator that remains a large power-of-ten. We can then perform decimal
- * string conversion on this, round the decimal result as needed, and piece together
- * the digits to form a whole, fractional, and exponential part.
+ * with a denominator that remains a large power-of-ten.
  *
- * @param a           Double value to convert.
- * @param digits      Desired precision, meaning varies between e/f and g.
- * @param formatter   printf-style formatter character: eEfFgG or ' '
- * @param plus        Whether to force a sign character when value is positive.
- * @param forcedigits Force trailing zeros, particularly in 'g' formatters.
- * @returns A KrkValue representing the string.
+ * @param m     Mantissa bits of the double, without the implicit 1.
+ * @param e     Unbiased exponent of the double; -1023 for subnormals.
+ * @param len   Receives the number of digits in the result.
+ * @param out_b Receives the power of ten the digits are divided by.
+ * @returns Decimal digits of the numerator, to be freed by the caller.
  */
-KrkValue krk_double_to_string(double a, unsigned int digits, char formatter, int plus, int forcedigits) {
-	union { double d; uint64_t u; } val = {.d = a};
-
-	int noexp = (formatter | 0x20) == 'f';
-	int alwaysexp = (formatter | 0x20) == 'e';
-	int caps = !(formatter & 0x20);
-	char expch = caps ? 'E' : 'e';
-
-	/* Extract sign, mantissa, exponent from double, and handle special cases. */
-	int sign = (val.u >> 63ULL) ? 1 : 0;
-	int64_t m = val.u & 0x000fffffffffffffULL;
-	int64_t e = ((val.u >> 52ULL) & 0x7FF) - 0x3FF;
-	if (e == 1024) {
-		struct StringBuilder sb = {0};
-		if (sign && !m) krk_pushStringBuilder(&sb, '-');
-		else if (plus) krk_pushStringBuilder(&sb, '+');
-		if (m) krk_pushStringBuilderStr(&sb, caps ? "NAN" : "nan", 3);
-		else krk_pushStringBuilderStr(&sb, caps ? "INF" : "inf", 3);
-		return krk_finishStringBuilder(&sb);
-	}
-	if (e == -1023 && m == 0) {
-		struct StringBuilder sb = {0};
-		if (sign) krk_pushStringBuilder(&sb, '-');
-		else if (plus) krk_pushStringBuilder(&sb,'+');
-		krk_pushStringBuilder(&sb, '0');
-		/* For f/F and e/E, always fill in digits? */
-		if (digits && (forcedigits || formatter == ' ')) {
-			krk_pushStringBuilder(&sb, '.');
-			for (unsigned int i = 0; i < ((formatter == ' ') ? 1 : (digits - ((!noexp && !alwaysexp) ? 1 : 0))); ++i) {
-				krk_pushStringBuilder(&sb, '0');
-			}
-		}
-		/* Include exponent for e/E */
-		if (alwaysexp) {
-			krk_pushStringBuilder(&sb, expch);
-			krk_pushStringBuilderStr(&sb, "+00", 3);
-		}
-		return krk_finishStringBuilder(&sb);
-	}
-
+static char * _exact_decimal(int64_t m, int64_t e, size_t * len, int * out_b) {
 	/* We need to cache the decimal versions of each necessary division of 10⁵², if we've not seen them before. */
 	KrkValue float_decimal_parts = NONE_VAL();
 	if (!krk_tableGet_fast(&vm.baseClasses->floatClass->methods, S("__decimals__"), &float_decimal_parts)) {
@@ -2618,7 +3811,7 @@ KrkValue krk_double_to_string(double a, unsigned int digits, char formatter, int
 		float_decimal_parts = krk_peek(0);
 
 		KrkLong d;
-		krk_long_parse_string("10000000000000000000000000000000000000000000000000000", &d, 10, 53);
+		krk_long_parse_string("10000000000000000000000000000000000000000000000000000", &d, 10, 53, 0);
 
 		for (int i = 0; i < 53; ++i) {
 			AS_TUPLE(float_decimal_parts)->values.values[AS_TUPLE(float_decimal_parts)->values.count++] = make_long_obj(&d);
@@ -2633,7 +3826,7 @@ KrkValue krk_double_to_string(double a, unsigned int digits, char formatter, int
 		/* We use 10^31 to add additional digits to ensure right shifting does not result
 		 * in dropped bits when converting the base-2 exponent to base-10. */
 		KrkLong f;
-		krk_long_parse_string("10000000000000000000000000000000", &f, 10, 32);
+		krk_long_parse_string("10000000000000000000000000000000", &f, 10, 32, 0);
 		AS_TUPLE(float_decimal_parts)->values.values[AS_TUPLE(float_decimal_parts)->values.count++] = make_long_obj(&f);
 
 		/* Attach to float class. */
@@ -2710,9 +3903,78 @@ KrkValue krk_double_to_string(double a, unsigned int digits, char formatter, int
 	 * determined based on the number of decimal digits in c and the size of b. We no
 	 * longer need our bigints, we want to deal entirely in decimal - so we'll convert
 	 * to a decimal string. */
-	size_t len = 0;
-	char * str = krk_long_to_decimal_str(&c, &len);
+	uint32_t hash;
+	char * str = krk_long_to_str(&c, 10, "", len, &hash);
 	krk_long_clear(&c);
+	*out_b = b;
+	return str;
+}
+
+/**
+ * @brief Convert a double to a KrkString.
+ *
+ * Where possible, the digits come from the shortest decimal that reads back
+ * as the same double; otherwise, from the exact decimal expansion of the
+ * double. We then round the decimal result as needed, and piece together
+ * the digits to form a whole, fractional, and exponential part.
+ *
+ * @param a           Double value to convert.
+ * @param digits      Desired precision, meaning varies between e/f and g.
+ * @param formatter   printf-style formatter character: eEfFgG or ' '
+ * @param plus        Whether to force a sign character when value is positive.
+ * @param forcedigits Force trailing zeros, particularly in 'g' formatters.
+ * @returns A KrkValue representing the string.
+ */
+KrkValue krk_double_to_string(double a, unsigned int digits, char formatter, int plus, int forcedigits) {
+	union { double d; uint64_t u; } val = {.d = a};
+
+	int noexp = (formatter | 0x20) == 'f';
+	int alwaysexp = (formatter | 0x20) == 'e';
+	int caps = !(formatter & 0x20);
+	char expch = caps ? 'E' : 'e';
+
+	/* Extract sign, mantissa, exponent from double, and handle special cases. */
+	int sign = (val.u >> 63ULL) ? 1 : 0;
+	int64_t m = val.u & 0x000fffffffffffffULL;
+	int64_t e = ((val.u >> 52ULL) & 0x7FF) - 0x3FF;
+	if (e == 1024) {
+		struct StringBuilder sb = {0};
+		if (sign && !m) krk_pushStringBuilder(&sb, '-');
+		else if (plus) krk_pushStringBuilder(&sb, '+');
+		if (m) krk_pushStringBuilderStr(&sb, caps ? "NAN" : "nan", 3);
+		else krk_pushStringBuilderStr(&sb, caps ? "INF" : "inf", 3);
+		return krk_finishStringBuilder(&sb);
+	}
+	if (e == -1023 && m == 0) {
+		struct StringBuilder sb = {0};
+		if (sign) krk_pushStringBuilder(&sb, '-');
+		else if (plus) krk_pushStringBuilder(&sb,'+');
+		krk_pushStringBuilder(&sb, '0');
+		/* For f/F and e/E, always fill in digits? */
+		if (digits && (forcedigits || formatter == ' ')) {
+			krk_pushStringBuilder(&sb, '.');
+			for (unsigned int i = 0; i < ((formatter == ' ') ? 1 : (digits - ((!noexp && !alwaysexp) ? 1 : 0))); ++i) {
+				krk_pushStringBuilder(&sb, '0');
+			}
+		}
+		/* Include exponent for e/E */
+		if (alwaysexp) {
+			krk_pushStringBuilder(&sb, expch);
+			krk_pushStringBuilderStr(&sb, "+00", 3);
+		}
+		return krk_finishStringBuilder(&sb);
+	}
+
+	char * str = NULL;
+	size_t len = 0;
+	int b = 0;
+	int shortest = 0;
+
+#ifdef FAST_FLOAT_CONVERSION
+	shortest = _shortest_decimal(val.u, formatter, digits, &str, &len, &b);
+#endif
+
+	if (!shortest) str = _exact_decimal(m, e, &len, &b);
 
 	/* Significant digits */
 	size_t actual = len;
@@ -2732,13 +3994,16 @@ KrkValue krk_double_to_string(double a, unsigned int digits, char formatter, int
 	if (!alwaysexp && !noexp) {
 		/* g/G formatter - rounding is for total digits displayed */
 		if (digits == 0) digits = 1; /* treat precision of 0 as 1 */
-		if (actual > digits) {
+		if (shortest && formatter == ' ') {
+			/* The shortest digits that round-trip are never rounded further. */
+		} else if (actual > digits) {
 			/* There are more digits than we need to show, so round */
 			int overflowed = round_to(str, len, actual, digits);
 			if (overflowed) {
 				/* If we overflowed, our exponent increases */
 				ten_exponent += 1;
-				if (ten_exponent) whole_digits++;
+				whole_digits = ten_exponent >= 0 ? ten_exponent + 1 : 0;
+				missing_digits = ten_exponent < 0 ? -ten_exponent - 1 : 0;
 			}
 			/* We are going to use exactly the number of digits we have */
 			actual = digits;
@@ -2900,6 +4165,48 @@ KrkValue krk_parse_float(const char * s, size_t l) {
 		}
 	}
 
+#ifdef FAST_FLOAT_CONVERSION
+	/* The first 19 significant digits fit in a native integer. If there are no
+	 * more, or if rounding up the last of them would not change the result, we
+	 * can usually find the nearest double directly. */
+	{
+		uint64_t w = 0;
+		int count = 0;
+		int truncated = 0;
+		int64_t q = -(int64_t)e_ex;
+		for (size_t i = ps; i < pe; ++i) {
+			if (s[i] == '_') continue;
+			if (count < 19) {
+				w = w * 10 + (s[i] - '0');
+				if (w) count++;
+			} else {
+				q++;
+				truncated |= s[i] != '0';
+			}
+		}
+		for (size_t i = ss; i < se; ++i) {
+			if (count < 19) {
+				w = w * 10 + (s[i] - '0');
+				if (w) count++;
+				q--;
+			} else {
+				truncated |= s[i] != '0';
+			}
+		}
+
+		int64_t exp = 0;
+		for (size_t i = (es != ee && s[es] == '-') ? es + 1 : es; i < ee; ++i) {
+			if (exp < 100000) exp = exp * 10 + (s[i] - '0');
+		}
+		q += (es != ee && s[es] == '-') ? -exp : exp;
+
+		double d, up;
+		if (_eisel_lemire(w, q, &d) && (!truncated || (_eisel_lemire(w + 1, q, &up) && d == up))) {
+			return FLOATING_VAL(sign < 0 ? -d : d);
+		}
+	}
+#endif
+
 	/* Pack up all the digits from whole and fractional parts into a string so we can parse
 	 * it with our faster decimal string parsing tools. */
 	struct StringBuilder sb = {0};
@@ -2925,7 +4232,7 @@ KrkValue krk_parse_float(const char * s, size_t l) {
 	/* Now parse it. We call this resulting value "m" because it's the numerator of the
 	 * mantissa fraction of a decimal float, if that makes any sense. */
 	KrkLong m_l;
-	krk_long_parse_string(m,&m_l,10,m_len);
+	krk_long_parse_string(m,&m_l,10,m_len,0);
 	krk_discardStringBuilder(&sb);
 
 	/* We didn't include the leading - in our string to parse, so we still want to apply
@@ -2938,7 +4245,7 @@ KrkValue krk_parse_float(const char * s, size_t l) {
 
 	/* And parse that into a big int */
 	KrkLong e_l;
-	krk_long_parse_string(e,&e_l,10,e_len);
+	krk_long_parse_string(e,&e_l,10,e_len,0);
 
 	/* We don't actually want to deal with big ints in the exponent, so assume
 	 * they are going to overflow without even bothering to check to the part
@@ -3106,14 +4413,9 @@ int krk_long_to_int(KrkValue val, char size, void * out) {
 		size_t swidth = this->width < 0 ? -this->width : this->width;
 
 		if (swidth > 0) {
-			/* Collect up to three digits worth of bits, to the maximum
-			 * we support of 64. 31, 31, and 2. */
-			accum |= (uint64_t)this->digits[0];
-			if (swidth > 1) {
-				accum |= (uint64_t)this->digits[1] << DIGIT_SHIFT;
-				if (swidth > 2) {
-					accum |= (uint64_t)(this->digits[2] & 0x3) << DIGIT_SHIFT * 2;
-				}
+			/* Collect the low 64 bits; that's three 31-bit digits or two 62-bit digits */
+			for (size_t i = 0, shift = 0; i < swidth && shift < 64; ++i, shift += DIGIT_SHIFT) {
+				accum |= (uint64_t)this->digits[i] << shift;
 			}
 			/* If this is a negative value, convert the result to twos-complement. */
 			if (this->width < 0) {
@@ -3154,23 +4456,18 @@ int krk_long_to_int(KrkValue val, char size, void * out) {
 /**
  * @c int wrapper implementations of the byte conversions.
  *
- * Convert to a @c long and just use those versions...
+ * The bit counts work on the machine word; the rest convert to a @c long
+ * and just use those versions...
  */
 
 KRK_Method(int,bit_count) {
-	krk_long value;
-	krk_long_init_si(value, self);
-	KrkValue out = long_bit_count(value);
-	krk_long_clear(value);
-	return out;
+	uint64_t value = self < 0 ? -(uint64_t)self : (uint64_t)self;
+	return INTEGER_VAL(__builtin_popcountll(value));
 }
 
 KRK_Method(int,bit_length) {
-	krk_long value;
-	krk_long_init_si(value, self);
-	KrkValue out = long_bit_length(value);
-	krk_long_clear(value);
-	return out;
+	uint64_t value = self < 0 ? -(uint64_t)self : (uint64_t)self;
+	return INTEGER_VAL(value ? 64 - __builtin_clzll(value) : 0);
 }
 
 KRK_Method(int,to_bytes) {
@@ -3181,11 +4478,71 @@ KRK_Method(int,to_bytes) {
 	return out;
 }
 
+/**
+ * @brief Build an integer from the bytes of a bytes-like object.
+ *
+ * Bytes are gathered straight into digits from the least significant end.
+ * Negative values are read inverted and then adjusted, as in @c to_bytes.
+ */
+KRK_StaticMethod(int,from_bytes) {
+	KrkValue data;
+	const char * byteorder = "big";
+	int _signed = 0;
+	if (!krk_parseArgs(".V|s$p", (const char*[]){"bytes","byteorder","signed"}, &data, &byteorder, &_signed)) return NONE_VAL();
+
+	int little;
+	if (!strcmp(byteorder,"little")) {
+		little = 1;
+	} else if (!strcmp(byteorder,"big")) {
+		little = 0;
+	} else {
+		return krk_runtimeError(vm.exceptions->valueError, "byteorder must be either 'little' or 'big'");
+	}
+
+	KrkBuffer buffer;
+	if (!krk_getBuffer(data, &buffer, 0)) return NONE_VAL();
+	const uint8_t * bytes = buffer.buf;
+	size_t length = buffer.len;
+	int negative = _signed && length && (bytes[little ? length - 1 : 0] & 0x80);
+
+	KrkLong out;
+	krk_long_init_si(&out, 0);
+	krk_long_resize(&out, (length * 8 + DIGIT_SHIFT - 1) / DIGIT_SHIFT);
+
+	twodigit_t accum = 0;
+	unsigned int have = 0;
+	size_t j = 0;
+	for (size_t i = 0; i < length; ++i) {
+		uint8_t byte = bytes[little ? i : length - i - 1];
+		accum |= (twodigit_t)(negative ? byte ^ 0xFF : byte) << have;
+		have += 8;
+		if (have >= DIGIT_SHIFT) {
+			out.digits[j++] = accum & DIGIT_MAX;
+			accum >>= DIGIT_SHIFT;
+			have -= DIGIT_SHIFT;
+		}
+	}
+	if (have) out.digits[j] = accum;
+	krk_long_trim(&out);
+
+	if (negative) {
+		KrkLong one;
+		krk_long_init_si(&one, 1);
+		krk_long_add(&out, &out, &one);
+		krk_long_set_sign(&out, -1);
+		krk_long_clear(&one);
+	}
+
+	return make_long_obj(&out);
+}
+
 #undef BIND_METHOD
 #undef BIND_STATICMETHOD
+#undef BIND_CLASSMETHOD
 /* These class names conflict with C types, so we need to cheat a bit */
 #define BIND_METHOD(klass,method) do { krk_defineNative(& _ ## klass->methods, #method, _ ## klass ## _ ## method); } while (0)
 #define BIND_STATICMETHOD(klass,method) do { krk_defineNativeStaticMethod(& _ ## klass->methods, #method, _ ## klass ## _ ## method); } while (0)
+#define BIND_CLASSMETHOD(klass,method) do { krk_defineNativeClassMethod(& _ ## klass->methods, #method, _ ## klass ## _ ## method); } while (0)
 #define BIND_TRIPLET(klass,name) \
 	BIND_METHOD(klass,__ ## name ## __); \
 	BIND_METHOD(klass,__r ## name ## __); \
@@ -3250,6 +4607,7 @@ void _createAndBind_longClass(void) {
 	BIND_METHOD(int,bit_count);
 	BIND_METHOD(int,bit_length);
 	BIND_METHOD(int,to_bytes);
+	BIND_CLASSMETHOD(int,from_bytes);
 
 }
 
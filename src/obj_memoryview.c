@@ -0,0 +1,500 @@
+#include <string.h>
+#include <kuroko/vm.h>
+#include <kuroko/value.h>
+#include <kuroko/memory.h>
+#include <kuroko/util.h>
+
+#include "private.h"
+
+/**
+ * A view of the memory of an object that supports the buffer protocol.
+ *
+ * The view holds a reference to the exporting object and asks it for its
+ * memory again on every access, so it never holds on to a stale pointer.
+ * Slicing a view produces another view of the same object with a different
+ * offset and stride; nothing is copied until @c tobytes or @c tolist.
+ */
+struct MemoryView {
+	KrkInstance inst;
+	KrkValue obj;     /* Exporting object, or None once released */
+	size_t offset;    /* Byte offset of the first item in the exported memory */
+	size_t count;     /* Number of items */
+	ssize_t stride;   /* Distance between items in bytes; negative for reversed views */
+	size_t itemsize;
+	char format;
+	int readonly;
+};
+
+#define IS_memoryview(o) (krk_isInstanceOf(o,KRK_BASE_CLASS(memoryview)))
+#define AS_memoryview(o) ((struct MemoryView*)AS_OBJECT(o))
+#define CURRENT_CTYPE struct MemoryView *
+#define CURRENT_NAME  self
+
+static void _memoryview_gcscan(KrkInstance * self) {
+	krk_markValue(((struct MemoryView*)self)->obj);
+}
+
+static size_t _formatSize(char format) {
+	switch (format) {
+		case 'b': case 'B': case 'c': case '?': return 1;
+		case 'h': case 'H': return 2;
+		case 'i': case 'I': case 'f': return 4;
+		case 'l': case 'L': return sizeof(long);
+		case 'q': case 'Q': case 'd': return 8;
+		case 'n': case 'N': return sizeof(size_t);
+		default: return 0;
+	}
+}
+
+#define UNPACK(type,make) { type x; memcpy(&x, p, sizeof(type)); return make(x); }
+static KrkValue _unpackItem(char format, const uint8_t * p) {
+	switch (format) {
+		case 'b': UNPACK(int8_t,INTEGER_VAL)
+		case 'B': UNPACK(uint8_t,INTEGER_VAL)
+		case 'c': return OBJECT_VAL(krk_newBytes(1,(uint8_t*)p));
+		case '?': return BOOLEAN_VAL(*p != 0);
+		case 'h': UNPACK(int16_t,INTEGER_VAL)
+		case 'H': UNPACK(uint16_t,INTEGER_VAL)
+		case 'i': UNPACK(int32_t,INTEGER_VAL)
+		case 'I': UNPACK(uint32_t,INTEGER_VAL)
+		case 'l': UNPACK(long,krk_int_from_ll)
+		case 'L': UNPACK(unsigned long,krk_int_from_ull)
+		case 'q': UNPACK(int64_t,krk_int_from_ll)
+		case 'Q': UNPACK(uint64_t,krk_int_from_ull)
+		case 'n': UNPACK(ssize_t,krk_int_from_ll)
+		case 'N': UNPACK(size_t,krk_int_from_ull)
+#ifndef KRK_NO_FLOAT
+		case 'f': UNPACK(float,FLOATING_VAL)
+		case 'd': UNPACK(double,FLOATING_VAL)
+#endif
+		default:
+			return krk_runtimeError(vm.exceptions->notImplementedError, "memoryview: format '%c' not supported", format);
+	}
+}
+#undef UNPACK
+
+#define PACK_RANGE(type,min,max) { \
+	if (!IS_INTEGER(value)) goto _type_error; \
+	if (AS_INTEGER(value) < (min) || AS_INTEGER(value) > (max)) goto _range_error; \
+	type x = AS_INTEGER(value); memcpy(p, &x, sizeof(type)); return 1; }
+#define PACK_WIDE(type) { \
+	if (!IS_INTEGER(value) && !krk_isInstanceOf(value, KRK_BASE_CLASS(long))) goto _type_error; \
+	type x; if (!krk_long_to_int(value, sizeof(type), &x)) return 0; memcpy(p, &x, sizeof(type)); return 1; }
+#define PACK_FLOAT(type) { \
+	if (!IS_FLOATING(value) && !IS_INTEGER(value)) goto _type_error; \
+	type x = IS_FLOATING(value) ? AS_FLOATING(value) : AS_INTEGER(value); memcpy(p, &x, sizeof(type)); return 1; }
+static int _packItem(char format, uint8_t * p, KrkValue value) {
+	switch (format) {
+		case 'b': PACK_RANGE(int8_t,INT8_MIN,INT8_MAX)
+		case 'B': PACK_RANGE(uint8_t,0,UINT8_MAX)
+		case 'c':
+			if (!IS_BYTES(value) || AS_BYTES(value)->length != 1) goto _type_error;
+			*p = AS_BYTES(value)->bytes[0];
+			return 1;
+		case '?': *p = !krk_isFalsey(value); return 1;
+		case 'h': PACK_RANGE(int16_t,INT16_MIN,INT16_MAX)
+		case 'H': PACK_RANGE(uint16_t,0,UINT16_MAX)
+		case 'i': PACK_RANGE(int32_t,INT32_MIN,INT32_MAX)
+		case 'I': PACK_RANGE(uint32_t,0,UINT32_MAX)
+		case 'l': PACK_WIDE(long)
+		case 'L': PACK_WIDE(unsigned long)
+		case 'q': PACK_WIDE(int64_t)
+		case 'Q': PACK_WIDE(uint64_t)
+		case 'n': PACK_WIDE(ssize_t)
+		case 'N': PACK_WIDE(size_t)
+#ifndef KRK_NO_FLOAT
+		case 'f': PACK_FLOAT(float)
+		case 'd': PACK_FLOAT(double)
+#endif
+		default:
+			krk_runtimeError(vm.exceptions->notImplementedError, "memoryview: format '%c' not supported", format);
+			return 0;
+	}
+_type_error:
+	krk_runtimeError(vm.exceptions->typeError, "memoryview: invalid type for format '%c'", format);
+	return 0;
+_range_error:
+	krk_runtimeError(vm.exceptions->valueError, "memoryview: value out of range for format '%c'", format);
+	return 0;
+}
+#undef PACK_RANGE
+#undef PACK_WIDE
+#undef PACK_FLOAT
+
+/**
+ * Get the address of the first item of a view, checking that the exporting
+ * object still covers every item the view refers to.
+ */
+static uint8_t * _viewStart(struct MemoryView * self, int writable) {
+	if (IS_NONE(self->obj)) {
+		krk_runtimeError(vm.exceptions->valueError, "operation forbidden on released memoryview object");
+		return NULL;
+	}
+	KrkBuffer buffer;
+	if (!krk_getBuffer(self->obj, &buffer, writable)) return NULL;
+	if (self->count) {
+		size_t first = self->offset;
+		size_t last  = self->offset + (ssize_t)(self->count - 1) * self->stride;
+		if ((first > last ? first : last) + self->itemsize > buffer.len) {
+			krk_runtimeError(vm.exceptions->indexError, "memoryview: underlying buffer has shrunk");
+			return NULL;
+		}
+	}
+	return (uint8_t*)buffer.buf + self->offset;
+}
+
+static int _memoryview_getbuffer(KrkValue value, KrkBuffer * buffer) {
+	struct MemoryView * self = AS_memoryview(value);
+	if (self->stride != (ssize_t)self->itemsize && self->count > 1) {
+		krk_runtimeError(vm.exceptions->typeError, "memoryview: underlying buffer is not contiguous");
+		return 0;
+	}
+	uint8_t * start = _viewStart(self, 0);
+	if (!start) return 0;
+	/* Formats are exported as strings, so point at one of these. */
+	static const char formats[] = "b\0B\0c\0?\0h\0H\0i\0I\0l\0L\0q\0Q\0n\0N\0f\0d\0";
+	const char * format = formats;
+	while (*format && *format != self->format) format += 2;
+	buffer->buf = start;
+	buffer->len = self->count * self->itemsize;
+	buffer->itemsize = self->itemsize;
+	buffer->format = format;
+	buffer->readonly = self->readonly;
+	return 1;
+}
+
+static KrkValue _newView(struct MemoryView * from, size_t offset, size_t count, ssize_t stride) {
+	struct MemoryView * out = (struct MemoryView*)krk_newInstance(KRK_BASE_CLASS(memoryview));
+	out->obj = from->obj;
+	out->offset = offset;
+	out->count = count;
+	out->stride = stride;
+	out->itemsize = from->itemsize;
+	out->format = from->format;
+	out->readonly = from->readonly;
+	return OBJECT_VAL(out);
+}
+
+KRK_Method(memoryview,__init__) {
+	KrkValue obj;
+	if (!krk_parseArgs(".V", (const char*[]){"object"}, &obj)) return NONE_VAL();
+
+	if (IS_memoryview(obj)) {
+		struct MemoryView * other = AS_memoryview(obj);
+		if (!_viewStart(other, 0)) return NONE_VAL();
+		self->obj = other->obj;
+		self->offset = other->offset;
+		self->count = other->count;
+		self->stride = other->stride;
+		self->itemsize = other->itemsize;
+		self->format = other->format;
+		self->readonly = other->readonly;
+		return NONE_VAL();
+	}
+
+	KrkBuffer buffer;
+	if (!krk_getBuffer(obj, &buffer, 0)) return NONE_VAL();
+	if (!buffer.format || strlen(buffer.format) != 1 || _formatSize(buffer.format[0]) != buffer.itemsize) {
+		return krk_runtimeError(vm.exceptions->notImplementedError, "memoryview: unsupported format %s", buffer.format ? buffer.format : "(null)");
+	}
+	self->obj = obj;
+	self->offset = 0;
+	self->count = buffer.len / buffer.itemsize;
+	self->stride = buffer.itemsize;
+	self->itemsize = buffer.itemsize;
+	self->format = buffer.format[0];
+	self->readonly = buffer.readonly;
+	return NONE_VAL();
+}
+
+KRK_Method(memoryview,__len__) {
+	METHOD_TAKES_NONE();
+	if (!_viewStart(self, 0)) return NONE_VAL();
+	return INTEGER_VAL(self->count);
+}
+
+KRK_Method(memoryview,__getitem__) {
+	METHOD_TAKES_EXACTLY(1);
+	if (IS_INTEGER(argv[1])) {
+		uint8_t * start = _viewStart(self, 0);
+		if (!start) return NONE_VAL();
+		krk_integer_type index = AS_INTEGER(argv[1]);
+		if (index < 0) index += self->count;
+		if (index < 0 || index >= (krk_integer_type)self->count) {
+			return krk_runtimeError(vm.exceptions->indexError, "memoryview index out of range: " PRIkrk_int, AS_INTEGER(argv[1]));
+		}
+		return _unpackItem(self->format, start + index * self->stride);
+	} else if (IS_slice(argv[1])) {
+		if (!_viewStart(self, 0)) return NONE_VAL();
+		KRK_SLICER(argv[1], self->count) {
+			return NONE_VAL();
+		}
+		size_t count = (step > 0) ? (end - start + step - 1) / step : (start - end - step - 1) / -step;
+		return _newView(self, self->offset + start * self->stride, count, self->stride * step);
+	} else {
+		return TYPE_ERROR(int or slice, argv[1]);
+	}
+}
+
+KRK_Method(memoryview,__setitem__) {
+	METHOD_TAKES_EXACTLY(2);
+	if (self->readonly && !IS_NONE(self->obj)) return krk_runtimeError(vm.exceptions->typeError, "cannot modify read-only memory");
+	if (IS_INTEGER(argv[1])) {
+		uint8_t * start = _viewStart(self, 1);
+		if (!start) return NONE_VAL();
+		krk_integer_type index = AS_INTEGER(argv[1]);
+		if (index < 0) index += self->count;
+		if (index < 0 || index >= (krk_integer_type)self->count) {
+			return krk_runtimeError(vm.exceptions->indexError, "memoryview index out of range: " PRIkrk_int, AS_INTEGER(argv[1]));
+		}
+		/* Packing a '?' may run a __bool__ that resizes the exporter, so pack
+		 * into a temporary and then look up the buffer again. */
+		uint8_t elem[8];
+		if (!_packItem(self->format, elem, argv[2])) return NONE_VAL();
+		start = _viewStart(self, 1);
+		if (!start) return NONE_VAL();
+		memcpy(start + index * self->stride, elem, self->itemsize);
+		return argv[2];
+	} else if (IS_slice(argv[1])) {
+		if (!_viewStart(self, 1)) return NONE_VAL();
+		KRK_SLICER(argv[1], self->count) {
+			return NONE_VAL();
+		}
+		size_t count = (step > 0) ? (end - start + step - 1) / step : (start - end - step - 1) / -step;
+
+		KrkBuffer source;
+		if (!krk_getBuffer(argv[2], &source, 0)) return NONE_VAL();
+		if (source.itemsize != self->itemsize || source.len != count * self->itemsize) {
+			return krk_runtimeError(vm.exceptions->valueError, "memoryview assignment: lvalue and rvalue have different structures");
+		}
+
+		/* The source may be this same memory, so take a copy first if it is not a simple move. */
+		uint8_t * target = _viewStart(self, 1);
+		if (!target) return NONE_VAL();
+		target += start * self->stride;
+		ssize_t stride = self->stride * step;
+		if (stride == (ssize_t)self->itemsize) {
+			memmove(target, source.buf, source.len);
+		} else {
+			uint8_t * tmp = malloc(source.len);
+			memcpy(tmp, source.buf, source.len);
+			for (size_t i = 0; i < count; ++i) {
+				memcpy(target + (ssize_t)i * stride, tmp + i * self->itemsize, self->itemsize);
+			}
+			free(tmp);
+		}
+		return argv[2];
+	} else {
+		return TYPE_ERROR(int or slice, argv[1]);
+	}
+}
+
+KRK_Method(memoryview,tobytes) {
+	METHOD_TAKES_NONE();
+	uint8_t * start = _viewStart(self, 0);
+	if (!start) return NONE_VAL();
+	if (self->stride == (ssize_t)self->itemsize) {
+		return OBJECT_VAL(krk_newBytes(self->count * self->itemsize, start));
+	}
+	KrkBytes * out = krk_newBytes(self->count * self->itemsize, NULL);
+	for (size_t i = 0; i < self->count; ++i) {
+		memcpy(out->bytes + i * self->itemsize, start + (ssize_t)i * self->stride, self->itemsize);
+	}
+	return OBJECT_VAL(out);
+}
+
+KRK_Method(memoryview,tolist) {
+	METHOD_TAKES_NONE();
+	if (!_viewStart(self, 0)) return NONE_VAL();
+	KrkValue list = krk_list_of(0,NULL,0);
+	krk_push(list);
+	for (size_t i = 0; i < self->count; ++i) {
+		/* Unpacking may allocate, so find the start again each time. */
+		KrkValue item = _unpackItem(self->format, _viewStart(self, 0) + (ssize_t)i * self->stride);
+		if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+		krk_writeValueArray(AS_LIST(list), item);
+	}
+	return krk_pop();
+}
+
+FUNC_SIG(listiterator,__init__);
+
+KRK_Method(memoryview,__iter__) {
+	METHOD_TAKES_NONE();
+	KrkValue list = FUNC_NAME(memoryview,tolist)(1, argv, 0);
+	if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+	krk_push(list);
+	KrkInstance * output = krk_newInstance(vm.baseClasses->listiteratorClass);
+	krk_push(OBJECT_VAL(output));
+	FUNC_NAME(listiterator,__init__)(2, (KrkValue[]){krk_peek(0), list}, 0);
+	krk_pop();
+	krk_pop();
+	return OBJECT_VAL(output);
+}
+
+KRK_Method(memoryview,hex) {
+	METHOD_TAKES_NONE();
+	uint8_t * start = _viewStart(self, 0);
+	if (!start) return NONE_VAL();
+	static const char digits[] = "0123456789abcdef";
+	struct StringBuilder sb = {0};
+	for (size_t i = 0; i < self->count; ++i) {
+		const uint8_t * item = start + (ssize_t)i * self->stride;
+		for (size_t j = 0; j < self->itemsize; ++j) {
+			pushStringBuilder(&sb, digits[item[j] >> 4]);
+			pushStringBuilder(&sb, digits[item[j] & 0xF]);
+		}
+	}
+	return finishStringBuilder(&sb);
+}
+
+KRK_Method(memoryview,cast) {
+	const char * format;
+	if (!krk_parseArgs(".s", (const char*[]){"format"}, &format)) return NONE_VAL();
+	if (strlen(format) != 1 || !_formatSize(format[0])) {
+		return krk_runtimeError(vm.exceptions->valueError, "memoryview: unsupported format %s", format);
+	}
+	if (!_viewStart(self, 0)) return NONE_VAL();
+	if (self->stride != (ssize_t)self->itemsize) {
+		return krk_runtimeError(vm.exceptions->typeError, "memoryview: casts are restricted to C-contiguous views");
+	}
+	size_t itemsize = _formatSize(format[0]);
+	size_t nbytes = self->count * self->itemsize;
+	if (nbytes % itemsize) {
+		return krk_runtimeError(vm.exceptions->typeError, "memoryview: length is not a multiple of itemsize");
+	}
+	KrkValue out = _newView(self, self->offset, nbytes / itemsize, itemsize);
+	AS_memoryview(out)->itemsize = itemsize;
+	AS_memoryview(out)->format = format[0];
+	return out;
+}
+
+KRK_Method(memoryview,release) {
+	METHOD_TAKES_NONE();
+	self->obj = NONE_VAL();
+	return NONE_VAL();
+}
+
+KRK_Method(memoryview,__enter__) {
+	METHOD_TAKES_NONE();
+	return argv[0];
+}
+
+KRK_Method(memoryview,__exit__) {
+	self->obj = NONE_VAL();
+	return NONE_VAL();
+}
+
+KRK_Method(memoryview,__eq__) {
+	METHOD_TAKES_EXACTLY(1);
+	if (krk_valuesSame(argv[0], argv[1])) return BOOLEAN_VAL(1);
+	if (!IS_BYTES(argv[1]) && !krk_getType(argv[1])->_getbuffer) return NOTIMPL_VAL();
+	if (IS_NONE(self->obj)) return BOOLEAN_VAL(0);
+
+	KrkValue other = argv[1];
+	if (!IS_memoryview(other)) {
+		krk_push(OBJECT_VAL(krk_newInstance(KRK_BASE_CLASS(memoryview))));
+		FUNC_NAME(memoryview,__init__)(2, (KrkValue[]){krk_peek(0), argv[1]}, 0);
+		if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+		other = krk_pop();
+	}
+	struct MemoryView * them = AS_memoryview(other);
+	if (IS_NONE(them->obj) || them->count != self->count) return BOOLEAN_VAL(0);
+
+	krk_push(other);
+	int result = 1;
+	if (them->format == self->format) {
+		uint8_t * a = _viewStart(self, 0);
+		uint8_t * b = _viewStart(them, 0);
+		if (!a || !b) return NONE_VAL();
+		for (size_t i = 0; result && i < self->count; ++i) {
+			result = !memcmp(a + (ssize_t)i * self->stride, b + (ssize_t)i * them->stride, self->itemsize);
+		}
+	} else {
+		for (size_t i = 0; result && i < self->count; ++i) {
+			KrkValue x = _unpackItem(self->format, _viewStart(self, 0) + (ssize_t)i * self->stride);
+			krk_push(x);
+			KrkValue y = _unpackItem(them->format, _viewStart(them, 0) + (ssize_t)i * them->stride);
+			krk_push(y);
+			if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) return NONE_VAL();
+			result = krk_valuesSameOrEqual(x, y);
+			krk_pop();
+			krk_pop();
+		}
+	}
+	krk_pop();
+	return BOOLEAN_VAL(result);
+}
+
+KRK_Method(memoryview,__repr__) {
+	METHOD_TAKES_NONE();
+	if (IS_NONE(self->obj)) return krk_stringFromFormat("<released memory at %p>", (void*)self);
+	return krk_stringFromFormat("<memory at %p>", (void*)self);
+}
+
+KRK_Method(memoryview,obj) {
+	ATTRIBUTE_NOT_ASSIGNABLE();
+	return self->obj;
+}
+
+KRK_Method(memoryview,nbytes) {
+	ATTRIBUTE_NOT_ASSIGNABLE();
+	return INTEGER_VAL(self->count * self->itemsize);
+}
+
+KRK_Method(memoryview,readonly) {
+	ATTRIBUTE_NOT_ASSIGNABLE();
+	return BOOLEAN_VAL(self->readonly);
+}
+
+KRK_Method(memoryview,itemsize) {
+	ATTRIBUTE_NOT_ASSIGNABLE();
+	return INTEGER_VAL(self->itemsize);
+}
+
+KRK_Method(memoryview,format) {
+	ATTRIBUTE_NOT_ASSIGNABLE();
+	return OBJECT_VAL(krk_copyString(&self->format, 1));
+}
+
+KRK_Method(memoryview,contiguous) {
+	ATTRIBUTE_NOT_ASSIGNABLE();
+	return BOOLEAN_VAL(self->count <= 1 || self->stride == (ssize_t)self->itemsize);
+}
+
+_noexport
+void _createAndBind_memoryviewClass(void) {
+	KrkClass * memoryview = ADD_BASE_CLASS(KRK_BASE_CLASS(memoryview), "memoryview", KRK_BASE_CLASS(object));
+	memoryview->allocSize = sizeof(struct MemoryView);
+	memoryview->_ongcscan = _memoryview_gcscan;
+	memoryview->_getbuffer = _memoryview_getbuffer;
+	memoryview->obj.flags |= KRK_OBJ_FLAGS_NO_INHERIT;
+	KRK_DOC(BIND_METHOD(memoryview,__init__),
+		"@brief Create a view of the memory of a bytes-like object.\n"
+		"@arguments object\n\n"
+		"Indexing a view reads and writes the memory of @p object directly, and slicing a view "
+		"produces another view of the same memory without copying it.");
+	BIND_METHOD(memoryview,__len__);
+	BIND_METHOD(memoryview,__getitem__);
+	BIND_METHOD(memoryview,__setitem__);
+	BIND_METHOD(memoryview,__eq__);
+	BIND_METHOD(memoryview,__iter__);
+	BIND_METHOD(memoryview,__repr__);
+	BIND_METHOD(memoryview,__enter__);
+	BIND_METHOD(memoryview,__exit__);
+	KRK_DOC(BIND_METHOD(memoryview,tobytes), "@brief Copy the memory of the view into a new @ref bytes object.");
+	KRK_DOC(BIND_METHOD(memoryview,tolist), "@brief Return the items of the view as a @ref list.");
+	KRK_DOC(BIND_METHOD(memoryview,hex), "@brief Return the memory of the view as a string of hexadecimal digits.");
+	KRK_DOC(BIND_METHOD(memoryview,cast),
+		"@brief Create a view of the same memory with a different item format.\n"
+		"@arguments format");
+	KRK_DOC(BIND_METHOD(memoryview,release), "@brief Release the underlying object; the view can not be used afterwards.");
+	BIND_PROP(memoryview,obj);
+	BIND_PROP(memoryview,nbytes);
+	BIND_PROP(memoryview,readonly);
+	BIND_PROP(memoryview,itemsize);
+	BIND_PROP(memoryview,format);
+	BIND_PROP(memoryview,contiguous);
+	krk_attachNamedValue(&memoryview->methods, "__hash__", NONE_VAL());
+	krk_finalizeClass(memoryview);
+}
@@ -57,7 +57,7 @@ _just_x:
 
 	if (IS_STRING(x)) {
 		KrkValue result = krk_parse_int(AS_CSTRING(x), AS_STRING(x)->length, base);
-		if (IS_NONE(result)) {
+		if (IS_NONE(result) && !(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) {
 			return krk_runtimeError(vm.exceptions->valueError,
 				"invalid literal for int() with base %zd: %R", (ssize_t)base, x);
 		}
@@ -69,9 +69,8 @@ _just_x:
 }
 
 KRK_Method(int,__repr__) {
-	char tmp[100];
-	size_t l = snprintf(tmp, 100, PRIkrk_int, self);
-	return OBJECT_VAL(krk_copyString(tmp, l));
+	char tmp[24];
+	return OBJECT_VAL(krk_copyString(tmp, krk_writeInteger(tmp, self)));
 }
 
 KRK_Method(int,__int__) { return argv[0]; }
@@ -96,7 +95,9 @@ KRK_Method(int,__eq__) {
 }
 
 KRK_Method(int,__hash__) {
-	return INTEGER_VAL((uint32_t)AS_INTEGER(argv[0]));
+	uint32_t hashed;
+	krk_hashValue(argv[0], &hashed);
+	return INTEGER_VAL(hashed);
 }
 
 static inline int matches(char c, const char * options) {
@@ -627,7 +628,6 @@ KRK_StaticMethod(float,__new__) {
 KRK_Method(float,__int__) { return krk_int_from_float(self); }
 KRK_Method(float,__float__) { return argv[0]; }
 
-extern KrkValue krk_double_to_string(double,unsigned int,char,int,int);
 KRK_Method(float,__repr__) {
 	return krk_double_to_string(self,16,' ',0,0);
 }
@@ -722,7 +722,9 @@ KRK_Method(float,__eq__) {
 }
 
 KRK_Method(float,__hash__) {
-	return INTEGER_VAL((uint32_t)self);
+	uint32_t hashed;
+	krk_hashValue(argv[0], &hashed);
+	return INTEGER_VAL(hashed);
 }
 
 KRK_Method(float,__neg__) {
@@ -854,7 +856,9 @@ KRK_Method(NoneType,__repr__) {
 }
 
 KRK_Method(NoneType,__hash__) {
-	return INTEGER_VAL((uint32_t)AS_INTEGER(argv[0]));
+	uint32_t hashed;
+	krk_hashValue(argv[0], &hashed);
+	return INTEGER_VAL(hashed);
 }
 
 KRK_Method(NoneType,__eq__) {
@@ -319,6 +319,12 @@ KRK_Method(set,clear) {
 	return NONE_VAL();
 }
 
+KRK_Method(set,compact) {
+	METHOD_TAKES_NONE();
+	krk_tableCompact(&self->entries);
+	return NONE_VAL();
+}
+
 KRK_Method(set,update) {
 	METHOD_TAKES_AT_MOST(1);
 	if (argc > 1) {
@@ -415,6 +421,9 @@ void _createAndBind_setClass(void) {
 	KRK_DOC(BIND_METHOD(set,clear),
 		"@brief Empty the set.\n\n"
 		"Removes all elements from the set, in-place.");
+	KRK_DOC(BIND_METHOD(set,compact),
+		"@brief Release space left behind by removed elements.\n\n"
+		"Rebuilds the set without gaps, shrinking it if it has far fewer elements than its capacity.");
 	BIND_METHOD(set,update);
 	krk_attachNamedValue(&set->methods, "__hash__", NONE_VAL());
 	krk_finalizeClass(set);
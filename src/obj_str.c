@@ -1,4 +1,7 @@
 #include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <kuroko/vm.h>
 #include <kuroko/value.h>
 #include <kuroko/memory.h>
@@ -11,13 +14,6 @@ static KrkValue FUNC_NAME(striterator,__init__)(int,const KrkValue[],int);
 #define CURRENT_CTYPE KrkString *
 #define CURRENT_NAME  self
 
-#define AT_END() (self->length == 0 || i == self->length - 1)
-
-#define KRK_STRING_FAST(string,offset)  (uint32_t)\
-	((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) <= (KRK_OBJ_FLAGS_STRING_UCS1) ? ((uint8_t*)string->codes)[offset] : \
-	((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == (KRK_OBJ_FLAGS_STRING_UCS2) ? ((uint16_t*)string->codes)[offset] : \
-	((uint32_t*)string->codes)[offset]))
-
 #define CODEPOINT_BYTES(cp) (cp < 0x80 ? 1 : (cp < 0x800 ? 2 : (cp < 0x10000 ? 3 : 4)))
 
 KRK_Method(str,__ord__) {
@@ -68,11 +64,7 @@ KRK_Method(str,__add__) {
 
 	KrkStringType type = self_type > them_type ? self_type : them_type;
 
-	/* Hashes can be extended, which saves us calculating the whole thing */
-	uint32_t hash = self->obj.hash;
-	for (size_t i = 0; i < bl; ++i) {
-		krk_hash_advance(hash,b[i]);
-	}
+	uint32_t hash = krk_hashBytes(chars, length);
 
 	KrkString * result = krk_takeStringVetted(chars, length, cpLength, type, hash);
 	if (needsPop) krk_pop();
@@ -119,7 +111,7 @@ KRK_Method(str,__getitem__) {
 		if ((self->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == KRK_OBJ_FLAGS_STRING_ASCII) {
 			return OBJECT_VAL(krk_copyString(self->chars + asInt, 1));
 		} else {
-			krk_unicodeString(self);
+			krk_unicodeIndex(self);
 			unsigned char asbytes[5];
 			size_t length = krk_codepointToBytes(KRK_STRING_FAST(self,asInt),(unsigned char*)&asbytes);
 			return OBJECT_VAL(krk_copyString((char*)&asbytes, length));
@@ -132,25 +124,15 @@ KRK_Method(str,__getitem__) {
 		if (step == 1) {
 			long len = end - start;
 			if ((self->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == KRK_OBJ_FLAGS_STRING_ASCII) {
-				return OBJECT_VAL(krk_copyString(self->chars + start, len));
+				return OBJECT_VAL(krk_stringSlice(self, start, len));
 			} else {
-				size_t offset = 0;
-				size_t length = 0;
-				/* Figure out where the UTF8 for this string starts. */
-				krk_unicodeString(self);
-				for (long i = 0; i < start; ++i) {
-					uint32_t cp = KRK_STRING_FAST(self,i);
-					offset += CODEPOINT_BYTES(cp);
-				}
-				for (long i = start; i < end; ++i) {
-					uint32_t cp = KRK_STRING_FAST(self,i);
-					length += CODEPOINT_BYTES(cp);
-				}
-				return OBJECT_VAL(krk_copyString(self->chars + offset, length));
+				/* Figure out where the UTF8 for this string starts and ends. */
+				size_t offset = krk_unicodeOffset(self, start);
+				return OBJECT_VAL(krk_stringSlice(self, offset, krk_unicodeOffset(self, end) - offset));
 			}
 		} else {
 			struct StringBuilder sb = {0};
-			krk_unicodeString(self);
+			krk_unicodeIndex(self);
 
 			unsigned char asbytes[5];
 			krk_integer_type i = start;
@@ -190,8 +172,6 @@ KRK_Method(str,__format__) {
 	}
 
 	/* Note we're going to deal in codepoints exclusive here, so hold on to your hat. */
-	krk_unicodeString(self);
-
 	size_t actualLength = self->codesLength;
 
 	/* Restrict to the precision specified */
@@ -226,13 +206,7 @@ KRK_Method(str,__format__) {
 	}
 
 	/* Push codes from us */
-	size_t offset = 0;
-	for (size_t i = 0; i < actualLength; ++i) {
-		uint32_t cp = KRK_STRING_FAST(self,i);
-		size_t   bytes =  CODEPOINT_BYTES(cp);
-		pushStringBuilderStr(&sb, &self->chars[offset], bytes);
-		offset += bytes;
-	}
+	pushStringBuilderStr(&sb, self->chars, krk_unicodeOffset(self, actualLength));
 
 	/* Push right padding */
 	for (size_t i = 0; i < padRight; ++i) {
@@ -242,119 +216,84 @@ KRK_Method(str,__format__) {
 	return finishStringBuilder(&sb);
 }
 
-/* str.format(**kwargs) */
-KRK_Method(str,format) {
-	KrkValue kwargs = NONE_VAL();
-	if (hasKw) {
-		kwargs = argv[argc];
-	}
+/**
+ * Parse a format string for str.format into a tuple of the form
+ * (self, literal, field, literal, field, ..., literal), where each field
+ * is either a positional index or a keyword name. Parsed templates are
+ * kept in a small per-thread cache keyed by the format string.
+ */
+static KrkTuple * _formatTemplate(KrkString * self) {
+	KrkValue * slot = &krk_currentThread.formatCache[self->obj.hash & (KRK_THREAD_FORMAT_CACHE_SIZE - 1)];
+	if (IS_TUPLE(*slot) && krk_valuesSame(AS_TUPLE(*slot)->values.values[0], OBJECT_VAL(self))) return AS_TUPLE(*slot);
 
-	/* Read through `self` until we find a field specifier. */
-	struct StringBuilder sb = {0};
+	size_t stackBefore = krk_currentThread.stackTop - krk_currentThread.stack;
+	krk_push(OBJECT_VAL(self));
 
+	struct StringBuilder sb = {0};
 	int counterOffset = 0;
-	char * erroneousField = NULL;
-	int erroneousIndex = -1;
 	const char * errorStr = "";
 
-	char * workSpace = strdup(self->chars);
-	char * c = workSpace;
-	for (size_t i = 0; i < self->length; i++, c++) {
+	const char * c = self->chars;
+	const char * end = self->chars + self->length;
+	while (c < end) {
 		if (*c == '{') {
-			if (!AT_END() && c[1] == '{') {
+			if (c + 1 < end && c[1] == '{') {
 				pushStringBuilder(&sb, '{');
-				i++; c++; /* Skip both */
+				c += 2;
 				continue;
-			} else {
-				/* Start field specifier */
-				i++; c++; /* Skip the { */
-				char * fieldStart = c;
-				char * fieldStop = NULL;
-				for (; i < self->length; i++, c++) {
-					if (*c == '}') {
-						fieldStop = c;
-						break;
-					}
-				}
-				if (!fieldStop) {
-					errorStr = "Unclosed { found.";
-					goto _formatError;
-				}
-				size_t fieldLength = fieldStop - fieldStart;
-				*fieldStop = '\0';
-				/* fieldStart is now a nice little C string... */
-				int isDigits = 1;
-				for (char * field = fieldStart; *field; ++field) {
-					if (!(*field >= '0' && *field <= '9')) {
-						isDigits = 0;
-						break;
-					}
-				}
-				KrkValue value;
-				if (isDigits) {
-					/* Must be positional */
-					int positionalOffset;
-					if (fieldLength == 0) {
-						positionalOffset = counterOffset++;
-					} else if (counterOffset) {
-						goto _formatSwitchedNumbering;
-					} else {
-						positionalOffset = strtoul(fieldStart,NULL,10);
-					}
-					if (positionalOffset >= argc - 1) {
-						erroneousIndex = positionalOffset;
-						goto _formatOutOfRange;
-					}
-					value = argv[1 + positionalOffset];
-				} else if (hasKw) {
-					KrkValue fieldAsString = OBJECT_VAL(krk_copyString(fieldStart, fieldLength));
-					krk_push(fieldAsString);
-					if (!krk_tableGet(AS_DICT(kwargs), fieldAsString, &value)) {
-						erroneousField = fieldStart;
-						goto _formatKeyError;
-					}
-					krk_pop(); /* fieldAsString */
-				} else {
-					erroneousField = fieldStart;
-					goto _formatKeyError;
+			}
+			/* Start field specifier */
+			const char * fieldStart = ++c;
+			while (c < end && *c != '}') c++;
+			if (c == end) {
+				errorStr = "Unclosed { found.";
+				goto _formatError;
+			}
+			size_t fieldLength = c - fieldStart;
+			c++;
+			krk_push(finishStringBuilder(&sb));
+			int isDigits = 1;
+			for (size_t i = 0; i < fieldLength; ++i) {
+				if (!(fieldStart[i] >= '0' && fieldStart[i] <= '9')) {
+					isDigits = 0;
+					break;
 				}
-				KrkValue asString;
-				if (IS_STRING(value)) {
-					asString = value;
+			}
+			if (isDigits) {
+				/* Must be positional */
+				if (fieldLength == 0) {
+					krk_push(INTEGER_VAL(counterOffset++));
+				} else if (counterOffset) {
+					goto _formatSwitchedNumbering;
 				} else {
-					krk_push(value);
-					KrkClass * type = krk_getType(value);
-					if (type->_tostr) {
-						asString = krk_callDirect(type->_tostr, 1);
-					} else {
-						if (!krk_bindMethod(type, AS_STRING(vm.specialMethodNames[METHOD_STR]))) {
-							errorStr = "Failed to convert field to string.";
-							goto _formatError;
-						}
-						asString = krk_callStack(0);
-					}
-					if (!IS_STRING(asString)) goto _freeAndDone;
+					krk_push(INTEGER_VAL(strtoul(fieldStart,NULL,10)));
 				}
-				krk_push(asString);
-				pushStringBuilderStr(&sb, AS_CSTRING(asString), AS_STRING(asString)->length);
-				krk_pop();
+			} else {
+				krk_push(OBJECT_VAL(krk_copyString(fieldStart, fieldLength)));
 			}
 		} else if (*c == '}') {
-			if (!AT_END() && c[1] == '}') {
+			if (c + 1 < end && c[1] == '}') {
 				pushStringBuilder(&sb, '}');
-				i++; c++; /* Skip both */
+				c += 2;
 				continue;
-			} else {
-				errorStr = "Single } found.";
-				goto _formatError;
 			}
+			errorStr = "Single } found.";
+			goto _formatError;
 		} else {
-			pushStringBuilder(&sb, *c);
+			const char * run = c;
+			while (c < end && *c != '{' && *c != '}') c++;
+			pushStringBuilderStr(&sb, run, c - run);
 		}
 	}
+	krk_push(finishStringBuilder(&sb));
 
-	free(workSpace);
-	return finishStringBuilder(&sb);
+	size_t count = krk_currentThread.stackTop - krk_currentThread.stack - stackBefore;
+	KrkTuple * template = krk_newTuple(count);
+	memcpy(template->values.values, krk_currentThread.stack + stackBefore, sizeof(KrkValue) * count);
+	template->values.count = count;
+	krk_currentThread.stackTop = krk_currentThread.stack + stackBefore;
+	*slot = OBJECT_VAL(template);
+	return template;
 
 _formatError:
 	krk_runtimeError(vm.exceptions->typeError, "Error parsing format string: %s", errorStr);
@@ -364,18 +303,73 @@ _formatSwitchedNumbering:
 	krk_runtimeError(vm.exceptions->valueError, "Can not switch from automatic indexing to manual indexing");
 	goto _freeAndDone;
 
-_formatOutOfRange:
-	krk_runtimeError(vm.exceptions->indexError, "Positional index out of range: %d", erroneousIndex);
-	goto _freeAndDone;
+_freeAndDone:
+	discardStringBuilder(&sb);
+	krk_currentThread.stackTop = krk_currentThread.stack + stackBefore;
+	return NULL;
+}
 
-_formatKeyError:
-	/* which one? */
-	krk_runtimeError(vm.exceptions->keyError, "'%s'", erroneousField);
-	goto _freeAndDone;
+/* str.format(**kwargs) */
+KRK_Method(str,format) {
+	KrkValue kwargs = NONE_VAL();
+	if (hasKw) {
+		kwargs = argv[argc];
+	}
+
+	KrkTuple * template = _formatTemplate(self);
+	if (!template) return NONE_VAL();
+	krk_push(OBJECT_VAL(template));
+
+	/* Collect the pieces on the stack, then write them out in one go. */
+	size_t stackBefore = krk_currentThread.stackTop - krk_currentThread.stack;
+
+	for (size_t i = 1; i < template->values.count; ++i) {
+		KrkValue piece = template->values.values[i];
+		if (i & 1) {
+			if (AS_STRING(piece)->length) krk_push(piece);
+			continue;
+		}
+
+		KrkValue value;
+		if (IS_INTEGER(piece)) {
+			if (AS_INTEGER(piece) >= argc - 1) {
+				krk_runtimeError(vm.exceptions->indexError, "Positional index out of range: %d", (int)AS_INTEGER(piece));
+				goto _freeAndDone;
+			}
+			value = argv[1 + AS_INTEGER(piece)];
+		} else if (!hasKw || !krk_tableGet(AS_DICT(kwargs), piece, &value)) {
+			krk_runtimeError(vm.exceptions->keyError, "'%s'", AS_CSTRING(piece));
+			goto _freeAndDone;
+		}
+
+		if (krk_simpleStrLength(value) < 0) {
+			krk_push(value);
+			KrkClass * type = krk_getType(value);
+			if (type->_tostr) {
+				value = krk_callDirect(type->_tostr, 1);
+			} else {
+				if (!krk_bindMethod(type, AS_STRING(vm.specialMethodNames[METHOD_STR]))) {
+					krk_runtimeError(vm.exceptions->typeError, "Error parsing format string: %s", "Failed to convert field to string.");
+					goto _freeAndDone;
+				}
+				value = krk_callStack(0);
+			}
+			if (krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION) goto _freeAndDone;
+			if (!IS_STRING(value)) {
+				krk_runtimeError(vm.exceptions->typeError, "__str__ returned non-string (type %T)", value);
+				goto _freeAndDone;
+			}
+		}
+		krk_push(value);
+	}
+
+	KrkValue result = krk_concatSimple(krk_currentThread.stackTop - krk_currentThread.stack - stackBefore,
+		krk_currentThread.stack + stackBefore);
+	krk_currentThread.stackTop = krk_currentThread.stack + stackBefore - 1;
+	return result;
 
 _freeAndDone:
-	discardStringBuilder(&sb);
-	free(workSpace);
+	krk_currentThread.stackTop = krk_currentThread.stack + stackBefore - 1;
 	return NONE_VAL();
 }
 
@@ -389,18 +383,13 @@ KRK_Method(str,__mul__) {
 	char * out = malloc(totalLength + 1);
 	char * c = out;
 
-	uint32_t hash = 0;
-
 	for (krk_integer_type i = 0; i < howMany; ++i) {
-		for (size_t j = 0; j < self->length; ++j) {
-			*c = self->chars[j];
-			krk_hash_advance(hash, *c);
-			c++;
-		}
+		memcpy(c, self->chars, self->length);
+		c += self->length;
 	}
 
 	*c = '\0';
-	return OBJECT_VAL(krk_takeStringVetted(out, totalLength, self->codesLength * howMany, (self->obj.flags & KRK_OBJ_FLAGS_STRING_MASK), hash));
+	return OBJECT_VAL(krk_takeStringVetted(out, totalLength, self->codesLength * howMany, (self->obj.flags & KRK_OBJ_FLAGS_STRING_MASK), krk_hashBytes(out, totalLength)));
 }
 
 KRK_Method(str,__rmul__) {
@@ -455,12 +444,130 @@ static int isWhitespace(char c) {
 	return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
 }
 
-static int substringMatch(const char * haystack, size_t haystackLen, const char * needle, size_t needleLength) {
-	if (haystackLen < needleLength) return 0;
-	for (size_t i = 0; i < needleLength; ++i) {
-		if (haystack[i] != needle[i]) return 0;
+/**
+ * Two-Way string matching (Crochemore and Perrin, 1991), which finds the
+ * first occurrence of @p needle in linear time and constant space. It is
+ * only used when the filter in krk_memmem degrades on repetitive input.
+ */
+static ssize_t _maximalSuffix(const unsigned char * x, ssize_t m, ssize_t * period, int reversed) {
+	ssize_t ms = -1, j = 0, k = 1, p = 1;
+	while (j + k < m) {
+		unsigned char a = x[j + k];
+		unsigned char b = x[ms + k];
+		if (reversed ? (a > b) : (a < b)) {
+			j += k;
+			k = 1;
+			p = j - ms;
+		} else if (a == b) {
+			if (k != p) {
+				k++;
+			} else {
+				j += p;
+				k = 1;
+			}
+		} else {
+			ms = j;
+			j = ms + 1;
+			k = p = 1;
+		}
+	}
+	*period = p;
+	return ms;
+}
+
+static ssize_t _twoWaySearch(const unsigned char * y, ssize_t n, const unsigned char * x, ssize_t m) {
+	ssize_t p, q;
+	ssize_t i = _maximalSuffix(x, m, &p, 0);
+	ssize_t j = _maximalSuffix(x, m, &q, 1);
+	ssize_t ell = i > j ? i : j;
+	ssize_t per = i > j ? p : q;
+
+	if (memcmp(x, x + per, ell + 1) == 0) {
+		/* The needle is periodic: remember how much of the period already matched. */
+		ssize_t memory = -1;
+		j = 0;
+		while (j <= n - m) {
+			i = (ell > memory ? ell : memory) + 1;
+			while (i < m && x[i] == y[i + j]) i++;
+			if (i >= m) {
+				i = ell;
+				while (i > memory && x[i] == y[i + j]) i--;
+				if (i <= memory) return j;
+				j += per;
+				memory = m - per - 1;
+			} else {
+				j += i - ell;
+				memory = -1;
+			}
+		}
+	} else {
+		per = (ell + 1 > m - ell - 1 ? ell + 1 : m - ell - 1) + 1;
+		j = 0;
+		while (j <= n - m) {
+			i = ell + 1;
+			while (i < m && x[i] == y[i + j]) i++;
+			if (i >= m) {
+				i = ell;
+				while (i >= 0 && x[i] == y[i + j]) i--;
+				if (i < 0) return j;
+				j += per;
+			} else {
+				j += i - ell;
+			}
+		}
+	}
+	return -1;
+}
+
+/* Candidate checks may cost this much more than scanning before switching to Two-Way. */
+#define SEARCH_WORK_LIMIT(scanned) ((scanned) * 4 + 4096)
+
+const char * krk_memmem(const char * haystack, size_t haystackLength, const char * needle, size_t needleLength) {
+	if (needleLength == 0) return haystack;
+	if (needleLength > haystackLength) return NULL;
+	if (needleLength == 1) return memchr(haystack, needle[0], haystackLength);
+
+	const unsigned char * h = (const unsigned char *)haystack;
+	const unsigned char * n = (const unsigned char *)needle;
+	size_t last = haystackLength - needleLength;
+	size_t work = 0;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	/* Test sixteen positions at once for both the first and last byte of the needle. */
+	__m128i first = _mm_set1_epi8(n[0]);
+	__m128i final = _mm_set1_epi8(n[needleLength-1]);
+	for (; i + 16 <= last + 1; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(h + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(h + i + needleLength - 1));
+		unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, final)));
+		while (mask) {
+			size_t candidate = i + __builtin_ctz(mask);
+			if (memcmp(h + candidate + 1, n + 1, needleLength - 2) == 0) return haystack + candidate;
+			work += needleLength;
+			mask &= mask - 1;
+		}
+		if (work > SEARCH_WORK_LIMIT(i)) goto _twoWay;
+	}
+#endif
+
+	while (i <= last) {
+		const unsigned char * c = memchr(h + i, n[0], last - i + 1);
+		if (!c) return NULL;
+		i = c - h;
+		if (h[i + needleLength - 1] == n[needleLength - 1]) {
+			if (memcmp(h + i + 1, n + 1, needleLength - 2) == 0) return haystack + i;
+			work += needleLength;
+			if (work > SEARCH_WORK_LIMIT(i)) goto _twoWay;
+		}
+		i++;
+	}
+	return NULL;
+
+_twoWay: {
+		ssize_t found = _twoWaySearch(h + i, haystackLength - i, n, needleLength);
+		return found < 0 ? NULL : haystack + i + found;
 	}
-	return 1;
 }
 
 /* str.__contains__ */
@@ -468,12 +575,19 @@ KRK_Method(str,__contains__) {
 	METHOD_TAKES_EXACTLY(1);
 	if (IS_NONE(argv[1])) return BOOLEAN_VAL(0);
 	CHECK_ARG(1,str,KrkString*,needle);
-	for (size_t i = 0; i < self->length; ++i) {
-		if (substringMatch(self->chars + i, self->length - i, needle->chars, needle->length)) {
-			return BOOLEAN_VAL(1);
-		}
+	return BOOLEAN_VAL(krk_memmem(self->chars, self->length, needle->chars, needle->length) != NULL);
+}
+
+/**
+ * Searches work on UTF-8 bytes; these convert between byte offsets and
+ * codepoint indexes by counting the bytes that start a codepoint.
+ */
+static size_t _codepointsIn(const char * chars, size_t length) {
+	size_t count = 0;
+	for (size_t i = 0; i < length; ++i) {
+		count += ((unsigned char)chars[i] & 0xC0) != 0x80;
 	}
-	return BOOLEAN_VAL(0);
+	return count;
 }
 
 static int charIn(uint32_t c, KrkString * str) {
@@ -499,8 +613,8 @@ static KrkValue _string_strip_shared(int argc, const KrkValue argv[], int which)
 	}
 
 	KrkString * self = AS_STRING(argv[0]);
-	krk_unicodeString(self);
-	krk_unicodeString(subset);
+	krk_unicodeIndex(self);
+	krk_unicodeIndex(subset);
 
 	uint32_t c;
 	size_t start = 0;
@@ -511,7 +625,7 @@ static KrkValue _string_strip_shared(int argc, const KrkValue argv[], int which)
 	if (which < 2) while (start < end && charIn((c = KRK_STRING_FAST(self, j)), subset)) { j++; start += CODEPOINT_BYTES(c); }
 	if (which != 1) while (end > start && charIn((c = KRK_STRING_FAST(self, k)), subset)) { k--; end -= CODEPOINT_BYTES(c); }
 
-	return OBJECT_VAL(krk_copyString(&self->chars[start], end-start));
+	return OBJECT_VAL(krk_stringSlice(self, start, end-start));
 }
 
 KRK_Method(str,strip) {
@@ -691,50 +805,38 @@ KRK_Method(str,split) {
 			if (i == self->length) break;
 
 			if (count == maxsplit) {
-				krk_push(OBJECT_VAL(krk_copyString(&self->chars[i], self->length - i)));
+				krk_push(OBJECT_VAL(krk_stringSlice(self, i, self->length - i)));
 				krk_writeValueArray(AS_LIST(myList), krk_peek(0));
 				krk_pop();
 				break;
 			}
 
-			struct StringBuilder sb = {0};
+			size_t start = i;
 			while (i != self->length && !isWhitespace(*c)) {
-				pushStringBuilder(&sb, *c);
 				i++;
 				c++;
 			}
-			krk_push(finishStringBuilder(&sb));
+			krk_push(OBJECT_VAL(krk_stringSlice(self, start, i - start)));
 			krk_writeValueArray(AS_LIST(myList), krk_peek(0));
 			krk_pop();
 			count++;
 		}
 	} else {
-		/* Special case 0 */
-		if (maxsplit == 0) {
-			krk_writeValueArray(AS_LIST(myList), argv[0]);
-			return krk_pop();
-		}
-
-		while (i != self->length) {
-			struct StringBuilder sb = {0};
-			while (i != self->length && !substringMatch(c, self->length - i, sep, sepLen)) {
-				pushStringBuilder(&sb, *c);
-				i++;
-				c++;
-			}
-			krk_push(finishStringBuilder(&sb));
-			krk_writeValueArray(AS_LIST(myList), krk_peek(0));
-			krk_pop();
-			if (i == self->length) break;
-			i += sepLen;
-			c += sepLen;
-			count++;
-			if (count == maxsplit || i == self->length) {
-				krk_push(OBJECT_VAL(krk_copyString(&self->chars[i], self->length - i)));
+		const char * c = self->chars;
+		const char * end = self->chars + self->length;
+		while (1) {
+			const char * match = (count == maxsplit) ? NULL : krk_memmem(c, end - c, sep, sepLen);
+			if (!match) {
+				krk_push(OBJECT_VAL(krk_stringSlice(self, c - self->chars, end - c)));
 				krk_writeValueArray(AS_LIST(myList), krk_peek(0));
 				krk_pop();
 				break;
 			}
+			krk_push(OBJECT_VAL(krk_copyString(c, match - c)));
+			krk_writeValueArray(AS_LIST(myList), krk_peek(0));
+			krk_pop();
+			c = match + sepLen;
+			count++;
 		}
 	}
 
@@ -748,28 +850,35 @@ KRK_Method(str,replace) {
 	CHECK_ARG(2,str,KrkString*,newStr);
 	KrkValue count = (argc > 3 && IS_INTEGER(argv[3])) ? argv[3] : NONE_VAL();
 
-	struct StringBuilder sb = {0};
-
-	int replacements = 0;
-	size_t i = 0;
-	char * c = self->chars;
-	while (i < self->length) {
-		if ( substringMatch(c, self->length - i, oldStr->chars, oldStr->length) && (IS_NONE(count) || replacements < AS_INTEGER(count))) {
-			pushStringBuilderStr(&sb, newStr->chars, newStr->length);
-			if (oldStr->length == 0) {
-				pushStringBuilder(&sb, *c);
-				c++;
-				i++;
+	if (oldStr->length == 0) {
+		struct StringBuilder sb = {0};
+		int replacements = 0;
+		for (size_t i = 0; i < self->length; ++i) {
+			if (IS_NONE(count) || replacements < AS_INTEGER(count)) {
+				pushStringBuilderStr(&sb, newStr->chars, newStr->length);
+				replacements++;
 			}
-			c += oldStr->length;
-			i += oldStr->length;
-			replacements++;
-		} else {
-			pushStringBuilder(&sb, *c);
-			c++;
-			i++;
+			pushStringBuilder(&sb, self->chars[i]);
 		}
+		return finishStringBuilder(&sb);
+	}
+
+	const char * c = self->chars;
+	const char * end = self->chars + self->length;
+	const char * match = krk_memmem(c, end - c, oldStr->chars, oldStr->length);
+	if (!match || (!IS_NONE(count) && AS_INTEGER(count) <= 0)) return argv[0];
+
+	struct StringBuilder sb = {0};
+	krk_integer_type replacements = 0;
+	while (match) {
+		pushStringBuilderStr(&sb, (char*)c, match - c);
+		pushStringBuilderStr(&sb, newStr->chars, newStr->length);
+		c = match + oldStr->length;
+		replacements++;
+		if (!IS_NONE(count) && replacements >= AS_INTEGER(count)) break;
+		match = krk_memmem(c, end - c, oldStr->chars, oldStr->length);
 	}
+	pushStringBuilderStr(&sb, (char*)c, end - c);
 
 	return finishStringBuilder(&sb);
 }
@@ -803,22 +912,44 @@ KRK_Method(str,find) {
 		}
 	}
 
+	/* As in CPython, a start past the end finds nothing, not even '' */
+	if (start > (krk_integer_type)self->codesLength) return INTEGER_VAL(-1);
 	WRAP_INDEX(start);
 	WRAP_INDEX(end);
 
-	/* Make sure both strings have code representations */
-	krk_unicodeString(self);
-	krk_unicodeString(substr);
+	if (start > end) return INTEGER_VAL(-1);
 
-	for (krk_integer_type i = start; i < end; ++i) {
-		krk_integer_type j;
-		for (j = 0; j < (krk_integer_type)substr->codesLength && (i + j < end); ++j) {
-			if (KRK_STRING_FAST(self,i+j) != KRK_STRING_FAST(substr,j)) break;
-		}
-		if (j == (krk_integer_type)substr->codesLength) return INTEGER_VAL(i);
+	size_t startByte = krk_unicodeOffset(self, start);
+	size_t endByte = krk_unicodeOffset(self, end);
+	const char * found = krk_memmem(self->chars + startByte, endByte - startByte, substr->chars, substr->length);
+	if (!found) return INTEGER_VAL(-1);
+	if (self->length == self->codesLength) return INTEGER_VAL(found - self->chars);
+	return INTEGER_VAL(start + _codepointsIn(self->chars + startByte, found - self->chars - startByte));
+}
+
+KRK_Method(str,count) {
+	KrkString * substr;
+	ssize_t start = 0;
+	ssize_t end = self->codesLength;
+	if (!krk_parseArgs(".O!|nn",(const char*[]){"sub","start","end"}, KRK_BASE_CLASS(str), &substr, &start, &end)) {
+		return NONE_VAL();
 	}
 
-	return INTEGER_VAL(-1);
+	if (start > (ssize_t)self->codesLength) return INTEGER_VAL(0);
+	WRAP_INDEX(start);
+	WRAP_INDEX(end);
+
+	if (start > end) return INTEGER_VAL(0);
+	if (substr->length == 0) return INTEGER_VAL(end - start + 1);
+
+	const char * c = self->chars + krk_unicodeOffset(self, start);
+	const char * stop = self->chars + krk_unicodeOffset(self, end);
+	krk_integer_type count = 0;
+	while ((c = krk_memmem(c, stop - c, substr->chars, substr->length))) {
+		count++;
+		c += substr->length;
+	}
+	return INTEGER_VAL(count);
 }
 
 KRK_Method(str,index) {
@@ -840,8 +971,8 @@ KRK_Method(str,startswith) {
 	WRAP_INDEX(start);
 	WRAP_INDEX(end);
 
-	krk_unicodeString(self);
-	krk_unicodeString(substr);
+	krk_unicodeIndex(self);
+	krk_unicodeIndex(substr);
 
 	if (end < start || (size_t)(end - start) < substr->codesLength) return BOOLEAN_VAL(0);
 
@@ -862,8 +993,8 @@ KRK_Method(str,endswith) {
 	WRAP_INDEX(start);
 	WRAP_INDEX(end);
 
-	krk_unicodeString(self);
-	krk_unicodeString(substr);
+	krk_unicodeIndex(self);
+	krk_unicodeIndex(substr);
 
 	if (end < start || (size_t)(end - start) < substr->codesLength) return BOOLEAN_VAL(0);
 
@@ -961,7 +1092,7 @@ KRK_Method(str,__iter__) {
 }
 
 #define CHECK_ALL(test) do { \
-	krk_unicodeString(self); \
+	krk_unicodeIndex(self); \
 	for (size_t i = 0; i < self->codesLength; ++i) { \
 		uint32_t c = KRK_STRING_FAST(self,i); \
 		if (!(test)) { return BOOLEAN_VAL(0); } \
@@ -1084,6 +1215,76 @@ _corrupt:
 }
 
 
+size_t krk_writeInteger(char * out, krk_integer_type value) {
+	static const char pairs[] =
+		"00010203040506070809" "10111213141516171819" "20212223242526272829" "30313233343536373839" "40414243444546474849"
+		"50515253545556575859" "60616263646566676869" "70717273747576777879" "80818283848586878889" "90919293949596979899";
+	char tmp[24];
+	char * c = tmp + sizeof(tmp);
+	uint64_t abs = value < 0 ? -(uint64_t)value : (uint64_t)value;
+	while (abs >= 100) {
+		unsigned int pair = (abs % 100) * 2;
+		abs /= 100;
+		*--c = pairs[pair + 1];
+		*--c = pairs[pair];
+	}
+	if (abs >= 10) {
+		*--c = pairs[abs * 2 + 1];
+		*--c = pairs[abs * 2];
+	} else {
+		*--c = '0' + abs;
+	}
+	if (value < 0) *--c = '-';
+	size_t length = tmp + sizeof(tmp) - c;
+	memcpy(out, c, length);
+	return length;
+}
+
+ssize_t krk_simpleStrLength(KrkValue value) {
+	if (IS_STRING(value)) return AS_STRING(value)->length;
+	if (IS_BOOLEAN(value)) return 5;
+	if (IS_INTEGER(value)) return 20;
+	if (IS_NONE(value)) return 4;
+	return -1;
+}
+
+size_t krk_simpleStrWrite(char * out, KrkValue value) {
+	if (IS_STRING(value)) {
+		memcpy(out, AS_CSTRING(value), AS_STRING(value)->length);
+		return AS_STRING(value)->length;
+	} else if (IS_BOOLEAN(value)) {
+		if (AS_BOOLEAN(value)) {
+			memcpy(out, "True", 4);
+			return 4;
+		}
+		memcpy(out, "False", 5);
+		return 5;
+	} else if (IS_INTEGER(value)) {
+		return krk_writeInteger(out, AS_INTEGER(value));
+	}
+	memcpy(out, "None", 4);
+	return 4;
+}
+
+KrkValue krk_concatSimple(size_t count, const KrkValue * parts) {
+	size_t bound = 0;
+	for (size_t i = 0; i < count; ++i) {
+		ssize_t length = krk_simpleStrLength(parts[i]);
+		if (unlikely(length < 0)) return krk_runtimeError(vm.exceptions->valueError, "'%T' is not a string", parts[i]);
+		bound += length;
+	}
+
+	char * out = malloc(bound + 1);
+	size_t length = 0;
+	for (size_t i = 0; i < count; ++i) {
+		length += krk_simpleStrWrite(out + length, parts[i]);
+	}
+	out[length] = '\0';
+
+	return OBJECT_VAL(krk_takeString(out, length));
+}
+
+
 void krk_pushStringBuilder(struct StringBuilder * sb, char c) {
 	if (sb->capacity < sb->length + 1) {
 		size_t old = sb->capacity;
@@ -1102,9 +1303,8 @@ void krk_pushStringBuilderStr(struct StringBuilder * sb, const char *str, size_t
 		}
 		sb->bytes = KRK_GROW_ARRAY(char, sb->bytes, prevcap, sb->capacity);
 	}
-	for (size_t i = 0; i < len; ++i) {
-		sb->bytes[sb->length++] = *(str++);
-	}
+	memcpy(sb->bytes + sb->length, str, len);
+	sb->length += len;
 }
 
 static void _freeStringBuilder(struct StringBuilder * sb) {
@@ -1313,6 +1513,7 @@ void _createAndBind_strClass(void) {
 	BIND_METHOD(str,format);
 	BIND_METHOD(str,replace);
 	BIND_METHOD(str,find);
+	BIND_METHOD(str,count);
 	BIND_METHOD(str,index);
 	BIND_METHOD(str,startswith);
 	BIND_METHOD(str,endswith);
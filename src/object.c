@@ -1,6 +1,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <kuroko/memory.h>
 #include <kuroko/object.h>
@@ -57,68 +60,77 @@ size_t krk_codepointToBytes(krk_integer_type value, unsigned char * out) {
 	}
 }
 
-#define UTF8_ACCEPT 0
-#define UTF8_REJECT 1
-
-static inline uint32_t decode(uint32_t* state, uint32_t* codep, uint32_t byte) {
-	static const int state_table[32] = {
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, /* 0xxxxxxx */
-		1,1,1,1,1,1,1,1,                 /* 10xxxxxx */
-		2,2,2,2,                         /* 110xxxxx */
-		3,3,                             /* 1110xxxx */
-		4,                               /* 11110xxx */
-		1                                /* 11111xxx */
-	};
-
-	static const int mask_bytes[32] = {
-		0x7F,0x7F,0x7F,0x7F,0x7F,0x7F,0x7F,0x7F,
-		0x7F,0x7F,0x7F,0x7F,0x7F,0x7F,0x7F,0x7F,
-		0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-		0x1F,0x1F,0x1F,0x1F,
-		0x0F,0x0F,
-		0x07,
-		0x00
-	};
-
-	static const int next[5] = {
-		0,
-		1,
-		0,
-		2,
-		3
-	};
-
-	if (*state == UTF8_ACCEPT) {
-		if (byte >= 0x80 && byte <= 0xC1) goto _reject;
-		*codep = byte & mask_bytes[byte >> 3];
-		*state = state_table[byte >> 3];
-	} else if (*state > 0) {
-		if (byte < 0x80 || byte >= 0xC0) goto _reject;
-		*codep = (byte & 0x3F) | (*codep << 6);
-		*state = next[*state];
+/**
+ * Length of the run of ASCII bytes at the start of @p c, checked sixteen
+ * bytes at a time with SSE2 or eight at a time otherwise. Most text is
+ * entirely or mostly ASCII, so validation and expansion skip these runs
+ * in bulk and only decode the sequences in between one at a time.
+ */
+static inline size_t _asciiPrefix(const unsigned char * c, size_t length) {
+	size_t i = 0;
+#if defined(__SSE2__)
+	for (; i + 16 <= length; i += 16) {
+		unsigned int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(c + i)));
+		if (mask) return i + __builtin_ctz(mask);
+	}
+#else
+	for (; i + 8 <= length; i += 8) {
+		uint64_t block;
+		memcpy(&block, c + i, 8);
+		if (block & UINT64_C(0x8080808080808080)) break;
+	}
+#endif
+	while (i < length && c[i] < 0x80) i++;
+	return i;
+}
+
+/**
+ * Decode the multibyte sequence at @p c, returning its length, or 0 if it
+ * is invalid or truncated. As before, overlong forms and surrogates are
+ * accepted, but stray continuation bytes and 0xC0, 0xC1, 0xF8-0xFF are not.
+ */
+static inline size_t _decodeOne(const unsigned char * c, const unsigned char * end, uint32_t * codepoint) {
+	size_t length;
+	uint32_t cp;
+	if (*c < 0xC2) return 0;
+	else if (*c < 0xE0) { length = 2; cp = *c & 0x1F; }
+	else if (*c < 0xF0) { length = 3; cp = *c & 0x0F; }
+	else if (*c < 0xF8) { length = 4; cp = *c & 0x07; }
+	else return 0;
+	if ((size_t)(end - c) < length) return 0;
+	for (size_t i = 1; i < length; ++i) {
+		if ((c[i] & 0xC0) != 0x80) return 0;
+		cp = (cp << 6) | (c[i] & 0x3F);
 	}
-	return *state;
-_reject:
-	*state = UTF8_REJECT;
-	return *state;
+	*codepoint = cp;
+	return length;
 }
 
 static int checkString(const char * chars, size_t length, size_t *codepointCount) {
-	uint32_t state = 0;
-	uint32_t codepoint = 0;
-	unsigned char * end = (unsigned char *)chars + length;
+	const unsigned char * c = (const unsigned char *)chars;
+	const unsigned char * end = c + length;
 	uint32_t maxCodepoint = 0;
-	for (unsigned char * c = (unsigned char *)chars; c < end; ++c) {
-		if (!decode(&state, &codepoint, *c)) {
-			if (codepoint > maxCodepoint) maxCodepoint = codepoint;
-			(*codepointCount)++;
-		} else if (state == UTF8_REJECT) {
+	size_t count = 0;
+	while (c < end) {
+		if (*c < 0x80) {
+			size_t ascii = _asciiPrefix(c, end - c);
+			c += ascii;
+			count += ascii;
+			continue;
+		}
+		uint32_t codepoint;
+		size_t bytes = _decodeOne(c, end, &codepoint);
+		if (!bytes) {
 			_release_lock(_stringLock);
 			krk_runtimeError(vm.exceptions->valueError, "Invalid UTF-8 sequence in string.");
 			*codepointCount = 0;
 			return -1;
 		}
+		if (codepoint > maxCodepoint) maxCodepoint = codepoint;
+		c += bytes;
+		count++;
 	}
+	*codepointCount = count;
 	if (maxCodepoint > 0xFFFF) {
 		return KRK_OBJ_FLAGS_STRING_UCS4;
 	} else if (maxCodepoint > 0xFF) {
@@ -130,37 +142,209 @@ static int checkString(const char * chars, size_t length, size_t *codepointCount
 	}
 }
 
+/* Widen a run of ASCII bytes into the codes buffer. */
+static inline void _widen1(uint8_t * out, const unsigned char * in, size_t count) {
+	memcpy(out, in, count);
+}
+
+static inline void _widen2(uint16_t * out, const unsigned char * in, size_t count) {
+	size_t i = 0;
+#if defined(__SSE2__)
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i bytes = _mm_loadu_si128((const __m128i *)(in + i));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_unpacklo_epi8(bytes, zero));
+		_mm_storeu_si128((__m128i *)(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+	}
+#endif
+	for (; i < count; ++i) out[i] = in[i];
+}
+
+static inline void _widen4(uint32_t * out, const unsigned char * in, size_t count) {
+	size_t i = 0;
+#if defined(__SSE2__)
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i bytes = _mm_loadu_si128((const __m128i *)(in + i));
+		__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+		__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+		_mm_storeu_si128((__m128i *)(out + i),      _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128((__m128i *)(out + i + 4),  _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128((__m128i *)(out + i + 8),  _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128((__m128i *)(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+	}
+#endif
+	for (; i < count; ++i) out[i] = in[i];
+}
+
 #define GENREADY(size,type) \
-	static void _readyUCS ## size (KrkString * string) { \
-		uint32_t state = 0; \
-		uint32_t codepoint = 0; \
-		unsigned char * end = (unsigned char *)string->chars + string->length; \
-		string->codes = malloc(sizeof(type) * string->codesLength); \
-		type *outPtr = (type *)string->codes; \
-		for (unsigned char * c = (unsigned char *)string->chars; c < end; ++c) { \
-			if (!decode(&state, &codepoint, *c)) { \
-				*(outPtr++) = (type)codepoint; \
-			} else if (state == UTF8_REJECT) { \
-				state = 0; \
+	static void * _readyUCS ## size (KrkString * string) { \
+		const unsigned char * c = (const unsigned char *)string->chars; \
+		const unsigned char * end = c + string->length; \
+		type * codes = malloc(sizeof(type) * string->codesLength); \
+		type *outPtr = codes; \
+		while (c < end) { \
+			if (*c < 0x80) { \
+				size_t ascii = _asciiPrefix(c, end - c); \
+				_widen ## size (outPtr, c, ascii); \
+				outPtr += ascii; \
+				c += ascii; \
+				continue; \
 			} \
+			uint32_t codepoint = 0; \
+			size_t bytes = _decodeOne(c, end, &codepoint); \
+			c += bytes ? bytes : 1; \
+			*(outPtr++) = (type)codepoint; \
 		} \
+		return codes; \
 	}
 GENREADY(1,uint8_t)
 GENREADY(2,uint16_t)
 GENREADY(4,uint32_t)
 #undef GENREADY
 
+/**
+ * Large non-ASCII strings are not expanded into a codepoint array for
+ * indexing. Instead, @c codes points to a table of the byte offsets of
+ * every STRING_INDEX_STRIDE'th codepoint, and codepoints are decoded from
+ * the UTF-8 data on demand. The offset of the last codepoint accessed is
+ * kept as well, so walking through a string in order doesn't rescan.
+ */
+#define STRING_INDEX_STRIDE 64
+#define STRING_INDEX_MIN    1024
+
+typedef struct {
+	uint64_t cursor;     /* Index of the last codepoint accessed in the high half, its offset in the low half */
+	void * full;         /* Full codepoint array, if krk_unicodeString was asked for one */
+	uint32_t offsets[];
+} KrkStringIndex;
+
+#define STRING_INDEX_SIZE(s) (sizeof(KrkStringIndex) + sizeof(uint32_t) * (((s)->codesLength + STRING_INDEX_STRIDE - 1) / STRING_INDEX_STRIDE))
+
+/* Find the byte offset of the codepoint @p count codepoints after the one at @p offset. */
+static size_t _skipCodepoints(const unsigned char * c, size_t length, size_t offset, size_t count) {
+	/* Skip eight bytes at a time while the target is past them, counting lead bytes. */
+	while (offset + 8 <= length) {
+		uint64_t word;
+		memcpy(&word, c + offset, 8);
+		size_t leads = 8 - __builtin_popcountll(word & ~(word << 1) & 0x8080808080808080ULL);
+		if (leads > count) break;
+		count -= leads;
+		offset += 8;
+	}
+	while (offset < length) {
+		if ((c[offset] & 0xC0) != 0x80) {
+			if (!count) break;
+			count--;
+		}
+		offset++;
+	}
+	return offset;
+}
+
+static void _readyIndex(KrkString * string) {
+	KrkStringIndex * index = malloc(STRING_INDEX_SIZE(string));
+	const unsigned char * c = (const unsigned char *)string->chars;
+	size_t offset = 0;
+	for (size_t i = 0; i < string->codesLength; i += STRING_INDEX_STRIDE) {
+		index->offsets[i / STRING_INDEX_STRIDE] = offset;
+		offset = _skipCodepoints(c, string->length, offset, STRING_INDEX_STRIDE);
+	}
+	index->cursor = 0;
+	index->full = NULL;
+	string->codes = index;
+	string->obj.flags |= KRK_OBJ_FLAGS_STRING_INDEXED;
+}
+
+static size_t _indexedOffset(KrkString * string, size_t index) {
+	KrkStringIndex * table = string->codes;
+	size_t at = index - index % STRING_INDEX_STRIDE;
+	size_t offset = table->offsets[index / STRING_INDEX_STRIDE];
+	uint64_t cursor = __atomic_load_n(&table->cursor, __ATOMIC_RELAXED);
+	if ((cursor >> 32) <= index && (cursor >> 32) > at) {
+		at = cursor >> 32;
+		offset = cursor & 0xFFFFFFFF;
+	}
+	offset = _skipCodepoints((const unsigned char *)string->chars, string->length, offset, index - at);
+	__atomic_store_n(&table->cursor, ((uint64_t)index << 32) | offset, __ATOMIC_RELAXED);
+	return offset;
+}
+
+uint32_t krk_unicodeIndexed(KrkString * string, size_t index) {
+	const unsigned char * c = (const unsigned char *)string->chars + _indexedOffset(string, index);
+	uint32_t codepoint = *c;
+	if (codepoint >= 0x80) _decodeOne(c, (const unsigned char *)string->chars + string->length, &codepoint);
+	return codepoint;
+}
+
+void krk_unicodeIndex(KrkString * string) {
+	if (string->codes) return;
+	if (string->codesLength >= STRING_INDEX_MIN && string->length < UINT32_MAX) _readyIndex(string);
+	else krk_unicodeString(string);
+}
+
+size_t krk_unicodeOffset(KrkString * string, size_t index) {
+	if (string->length == string->codesLength) return index;
+	if (index >= string->codesLength) return string->length;
+	if (string->codesLength >= STRING_INDEX_MIN) krk_unicodeIndex(string);
+	if (string->obj.flags & KRK_OBJ_FLAGS_STRING_INDEXED) return _indexedOffset(string, index);
+	return _skipCodepoints((const unsigned char *)string->chars, string->length, 0, index);
+}
+
+static void * _readyCodes(KrkString * string) {
+	switch (string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) {
+		case KRK_OBJ_FLAGS_STRING_UCS1: return _readyUCS1(string);
+		case KRK_OBJ_FLAGS_STRING_UCS2: return _readyUCS2(string);
+		case KRK_OBJ_FLAGS_STRING_UCS4: return _readyUCS4(string);
+		default:
+			krk_runtimeError(vm.exceptions->valueError, "Internal string error.");
+			return NULL;
+	}
+}
+
 void * krk_unicodeString(KrkString * string) {
-	if (string->codes) return string->codes;
-	else if ((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == KRK_OBJ_FLAGS_STRING_UCS1) _readyUCS1(string);
-	else if ((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == KRK_OBJ_FLAGS_STRING_UCS2) _readyUCS2(string);
-	else if ((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == KRK_OBJ_FLAGS_STRING_UCS4) _readyUCS4(string);
-	else krk_runtimeError(vm.exceptions->valueError, "Internal string error.");
+	if (string->obj.flags & KRK_OBJ_FLAGS_STRING_INDEXED) {
+		/*
+		 * Someone wants the full array after all. Other threads may be
+		 * reading through the index, so it stays, and the array is kept
+		 * alongside it until the string is freed.
+		 */
+		KrkStringIndex * index = string->codes;
+		void * full = __atomic_load_n(&index->full, __ATOMIC_ACQUIRE);
+		if (full) return full;
+		full = _readyCodes(string);
+		void * expected = NULL;
+		if (!__atomic_compare_exchange_n(&index->full, &expected, full, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			free(full);
+			full = expected;
+		}
+		return full;
+	}
+	if (!string->codes) string->codes = _readyCodes(string);
 	return string->codes;
 }
 
+void krk_unicodeFree(KrkString * string) {
+	if (string->obj.flags & KRK_OBJ_FLAGS_STRING_INDEXED) free(((KrkStringIndex*)string->codes)->full);
+	if (string->codes && string->codes != string->chars) free(string->codes);
+}
+
+size_t krk_unicodeIndexSize(KrkString * string) {
+	if (!(string->obj.flags & KRK_OBJ_FLAGS_STRING_INDEXED)) return 0;
+	size_t size = STRING_INDEX_SIZE(string);
+	if (((KrkStringIndex*)string->codes)->full) {
+		switch (string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) {
+			case KRK_OBJ_FLAGS_STRING_UCS1: size += string->codesLength; break;
+			case KRK_OBJ_FLAGS_STRING_UCS2: size += 2 * string->codesLength; break;
+			default: size += 4 * string->codesLength; break;
+		}
+	}
+	return size;
+}
+
 uint32_t krk_unicodeCodepoint(KrkString * string, size_t index) {
-	krk_unicodeString(string);
+	krk_unicodeIndex(string);
+	if (string->obj.flags & KRK_OBJ_FLAGS_STRING_INDEXED) return krk_unicodeIndexed(string, index);
 	switch (string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) {
 		case KRK_OBJ_FLAGS_STRING_ASCII:
 		case KRK_OBJ_FLAGS_STRING_UCS1: return ((uint8_t*)string->codes)[index];
@@ -195,18 +379,8 @@ static KrkString * allocateString(char * chars, size_t length, uint32_t hash) {
 	return string;
 }
 
-static uint32_t hashString(const char * key, size_t length) {
-	uint32_t hash = 0;
-	/* This is the so-called "sdbm" hash. It comes from a piece of
-	 * public domain code from a clone of ndbm. */
-	for (size_t i = 0; i < length; ++i) {
-		krk_hash_advance(hash,key[i]);
-	}
-	return hash;
-}
-
 KrkString * krk_takeString(char * chars, size_t length) {
-	uint32_t hash = hashString(chars, length);
+	uint32_t hash = krk_hashBytes(chars, length);
 	_obtain_lock(_stringLock);
 	KrkString * interned = krk_tableFindString(&vm.strings, chars, length, hash);
 	if (interned != NULL) {
@@ -222,7 +396,7 @@ KrkString * krk_takeString(char * chars, size_t length) {
 }
 
 KrkString * krk_copyString(const char * chars, size_t length) {
-	uint32_t hash = hashString(chars, length);
+	uint32_t hash = krk_hashBytes(chars, length);
 	_obtain_lock(_stringLock);
 	KrkString * interned = krk_tableFindString(&vm.strings, chars ? chars : "", length, hash);
 	if (interned) {
@@ -261,6 +435,54 @@ KrkString * krk_takeStringVetted(char * chars, size_t length, size_t codesLength
 	return string;
 }
 
+/**
+ * Slices share their parent's data only when they are long enough that the
+ * copy would matter, and large enough relative to the parent that they can
+ * not keep much more than themselves alive. Anything else is copied.
+ */
+#define SLICE_MIN   128
+#define SLICE_RATIO 4
+#define SLICE_SHARES(length, total) ((length) >= SLICE_MIN && (length) * SLICE_RATIO >= (total))
+
+KrkString * krk_stringSlice(KrkString * parent, size_t offset, size_t length) {
+	if (offset == 0 && length == parent->length) return parent;
+	KrkString * root = parent;
+	if ((parent->obj.flags & KRK_OBJ_FLAGS_STRING_SLICE) && ((KrkStringSlice*)parent)->parent) {
+		root = (KrkString*)((KrkStringSlice*)parent)->parent;
+	}
+	if (offset + length != parent->length || !SLICE_SHARES(length, root->length)) {
+		return krk_copyString(parent->chars + offset, length);
+	}
+
+	const char * chars = parent->chars + offset;
+	uint32_t hash = krk_hashBytes(chars, length);
+	_obtain_lock(_stringLock);
+	KrkString * interned = krk_tableFindString(&vm.strings, chars, length, hash);
+	if (interned) {
+		_release_lock(_stringLock);
+		return interned;
+	}
+	size_t codesLength = 0;
+	int type = checkString(chars, length, &codesLength);
+	krk_push(OBJECT_VAL(root));
+	KrkStringSlice * slice = (KrkStringSlice*)allocateObject(sizeof(KrkStringSlice), KRK_OBJ_STRING);
+	slice->parent = (KrkObj*)root;
+	KrkString * string = &slice->str;
+	string->length = length;
+	string->chars = (char*)chars;
+	string->obj.hash = hash;
+	string->obj.flags |= KRK_OBJ_FLAGS_VALID_HASH | KRK_OBJ_FLAGS_STRING_SLICE | type;
+	string->codesLength = codesLength;
+	string->codes = NULL;
+	if (type == KRK_OBJ_FLAGS_STRING_ASCII) string->codes = string->chars;
+	krk_pop();
+	krk_push(OBJECT_VAL(string));
+	krk_tableSetExact(&vm.strings, OBJECT_VAL(string), NONE_VAL());
+	krk_pop();
+	_release_lock(_stringLock);
+	return string;
+}
+
 KrkCodeObject * krk_newCodeObject(void) {
 	KrkCodeObject * codeobject = ALLOCATE_OBJECT(KrkCodeObject, KRK_OBJ_CODEOBJECT);
 	codeobject->requiredArgs = 0;
@@ -333,6 +555,7 @@ KrkClass * krk_newClass(KrkString * name, KrkClass * baseClass) {
 		_class->allocSize = baseClass->allocSize;
 		_class->_ongcscan = baseClass->_ongcscan;
 		_class->_ongcsweep = baseClass->_ongcsweep;
+		_class->_getbuffer = baseClass->_getbuffer;
 
 		krk_tableSet(&baseClass->subclasses, OBJECT_VAL(_class), NONE_VAL());
 	}
@@ -343,7 +566,8 @@ KrkClass * krk_newClass(KrkString * name, KrkClass * baseClass) {
 KrkInstance * krk_newInstance(KrkClass * _class) {
 	KrkInstance * instance = (KrkInstance*)allocateObject(_class->allocSize, KRK_OBJ_INSTANCE);
 	instance->_class = _class;
-	krk_initTable(&instance->fields);
+	if (_class->sharedKeys) krk_initTableShared(&instance->fields, _class->sharedKeys);
+	else krk_initTable(&instance->fields);
 	return instance;
 }
 
@@ -378,3 +602,44 @@ KrkBytes * krk_newBytes(size_t length, uint8_t * source) {
 	return bytes;
 }
 
+int krk_getBuffer(KrkValue value, KrkBuffer * buffer, int writable) {
+	if (IS_BYTES(value)) {
+		if (writable) goto _readonly;
+		buffer->buf = AS_BYTES(value)->bytes;
+		buffer->len = AS_BYTES(value)->length;
+		buffer->itemsize = 1;
+		buffer->format = "B";
+		buffer->readonly = 1;
+		return 1;
+	}
+	KrkClass * type = krk_getType(value);
+	if (!type->_getbuffer) {
+		krk_runtimeError(vm.exceptions->typeError, "a bytes-like object is required, not '%T'", value);
+		return 0;
+	}
+	if (!type->_getbuffer(value, buffer)) return 0;
+	if (writable && buffer->readonly) goto _readonly;
+	return 1;
+
+_readonly:
+	krk_runtimeError(vm.exceptions->typeError, "a writable bytes-like object is required, not '%T'", value);
+	return 0;
+}
+
+KrkBytes * krk_bytesSlice(KrkBytes * parent, size_t offset, size_t length) {
+	KrkBytes * root = parent;
+	if ((parent->obj.flags & KRK_OBJ_FLAGS_BYTES_SLICE) && ((KrkBytesSlice*)parent)->parent) {
+		root = (KrkBytes*)((KrkBytesSlice*)parent)->parent;
+	}
+	if (!SLICE_SHARES(length, root->length)) return krk_newBytes(length, parent->bytes + offset);
+	krk_push(OBJECT_VAL(root));
+	KrkBytesSlice * slice = (KrkBytesSlice*)allocateObject(sizeof(KrkBytesSlice), KRK_OBJ_BYTES);
+	slice->parent = (KrkObj*)root;
+	slice->bytes.obj.flags |= KRK_OBJ_FLAGS_BYTES_SLICE;
+	slice->bytes.obj.hash = -1;
+	slice->bytes.length = length;
+	slice->bytes.bytes = parent->bytes + offset;
+	krk_pop();
+	return &slice->bytes;
+}
+
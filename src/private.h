@@ -18,6 +18,7 @@ extern void _createAndBind_rangeClass(void);
 extern void _createAndBind_setClass(void);
 extern void _createAndBind_generatorClass(void);
 extern void _createAndBind_sliceClass(void);
+extern void _createAndBind_memoryviewClass(void);
 extern void _createAndBind_builtins(void);
 extern void _createAndBind_type(void);
 extern void _createAndBind_exceptions(void);
@@ -50,6 +51,41 @@ typedef enum {
 #define FORMAT_OP_STR    (1 << 2)
 #define FORMAT_OP_FORMAT (1 << 3)
 
+/**
+ * @brief Convert a float to a string.
+ *
+ * Backs float.__repr__ (digits=16, formatter=' ') and float.__format__.
+ */
+extern KrkValue krk_double_to_string(double a, unsigned int digits, char formatter, int plus, int forcedigits);
+
+/**
+ * @brief Write the decimal representation of an integer to @p out.
+ *
+ * @p out must have room for 20 bytes. Returns the number of bytes written.
+ */
+extern size_t krk_writeInteger(char * out, krk_integer_type value);
+
+/**
+ * @brief Upper bound on the length of str() of a value that can be converted inline.
+ *
+ * f-strings and str.format convert str, int, bool and None values directly
+ * instead of calling their __str__; other values return -1.
+ */
+extern ssize_t krk_simpleStrLength(KrkValue value);
+
+/**
+ * @brief Write str() of a value accepted by krk_simpleStrLength to @p out.
+ */
+extern size_t krk_simpleStrWrite(char * out, KrkValue value);
+
+/**
+ * @brief Concatenate values accepted by krk_simpleStrLength into a new string.
+ *
+ * The result is sized once and written in place. Raises ValueError
+ * if any of @p parts can not be converted inline.
+ */
+extern KrkValue krk_concatSimple(size_t count, const KrkValue * parts);
+
 struct ParsedFormatSpec {
 	const char * fill;
 	char align;
@@ -63,10 +99,145 @@ struct ParsedFormatSpec {
 	int fillSize;
 };
 
-/* We inline hashing in a few places, so it's nice to have this in one place.
- * This is the "sdbm" hash. I've been using it in various places for many years,
- * and this specific version apparently traces to gawk. */
-#define krk_hash_advance(hash,c) do { hash = (int)(c) + (hash << 6) + (hash << 16) - hash; } while (0)
+/**
+ * @brief Find the first occurrence of @p needle in @p haystack.
+ *
+ * Shared by the substring searches of str, bytes and bytearray. Candidate
+ * positions are found by matching the first and last bytes of the needle,
+ * sixteen at a time with SSE2, and verified with memcmp; if that degrades
+ * on repetitive input, the search falls back to the linear-time Two-Way
+ * algorithm. Returns NULL if there is no match.
+ */
+extern const char * krk_memmem(const char * haystack, size_t haystackLength, const char * needle, size_t needleLength);
+
+/**
+ * @brief Prepare a string for codepoint access with KRK_STRING_FAST.
+ *
+ * Short strings get a full codepoint array, as with krk_unicodeString.
+ * Long non-ASCII strings instead get a sparse table of byte offsets
+ * and are marked with KRK_OBJ_FLAGS_STRING_INDEXED, and their codepoints
+ * are decoded from the UTF-8 data as they are accessed.
+ */
+extern void krk_unicodeIndex(KrkString * string);
+
+/**
+ * @brief Get a codepoint from a string prepared in indexed mode.
+ */
+extern uint32_t krk_unicodeIndexed(KrkString * string, size_t index);
+
+/**
+ * @brief Get the byte offset of a codepoint in a string.
+ *
+ * Indexes at or past the end of the string return its length in bytes.
+ */
+extern size_t krk_unicodeOffset(KrkString * string, size_t index);
+
+/**
+ * @brief Size of the offset table of a string in indexed mode, or 0.
+ *
+ * Includes the full codepoint array if one was also built.
+ */
+extern size_t krk_unicodeIndexSize(KrkString * string);
+
+/**
+ * @brief Free the codepoint data of a string that is being freed.
+ */
+extern void krk_unicodeFree(KrkString * string);
+
+#define KRK_STRING_FAST(string,offset)  (uint32_t)\
+	((string->obj.flags & KRK_OBJ_FLAGS_STRING_INDEXED) ? krk_unicodeIndexed(string,offset) : \
+	(string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) <= (KRK_OBJ_FLAGS_STRING_UCS1) ? ((uint8_t*)string->codes)[offset] : \
+	((string->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == (KRK_OBJ_FLAGS_STRING_UCS2) ? ((uint16_t*)string->codes)[offset] : \
+	((uint32_t*)string->codes)[offset]))
+
+/**
+ * @brief A string sharing the character data of another string.
+ *
+ * Slices are marked with KRK_OBJ_FLAGS_STRING_SLICE. Their @c chars point
+ * into @c parent, which is kept alive by the garbage collector and is never
+ * itself a slice. Since strings are NUL-terminated, only slices that run to
+ * the end of their parent can be shared.
+ */
+typedef struct {
+	KrkString str;
+	KrkObj * parent;
+} KrkStringSlice;
+
+/**
+ * @brief A bytes object sharing the data of another bytes object.
+ */
+typedef struct {
+	KrkBytes bytes;
+	KrkObj * parent;
+} KrkBytesSlice;
+
+/**
+ * @brief Obtain a string for a range of bytes from another string.
+ *
+ * If the range is a long enough suffix of @p parent, the result shares its
+ * data rather than copying it. The range must fall on codepoint boundaries.
+ */
+extern KrkString * krk_stringSlice(KrkString * parent, size_t offset, size_t length);
+
+/**
+ * @brief Obtain a bytes object for a range of another bytes object.
+ *
+ * Long enough ranges share the data of @p parent rather than copying it.
+ * Must not be used on the backing store of a bytearray.
+ */
+extern KrkBytes * krk_bytesSlice(KrkBytes * parent, size_t offset, size_t length);
+
+/**
+ * @brief Finish hashing a number that has been reduced modulo KRK_HASH_MODULUS.
+ *
+ * Numeric types that can be equal to each other reduce their absolute
+ * values modulo the same prime and then pass the residue through here,
+ * so that equal ints, longs and floats produce the same hash.
+ */
+#define KRK_HASH_MODULUS ((UINT64_C(1) << 61) - 1)
+extern uint32_t krk_hashReduced(uint64_t residue, int negative);
+
+/**
+ * @brief Whether a value is an int (or bool) or a float.
+ *
+ * Ints and floats are stored in the value itself, so containers holding
+ * only numbers can be searched, compared and summed without calling methods.
+ * Ints have at most 48 bits and convert to double exactly, so a mixed pair
+ * of an int and a float compares correctly as two doubles.
+ */
+static inline int krk_isNumber(KrkValue value) {
+#ifndef KRK_NO_FLOAT
+	return IS_INTEGER(value) || IS_FLOATING(value);
+#else
+	return IS_INTEGER(value);
+#endif
+}
+
+#ifndef KRK_NO_FLOAT
+static inline double krk_numberAsDouble(KrkValue value) {
+	return IS_INTEGER(value) ? (double)AS_INTEGER(value) : AS_FLOATING(value);
+}
+#endif
+
+/**
+ * @brief a == b for two values accepted by krk_isNumber.
+ */
+static inline int krk_numbersEqual(KrkValue a, KrkValue b) {
+#ifndef KRK_NO_FLOAT
+	if (!IS_INTEGER(a) || !IS_INTEGER(b)) return krk_numberAsDouble(a) == krk_numberAsDouble(b);
+#endif
+	return AS_INTEGER(a) == AS_INTEGER(b);
+}
+
+/**
+ * @brief a < b for two values accepted by krk_isNumber.
+ */
+static inline int krk_numbersLess(KrkValue a, KrkValue b) {
+#ifndef KRK_NO_FLOAT
+	if (!IS_INTEGER(a) || !IS_INTEGER(b)) return krk_numberAsDouble(a) < krk_numberAsDouble(b);
+#endif
+	return AS_INTEGER(a) < AS_INTEGER(b);
+}
 
 #ifndef KRK_DISABLE_DEBUG
 #include <kuroko/debug.h>
@@ -3,6 +3,8 @@
 #include <kuroko/object.h>
 #include <kuroko/util.h>
 
+#include "private.h"
+
 #define KRK_VERSION_MAJOR  1
 #define KRK_VERSION_MINOR  5
 #define KRK_VERSION_PATCH  0
@@ -62,8 +64,10 @@ KRK_Function(getsizeof) {
 	switch (AS_OBJECT(argv[0])->type) {
 		case KRK_OBJ_STRING: {
 			KrkString * self = AS_STRING(argv[0]);
-			mySize += sizeof(KrkString) + self->length + 1; /* For the UTF8 */
-			if (self->codes && self->chars != self->codes) {
+			if (self->obj.flags & KRK_OBJ_FLAGS_STRING_SLICE) mySize += sizeof(KrkStringSlice); /* UTF8 belongs to the parent */
+			else mySize += sizeof(KrkString) + self->length + 1; /* For the UTF8 */
+			if (self->obj.flags & KRK_OBJ_FLAGS_STRING_INDEXED) mySize += krk_unicodeIndexSize(self);
+			else if (self->codes && self->chars != self->codes) {
 				if ((self->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) <= KRK_OBJ_FLAGS_STRING_UCS1) mySize += self->codesLength;
 				else if ((self->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == KRK_OBJ_FLAGS_STRING_UCS2) mySize += 2 * self->codesLength;
 				else if ((self->obj.flags & KRK_OBJ_FLAGS_STRING_MASK) == KRK_OBJ_FLAGS_STRING_UCS4) mySize += 4 * self->codesLength;
@@ -114,6 +118,7 @@ KRK_Function(getsizeof) {
 		case KRK_OBJ_INSTANCE: {
 			KrkInstance * self = AS_INSTANCE(argv[0]);
 			mySize += (sizeof(KrkTableEntry) + sizeof(ssize_t)) * self->fields.capacity;
+			if (self->fields.split) mySize += sizeof(KrkSplitValues) + sizeof(KrkValue) * self->fields.split->capacity;
 			KrkClass * type = krk_getType(argv[0]);
 			mySize += type->allocSize; /* All instance types have an allocSize set */
 
@@ -136,7 +141,8 @@ KRK_Function(getsizeof) {
 		}
 		case KRK_OBJ_BYTES: {
 			KrkBytes * self = AS_BYTES(argv[0]);
-			mySize += sizeof(KrkBytes) + self->length;
+			if (self->obj.flags & KRK_OBJ_FLAGS_BYTES_SLICE) mySize += sizeof(KrkBytesSlice);
+			else mySize += sizeof(KrkBytes) + self->length;
 			break;
 		}
 		default: break;
@@ -224,6 +230,32 @@ KRK_Function(get_recursion_depth) {
 	return INTEGER_VAL(krk_currentThread.maximumCallDepth);
 }
 
+KRK_Function(set_int_max_str_digits) {
+	ssize_t maxdigits;
+	if (!krk_parseArgs("n",(const char*[]){"maxdigits"},&maxdigits)) return NONE_VAL();
+	if (maxdigits < 0 || (maxdigits && maxdigits < 640)) {
+		return krk_runtimeError(vm.exceptions->valueError, "maxdigits must be 0 or larger than %d", 640);
+	}
+	vm.maxIntStrDigits = maxdigits;
+	return NONE_VAL();
+}
+
+KRK_Function(get_int_max_str_digits) {
+	return INTEGER_VAL(vm.maxIntStrDigits);
+}
+
+KRK_Function(set_sort_threads) {
+	ssize_t threads;
+	if (!krk_parseArgs("n",(const char*[]){"threads"},&threads)) return NONE_VAL();
+	if (threads < 1) return krk_runtimeError(vm.exceptions->valueError, "threads must be at least 1");
+	vm.sortThreads = threads;
+	return NONE_VAL();
+}
+
+KRK_Function(get_sort_threads) {
+	return INTEGER_VAL(vm.sortThreads);
+}
+
 void krk_module_init_kuroko(void) {
 	/**
 	 * kuroko = module()
@@ -277,6 +309,22 @@ void krk_module_init_kuroko(void) {
 		"Change the maximum recursion depth of the current thread if possible.");
 	KRK_DOC(BIND_FUNC(vm.system,get_recursion_depth),
 		"Examine the maximum recursion depth of the current thread.");
+	KRK_DOC(BIND_FUNC(vm.system,set_int_max_str_digits),
+		"@brief Limit the size of decimal conversions between int and str.\n"
+		"@arguments maxdigits\n\n"
+		"Converting an int with more than @p maxdigits decimal digits to or from a string raises @ref ValueError. "
+		"Conversions in power-of-two bases are not limited.\n\n"
+		"@param maxdigits Digit limit, at least 640, or 0 to remove the limit.");
+	KRK_DOC(BIND_FUNC(vm.system,get_int_max_str_digits),
+		"Examine the limit on digits in int and str conversions.");
+	KRK_DOC(BIND_FUNC(vm.system,set_sort_threads),
+		"@brief Set how many threads may sort a very large list.\n"
+		"@arguments threads\n\n"
+		"Sorting millions of ints, floats or strings, with or without a key, splits the work over up to "
+		"@p threads threads. The default comes from @c KUROKO_SORT_THREADS or the number of processors.\n\n"
+		"@param threads Thread limit; 1 sorts on the calling thread only.");
+	KRK_DOC(BIND_FUNC(vm.system,get_sort_threads),
+		"Examine the limit on threads used to sort a list.");
 	krk_attachNamedObject(&vm.system->fields, "module", (KrkObj*)vm.baseClasses->moduleClass);
 	krk_attachNamedObject(&vm.system->fields, "path_sep", (KrkObj*)S(KRK_PATH_SEP));
 	KrkValue module_paths = krk_list_of(0,NULL,0);
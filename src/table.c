@@ -17,6 +17,17 @@
  *
  * When resizing a table, the entries array is rewritten and gaps
  * are removed. Simultaneously, the new index entries are populated.
+ *
+ * Tables may also be "split", sharing their keys with other tables
+ * through a layout owned by a class. See KrkSplitValues.
+ *
+ * When built with KRK_SWISS_TABLES, the indexes array is followed by
+ * an array of control bytes, one per slot, in the style of Abseil's
+ * "Swiss tables". Each control byte is either empty, deleted, or holds
+ * seven bits of the hash of the key in that slot. Lookups probe groups
+ * of sixteen control bytes at once (with SSE2 or NEON when available)
+ * and only compare keys whose control byte matches, so long collision
+ * chains and misses are resolved without touching the entries array.
  */
 #include <string.h>
 #include <kuroko/kuroko.h>
@@ -28,22 +39,276 @@
 #include <kuroko/threads.h>
 #include <kuroko/util.h>
 
+#include "private.h"
+
 #define TABLE_MAX_LOAD 3 / 4
 
+#ifdef KRK_SWISS_TABLES
+
+#define GROUP_WIDTH 16
+#define CTRL_EMPTY   ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+
+/* Control bytes live directly after the indexes, with GROUP_WIDTH extra
+ * bytes mirroring the start of the array so that group loads never need
+ * to wrap around the end of the table. */
+#define INDEXES_SIZE(c) ((c) ? (sizeof(ssize_t) * (c) + (c) + GROUP_WIDTH) : 0)
+#define TABLE_CTRL(i,c) ((uint8_t*)((i) + (c)))
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i KrkGroup;
+typedef uint32_t KrkGroupMask;
+#define GROUP_LANE_SHIFT 0
+static inline KrkGroup _group_load(const uint8_t * ctrl) {
+	return _mm_loadu_si128((const __m128i*)ctrl);
+}
+static inline KrkGroupMask _group_match(KrkGroup group, uint8_t byte) {
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+}
+static inline KrkGroupMask _group_match_free(KrkGroup group) {
+	/* Empty and deleted both have their high bit set. */
+	return _mm_movemask_epi8(group);
+}
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+typedef uint8x16_t KrkGroup;
+typedef uint64_t KrkGroupMask;
+#define GROUP_LANE_SHIFT 2
+static inline KrkGroupMask _neon_movemask(uint8x16_t cmp) {
+	/* Narrow each lane to a nibble, then keep one bit per nibble. */
+	uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+	return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+}
+static inline KrkGroup _group_load(const uint8_t * ctrl) {
+	return vld1q_u8(ctrl);
+}
+static inline KrkGroupMask _group_match(KrkGroup group, uint8_t byte) {
+	return _neon_movemask(vceqq_u8(group, vdupq_n_u8(byte)));
+}
+static inline KrkGroupMask _group_match_free(KrkGroup group) {
+	return _neon_movemask(vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(group), 7)));
+}
+#else
+typedef const uint8_t * KrkGroup;
+typedef uint32_t KrkGroupMask;
+#define GROUP_LANE_SHIFT 0
+static inline KrkGroup _group_load(const uint8_t * ctrl) {
+	return ctrl;
+}
+static inline KrkGroupMask _group_match(KrkGroup group, uint8_t byte) {
+	KrkGroupMask out = 0;
+	for (int i = 0; i < GROUP_WIDTH; ++i) out |= (KrkGroupMask)(group[i] == byte) << i;
+	return out;
+}
+static inline KrkGroupMask _group_match_free(KrkGroup group) {
+	KrkGroupMask out = 0;
+	for (int i = 0; i < GROUP_WIDTH; ++i) out |= (KrkGroupMask)(group[i] >> 7) << i;
+	return out;
+}
+#endif
+
+static inline size_t _group_lowest(KrkGroupMask mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(mask) >> GROUP_LANE_SHIFT;
+#else
+	size_t i = 0;
+	while (!(mask & 1)) { mask >>= 1; i++; }
+	return i >> GROUP_LANE_SHIFT;
+#endif
+}
+
+/**
+ * The low bits of the hash select the starting slot, so the control
+ * byte is taken from the top bits of a multiplicative mix; otherwise
+ * small integers, which hash to themselves, would all share one tag.
+ */
+static inline uint8_t _ctrl_tag(uint32_t hash) {
+	return (uint8_t)((hash * 0x9E3779B1U) >> 25);
+}
+
+static inline void _ctrl_set(uint8_t * ctrl, size_t capacity, size_t slot, uint8_t byte) {
+	ctrl[slot] = byte;
+	for (size_t mirror = slot; mirror < GROUP_WIDTH; mirror += capacity) {
+		ctrl[capacity + mirror] = byte;
+	}
+}
+
+#define FOR_EACH_PROBE_GROUP(pos,hash,capacity) \
+	for (size_t pos = (hash) & ((capacity) - 1), _stride = 0; ; \
+	     _stride += GROUP_WIDTH, pos = (pos + _stride) & ((capacity) - 1))
+
+#define FOR_EACH_MATCH(slot,mask,pos,capacity) \
+	for (KrkGroupMask _m = (mask); _m; _m &= _m - 1) \
+		for (size_t slot = ((pos) + _group_lowest(_m)) & ((capacity) - 1), _once = 1; _once; _once = 0)
+
+#else
+
+#define INDEXES_SIZE(c) (sizeof(ssize_t) * (c))
+
+#endif
+
+/* Beyond this, instances are probably being used as ad-hoc dicts. */
+#define SHARED_KEYS_MAX 30
+#define SPLIT_SIZE(c) (sizeof(KrkSplitValues) + sizeof(KrkValue) * (c))
+
+/**
+ * Tables this small skip the index array while all of their keys have
+ * hashes that are cached or cheap to compute, and are searched with a
+ * linear scan of their entries instead. At this size a scan is faster
+ * than probing, and most instance tables and kwargs dicts save an
+ * allocation.
+ */
+#define SMALL_TABLE_MAX 8
+#define TABLE_LIMIT(t) ((t)->indexes ? (t)->capacity * TABLE_MAX_LOAD : (t)->capacity)
+#define TABLE_INDEXES_SIZE(t) ((t)->indexes ? INDEXES_SIZE((t)->capacity) : 0)
+
 void krk_initTable(KrkTable * table) {
 	table->count = 0;
 	table->capacity = 0;
 	table->used = 0;
 	table->entries = NULL;
 	table->indexes = NULL;
+	table->split = NULL;
+}
+
+void krk_initTableShared(KrkTable * table, KrkTable * keys) {
+	KrkSplitValues * split = krk_reallocate(NULL, 0, SPLIT_SIZE(0));
+	split->keys = keys;
+	split->capacity = 0;
+	krk_initTable(table);
+	table->split = split;
 }
 
 void krk_freeTable(KrkTable * table) {
+	if (table->split) krk_reallocate(table->split, SPLIT_SIZE(table->split->capacity), 0);
 	KRK_FREE_ARRAY(KrkTableEntry, table->entries, table->capacity);
-	KRK_FREE_ARRAY(ssize_t, table->indexes, table->capacity);
+	krk_reallocate(table->indexes, TABLE_INDEXES_SIZE(table), 0);
 	krk_initTable(table);
 }
 
+/**
+ * String and bytes hashing is derived from wyhash (final version 4),
+ * by Wang Yi, which was released into the public domain. It reads
+ * eight bytes at a time and is keyed with the per-process seed in
+ * @c vm.hashSeed so that colliding keys can not be precomputed.
+ */
+static const uint64_t _wysecret[4] = {
+	0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL,
+};
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 _wyuint128;
+#endif
+
+static inline void _wymum(uint64_t * a, uint64_t * b) {
+#ifdef __SIZEOF_INT128__
+	_wyuint128 r = (_wyuint128)*a * *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32), c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t _wymix(uint64_t a, uint64_t b) {
+	_wymum(&a, &b);
+	return a ^ b;
+}
+
+static inline uint64_t _wyr8(const uint8_t * p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t _wyr4(const uint8_t * p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline uint64_t _wyr3(const uint8_t * p, size_t k) {
+	return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+uint32_t krk_hashBytes(const void * data, size_t length) {
+	const uint8_t * p = data;
+	uint64_t seed = vm.hashSeed ^ _wymix(vm.hashSeed ^ _wysecret[0], _wysecret[1]);
+	uint64_t a, b;
+	if (likely(length <= 16)) {
+		if (likely(length >= 4)) {
+			a = (_wyr4(p) << 32) | _wyr4(p + ((length >> 3) << 2));
+			b = (_wyr4(p + length - 4) << 32) | _wyr4(p + length - 4 - ((length >> 3) << 2));
+		} else if (likely(length > 0)) {
+			a = _wyr3(p, length);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = length;
+		if (unlikely(i >= 48)) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = _wymix(_wyr8(p) ^ _wysecret[1], _wyr8(p + 8) ^ seed);
+				see1 = _wymix(_wyr8(p + 16) ^ _wysecret[2], _wyr8(p + 24) ^ see1);
+				see2 = _wymix(_wyr8(p + 32) ^ _wysecret[3], _wyr8(p + 40) ^ see2);
+				p += 48; i -= 48;
+			} while (likely(i >= 48));
+			seed ^= see1 ^ see2;
+		}
+		while (unlikely(i > 16)) {
+			seed = _wymix(_wyr8(p) ^ _wysecret[1], _wyr8(p + 8) ^ seed);
+			i -= 16; p += 16;
+		}
+		a = _wyr8(p + i - 16);
+		b = _wyr8(p + i - 8);
+	}
+	a ^= _wysecret[1];
+	b ^= seed;
+	_wymum(&a, &b);
+	uint64_t h = _wymix(a ^ _wysecret[0] ^ length, b ^ _wysecret[1]);
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+/**
+ * Numeric values that compare equal must hash equal, whether they are
+ * ints, longs, floats or bools. Like CPython, every number is first reduced
+ * modulo the Mersenne prime 2**61-1, which each type can do cheaply from its
+ * own representation, and the residue is then mixed with the seed.
+ */
+static inline uint64_t _rotl61(uint64_t x, unsigned int r) {
+	return r ? (((x << r) & KRK_HASH_MODULUS) | (x >> (61 - r))) : x;
+}
+
+uint32_t krk_hashReduced(uint64_t residue, int negative) {
+	if (negative && residue) residue = KRK_HASH_MODULUS - residue;
+	return (uint32_t)_wymix(residue ^ _wysecret[2], vm.hashSeed ^ _wysecret[3]);
+}
+
+static inline uint32_t krk_hashInteger(krk_integer_type value) {
+	uint64_t abs = value < 0 ? -(uint64_t)value : (uint64_t)value;
+	abs = (abs & KRK_HASH_MODULUS) + (abs >> 61);
+	if (abs >= KRK_HASH_MODULUS) abs -= KRK_HASH_MODULUS;
+	return krk_hashReduced(abs, value < 0);
+}
+
+#ifndef KRK_NO_FLOAT
+static uint32_t krk_hashFloat(double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(double));
+	int negative = bits >> 63;
+	int exponent = (bits >> 52) & 0x7FF;
+	uint64_t mantissa = bits & 0xFFFFFFFFFFFFFULL;
+
+	if (exponent == 0x7FF) return mantissa ? 0 : krk_hashReduced(314159, negative);
+	if (exponent) mantissa |= (1ULL << 52);
+	else exponent = 1;
+
+	/* value = mantissa * 2**(exponent - 1075), and 2**61 = 1 (mod 2**61-1) */
+	int shift = (exponent - 1075) % 61;
+	if (shift < 0) shift += 61;
+	return krk_hashReduced(_rotl61(mantissa, shift), negative);
+}
+#endif
+
 inline int krk_hashValue(KrkValue value, uint32_t *hashOut) {
 	switch (KRK_VAL_TYPE(value)) {
 		case KRK_VAL_BOOLEAN:
@@ -51,7 +316,7 @@ inline int krk_hashValue(KrkValue value, uint32_t *hashOut) {
 		case KRK_VAL_NONE:
 		case KRK_VAL_HANDLER:
 		case KRK_VAL_KWARGS:
-			*hashOut = (uint32_t)AS_INTEGER(value);
+			*hashOut = krk_hashInteger(AS_INTEGER(value));
 			return 0;
 		case KRK_VAL_OBJECT:
 			if (AS_OBJECT(value)->flags & KRK_OBJ_FLAGS_VALID_HASH) {
@@ -61,7 +326,7 @@ inline int krk_hashValue(KrkValue value, uint32_t *hashOut) {
 			break;
 		default:
 #ifndef KRK_NO_FLOAT
-			*hashOut = (uint32_t)AS_FLOATING(value);
+			*hashOut = krk_hashFloat(AS_FLOATING(value));
 			return 0;
 #else
 			break;
@@ -85,10 +350,32 @@ _unhashable:
 	return 1;
 }
 
-static inline ssize_t krk_tableIndexKeyC(const KrkTableEntry * entries, const ssize_t * indexes, size_t capacity, KrkValue key, int (*comparator)(KrkValue,KrkValue)) {
-	uint32_t index;
-	if (krk_hashValue(key, &index)) return -1;
-	index &= (capacity - 1);
+#ifdef KRK_SWISS_TABLES
+/**
+ * Returns the slot holding @p key if it is present, otherwise the first
+ * empty or deleted slot along its probe sequence, where it should be inserted.
+ * The load factor guarantees every probe sequence reaches an empty slot.
+ */
+static inline ssize_t krk_tableIndexKeyC(const KrkTableEntry * entries, const ssize_t * indexes, size_t capacity, KrkValue key, uint32_t hash, int (*comparator)(KrkValue,KrkValue)) {
+	const uint8_t * ctrl = TABLE_CTRL(indexes, capacity);
+	uint8_t tag = _ctrl_tag(hash);
+	ssize_t insertAt = -1;
+
+	FOR_EACH_PROBE_GROUP(pos, hash, capacity) {
+		KrkGroup group = _group_load(ctrl + pos);
+		FOR_EACH_MATCH(slot, _group_match(group, tag), pos, capacity) {
+			if (comparator(entries[indexes[slot]].key, key)) return slot;
+		}
+		if (insertAt == -1) {
+			KrkGroupMask avail = _group_match_free(group);
+			if (avail) insertAt = (pos + _group_lowest(avail)) & (capacity - 1);
+		}
+		if (_group_match(group, CTRL_EMPTY)) return insertAt;
+	}
+}
+#else
+static inline ssize_t krk_tableIndexKeyC(const KrkTableEntry * entries, const ssize_t * indexes, size_t capacity, KrkValue key, uint32_t hash, int (*comparator)(KrkValue,KrkValue)) {
+	uint32_t index = hash & (capacity - 1);
 
 	ssize_t tombstone = -1;
 	for (;;) {
@@ -103,31 +390,169 @@ static inline ssize_t krk_tableIndexKeyC(const KrkTableEntry * entries, const ss
 		index = (index + 1) & (capacity - 1);
 	}
 }
+#endif
+
+/**
+ * Whether the hash of @p key can be recomputed without calling into
+ * managed code, as linear lookups need to do for each candidate.
+ */
+static inline int krk_keyHashIsCheap(KrkValue key) {
+	return !IS_OBJECT(key) || (AS_OBJECT(key)->flags & KRK_OBJ_FLAGS_VALID_HASH);
+}
 
-static ssize_t krk_tableIndexKey(const KrkTableEntry * entries, const ssize_t * indexes, size_t capacity, KrkValue key) {
-	return krk_tableIndexKeyC(entries,indexes,capacity,key,krk_valuesSameOrEqual);
+/**
+ * Without an index to narrow down candidates, compare hashes before calling
+ * any equality method, as a hashed lookup would. Strings are interned and
+ * integers unboxed, so two of either that aren't the same can't be equal.
+ */
+static inline int krk_linearCandidate(KrkValue entry, KrkValue key, uint32_t hash) {
+	if (IS_KWARGS(entry)) return 0;
+	if (IS_STRING(entry) && IS_STRING(key)) return 0;
+	if (IS_INTEGER(entry) && KRK_VAL_TYPE(entry) == KRK_VAL_TYPE(key)) return 0;
+	uint32_t entryHash = 0;
+	krk_hashValue(entry, &entryHash);
+	return entryHash == hash;
 }
 
-static ssize_t krk_tableIndexKeyExact(const KrkTableEntry * entries, const ssize_t * indexes, size_t capacity, KrkValue key) {
-	return krk_tableIndexKeyC(entries,indexes,capacity,key,krk_valuesSame);
+static inline ssize_t krk_tableLinearFind(const KrkTable * table, KrkValue key, uint32_t hash, int exact) {
+	for (size_t i = 0; i < table->used; ++i) {
+		KrkValue entry = table->entries[i].key;
+		if (krk_valuesSame(entry, key)) return i;
+		if (!exact && krk_linearCandidate(entry, key, hash) && krk_valuesSameOrEqual(entry, key)) return i;
+	}
+	return -1;
 }
 
-void krk_tableAdjustCapacity(KrkTable * table, size_t capacity) {
+/**
+ * Look up @p key, returning 0 if it could not be hashed. @p entry receives
+ * the index of its entry, or -1 if it is absent. In tables with indexes,
+ * @p slot receives the slot holding the key, or where it should be inserted.
+ */
+static inline int krk_tableLookup(const KrkTable * table, KrkValue key, int exact, uint32_t * hash, ssize_t * slot, ssize_t * entry) {
+	if (krk_hashValue(key, hash)) return 0;
+	if (!table->indexes) {
+		*slot = -1;
+		*entry = krk_tableLinearFind(table, key, *hash, exact);
+		return 1;
+	}
+	*slot = krk_tableIndexKeyC(table->entries, table->indexes, table->capacity, key, *hash, exact ? krk_valuesSame : krk_valuesSameOrEqual);
+	*entry = table->indexes[*slot] < 0 ? -1 : table->indexes[*slot];
+	return 1;
+}
+
+/**
+ * Point a slot returned by krk_tableIndexKeyC at an entry,
+ * or at -2 to leave a tombstone behind.
+ */
+static inline void krk_tableSetSlot(KrkTable * table, size_t slot, ssize_t entry, uint32_t hash) {
+	table->indexes[slot] = entry;
+#ifdef KRK_SWISS_TABLES
+	_ctrl_set(TABLE_CTRL(table->indexes, table->capacity), table->capacity, slot, entry >= 0 ? _ctrl_tag(hash) : CTRL_DELETED);
+#endif
+}
+
+void krk_tableUnshare(KrkTable * table) {
+	KrkSplitValues * split = table->split;
+	if (!split) return;
+
+	/* Build the new table on the side, so the values remain reachable
+	 * through the split table if the GC runs while we allocate. Layouts
+	 * are never deleted from, so entry i of the layout is key i. */
+	KrkTable own;
+	krk_initTable(&own);
+	for (size_t i = 0; i < table->count; ++i) {
+		krk_tableSet(&own, split->keys->entries[i].key, split->values[i]);
+	}
+
+	krk_reallocate(split, SPLIT_SIZE(split->capacity), 0);
+	*table = own;
+}
+
+/**
+ * Try to assign to a table with shared keys. Existing keys are updated in
+ * place, and a new key can be added only if it is the next one in the layout,
+ * or if this table holds every key in the layout and can extend it. If neither
+ * applies, the table is unshared and 0 is returned to let the caller continue.
+ */
+static int krk_tableSetSplit(KrkTable * table, KrkValue key, KrkValue value, int * isNew) {
+	KrkSplitValues * split = table->split;
+	size_t count = table->count;
+	if (!IS_STRING(key)) goto _unshare;
+
+	KrkValue position;
+	if (krk_tableGet_fast(split->keys, AS_STRING(key), &position)) {
+		if ((size_t)AS_INTEGER(position) < count) {
+			split->values[AS_INTEGER(position)] = value;
+			*isNew = 0;
+			return 1;
+		}
+		if ((size_t)AS_INTEGER(position) > count) goto _unshare;
+	} else {
+		/* Layouts are read without locks, so they stop growing once threads exist. */
+		if (count != split->keys->count || count >= SHARED_KEYS_MAX || (vm.globalFlags & KRK_GLOBAL_THREADS)) goto _unshare;
+		krk_tableSet(split->keys, key, INTEGER_VAL(count));
+	}
+
+	if (count == split->capacity) {
+		size_t capacity = count < 4 ? 4 : count * 2;
+		split = krk_reallocate(split, SPLIT_SIZE(split->capacity), SPLIT_SIZE(capacity));
+		split->capacity = capacity;
+		table->split = split;
+	}
+
+	split->values[count] = value;
+	table->count++;
+	*isNew = 1;
+	return 1;
+
+_unshare:
+	krk_tableUnshare(table);
+	return 0;
+}
+
+/**
+ * Rebuild the entries of a table without gaps at @p capacity,
+ * with a hash index if @p indexed is set.
+ */
+static void krk_tableRebuild(KrkTable * table, size_t capacity, int indexed) {
 	KrkTableEntry * nentries = KRK_ALLOCATE(KrkTableEntry, capacity);
-	ssize_t * nindexes = KRK_ALLOCATE(ssize_t, capacity);
+	ssize_t * nindexes = indexed ? krk_reallocate(NULL, 0, INDEXES_SIZE(capacity)) : NULL;
 	for (size_t i = 0; i < capacity; ++i) {
-		nindexes[i] = -1;
 		nentries[i].key = KWARGS_VAL(0);
 		nentries[i].value = KWARGS_VAL(0);
 	}
+	if (indexed) {
+		for (size_t i = 0; i < capacity; ++i) nindexes[i] = -1;
+#ifdef KRK_SWISS_TABLES
+		memset(TABLE_CTRL(nindexes, capacity), CTRL_EMPTY, capacity + GROUP_WIDTH);
+#endif
+	}
 
 	/* Fill in used entries */
 	const KrkTableEntry * e = table->entries;
 	for (size_t i = 0; i < table->count; ++i) {
 		while (IS_KWARGS(e->key)) e++;
 		memcpy(&nentries[i], e, sizeof(KrkTableEntry));
-		ssize_t indexkey = krk_tableIndexKeyExact(nentries,nindexes,capacity, e->key);
-		nindexes[indexkey] = i;
+		if (indexed) {
+			uint32_t hash = 0;
+			krk_hashValue(e->key, &hash);
+#ifdef KRK_SWISS_TABLES
+			/* Keys are known to be unique, so just take the first empty slot. */
+			uint8_t * nctrl = TABLE_CTRL(nindexes, capacity);
+			FOR_EACH_PROBE_GROUP(pos, hash, capacity) {
+				KrkGroupMask avail = _group_match_free(_group_load(nctrl + pos));
+				if (avail) {
+					size_t slot = (pos + _group_lowest(avail)) & (capacity - 1);
+					nindexes[slot] = i;
+					_ctrl_set(nctrl, capacity, slot, _ctrl_tag(hash));
+					break;
+				}
+			}
+#else
+			ssize_t indexkey = krk_tableIndexKeyC(nentries,nindexes,capacity,e->key,hash,krk_valuesSame);
+			nindexes[indexkey] = i;
+#endif
+		}
 		e++;
 	}
 
@@ -137,69 +562,111 @@ void krk_tableAdjustCapacity(KrkTable * table, size_t capacity) {
 	KRK_FREE_ARRAY(KrkTableEntry, oldEntries, table->capacity);
 
 	ssize_t * oldIndexes = table->indexes;
+	size_t oldIndexesSize = TABLE_INDEXES_SIZE(table);
 	table->indexes = nindexes;
-	KRK_FREE_ARRAY(ssize_t, oldIndexes, table->capacity);
+	krk_reallocate(oldIndexes, oldIndexesSize, 0);
 
 	/* Update table with new capacity and used count */
 	table->capacity = capacity;
 	table->used = table->count;
 }
 
-int krk_tableSet(KrkTable * table, KrkValue key, KrkValue value) {
-	if (table->used + 1 > table->capacity * TABLE_MAX_LOAD) {
-		size_t capacity = KRK_GROW_CAPACITY(table->capacity);
-		krk_tableAdjustCapacity(table, capacity);
-	}
-
-	ssize_t index = krk_tableIndexKey(table->entries, table->indexes, table->capacity, key);
-	if (index < 0) return 0;
-	KrkTableEntry * entry;
-	int isNew = table->indexes[index] < 0;
-	if (isNew) {
-		table->indexes[index] = table->used;
-		entry = &table->entries[table->used];
-		entry->key = key;
-		table->used++;
-		table->count++;
-	} else {
-		entry = &table->entries[table->indexes[index]];
+void krk_tableAdjustCapacity(KrkTable * table, size_t capacity) {
+	krk_tableUnshare(table);
+	int indexed = capacity > SMALL_TABLE_MAX;
+	for (size_t i = 0; !indexed && i < table->used; ++i) {
+		if (!krk_keyHashIsCheap(table->entries[i].key)) indexed = 1;
 	}
-	entry->value = value;
-	return isNew;
+	krk_tableRebuild(table, capacity, indexed);
 }
 
-int krk_tableSetExact(KrkTable * table, KrkValue key, KrkValue value) {
-	if (table->used + 1 > table->capacity * TABLE_MAX_LOAD) {
-		size_t capacity = KRK_GROW_CAPACITY(table->capacity);
-		krk_tableAdjustCapacity(table, capacity);
-	}
-
-	ssize_t index = krk_tableIndexKeyExact(table->entries, table->indexes, table->capacity, key);
-	if (index < 0) return 0;
-	KrkTableEntry * entry;
-	int isNew = table->indexes[index] < 0;
-	if (isNew) {
-		table->indexes[index] = table->used;
-		entry = &table->entries[table->used];
-		entry->key = key;
-		table->used++;
-		table->count++;
-	} else {
-		entry = &table->entries[table->indexes[index]];
+/**
+ * Pick the capacity to rebuild a table with when it holds @p count entries.
+ * Tables are rebuilt to be at most half full, so a table that filled up with
+ * tombstones is compacted in place (or shrinks) rather than doubling, while
+ * a table without deletions still grows by a factor of two.
+ */
+static size_t krk_tableCapacityFor(size_t count) {
+	size_t capacity = 8;
+	while (capacity < count * 2) capacity *= 2;
+	return capacity;
+}
+
+void krk_tableCompact(KrkTable * table) {
+	if (table->split) return;
+	if (table->count == 0) {
+		krk_freeTable(table);
+		return;
 	}
+	size_t capacity = krk_tableCapacityFor(table->count);
+	if (capacity < table->capacity || table->used != table->count) {
+		krk_tableAdjustCapacity(table, capacity < table->capacity ? capacity : table->capacity);
+	}
+}
+
+static inline int krk_tableSetC(KrkTable * table, KrkValue key, KrkValue value, int exact) {
+	if (table->split) {
+		int isNew;
+		if (krk_tableSetSplit(table, key, value, &isNew)) return isNew;
+	}
+
+	if (table->used + 1 > TABLE_LIMIT(table)) {
+		krk_tableAdjustCapacity(table, krk_tableCapacityFor(table->count));
+	}
+
+	uint32_t hash;
+	ssize_t slot, index;
+	if (!krk_tableLookup(table, key, exact, &hash, &slot, &index)) return 0;
+	if (index >= 0) {
+		table->entries[index].value = value;
+		return 0;
+	}
+
+	if (!table->indexes && !krk_keyHashIsCheap(key)) {
+		krk_tableRebuild(table, krk_tableCapacityFor(table->count), 1);
+		slot = krk_tableIndexKeyC(table->entries, table->indexes, table->capacity, key, hash, krk_valuesSame);
+	}
+
+	KrkTableEntry * entry = &table->entries[table->used];
+	entry->key = key;
 	entry->value = value;
-	return isNew;
+	if (table->indexes) krk_tableSetSlot(table, slot, table->used, hash);
+	table->used++;
+	table->count++;
+	return 1;
+}
+
+int krk_tableSet(KrkTable * table, KrkValue key, KrkValue value) {
+	return krk_tableSetC(table, key, value, 0);
+}
+
+int krk_tableSetExact(KrkTable * table, KrkValue key, KrkValue value) {
+	return krk_tableSetC(table, key, value, 1);
 }
 
 int krk_tableSetIfExists(KrkTable * table, KrkValue key, KrkValue value) {
 	if (table->count == 0) return 0;
-	ssize_t index = krk_tableIndexKey(table->entries, table->indexes, table->capacity, key);
-	if (index < 0 || table->indexes[index] < 0) return 0;
-	table->entries[table->indexes[index]].value = value;
+	if (table->split) {
+		KrkValue position;
+		if (!IS_STRING(key) || !krk_tableGet_fast(table->split->keys, AS_STRING(key), &position) ||
+		    (size_t)AS_INTEGER(position) >= table->count) return 0;
+		table->split->values[AS_INTEGER(position)] = value;
+		return 1;
+	}
+	uint32_t hash;
+	ssize_t slot, index;
+	if (!krk_tableLookup(table, key, 0, &hash, &slot, &index) || index < 0) return 0;
+	table->entries[index].value = value;
 	return 1;
 }
 
 void krk_tableAddAll(KrkTable * from, KrkTable * to) {
+	if (from->split) {
+		for (size_t i = 0; i < from->count; ++i) {
+			krk_tableSet(to, from->split->keys->entries[i].key, from->split->values[i]);
+		}
+		return;
+	}
 	for (size_t i = 0; i < from->capacity; ++i) {
 		KrkTableEntry * entry = &from->entries[i];
 		if (!IS_KWARGS(entry->key)) {
@@ -210,14 +677,45 @@ void krk_tableAddAll(KrkTable * from, KrkTable * to) {
 
 int krk_tableGet(KrkTable * table, KrkValue key, KrkValue * value) {
 	if (table->count == 0) return 0;
-	ssize_t index = krk_tableIndexKey(table->entries, table->indexes, table->capacity, key);
-	if (index < 0 || table->indexes[index] < 0) return 0;
-	*value = table->entries[table->indexes[index]].value;
+	if (table->split) return IS_STRING(key) && krk_tableGet_fast(table, AS_STRING(key), value);
+	uint32_t hash;
+	ssize_t slot, index;
+	if (!krk_tableLookup(table, key, 0, &hash, &slot, &index) || index < 0) return 0;
+	*value = table->entries[index].value;
 	return 1;
 }
 
 int krk_tableGet_fast(KrkTable * table, KrkString * str, KrkValue * value) {
 	if (table->count == 0) return 0;
+	if (table->split) {
+		KrkValue position;
+		if (!krk_tableGet_fast(table->split->keys, str, &position) || (size_t)AS_INTEGER(position) >= table->count) return 0;
+		*value = table->split->values[AS_INTEGER(position)];
+		return 1;
+	}
+	if (!table->indexes) {
+		for (size_t i = 0; i < table->used; ++i) {
+			if (krk_valuesSame(table->entries[i].key, OBJECT_VAL(str))) {
+				*value = table->entries[i].value;
+				return 1;
+			}
+		}
+		return 0;
+	}
+#ifdef KRK_SWISS_TABLES
+	const uint8_t * ctrl = TABLE_CTRL(table->indexes, table->capacity);
+	uint8_t tag = _ctrl_tag(str->obj.hash);
+	FOR_EACH_PROBE_GROUP(pos, str->obj.hash, table->capacity) {
+		KrkGroup group = _group_load(ctrl + pos);
+		FOR_EACH_MATCH(slot, _group_match(group, tag), pos, table->capacity) {
+			if (krk_valuesSame(table->entries[table->indexes[slot]].key, OBJECT_VAL(str))) {
+				*value = table->entries[table->indexes[slot]].value;
+				return 1;
+			}
+		}
+		if (_group_match(group, CTRL_EMPTY)) return 0;
+	}
+#else
 	uint32_t index = str->obj.hash & (table->capacity-1);
 
 	ssize_t tombstone = -1;
@@ -233,32 +731,62 @@ int krk_tableGet_fast(KrkTable * table, KrkString * str, KrkValue * value) {
 		}
 		index = (index + 1) & (table->capacity - 1);
 	}
+#endif
 }
 
-int krk_tableDelete(KrkTable * table, KrkValue key) {
+static inline int krk_tableDeleteC(KrkTable * table, KrkValue key, int exact) {
 	if (table->count == 0) return 0;
-	ssize_t index = krk_tableIndexKey(table->entries, table->indexes, table->capacity, key);
-	if (index < 0 || table->indexes[index] < 0) return 0;
+	if (table->split) {
+		KrkValue existing;
+		if (!krk_tableGet(table, key, &existing)) return 0;
+		krk_tableUnshare(table);
+	}
+	uint32_t hash;
+	ssize_t slot, index;
+	if (!krk_tableLookup(table, key, exact, &hash, &slot, &index) || index < 0) return 0;
 	table->count--;
-	table->entries[table->indexes[index]].key = KWARGS_VAL(0);
-	table->entries[table->indexes[index]].value = KWARGS_VAL(0);
-	table->indexes[index] = -2;
+	table->entries[index].key = KWARGS_VAL(0);
+	table->entries[index].value = KWARGS_VAL(0);
+	if (table->indexes) krk_tableSetSlot(table, slot, -2, hash);
 	return 1;
 }
 
+int krk_tableDelete(KrkTable * table, KrkValue key) {
+	return krk_tableDeleteC(table, key, 0);
+}
+
 int krk_tableDeleteExact(KrkTable * table, KrkValue key) {
-	if (table->count == 0) return 0;
-	ssize_t index = krk_tableIndexKeyExact(table->entries, table->indexes, table->capacity, key);
-	if (index < 0 || table->indexes[index] < 0) return 0;
-	table->count--;
-	table->entries[table->indexes[index]].key = KWARGS_VAL(0);
-	table->entries[table->indexes[index]].value = KWARGS_VAL(0);
-	table->indexes[index] = -2;
-	return 1;
+	return krk_tableDeleteC(table, key, 1);
 }
 
 KrkString * krk_tableFindString(KrkTable * table, const char * chars, size_t length, uint32_t hash) {
 	if (table->count == 0) return NULL;
+	if (!table->indexes) {
+		for (size_t i = 0; i < table->used; ++i) {
+			if (IS_KWARGS(table->entries[i].key)) continue;
+			KrkString * candidate = AS_STRING(table->entries[i].key);
+			if (candidate->length == length && candidate->obj.hash == hash &&
+			    memcmp(candidate->chars, chars, length) == 0) {
+				return candidate;
+			}
+		}
+		return NULL;
+	}
+#ifdef KRK_SWISS_TABLES
+	const uint8_t * ctrl = TABLE_CTRL(table->indexes, table->capacity);
+	uint8_t tag = _ctrl_tag(hash);
+	FOR_EACH_PROBE_GROUP(pos, hash, table->capacity) {
+		KrkGroup group = _group_load(ctrl + pos);
+		FOR_EACH_MATCH(slot, _group_match(group, tag), pos, table->capacity) {
+			KrkString * candidate = AS_STRING(table->entries[table->indexes[slot]].key);
+			if (candidate->length == length && candidate->obj.hash == hash &&
+			    memcmp(candidate->chars, chars, length) == 0) {
+				return candidate;
+			}
+		}
+		if (_group_match(group, CTRL_EMPTY)) return NULL;
+	}
+#else
 	uint32_t index = hash & (table->capacity - 1);
 
 	ssize_t tombstone = -1;
@@ -275,4 +803,5 @@ KrkString * krk_tableFindString(KrkTable * table, const char * chars, size_t len
 		}
 		index = (index + 1) & (table->capacity - 1);
 	}
+#endif
 }
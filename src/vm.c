@@ -3,7 +3,10 @@
 #include <stdarg.h>
 #include <string.h>
 #include <errno.h>
+#include <stdio.h>
+#include <time.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <kuroko/vm.h>
 #include <kuroko/debug.h>
@@ -865,12 +868,73 @@ void krk_setMaximumRecursionDepth(size_t maxDepth) {
 	krk_currentThread.frames = realloc(krk_currentThread.frames, maxDepth * sizeof(KrkCallFrame));
 }
 
+/**
+ * Pick the key for hashing strings and numbers. This needs to be unpredictable
+ * so that dict keys from untrusted input can not be chosen to collide, but
+ * it can be pinned with KUROKO_HASH_SEED for reproducible runs; 0 disables
+ * randomization entirely.
+ */
+static uint64_t _pickHashSeed(void) {
+	const char * fixed = getenv("KUROKO_HASH_SEED");
+	if (fixed && *fixed) return strtoull(fixed, NULL, 0);
+
+	uint64_t seed = 0;
+	FILE * f = fopen("/dev/urandom", "rb");
+	if (f) {
+		size_t got = fread(&seed, sizeof(seed), 1, f);
+		fclose(f);
+		if (got == 1 && seed) return seed;
+	}
+
+	/* Without a system entropy source, mix what varies between runs. */
+	seed = (uint64_t)time(NULL) * 0x9E3779B97F4A7C15ULL;
+	seed ^= (uint64_t)clock() << 32;
+	seed ^= (uint64_t)(uintptr_t)&seed;
+	seed ^= (uint64_t)(uintptr_t)&_pickHashSeed;
+	return seed;
+}
+
+/**
+ * Default limit on decimal digits in int/str conversions; overridden by
+ * KUROKO_INT_MAX_STR_DIGITS and changeable with kuroko.set_int_max_str_digits.
+ */
+#ifndef KRK_INT_MAX_STR_DIGITS
+#define KRK_INT_MAX_STR_DIGITS 4300
+#endif
+
+static size_t _pickIntMaxStrDigits(void) {
+	const char * fixed = getenv("KUROKO_INT_MAX_STR_DIGITS");
+	if (fixed && *fixed) {
+		/* Values set_int_max_str_digits would reject leave the default in place */
+		long long digits = strtoll(fixed, NULL, 10);
+		if (digits == 0 || digits >= 640) return digits;
+	}
+	return KRK_INT_MAX_STR_DIGITS;
+}
+
+/**
+ * Threads list.sort may use for lists of millions of ints, floats or strings:
+ * KUROKO_SORT_THREADS if set, otherwise one per online processor.
+ */
+static size_t _pickSortThreads(void) {
+	const char * fixed = getenv("KUROKO_SORT_THREADS");
+	if (fixed && *fixed) return strtoull(fixed, NULL, 10);
+#if !defined(KRK_DISABLE_THREADS) && defined(_SC_NPROCESSORS_ONLN)
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	if (processors > 0) return processors;
+#endif
+	return 1;
+}
+
 void krk_initVM(int flags) {
 #if !defined(KRK_DISABLE_THREADS) && defined(__APPLE__) && defined(__aarch64__)
 	krk_forceThreadData();
 #endif
 
 	vm.globalFlags = flags & 0xFF00;
+	vm.hashSeed = _pickHashSeed();
+	vm.maxIntStrDigits = _pickIntMaxStrDigits();
+	vm.sortThreads = _pickSortThreads();
 
 	/* Reset current thread */
 	krk_resetStack();
@@ -924,6 +988,7 @@ void krk_initVM(int flags) {
 	_createAndBind_rangeClass();
 	_createAndBind_setClass();
 	_createAndBind_sliceClass();
+	_createAndBind_memoryviewClass();
 	_createAndBind_exceptions();
 	_createAndBind_generatorClass();
 	_createAndBind_longClass();
@@ -2006,6 +2071,20 @@ static inline int doFormatString(int options) {
 		krk_swap(1);
 	}
 
+	/* Builtin scalars with no format spec are converted by OP_MAKE_STRING in place. */
+	if (!(options & (FORMAT_OP_FORMAT | FORMAT_OP_REPR))) {
+		if (krk_simpleStrLength(krk_peek(0)) >= 0) return 0;
+#ifndef KRK_NO_FLOAT
+		if (IS_FLOATING(krk_peek(0))) {
+			/* May grow the stack, so don't write it through stackTop until it returns. */
+			KrkValue result = krk_double_to_string(AS_FLOATING(krk_peek(0)),16,(options & FORMAT_OP_STR) ? ' ' : 'g',0,0);
+			if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) return 1;
+			krk_currentThread.stackTop[-1] = result;
+			return 0;
+		}
+#endif
+	}
+
 	/* Was this a repr or str call? (it can't be both) */
 	if (options & FORMAT_OP_STR) {
 		KrkClass * type = krk_getType(krk_peek(0));
@@ -3179,24 +3258,13 @@ _finishPopBlock: (void)0;
 				THREE_BYTE_OPERAND;
 			case OP_MAKE_STRING: {
 				ONE_BYTE_OPERAND;
+				if (OPERAND == 1 && IS_STRING(krk_peek(0))) break;
 
-				struct StringBuilder sb = {0};
+				KrkValue result = krk_concatSimple(OPERAND, &krk_currentThread.stackTop[-(ssize_t)OPERAND]);
+				if (unlikely(krk_currentThread.flags & KRK_THREAD_HAS_EXCEPTION)) goto _finishException;
 
-				for (ssize_t i = 0; i < (ssize_t)OPERAND; ++i) {
-					KrkValue s = krk_currentThread.stackTop[-(ssize_t)OPERAND+i];
-					if (unlikely(!IS_STRING(s))) {
-						discardStringBuilder(&sb);
-						krk_runtimeError(vm.exceptions->valueError, "'%T' is not a string", s);
-						goto _finishException;
-					}
-					pushStringBuilderStr(&sb, (char*)AS_STRING(s)->chars, AS_STRING(s)->length);
-				}
-
-				for (ssize_t i = 0; i < (ssize_t)OPERAND; ++i) {
-					krk_pop();
-				}
-
-				krk_push(finishStringBuilder(&sb));
+				krk_currentThread.stackTop -= OPERAND;
+				krk_push(result);
 				break;
 			}
 